@@ -49,6 +49,216 @@ public class ImageProcessor {
 	private static final int REQUEST_DRAW = 1;
 	private static final int REQUEST_UPDATE_SIZE = 2;
 
+	// type of frame source, should match values on native side.
+	/** read back images from SurfaceTexture via OpenGL|ES(default) */
+	public static final int FRAME_SOURCE_GL = 0;
+	/** raw images(RGBA/YUYV/NV21/MJPEG) pushed by #handleBuffer */
+	public static final int FRAME_SOURCE_MEMORY = 1;
+	/** image file or synthetic pattern generated on native side, for benchmark/load testing */
+	public static final int FRAME_SOURCE_SYNTHETIC = 2;
+	/** MJPEG frames pushed by #handleBuffer with PIXEL_FORMAT_MJPEG,
+	 * decoded to processing size on native thread pipelined with processing */
+	public static final int FRAME_SOURCE_MJPEG = 3;
+
+	// pixel format of raw image buffer for #handleBuffer, should match values on native side.
+	/** RGBA, 4 bytes per pixel */
+	public static final int PIXEL_FORMAT_RGBA = 0;
+	/** packed YUV 4:2:2(Y0 U Y1 V), e.g. raw frame of UVC camera */
+	public static final int PIXEL_FORMAT_YUYV = 1;
+	/** Y plane followed by interleaved V/U plane, e.g. preview frame of Android camera */
+	public static final int PIXEL_FORMAT_NV21 = 2;
+	/** one JPEG image per buffer, e.g. MJPEG frame of UVC camera */
+	public static final int PIXEL_FORMAT_MJPEG = 3;
+
+	/** default number of PBOs used for asynchronous readback of frames */
+	public static final int DEFAULT_READBACK_DEPTH = 3;
+	/** index of latency of readback from GPU in result array[ms] */
+	public static final int RESULT_IX_READBACK_LATENCY = 39;
+
+	// type of the result passed to ImageProcessorCallback#onResult, should match DetectType on native side.
+	// when both "line" and "curve" stages are in the pipeline, this is the type of the stage that reported last
+	// and values of both stages are in the result array.
+	/** nothing detected */
+	public static final int DETECT_TYPE_NON = -1;
+	/** line detected by "line" stage */
+	public static final int DETECT_TYPE_LINE = 0;
+	/** curve detected by "curve" stage */
+	public static final int DETECT_TYPE_CURVE = 1;
+
+	// index of the values of "line" stage in result array,
+	// "line" and "curve" stages have their own values so that both can be used in same pipeline
+	/** confidence of the detection(0-1), 0 if the previous result is reported as it was not found in this frame */
+	public static final int RESULT_IX_LINE_CONFIDENCE = 0;
+	/** angle of the line from x axis[deg](-90, 90], clockwise on the image as y axis points down */
+	public static final int RESULT_IX_LINE_ANGLE = 1;
+	/** signed distance of the line from the center of region of interest[px], positive when right of or above the center */
+	public static final int RESULT_IX_LINE_OFFSET = 2;
+	/** 1 if whole frame was searched in this frame, 0 if previous result was tracked */
+	public static final int RESULT_IX_LINE_FULL_SEARCH = 3;
+	// index of the values of "curve" stage in result array
+	/** confidence of the detection(0-1), 0 if the previous result is reported as it was not found in this frame */
+	public static final int RESULT_IX_CURVE_CONFIDENCE = 4;
+	/**
+	 * coefficients of the curve u = a * v^3 + b * v^2 + c * v + d,
+	 * u and v are pixels relative to the center of region of interest, see RESULT_IX_CURVE_AXIS
+	 */
+	public static final int RESULT_IX_CURVE_A = 5;
+	public static final int RESULT_IX_CURVE_B = 6;
+	public static final int RESULT_IX_CURVE_C = 7;
+	public static final int RESULT_IX_CURVE_D = 8;
+	/** 0 if the curve is x = f(y), 1 if y = f(x) */
+	public static final int RESULT_IX_CURVE_AXIS = 9;
+	/** 1 if whole frame was searched in this frame, 0 if previous result was tracked */
+	public static final int RESULT_IX_CURVE_FULL_SEARCH = 10;
+	// index of the values of "color" stage in result array
+	/** ratio of extracted pixels in region of interest(0-1) */
+	public static final int RESULT_IX_COLOR_AREA = 11;
+	/** centroid of extracted pixels relative to the center of region of interest[px] */
+	public static final int RESULT_IX_COLOR_X = 12;
+	public static final int RESULT_IX_COLOR_Y = 13;
+	// index of the values of "motion" stage in result array
+	/** ratio of the pixels in motion in region of interest(0-1) */
+	public static final int RESULT_IX_MOTION_ACTIVITY = 14;
+	/** number of the regions of motion */
+	public static final int RESULT_IX_MOTION_REGIONS = 15;
+	/** bounding box of all regions of motion relative to top left of region of interest[px] */
+	public static final int RESULT_IX_MOTION_X = 16;
+	public static final int RESULT_IX_MOTION_Y = 17;
+	public static final int RESULT_IX_MOTION_WIDTH = 18;
+	public static final int RESULT_IX_MOTION_HEIGHT = 19;
+	/**
+	 * bounding box(x, y, width, height) of each region of motion relative to top left of region of interest[px],
+	 * up to RESULT_MOTION_MAX_BOXES largest regions in descending order of area, unused boxes are 0
+	 */
+	public static final int RESULT_IX_MOTION_BOXES = 20;
+	public static final int RESULT_MOTION_MAX_BOXES = 4;
+	// index of the values of "klt" stage in result array
+	/** global motion of the frame from previous frame[px] */
+	public static final int RESULT_IX_FLOW_DX = 36;
+	public static final int RESULT_IX_FLOW_DY = 37;
+	/** number of the tracked features that follow global motion */
+	public static final int RESULT_IX_FLOW_TRACKS = 38;
+
+	// what to do when frame queue is full, should match values on native side.
+	/** drop the oldest queued frame and append new one(default, lowest latency) */
+	public static final int QUEUE_POLICY_DROP_OLDEST = 0;
+	/** drop the new frame and keep queued frames */
+	public static final int QUEUE_POLICY_DROP_NEWEST = 1;
+	/** block frame source until worker thread takes queued frame or timeout */
+	public static final int QUEUE_POLICY_BLOCK = 2;
+
+	/** default max number of frames in frame queue */
+	public static final int DEFAULT_QUEUE_SIZE = 1;
+	/** default number of spare frames in addition to frame queue */
+	public static final int DEFAULT_POOL_SIZE = 2;
+	/** default timeout for QUEUE_POLICY_BLOCK[ms] */
+	public static final int DEFAULT_BLOCK_TIMEOUT_MS = 30;
+
+	// index of frame counters in the array of #getFrameStats
+	/** number of frames that frame source read back/generated */
+	public static final int FRAME_STATS_IX_READBACK = 0;
+	/** number of frames appended to frame queue */
+	public static final int FRAME_STATS_IX_ENQUEUED = 1;
+	/** number of frames dropped by queue policy, includes both rejected and evicted frames */
+	public static final int FRAME_STATS_IX_DROPPED = 2;
+	/** number of frames that native worker thread finished processing */
+	public static final int FRAME_STATS_IX_PROCESSED = 3;
+	/** number of native buffer allocations after steady state, should be zero */
+	public static final int FRAME_STATS_IX_STEADY_ALLOCATIONS = 4;
+	/** number of frames that were not read back because native worker thread was busy,
+	 * these are also counted in FRAME_STATS_IX_DROPPED */
+	public static final int FRAME_STATS_IX_BACKPRESSURE = 5;
+	/** number of frames that skipped native stages because they were same as last processed frame,
+	 * these are also counted in FRAME_STATS_IX_PROCESSED, see #setUnchangedThreshold */
+	public static final int FRAME_STATS_IX_UNCHANGED = 6;
+	public static final int FRAME_STATS_NUM = 7;
+
+	// flags for the arena that serves native frame buffers, should match values on native side.
+	/** try to back the arena with huge pages */
+	public static final int ARENA_FLAG_HUGE_PAGES = 0x01;
+	/** abort when native buffer is allocated in steady state(for debugging) */
+	public static final int ARENA_FLAG_ASSERT_NO_ALLOC = 0x02;
+
+	// index of scheduler stats in the array of #getSchedulerStats,
+	// frames of all ImageProcessor instances are processed on shared native worker threads
+	/** number of frames processed for this instance */
+	public static final int SCHEDULER_STATS_IX_PROCESSED = 0;
+	/** time that worker threads spent in processing for this instance[ns] */
+	public static final int SCHEDULER_STATS_IX_BUSY_TIME = 1;
+	/** number of frames processed for all instances */
+	public static final int SCHEDULER_STATS_IX_TOTAL_PROCESSED = 2;
+	/** time that worker threads spent in processing for all instances[ns] */
+	public static final int SCHEDULER_STATS_IX_TOTAL_BUSY_TIME = 3;
+	/** number of shared worker threads */
+	public static final int SCHEDULER_STATS_IX_THREADS = 4;
+	/** number of running instances */
+	public static final int SCHEDULER_STATS_IX_CLIENTS = 5;
+	public static final int SCHEDULER_STATS_NUM = 6;
+
+	/** processing stages used when #setPipeline is not called */
+	public static final String DEFAULT_PIPELINE = "gray_rgba";
+	/** max number of stages in one pipeline */
+	public static final int PIPELINE_MAX_STAGES = 16;
+	/** max number of segments(threads) in one pipeline */
+	public static final int PIPELINE_MAX_SEGMENTS = 4;
+	/** default number of frames that can wait between segments of the pipeline */
+	public static final int DEFAULT_STAGE_QUEUE_DEPTH = 2;
+	// index of stage stats in the array of #getStageStats, repeated for each stage
+	/** number of frames processed by the stage */
+	public static final int STAGE_STATS_IX_COUNT = 0;
+	/** total processing time of the stage[ns] */
+	public static final int STAGE_STATS_IX_TOTAL_TIME = 1;
+	/** max processing time of the stage[ns] */
+	public static final int STAGE_STATS_IX_MAX_TIME = 2;
+	/** index of the segment(thread) that runs the stage, 0 is shared native worker thread */
+	public static final int STAGE_STATS_IX_SEGMENT = 3;
+	// input queue of the segment, these are zero except first stage of second and later segments
+	/** capacity of input queue */
+	public static final int STAGE_STATS_IX_QUEUE_CAPACITY = 4;
+	/** current number of frames in input queue */
+	public static final int STAGE_STATS_IX_QUEUE_SIZE = 5;
+	/** max number of frames in input queue */
+	public static final int STAGE_STATS_IX_QUEUE_MAX = 6;
+	/** sum of number of frames in input queue when each frame was queued, divide by count for average */
+	public static final int STAGE_STATS_IX_QUEUE_TOTAL = 7;
+	/**
+	 * number of full(whole frame) detections of tracking stage(e.g. "line"),
+	 * number of seeding of features for "klt", 0 for other stages
+	 */
+	public static final int STAGE_STATS_IX_DETECT_COUNT = 8;
+	/**
+	 * number of full detections because tracking was lost, others were scheduled by #setDetectInterval.
+	 * for "klt", number of seeding that found too few features and backed off seeding for 15 frames
+	 */
+	public static final int STAGE_STATS_IX_FALLBACK_COUNT = 9;
+	public static final int STAGE_STATS_NUM = 10;
+
+	// index of per-frame information passed to FrameInfoCallback,
+	// all times are in nanoseconds of CLOCK_MONOTONIC, same base as System#nanoTime
+	/** sequence number of the frame since #start, gaps mean dropped frames */
+	public static final int FRAME_INFO_IX_SEQ = 0;
+	/** time when the frame was captured or its readback was requested */
+	public static final int FRAME_INFO_IX_CAPTURE_TIME = 1;
+	/** time when the frame was queued for native worker thread */
+	public static final int FRAME_INFO_IX_QUEUED_TIME = 2;
+	/** timestamp of the frame from SurfaceTexture#getTimestamp or #handleBuffer */
+	public static final int FRAME_INFO_IX_SOURCE_TIMESTAMP = 3;
+	/** total number of frames dropped before this frame was queued */
+	public static final int FRAME_INFO_IX_DROPPED = 4;
+	/** time when native worker thread took the frame from the queue */
+	public static final int FRAME_INFO_IX_DEQUEUED_TIME = 5;
+	/** time when the result was passed to Java */
+	public static final int FRAME_INFO_IX_RESULT_TIME = 6;
+	/** region of the full frame that was read back and processed, see #setReadbackRoi */
+	public static final int FRAME_INFO_IX_ROI_X = 7;
+	public static final int FRAME_INFO_IX_ROI_Y = 8;
+	public static final int FRAME_INFO_IX_ROI_WIDTH = 9;
+	public static final int FRAME_INFO_IX_ROI_HEIGHT = 10;
+	/** pixel format of the result image passed to ImageProcessorCallback#onFrame, see #setResultFormat,
+	 * -1 when there is no result image(RESULT_FRAME_TYPE_NON) */
+	public static final int FRAME_INFO_IX_RESULT_FORMAT = 11;
+	public static final int FRAME_INFO_NUM = 12;
+
 	/**
 	 * callback listener to notify image processing result
 	 */
@@ -61,23 +271,44 @@ public class ImageProcessor {
 
 		/**
 		 * when receive something result as float array
-		 * @param type
-		 * @param result
+		 * @param type DETECT_TYPE_XXX
+		 * @param result see RESULT_IX_XXX
 		 */
 		public void onResult(final int type, final float[] result);
 	}
 
+	/**
+	 * optional callback listener to receive per-frame information
+	 */
+	public interface FrameInfoCallback {
+		/**
+		 * called with the result of each frame, on the same thread as ImageProcessorCallback
+		 * @param info see FRAME_INFO_IX_XXX, this array is not re-used
+		 */
+		public void onFrameInfo(final long[] info);
+	}
+
 	/** for access control */
 	private final Object mSync = new Object();
 	private final ImageProcessorCallback mCallback;
+	private volatile FrameInfoCallback mFrameInfoCallback;
 	private volatile boolean isProcessingRunning;
 	private ProcessingTask mProcessingTask;
 	private Handler mAsyncHandler;
 
 	private final int mSrcWidth, mSrcHeight;
-	private volatile boolean requestUpdateExtractionColor;
+	/** lend mapped PBO to native worker thread instead of copying */
+	private boolean mZeroCopyReadback;
+	private int mQueueSize = DEFAULT_QUEUE_SIZE;
+	private int mPoolSize = DEFAULT_POOL_SIZE;
+	private int mQueuePolicy = QUEUE_POLICY_DROP_OLDEST;
+	private int mBlockTimeoutMs = DEFAULT_BLOCK_TIMEOUT_MS;
+	/** type of frame source */
+	private int mFrameSource = FRAME_SOURCE_GL;
 	/** for calculation of frame rate */
 	private final FpsCounter mResultFps = new FpsCounter();
+	/** receives sequence number of #getDenseFlow so that polling never allocates */
+	private final long[] mFlowSeq = new long[1];
 
 	/** reference of native object, never change name, remove */
 	private long mNativePtr;
@@ -111,8 +342,20 @@ public class ImageProcessor {
 	 * @param height
 	 */
 	public void start(final int width, final int height) {
+		start(width, height, DEFAULT_READBACK_DEPTH);
+	}
+
+	/**
+	 * start worker thread of ImageProcessor
+	 * this will block current thread until worker thread run
+	 * @param width
+	 * @param height
+	 * @param readbackDepth number of PBOs for asynchronous readback, [1, 8]
+	 */
+	public void start(final int width, final int height, final int readbackDepth) {
 		if (mProcessingTask == null) {
-			mProcessingTask = new ProcessingTask(this, mSrcWidth, mSrcHeight, width, height);
+			mProcessingTask = new ProcessingTask(this, mSrcWidth, mSrcHeight,
+				width, height, readbackDepth);
 			new Thread(mProcessingTask, "VideoStream$rendererTask").start();
 			mProcessingTask.waitReady();
 			synchronized (mSync) {
@@ -127,6 +370,258 @@ public class ImageProcessor {
 		}
 	}
 
+	/**
+	 * set whether or not native worker thread receives frames that directly wrap
+	 * mapped PBO(zero-copy readback). If enabled, one full frame copy per frame
+	 * on GL thread is avoided but at least 3 PBOs are used for readback.
+	 * this should be called before #start
+	 * @param zeroCopy
+	 */
+	public void setZeroCopyReadback(final boolean zeroCopy) {
+		mZeroCopyReadback = zeroCopy;
+	}
+
+	/**
+	 * set type of frame source, this should be called before #start
+	 * @param frameSource one of FRAME_SOURCE_GL, FRAME_SOURCE_MEMORY, FRAME_SOURCE_SYNTHETIC,
+	 * 				FRAME_SOURCE_MJPEG
+	 */
+	public void setFrameSource(final int frameSource) {
+		mFrameSource = frameSource;
+	}
+
+	/**
+	 * use image file or synthetic pattern as frame source, this should be called before #start
+	 * @param path raw RGBA frames with processing size(*.rgba) or image file,
+	 * 				null to generate synthetic pattern
+	 * @param fps frame rate, zero means as fast as native side can process
+	 */
+	public void setSyntheticFrameSource(final String path, final float fps) {
+		mFrameSource = FRAME_SOURCE_SYNTHETIC;
+		final int result = nativeSetSyntheticSource(mNativePtr, path, fps);
+		if (result != 0) {
+			throw new IllegalStateException("nativeSetSyntheticSource:result=" + result);
+		}
+	}
+
+	/**
+	 * set frame queue between frame source and native worker thread,
+	 * this should be called before #start
+	 * @param queueSize max number of frames in frame queue
+	 * @param poolSize number of frames kept for re-use in addition to frame queue, at least 2
+	 * @param policy one of QUEUE_POLICY_DROP_OLDEST, QUEUE_POLICY_DROP_NEWEST, QUEUE_POLICY_BLOCK
+	 * @param timeoutMs max waiting time of frame source for QUEUE_POLICY_BLOCK[ms]
+	 */
+	public void setFrameQueue(final int queueSize, final int poolSize,
+		final int policy, final int timeoutMs) {
+
+		mQueueSize = queueSize;
+		mPoolSize = poolSize;
+		mQueuePolicy = policy;
+		mBlockTimeoutMs = timeoutMs;
+	}
+
+	/**
+	 * set flags for the arena that serves native frame buffers,
+	 * this should be called before #start
+	 * @param flags combination of ARENA_FLAG_HUGE_PAGES and ARENA_FLAG_ASSERT_NO_ALLOC
+	 */
+	public void setArenaFlags(final int flags) {
+		final int result = nativeSetArenaFlags(mNativePtr, flags);
+		if (result != 0) {
+			throw new IllegalStateException("nativeSetArenaFlags:result=" + result);
+		}
+	}
+
+	/**
+	 * set region of interest to read back, cost of readback and copying scales with this region.
+	 * this can be called anytime and is applied to later frames.
+	 * coordinates are those of the processing size passed to #start, as stored in native frame
+	 * (bottom-up rows for frames read back from OpenGL|ES).
+	 * result frame keeps the processing size and only the region is updated.
+	 * @param x
+	 * @param y
+	 * @param width zero to read back full frame
+	 * @param height zero to read back full frame
+	 */
+	public void setReadbackRoi(final int x, final int y, final int width, final int height) {
+		final int result = nativeSetReadbackRoi(mNativePtr, x, y, width, height);
+		if (result != 0) {
+			throw new IllegalStateException("nativeSetReadbackRoi:result=" + result);
+		}
+	}
+
+	/**
+	 * set priority and frame budget of this instance(camera) on native worker threads
+	 * that are shared by all ImageProcessor instances, this can be called anytime
+	 * @param priority larger value is served first, default is 0
+	 * @param budgetFps max number of frames per second that are processed, zero means unlimited
+	 */
+	public void setPriority(final int priority, final float budgetFps) {
+		final int result = nativeSetPriority(mNativePtr, priority, budgetFps);
+		if (result != 0) {
+			throw new IllegalStateException("nativeSetPriority:result=" + result);
+		}
+	}
+
+	/**
+	 * get per instance and aggregate throughput of shared native worker threads
+	 * @param stats array to receive stats, if null or too short new array is allocated
+	 * @return array of stats, see SCHEDULER_STATS_IX_XXX
+	 */
+	public long[] getSchedulerStats(final long[] stats) {
+		final long[] result = (stats != null) && (stats.length >= SCHEDULER_STATS_NUM)
+			? stats : new long[SCHEDULER_STATS_NUM];
+		nativeGetSchedulerStats(mNativePtr, result);
+		return result;
+	}
+
+	/**
+	 * set native processing stages as comma separated stage names(e.g. "gray,rgba"),
+	 * this can be called anytime and new stages are applied from next frame while running.
+	 * detectors follow gray scale stage(e.g. "gray_rgba,line" or "gray_rgba,curve"),
+	 * "color" needs RGBA frame and outputs mask of the color(e.g. "color,line", see #setExtractionColor),
+	 * "motion" skips following stages while nothing moves(e.g. "motion,gray_rgba,line"),
+	 * put it last to get only motion results,
+	 * "klt" tracks features and reports global motion of the frame(e.g. "gray_rgba,klt"),
+	 * "dense_flow" computes dense optical flow on downscaled frame(see #setDenseFlow, #getDenseFlow)
+	 * @param spec null or empty string means DEFAULT_PIPELINE
+	 * @throws IllegalStateException spec contains unknown stage
+	 */
+	public void setPipeline(final String spec) {
+		setPipeline(spec, DEFAULT_STAGE_QUEUE_DEPTH);
+	}
+
+	/**
+	 * set native processing stages, stages separated by '|' instead of ','
+	 * run on their own thread(e.g. "gray|rgba") so that next frame can be processed
+	 * by earlier stages while later stages process current frame.
+	 * results are still passed to callback in the order of the frames.
+	 * @param spec null or empty string means DEFAULT_PIPELINE
+	 * @param queueDepth max number of frames that can wait between threads, [1, 8]
+	 * @throws IllegalStateException spec contains unknown stage or too many stages/threads
+	 */
+	public void setPipeline(final String spec, final int queueDepth) {
+		final int result = nativeSetPipeline(mNativePtr, spec, queueDepth);
+		if (result != 0) {
+			throw new IllegalStateException("nativeSetPipeline:result=" + result);
+		}
+	}
+
+	/**
+	 * get processing stats of each stage of current pipeline
+	 * @param stats array to receive stats, if null or too short new array is allocated
+	 * @return array of stats, STAGE_STATS_NUM values for each stage, see STAGE_STATS_IX_XXX
+	 */
+	public long[] getStageStats(final long[] stats) {
+		final int n = PIPELINE_MAX_STAGES * STAGE_STATS_NUM;
+		final long[] result = (stats != null) && (stats.length >= n)
+			? stats : new long[n];
+		nativeGetStageStats(mNativePtr, result);
+		return result;
+	}
+
+	/**
+	 * set number of native worker threads shared by all ImageProcessor instances,
+	 * this is applied when first instance starts(i.e. no instance is running)
+	 * @param numThreads zero means number of cpu cores
+	 */
+	public static void setWorkerThreads(final int numThreads) {
+		nativeSetSchedulerThreads(numThreads);
+	}
+
+	/**
+	 * set number of native threads that process horizontal tiles of per-pixel stages
+	 * in addition to the thread that runs the stage, shared by all ImageProcessor instances
+	 * @param numThreads negative value means number of cpu cores - 1, zero disables tiling
+	 */
+	public static void setTileThreads(final int numThreads) {
+		nativeSetTileThreads(numThreads);
+	}
+
+	/**
+	 * get frame counters since #start
+	 * @param stats array to receive counters, if null or too short new array is allocated
+	 * @return array of counters, see FRAME_STATS_IX_XXX
+	 */
+	public long[] getFrameStats(final long[] stats) {
+		final long[] result = (stats != null) && (stats.length >= FRAME_STATS_NUM)
+			? stats : new long[FRAME_STATS_NUM];
+		nativeGetFrameStats(mNativePtr, result);
+		return result;
+	}
+
+	/**
+	 * set callback listener to receive per-frame information
+	 * @param callback null to remove
+	 */
+	public void setFrameInfoCallback(final FrameInfoCallback callback) {
+		mFrameInfoCallback = callback;
+	}
+
+	/**
+	 * pass raw RGBA image to native side when frame source is FRAME_SOURCE_MEMORY
+	 * @param frame direct ByteBuffer
+	 * @param width
+	 * @param height
+	 * @param stride row stride[bytes], zero means width * 4
+	 * @return 0: queued, 1: dropped, negative value: error
+	 */
+	public int handleBuffer(final ByteBuffer frame,
+		final int width, final int height, final int stride) {
+
+		return handleBuffer(frame, width, height, stride, 0);
+	}
+
+	/**
+	 * pass raw RGBA image to native side when frame source is FRAME_SOURCE_MEMORY
+	 * @param frame direct ByteBuffer
+	 * @param width
+	 * @param height
+	 * @param stride row stride[bytes], zero means width * 4
+	 * @param timestampNs timestamp of the image[ns],
+	 * 				it is passed through as FRAME_INFO_IX_SOURCE_TIMESTAMP
+	 * @return 0: queued, 1: dropped, negative value: error
+	 */
+	public int handleBuffer(final ByteBuffer frame,
+		final int width, final int height, final int stride, final long timestampNs) {
+
+		return nativeHandleBuffer(mNativePtr, frame, width, height, stride, timestampNs,
+			PIXEL_FORMAT_RGBA);
+	}
+
+	/**
+	 * pass raw frame of camera(e.g. frame callback of UVCCamera) to native side
+	 * without OpenGL|ES when frame source is FRAME_SOURCE_MEMORY(or FRAME_SOURCE_MJPEG for MJPEG).
+	 * YUV/JPEG image is converted only as far as native processing needs, see #setLumaOnly
+	 * @param frame direct ByteBuffer
+	 * @param width
+	 * @param height
+	 * @param stride row stride(Y plane for NV21)[bytes], zero means packed
+	 * @param timestampNs timestamp of the image[ns],
+	 * 				it is passed through as FRAME_INFO_IX_SOURCE_TIMESTAMP
+	 * @param format one of PIXEL_FORMAT_XXX
+	 * @return 0: queued, 1: dropped, negative value: error
+	 */
+	public int handleBuffer(final ByteBuffer frame,
+		final int width, final int height, final int stride, final long timestampNs,
+		final int format) {
+
+		return nativeHandleBuffer(mNativePtr, frame, width, height, stride, timestampNs, format);
+	}
+
+	/**
+	 * whether or not YUV/JPEG image is passed to native processing as luminance only,
+	 * this should be called before #start. default is true
+	 * @param lumaOnly set false if native processing needs color
+	 */
+	public void setLumaOnly(final boolean lumaOnly) {
+		final int result = nativeSetLumaOnly(mNativePtr, lumaOnly);
+		if (result != 0) {
+			throw new IllegalStateException("nativeSetLumaOnly:result=" + result);
+		}
+	}
+
 	/**
 	 * stop worker thread for ImageProcessor
 	 */
@@ -188,21 +683,29 @@ public class ImageProcessor {
 		return mResultFps.getTotalFps();
 	}
 //================================================================================
-	// type of result image(currently these values are just ignored on native side)
-	// should match values on native side.
+	// type of result image, should match values on native side.
+	/** no result image, only result values are passed and ImageProcessorCallback#onFrame is not called */
+	public static final int RESULT_FRAME_TYPE_NON = 0;
 	/** result is src image */
-	public static final int RESULT_FRAME_TYPE_SRC = 0;
+	public static final int RESULT_FRAME_TYPE_SRC = 1;
 	/** result is after image processing image */
-	public static final int RESULT_FRAME_TYPE_DST = 1;
+	public static final int RESULT_FRAME_TYPE_DST = 2;
 	/** result is src image with drawing something */
-	public static final int RESULT_FRAME_TYPE_SRC_LINE = 2;
-	/** result is after image processing image with drawing something */
-	public static final int RESULT_FRAME_TYPE_DST_LINE = 3;
+	public static final int RESULT_FRAME_TYPE_SRC_LINE = 3;
+	/** result is after image processing image with drawing something(default) */
+	public static final int RESULT_FRAME_TYPE_DST_LINE = 4;
+
+	// pixel format of result image, should match values on native side.
+	/** 4 bytes per pixel, RGBA */
+	public static final int RESULT_FORMAT_RGBA = 0;
+	/** 1 byte per pixel, gray scale */
+	public static final int RESULT_FORMAT_GRAY = 1;
 
 	/**
 	 * request to change result image type
-	 * value is just ignored on native side now
-	 * @param result_frame_type
+	 * result image is not built at all for RESULT_FRAME_TYPE_NON,
+	 * this is applied from next frame
+	 * @param result_frame_type RESULT_FRAME_TYPE_XXX
 	 */
 	public void setResultFrameType(final int result_frame_type) {
 		final int result = nativeSetResultFrameType(mNativePtr, result_frame_type);
@@ -211,6 +714,133 @@ public class ImageProcessor {
 		}
 	}
 
+	/**
+	 * request to change pixel format of result image passed to ImageProcessorCallback#onFrame,
+	 * RESULT_FORMAT_GRAY reduces the size of the result to 1/4 of RESULT_FORMAT_RGBA.
+	 * this is applied from next frame, check FRAME_INFO_IX_RESULT_FORMAT of each frame
+	 * @param resultFormat RESULT_FORMAT_RGBA(default) or RESULT_FORMAT_GRAY
+	 */
+	public void setResultFormat(final int resultFormat) {
+		final int result = nativeSetResultFormat(mNativePtr, resultFormat);
+		if (result != 0) {
+			throw new IllegalStateException("nativeSetResultFormat:result=" + result);
+		}
+	}
+
+	/**
+	 * set interval of full(whole frame) detection of tracking stages("line", "curve"),
+	 * they search only around tracked object between full detections.
+	 * full detection also runs when tracking is lost regardless of this interval.
+	 * @param interval [frames], 0(default) means full detection runs only when tracking is lost
+	 * @throws IllegalStateException interval is out of range [0, 1000]
+	 */
+	public void setDetectInterval(final int interval) {
+		setStageParameter("line", "detect_interval", interval);
+		setStageParameter("curve", "detect_interval", interval);
+	}
+
+	/**
+	 * skip native stages for the frames that are same as last processed frame(e.g. static scene),
+	 * results of last processed frame are passed again for those frames without result image.
+	 * frames are compared by mean luminance of 32x24 blocks and the frame is processed anyway
+	 * after 30 unchanged frames. this can be called anytime and applied from next frame.
+	 * @param threshold frames are unchanged when difference of every block is less than this,
+	 * 	0(default) disables the check
+	 * @throws IllegalStateException threshold is out of range [0, 255]
+	 */
+	public void setUnchangedThreshold(final int threshold) {
+		final int result = nativeSetUnchangedThreshold(mNativePtr, threshold);
+		if (result != 0) {
+			throw new IllegalStateException("nativeSetUnchangedThreshold:result=" + result);
+		}
+	}
+
+	/**
+	 * set parameters of "dense_flow" stage, this can be called anytime and applied from next frame.
+	 * flow is always the motion from previous frame regardless of the interval
+	 * @param width width of downscaled frame that flow is computed on[px], default is 160
+	 * @param interval flow is computed every interval frames, default is 1
+	 * @param gridCols gridRows number of the cells that flow is averaged in, default is 16x12,
+	 * 	0 means flow of each pixel of downscaled frame
+	 * @throws IllegalStateException width is out of range [16, 320], interval is out of range [1, 1000]
+	 * 	or gridCols/gridRows is out of range [0, 64]
+	 */
+	public void setDenseFlow(final int width, final int interval, final int gridCols, final int gridRows) {
+		setStageParameter("dense_flow", "flow", width, interval, gridCols, gridRows);
+	}
+
+	/**
+	 * set region of the full frame that "dense_flow" stage computes flow,
+	 * this can be called anytime and applied from next frame
+	 * @param width height zero or negative value means whole frame(default)
+	 */
+	public void setDenseFlowRoi(final int x, final int y, final int width, final int height) {
+		setStageParameter("dense_flow", "roi", x, y, width, height);
+	}
+
+	/**
+	 * get latest flow of "dense_flow" stage
+	 * @param flow receives number of cells in x and y direction(cols, rows)
+	 * 	followed by (dx, dy) of each cell in row major order[px]
+	 * 	so that 2 + cols * rows * 2 values are needed.
+	 * 	only first values are set if the array is too short
+	 * @return sequence number of the frame of the flow,
+	 * 	-1 if no flow is computed yet, the pipeline does not have "dense_flow" or the array is too short
+	 */
+	public long getDenseFlow(final float[] flow) {
+		synchronized (mFlowSeq) {
+			final int n = getStageResult("dense_flow", "flow", flow, mFlowSeq);
+			return (n > 0) && (n <= flow.length) ? mFlowSeq[0] : -1;
+		}
+	}
+
+	/**
+	 * set range of the color that "color" stage extracts as HSV of OpenCV(same as Imgproc.COLOR_RGB2HSV),
+	 * default is white(H 0-179, S 0-64, V 192-255). this can be called anytime and returns immediately,
+	 * lookup table of the color is built on native thread and applied to the frames after it is built,
+	 * processing never waits for it.
+	 * @param hMin hMax hue [0, 180), range wraps around if hMin > hMax(e.g. red)
+	 * @param sMin sMax saturation [0, 255]
+	 * @param vMin vMax value [0, 255]
+	 * @throws IllegalStateException invalid range
+	 */
+	public void setExtractionColor(final int hMin, final int hMax,
+		final int sMin, final int sMax, final int vMin, final int vMax) {
+
+		setStageParameter("color", "color", hMin, hMax, sMin, sMax, vMin, vMax);
+	}
+
+	/**
+	 * set parameter of the stages of the name, this can be called anytime and applied from next frame.
+	 * the parameter is kept and also applied to the pipeline that is set later(#setPipeline),
+	 * so this can be called for the stage that is not in current pipeline.
+	 * parameters of each stage are described in its native header, e.g. IPDenseFlow.h
+	 * @param stage name of the stage, e.g. "dense_flow"
+	 * @param key name of the parameter, e.g. "flow"
+	 * @param values
+	 * @throws IllegalStateException unknown stage, unknown key or invalid values
+	 */
+	public void setStageParameter(final String stage, final String key, final float... values) {
+		final int result = nativeSetStageParameter(mNativePtr, stage, key, values);
+		if (result != 0) {
+			throw new IllegalStateException("nativeSetStageParameter:result=" + result);
+		}
+	}
+
+	/**
+	 * get latest result of the stage of the name in current pipeline that does not fit in the result array
+	 * passed to the callback(e.g. "flow" of "dense_flow", see #getDenseFlow)
+	 * @param stage name of the stage
+	 * @param key name of the result
+	 * @param values receives the result, only first values are set if the array is too short
+	 * @param seq receives sequence number of the frame of the result at seq[0] if it is not null
+	 * @return number of the values of the result, 0 if no result yet,
+	 * 	-1 if current pipeline does not have the stage or the result
+	 */
+	public int getStageResult(final String stage, final String key, final float[] values, final long[] seq) {
+		return nativeGetStageResult(mNativePtr, stage, key, values, seq);
+	}
+
 	/**
 	 * get result image type
 	 * @return
@@ -232,12 +862,14 @@ public class ImageProcessor {
 	 * @param type
 	 * @param frame
 	 * @param result
+	 * @param frameInfo
 	 */
 	private static void callFromNative(final WeakReference<ImageProcessor> weakSelf,
-		final int type, final ByteBuffer frame, final float[] result) {
+		final int type, final ByteBuffer frame, final float[] result, final long[] frameInfo) {
 		final ImageProcessor self = weakSelf != null ? weakSelf.get() : null;
 		if (self != null) {
 			try {
+				self.handleFrameInfo(frameInfo);
 				self.handleResult(type, result);
 				if (frame != null) {
 					self.handleOpenCVFrame(frame);
@@ -248,6 +880,21 @@ public class ImageProcessor {
 		}
 	}
 
+	/**
+	 * actual callback method when receive per-frame information
+	 * @param frameInfo
+	 */
+	private void handleFrameInfo(final long[] frameInfo) {
+		final FrameInfoCallback callback = mFrameInfoCallback;
+		if ((callback != null) && (frameInfo != null)) {
+			try {
+				callback.onFrameInfo(frameInfo);
+			} catch (final Exception e) {
+				Log.w(TAG, e);
+			}
+		}
+	}
+
 	/**
 	 * actual callback method when receive something processing result as float array
 	 * @param result
@@ -277,18 +924,22 @@ public class ImageProcessor {
 		private final int WIDTH, HEIGHT;
 		/** size of processing images */
 		private int mVideoWidth, mVideoHeight;
+		/** number of PBOs for asynchronous readback */
+		private final int mReadbackDepth;
 		private GLDrawer2D mSrcDrawer;
 		private MediaSource mMediaSource;
 
 		public ProcessingTask(final ImageProcessor parent,
 			final int src_width, final int src_height,
-			final int video_width, final int video_height) {
+			final int video_width, final int video_height,
+			final int readback_depth) {
 			
 			super(null, 0);
 			WIDTH = src_width;
 			HEIGHT = src_height;
 			mVideoWidth = video_width;
 			mVideoHeight = video_height;
+			mReadbackDepth = readback_depth;
 		}
 
 		public Surface getSurface() {
@@ -316,7 +967,9 @@ public class ImageProcessor {
 			}
 			handleResize(mVideoWidth, mVideoHeight);
 			// start image processing on native side
-			nativeStart(mNativePtr, mVideoWidth, mVideoHeight);
+			nativeStart(mNativePtr, mVideoWidth, mVideoHeight,
+				mFrameSource, mReadbackDepth, mZeroCopyReadback,
+				mQueueSize, mPoolSize, mQueuePolicy, mBlockTimeoutMs);
 			synchronized (mSync) {
 				isProcessingRunning = true;
 				mSync.notifyAll();
@@ -405,7 +1058,12 @@ public class ImageProcessor {
 				Log.e(TAG, "ProcessingTask#draw:thread id =" + Thread.currentThread().getId(), e);
 				return;
 			}
-			mMediaSource.setSource(mSrcDrawer, mTexId, mTexMatrix);
+			// backpressure, if native worker thread is still busy,
+			// skip rendering and readback of this frame
+			final boolean readback = !nativeIsBusy(mNativePtr);
+			if (readback) {
+				mMediaSource.setSource(mSrcDrawer, mTexId, mTexMatrix);
+			}
 //--------------------------------------------------------------------------------
 // there is gl context and you can use OpenGL|ES functions here
 // Most functions on OpenCV is relatively heavy on most of Android devices
@@ -415,7 +1073,8 @@ public class ImageProcessor {
 //--------------------------------------------------------------------------------
 			// pass image to native side(as cv::mat)
 			mMediaSource.getOutputTexture().bind();
-			nativeHandleFrame(mNativePtr, mVideoWidth, mVideoHeight, 0);
+			nativeHandleFrame(mNativePtr, mVideoWidth, mVideoHeight, 0,
+				mSourceTexture.getTimestamp(), readback);
 			mMediaSource.getOutputTexture().unbind();
 			// workaround to avoid hung-up
 			makeCurrent();
@@ -466,11 +1125,39 @@ public class ImageProcessor {
 	private native void nativeRelease(final long id_native);
 
 	private static native int nativeStart(final long id_native,
-		final int width, final int height);
+		final int width, final int height, final int frame_source,
+		final int readback_depth, final boolean zero_copy,
+		final int queue_size, final int pool_size, final int queue_policy, final int block_timeout_ms);
 	private static native int nativeStop(final long id_native);
 	private static native int nativeHandleFrame(final long id_native,
-		final int width, final int height, final int tex_name);
+		final int width, final int height, final int tex_name, final long timestamp_ns,
+		final boolean readback);
+	private static native boolean nativeIsBusy(final long id_native);
+	private static native int nativeHandleBuffer(final long id_native,
+		final ByteBuffer frame, final int width, final int height, final int stride,
+		final long timestamp_ns, final int format);
+	private static native int nativeSetLumaOnly(final long id_native, final boolean luma_only);
+	private static native int nativeSetSyntheticSource(final long id_native,
+		final String path, final float fps);
+	private static native int nativeSetArenaFlags(final long id_native, final int flags);
+	private static native int nativeGetFrameStats(final long id_native, final long[] stats);
+	private static native int nativeSetPriority(final long id_native,
+		final int priority, final float budget_fps);
+	private static native int nativeGetSchedulerStats(final long id_native, final long[] stats);
+	private static native int nativeSetSchedulerThreads(final int num_threads);
+	private static native int nativeSetTileThreads(final int num_threads);
+	private static native int nativeSetPipeline(final long id_native,
+		final String spec, final int queue_depth);
+	private static native int nativeGetStageStats(final long id_native, final long[] stats);
+	private static native int nativeSetReadbackRoi(final long id_native,
+		final int x, final int y, final int width, final int height);
 	private static native int nativeSetResultFrameType(final long id_native,
 		final int showDetects);
 	private static native int nativeGetResultFrameType(final long id_native);
+	private static native int nativeSetResultFormat(final long id_native, final int result_format);
+	private static native int nativeSetUnchangedThreshold(final long id_native, final int threshold);
+	private static native int nativeSetStageParameter(final long id_native,
+		final String stage, final String key, final float[] values);
+	private static native int nativeGetStageResult(final long id_native,
+		final String stage, final String key, final float[] values, final long[] seq);
 }
@@ -38,6 +38,7 @@ LOCAL_SRC_FILES := \
 	JNIHelp.cpp \
 	JniConstants.cpp \
 	Timers.cpp \
+	WorkStealingPool.cpp \
 
 LOCAL_CFLAGS := $(LOCAL_C_INCLUDES:%=-I%)
 #マクロ定義
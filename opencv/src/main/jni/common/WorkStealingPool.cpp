@@ -0,0 +1,352 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+#define LOG_TAG "WorkStealingPool"
+#ifndef LOG_NDEBUG
+#define	LOG_NDEBUG
+#endif
+#undef USE_LOGALL
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <algorithm>
+
+#include "utilbase.h"
+#include "WorkStealingPool.h"
+
+typedef struct worker_args {
+	WorkStealingPool *pool;
+	int index;
+} worker_args_t;
+
+/** process-wide instance */
+/*public static*/
+WorkStealingPool &WorkStealingPool::getInstance() {
+	static WorkStealingPool instance;
+	return instance;
+}
+
+/*private*/
+WorkStealingPool::WorkStealingPool()
+:	mIsRunning(false),
+	mRequestThreads(-1),
+	mNumThreads(0),
+	mTask(NULL),
+	mGrain(1),
+	mGeneration(0),
+	mActive(0),
+	mRemaining(0),
+	mFailed(false) {
+
+	ENTER();
+
+	for (int i = 0; i <= WORK_STEALING_MAX_THREADS; i++) {
+		mSlots[i].begin = mSlots[i].end = 0;
+	}
+
+	EXIT();
+}
+
+WorkStealingPool::~WorkStealingPool() {
+	ENTER();
+
+	Mutex::Autolock lock(mJobLock);
+	stopThreads();
+
+	EXIT();
+}
+
+/**
+ * set number of worker threads, caller thread of #parallelFor also executes the loop
+ * so that one less than number of cores is appropriate.
+ * threads are started on next #parallelFor
+ * @param num_threads negative value means number of cpu cores - 1, zero means no worker thread
+ */
+void WorkStealingPool::setNumThreads(const int &num_threads) {
+	ENTER();
+
+	// wait for current loop
+	Mutex::Autolock lock(mJobLock);
+	if (num_threads != mRequestThreads) {
+		stopThreads();
+		mRequestThreads = num_threads;
+	}
+
+	EXIT();
+}
+
+/** number of threads that execute the loop including caller thread */
+const int WorkStealingPool::getNumThreads() {
+	Mutex::Autolock lock(mJobLock);
+	int num = mRequestThreads >= 0 ? mRequestThreads : (int)sysconf(_SC_NPROCESSORS_ONLN) - 1;
+	return std::min(std::max(num, 0), WORK_STEALING_MAX_THREADS) + 1;
+}
+
+/** call this with mJobLock held */
+/*private*/
+void WorkStealingPool::startThreads() {
+	ENTER();
+
+	int num = mRequestThreads >= 0 ? mRequestThreads : (int)sysconf(_SC_NPROCESSORS_ONLN) - 1;
+	num = std::min(std::max(num, 0), WORK_STEALING_MAX_THREADS);
+	mIsRunning = true;
+	mNumThreads = 0;
+	for (int i = 0; i < num; i++) {
+		worker_args_t *args = new worker_args_t;
+		args->pool = this;
+		args->index = i + 1;
+		if (UNLIKELY(pthread_create(&mThreads[mNumThreads], NULL, worker_thread_func, (void *)args))) {
+			LOGE("pthread_create failed");
+			delete args;
+			break;
+		}
+		mNumThreads++;
+	}
+	LOGI("started %d worker threads", mNumThreads);
+
+	EXIT();
+}
+
+/** call this with mJobLock held */
+/*private*/
+void WorkStealingPool::stopThreads() {
+	ENTER();
+
+	mLock.lock();
+	{
+		mIsRunning = false;
+		mSync.broadcast();
+	}
+	mLock.unlock();
+	for (int i = 0; i < mNumThreads; i++) {
+		if (pthread_join(mThreads[i], NULL) != EXIT_SUCCESS) {
+			LOGW("terminate worker thread: pthread_join failed");
+		}
+	}
+	mNumThreads = 0;
+
+	EXIT();
+}
+
+/**
+ * execute task for [begin, end) on caller thread and worker threads and
+ * return after all iterations finished.
+ * return 0 if success, -1 if the task threw exception(rest of iterations are still executed)
+ * @param grain min number of iterations that is executed at once
+ */
+int WorkStealingPool::parallelFor(const int &begin, const int &end, const int &grain,
+	WorkStealingTask &task) {
+
+	ENTER();
+
+	const int n = end - begin;
+	const int g = std::max(grain, 1);
+	if (UNLIKELY(n <= 0)) {
+		RETURN(0, int);
+	}
+	if ((n <= g) || mJobLock.tryLock()) {
+		// too small to split or the pool is busy(other loop or nested call)
+		RETURN(execute(task, begin, end), int);
+	}
+	if (UNLIKELY(!mIsRunning)) {
+		startThreads();
+	}
+	const int num = std::min(mNumThreads + 1, (n + g - 1) / g);
+	if (num <= 1) {
+		mJobLock.unlock();
+		RETURN(execute(task, begin, end), int);
+	}
+	// divide the range into contiguous parts, aligned to grain
+	const int chunks = (n + g - 1) / g;
+	for (int i = 0; i <= mNumThreads; i++) {
+		work_slot_t &slot = mSlots[i];
+		Mutex::Autolock lock(slot.lock);
+		if (i < num) {
+			slot.begin = std::min(begin + (int)((int64_t)chunks * i / num) * g, end);
+			slot.end = std::min(begin + (int)((int64_t)chunks * (i + 1) / num) * g, end);
+		} else {
+			slot.begin = slot.end = end;
+		}
+	}
+	mLock.lock();
+	{
+		mTask = &task;
+		mGrain = g;
+		mRemaining = n;
+		mFailed = false;
+		mGeneration++;
+		mSync.broadcast();
+	}
+	mLock.unlock();
+	participate(0);
+	mLock.lock();
+	{
+		// wait until all iterations finished and no worker thread refers current loop
+		for ( ; (mRemaining > 0) || (mActive > 0) ; ) {
+			mDone.wait(mLock);
+		}
+		mTask = NULL;
+	}
+	mLock.unlock();
+	const int result = mFailed ? -1 : 0;
+	mJobLock.unlock();
+
+	RETURN(result, int);
+}
+
+/**
+ * execute the task and catch exception so that it never escapes from worker thread
+ */
+/*private*/
+int WorkStealingPool::execute(WorkStealingTask &task, const int &begin, const int &end) {
+	try {
+		task.run(begin, end);
+	} catch (...) {
+		LOGE("task failed:[%d,%d)", begin, end);
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * execute own part of the loop and then steal from others until nothing remains
+ */
+/*private*/
+void WorkStealingPool::participate(const int &index) {
+	int begin, end;
+	for ( ; ; ) {
+		if (take(index, begin, end)) {
+			if (UNLIKELY(execute(*mTask, begin, end))) {
+				mFailed = true;
+			}
+			if (__sync_sub_and_fetch(&mRemaining, end - begin) == 0) {
+				Mutex::Autolock lock(mLock);
+				mDone.broadcast();
+			}
+		} else if (!steal(index)) {
+			break;
+		}
+	}
+}
+
+/**
+ * take one grain from the front of own part
+ */
+/*private*/
+bool WorkStealingPool::take(const int &index, int &begin, int &end) {
+	work_slot_t &slot = mSlots[index];
+	Mutex::Autolock lock(slot.lock);
+	if (slot.begin < slot.end) {
+		begin = slot.begin;
+		end = std::min(begin + mGrain, (int)slot.end);
+		slot.begin = end;
+		return true;
+	}
+	return false;
+}
+
+/**
+ * steal back half of the largest remaining part of other threads into own part
+ * return false if nothing remains
+ */
+/*private*/
+bool WorkStealingPool::steal(const int &index) {
+	for ( ; ; ) {
+		// choose victim that has most iterations, this is just a hint without lock
+		int victim = -1, max_remaining = 0;
+		for (int i = 0; i <= mNumThreads; i++) {
+			const int remaining = mSlots[i].end - mSlots[i].begin;
+			if ((i != index) && (remaining > max_remaining)) {
+				victim = i;
+				max_remaining = remaining;
+			}
+		}
+		if (victim < 0) {
+			return false;
+		}
+		int begin, end;
+		{
+			work_slot_t &slot = mSlots[victim];
+			Mutex::Autolock lock(slot.lock);
+			const int remaining = slot.end - slot.begin;
+			if (remaining <= 0) {
+				// victim finished while choosing, try again
+				continue;
+			}
+			// leave at least front half(and the grain that victim may take next) to victim
+			const int n = remaining > mGrain ? std::max(remaining / 2, mGrain) : remaining;
+			end = slot.end;
+			begin = end - n;
+			slot.end = begin;
+		}
+		work_slot_t &own = mSlots[index];
+		Mutex::Autolock lock(own.lock);
+		own.begin = begin;
+		own.end = end;
+		return true;
+	}
+}
+
+/** static member thread function */
+/*private*/
+void *WorkStealingPool::worker_thread_func(void *vptr_args) {
+	ENTER();
+
+	worker_args_t *args = reinterpret_cast<worker_args_t *>(vptr_args);
+	if (LIKELY(args)) {
+		WorkStealingPool *pool = args->pool;
+		const int index = args->index;
+		delete args;
+		pool->do_work(index);
+	}
+
+	PRE_EXIT();
+	pthread_exit(NULL);
+}
+
+/*private*/
+void WorkStealingPool::do_work(const int &index) {
+	ENTER();
+
+	int generation = 0;
+	mLock.lock();
+	for ( ; mIsRunning ; ) {
+		if (!mTask || (generation == mGeneration)) {
+			mSync.wait(mLock);
+			continue;
+		}
+		generation = mGeneration;
+		mActive++;
+		mLock.unlock();
+		{
+			participate(index);
+		}
+		mLock.lock();
+		if (--mActive == 0) {
+			mDone.broadcast();
+		}
+	}
+	mLock.unlock();
+
+	EXIT();
+}
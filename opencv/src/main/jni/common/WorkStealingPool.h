@@ -0,0 +1,109 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+#ifndef FLIGHTDEMO_WORKSTEALINGPOOL_H
+#define FLIGHTDEMO_WORKSTEALINGPOOL_H
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include "Mutex.h"
+#include "Condition.h"
+
+// upper limit of number of worker threads of the pool(not including caller thread)
+#define WORK_STEALING_MAX_THREADS 8
+#define WORK_STEALING_CACHE_LINE 64
+
+using namespace android;
+
+/**
+ * body of parallel loop, #run is called for disjoint sub ranges of the loop
+ * on caller thread and worker threads simultaneously
+ */
+class WorkStealingTask {
+public:
+	virtual ~WorkStealingTask() {};
+	virtual void run(const int &begin, const int &end) = 0;
+};
+
+/**
+ * process-wide pool of threads that executes parallel loop.
+ * the range of the loop is divided into contiguous parts for each thread(including caller thread),
+ * each thread executes its part by grain from the front and when its part is exhausted,
+ * it steals back half of the part of other thread so that fast(big) cores
+ * help slow(little) cores without fine grained scheduling.
+ * only one loop is executed on the pool at a time,
+ * if the pool is busy(e.g. other camera or nested call), the loop is executed on caller thread.
+ * This class does not depend on OpenCV.
+ */
+class WorkStealingPool {
+private:
+	// range of the loop that is owned by each thread, padded to avoid false sharing
+	typedef struct work_slot {
+		Mutex lock;
+		volatile int begin;
+		volatile int end;
+		uint8_t pad[WORK_STEALING_CACHE_LINE];
+	} work_slot_t;
+
+	// serialize loops
+	Mutex mJobLock;
+	// guard for members below
+	Mutex mLock;
+	Condition mSync;
+	Condition mDone;
+	volatile bool mIsRunning;
+	int mRequestThreads;
+	int mNumThreads;
+	pthread_t mThreads[WORK_STEALING_MAX_THREADS];
+	// current loop
+	WorkStealingTask *mTask;
+	int mGrain;
+	int mGeneration;
+	// number of worker threads that are executing current loop
+	int mActive;
+	// number of iterations of current loop that are not executed yet
+	volatile int mRemaining;
+	// set when the task threw exception
+	volatile bool mFailed;
+	// slot 0 is used by caller thread
+	work_slot_t mSlots[WORK_STEALING_MAX_THREADS + 1];
+
+	WorkStealingPool();
+	void startThreads();
+	void stopThreads();
+	void participate(const int &index);
+	int execute(WorkStealingTask &task, const int &begin, const int &end);
+	bool take(const int &index, int &begin, int &end);
+	bool steal(const int &index);
+	static void *worker_thread_func(void *vptr_args);
+	void do_work(const int &index);
+public:
+	virtual ~WorkStealingPool();
+	static WorkStealingPool &getInstance();
+	void setNumThreads(const int &num_threads);
+	const int getNumThreads();
+	int parallelFor(const int &begin, const int &end, const int &grain, WorkStealingTask &task);
+};
+
+#endif //FLIGHTDEMO_WORKSTEALINGPOOL_H
@@ -0,0 +1,125 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+
+/*
+ * host test of the gray scale kernels of IPColorKernels,
+ * SIMD path must be bit-exact to scalar reference that is same as cv::cvtColor of OpenCV 3.2.
+ * this is built twice, color_kernels_test uses SIMD of host(SSE2 on x86)
+ * and color_kernels_neon_test uses NEON path with scalar emulation of arm_neon.h(see neon/arm_neon.h).
+ */
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include "IPColorKernels.h"
+#include "host_test.h"
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+	#define KERNEL_PATH "neon"
+#elif defined(__SSE2__)
+	#define KERNEL_PATH "sse2"
+#else
+	#define KERNEL_PATH "scalar"
+#endif
+
+// same table as RGB2Gray<uchar> of OpenCV 3.2
+static int gray_tab[256 * 3];
+
+static void init_gray_tab(void) {
+	int r = 1 << 13, g = 0, b = 0;
+	for (int i = 0; i < 256; i++, r += 4899, g += 9617, b += 1868) {
+		gray_tab[i] = r;
+		gray_tab[i + 256] = g;
+		gray_tab[i + 512] = b;
+	}
+}
+
+static void ref_gray(const uint8_t *src, uint8_t *gray, const int &n) {
+	for (int i = 0; i < n; i++, src += 4) {
+		gray[i] = (uint8_t)((gray_tab[src[0]] + gray_tab[src[1] + 256] + gray_tab[src[2] + 512]) >> 14);
+	}
+}
+
+static void ref_rgba(const uint8_t *gray, uint8_t *rgba, const int &n) {
+	for (int i = 0; i < n; i++, rgba += 4) {
+		rgba[0] = rgba[1] = rgba[2] = gray[i];
+		rgba[3] = 0xff;
+	}
+}
+
+/** compare kernels with reference for n pixels, guard bytes after the output must not be written */
+static void check(const std::vector<uint8_t> &src, const int &n, const char *name) {
+	const int guard = 64;
+	std::vector<uint8_t> gray(n + guard, 0xa5), rgba(n * 4 + guard, 0xa5);
+	std::vector<uint8_t> expected_gray(n + guard, 0xa5), expected_rgba(n * 4 + guard, 0xa5);
+	ref_gray(&src[0], &expected_gray[0], n);
+	ref_rgba(&expected_gray[0], &expected_rgba[0], n);
+	// fused
+	rgba_to_gray_rgba(&src[0], &gray[0], &rgba[0], n);
+	if (memcmp(&gray[0], &expected_gray[0], gray.size()) || memcmp(&rgba[0], &expected_rgba[0], rgba.size())) {
+		fprintf(stderr, "%s n=%d: fused gray/rgba mismatch\n", name, n);
+		host_test_failures++;
+	}
+	// gray only
+	memset(&gray[0], 0xa5, gray.size());
+	rgba_to_gray_rgba(&src[0], &gray[0], NULL, n);
+	if (memcmp(&gray[0], &expected_gray[0], gray.size())) {
+		fprintf(stderr, "%s n=%d: gray mismatch\n", name, n);
+		host_test_failures++;
+	}
+	memset(&rgba[0], 0xa5, rgba.size());
+	gray_to_rgba(&expected_gray[0], &rgba[0], n);
+	if (memcmp(&rgba[0], &expected_rgba[0], rgba.size())) {
+		fprintf(stderr, "%s n=%d: gray_to_rgba mismatch\n", name, n);
+		host_test_failures++;
+	}
+}
+
+int main(int argc, char *argv[]) {
+	init_gray_tab();
+	const int max_n = 1920;
+	std::vector<uint8_t> random(max_n * 4), white(max_n * 4, 0xff), black(max_n * 4, 0);
+	for (size_t i = 0; i < random.size(); i++) {
+		random[i] = (uint8_t)((i * 2654435761u) >> 24);
+	}
+	// every value of each channel with others fixed, covers rounding boundaries
+	std::vector<uint8_t> ramp(256 * 3 * 4);
+	for (int c = 0; c < 3; c++) {
+		for (int v = 0; v < 256; v++) {
+			uint8_t *p = &ramp[(c * 256 + v) * 4];
+			p[0] = p[1] = p[2] = (uint8_t)(255 - v);
+			p[c] = (uint8_t)v;
+			p[3] = (uint8_t)v;
+		}
+	}
+	// lengths around the SIMD block of 16 pixels
+	for (int n = 0; n <= 70; n++) {
+		check(random, n, "random");
+	}
+	check(random, max_n, "random");
+	check(white, max_n, "white");
+	check(black, max_n, "black");
+	check(ramp, 256 * 3, "ramp");
+	return TEST_RESULT("color_kernels_test(" KERNEL_PATH ")");
+}
@@ -0,0 +1,193 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+
+/*
+ * host test of the curve detector(IPCurveDetector) on synthetic gray scale frames.
+ * checks that full detection finds the curve along rows and along columns, also among clutter,
+ * that tracking follows the shifted curve without full search,
+ * and that reported coefficients are in pixels relative to the center of the region of interest.
+ * overlay is not drawn(RESULT_FRAME_TYPE_NON), so no drawing function of OpenCV is needed.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "IPCurveDetector.h"
+#include "host_test.h"
+
+#define WIDTH 256
+#define HEIGHT 192
+#define BACK 40
+#define FORE 220
+#define LINE_WIDTH 6
+// allowed distance between reported curve and drawn curve[px]
+#define TOLERANCE 2.0f
+
+typedef struct test_curve {
+	float a, b, c, d;
+} test_curve_t;
+
+static inline float eval(const test_curve_t &c, const float &v) {
+	return ((c.a * v + c.b) * v + c.c) * v + c.d;
+}
+
+/**
+ * draw the curve u = f(v) relative to the center of the frame
+ * @param vertical true if u is x and v is y
+ */
+static void draw_curve(cv::Mat &gray, const test_curve_t &c, const bool &vertical) {
+	gray.create(HEIGHT, WIDTH, CV_8UC1);
+	memset(gray.data, BACK, gray.total());
+	const int len_v = vertical ? HEIGHT : WIDTH;
+	const int len_u = vertical ? WIDTH : HEIGHT;
+	for (int v = 0; v < len_v; v++) {
+		const int u = (int)lroundf(eval(c, v - len_v * 0.5f) + len_u * 0.5f);
+		for (int i = u - LINE_WIDTH / 2; i < u + LINE_WIDTH / 2; i++) {
+			if ((i >= 0) && (i < len_u)) {
+				if (vertical) {
+					gray.at<uint8_t>(v, i) = FORE;
+				} else {
+					gray.at<uint8_t>(i, v) = FORE;
+				}
+			}
+		}
+	}
+}
+
+static void init_ctx(stage_context_t &ctx) {
+	ctx.width = WIDTH;
+	ctx.height = HEIGHT;
+	ctx.roi = cv::Rect(0, 0, WIDTH, HEIGHT);
+	ctx.result_frame_type = RESULT_FRAME_TYPE_NON;
+	ctx.allocator = NULL;
+	ctx.unchanged = false;
+	ctx.result.release();
+	memset(ctx.results, 0, sizeof(ctx.results));
+	ctx.detect_type = TYPE_NON;
+}
+
+/** compare reported curve with drawn curve along whole frame */
+static bool matches(const stage_context_t &ctx, const test_curve_t &c, const bool &vertical) {
+	if ((ctx.detect_type != TYPE_CURVE)
+		|| (ctx.results[RESULT_IX_CURVE_AXIS] != (vertical ? 0.0f : 1.0f))) {
+		return false;
+	}
+	const test_curve_t found = {
+		ctx.results[RESULT_IX_CURVE_A], ctx.results[RESULT_IX_CURVE_B],
+		ctx.results[RESULT_IX_CURVE_C], ctx.results[RESULT_IX_CURVE_D],
+	};
+	const int len_v = vertical ? HEIGHT : WIDTH;
+	for (int v = -len_v / 2 + 8; v < len_v / 2 - 8; v += 8) {
+		if (fabsf(eval(found, (float)v) - eval(c, (float)v)) > TOLERANCE) {
+			fprintf(stderr, "v=%d,expected=%f,found=%f\n", v, eval(c, (float)v), eval(found, (float)v));
+			return false;
+		}
+	}
+	return true;
+}
+
+static void test_detect_and_track(const bool &vertical) {
+	IPCurveDetector detector;
+	stage_context_t ctx;
+	cv::Mat gray, dst;
+	test_curve_t c = { 0.0f, 0.002f, 0.1f, -20.0f };
+	if (!vertical) {
+		c.a = 1e-5f;
+	}
+
+	draw_curve(gray, c, vertical);
+	init_ctx(ctx);
+	TEST_ASSERT_EQ(0, detector.process(ctx, gray, dst));
+	TEST_ASSERT(dst.data == gray.data);
+	TEST_ASSERT(ctx.results[RESULT_IX_CURVE_FULL_SEARCH] == 1.0f);
+	TEST_ASSERT(ctx.results[RESULT_IX_CURVE_CONFIDENCE] >= CURVE_MIN_CONFIDENCE);
+	TEST_ASSERT(matches(ctx, c, vertical));
+
+	// curve moves a little on each frame, it is tracked without full search
+	for (int i = 0; i < 8; i++) {
+		c.d += 3.0f;
+		draw_curve(gray, c, vertical);
+		init_ctx(ctx);
+		TEST_ASSERT_EQ(0, detector.process(ctx, gray, dst));
+		TEST_ASSERT(ctx.results[RESULT_IX_CURVE_FULL_SEARCH] == 0.0f);
+		TEST_ASSERT(ctx.results[RESULT_IX_CURVE_CONFIDENCE] >= CURVE_MIN_CONFIDENCE);
+		TEST_ASSERT(matches(ctx, c, vertical));
+	}
+}
+
+static void test_clutter(void) {
+	IPCurveDetector detector;
+	stage_context_t ctx;
+	cv::Mat gray, dst;
+	const test_curve_t c = { 0.0f, -0.003f, -0.2f, 10.0f };
+	draw_curve(gray, c, true);
+	// bright blobs on some rows, their edges are stronger candidates than the curve on those rows
+	for (int y = 10; y < HEIGHT; y += 40) {
+		for (int j = y; j < y + 6; j++) {
+			memset(gray.ptr<uint8_t>(j) + 8, 255, 20);
+		}
+	}
+	init_ctx(ctx);
+	detector.process(ctx, gray, dst);
+	TEST_ASSERT(ctx.results[RESULT_IX_CURVE_CONFIDENCE] >= CURVE_MIN_CONFIDENCE);
+	TEST_ASSERT(matches(ctx, c, true));
+}
+
+static void test_roi(void) {
+	IPCurveDetector detector;
+	stage_context_t ctx;
+	cv::Mat gray, dst;
+	const test_curve_t c = { 0.0f, 0.001f, 0.0f, -30.0f };
+	draw_curve(gray, c, true);
+	// frame only contains left half of the full frame, coefficients are still relative to its center
+	const cv::Mat left(gray, cv::Rect(0, 0, WIDTH / 2, HEIGHT));
+	init_ctx(ctx);
+	ctx.roi = cv::Rect(0, 0, WIDTH / 2, HEIGHT);
+	test_curve_t expected = c;
+	expected.d += WIDTH / 4;
+	detector.process(ctx, left, dst);
+	TEST_ASSERT(ctx.results[RESULT_IX_CURVE_CONFIDENCE] >= CURVE_MIN_CONFIDENCE);
+	TEST_ASSERT(matches(ctx, expected, true));
+}
+
+static void test_blank(void) {
+	IPCurveDetector detector;
+	stage_context_t ctx;
+	cv::Mat gray, dst;
+	gray.create(HEIGHT, WIDTH, CV_8UC1);
+	memset(gray.data, BACK, gray.total());
+	init_ctx(ctx);
+	detector.process(ctx, gray, dst);
+	TEST_ASSERT_EQ(TYPE_NON, ctx.detect_type);
+	TEST_ASSERT(ctx.results[RESULT_IX_CURVE_FULL_SEARCH] == 1.0f);
+}
+
+int main(int argc, char *argv[]) {
+	test_detect_and_track(true);
+	test_detect_and_track(false);
+	test_clutter();
+	test_roi();
+	test_blank();
+	return TEST_RESULT("curve_test");
+}
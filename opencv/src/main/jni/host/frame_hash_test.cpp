@@ -0,0 +1,170 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+
+/*
+ * host test of the frame hash(IPFrameHash) that ImageProcessor uses to skip unchanged frames.
+ * checks block layout and luminance of gray/RGBA frames and region of interest,
+ * the maximum block difference, and the unchanged check including threshold,
+ * change of region of interest, reset and the cap of MAX_UNCHANGED_FRAMES consecutive frames.
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "IPFrameHash.h"
+#include "host_test.h"
+
+#define WIDTH 640
+#define HEIGHT 480
+// size of a block for WIDTH x HEIGHT
+#define BLOCK_W (WIDTH / FRAME_HASH_COLS)
+#define BLOCK_H (HEIGHT / FRAME_HASH_ROWS)
+#define BACK 80
+
+static cv::Mat gray_frame(const int &value) {
+	cv::Mat gray(HEIGHT, WIDTH, CV_8UC1);
+	memset(gray.data, value, gray.total());
+	return gray;
+}
+
+static void fill(cv::Mat &gray, const cv::Rect &rect, const int &value) {
+	for (int y = rect.y; y < rect.y + rect.height; y++) {
+		memset(gray.ptr<uint8_t>(y) + rect.x, value, rect.width);
+	}
+}
+
+static void test_hash(void) {
+	uint8_t a[FRAME_HASH_SIZE], b[FRAME_HASH_SIZE];
+	cv::Mat gray = gray_frame(BACK);
+	frame_hash(gray, a);
+	int errors = 0;
+	for (int i = 0; i < FRAME_HASH_SIZE; i++) {
+		errors += a[i] != BACK;
+	}
+	TEST_ASSERT_EQ(0, errors);
+
+	// one block changed
+	const int bx = 3, by = 2;
+	fill(gray, cv::Rect(bx * BLOCK_W, by * BLOCK_H, BLOCK_W, BLOCK_H), 200);
+	frame_hash(gray, b);
+	TEST_ASSERT_EQ(200, b[by * FRAME_HASH_COLS + bx]);
+	TEST_ASSERT_EQ(200 - BACK, frame_hash_diff(a, b));
+	TEST_ASSERT_EQ(200 - BACK, frame_hash_diff(b, a));
+	b[by * FRAME_HASH_COLS + bx] = BACK;
+	TEST_ASSERT_EQ(0, frame_hash_diff(a, b));
+
+	// half of the block, mean of sampled pixels
+	gray = gray_frame(BACK);
+	fill(gray, cv::Rect(bx * BLOCK_W, by * BLOCK_H, BLOCK_W / 2, BLOCK_H), 200);
+	frame_hash(gray, b);
+	TEST_ASSERT_EQ((200 + BACK) / 2, b[by * FRAME_HASH_COLS + bx]);
+
+	// pixels are sampled every 2 pixels, so a pixel at odd position does not change the hash
+	gray = gray_frame(BACK);
+	gray.at<uint8_t>(1, 1) = 255;
+	frame_hash(gray, b);
+	TEST_ASSERT_EQ(0, frame_hash_diff(a, b));
+	gray.at<uint8_t>(0, 0) = 255;
+	frame_hash(gray, b);
+	TEST_ASSERT(frame_hash_diff(a, b) > 0);
+}
+
+static void test_rgba_and_roi(void) {
+	uint8_t a[FRAME_HASH_SIZE], b[FRAME_HASH_SIZE];
+	// green is the luminance of RGBA
+	cv::Mat rgba(HEIGHT, WIDTH, CV_8UC4);
+	for (size_t i = 0; i < rgba.total(); i++) {
+		uint8_t *p = rgba.data + i * 4;
+		p[0] = 10; p[1] = BACK; p[2] = 200; p[3] = 255;
+	}
+	frame_hash(rgba, a);
+	frame_hash(gray_frame(BACK), b);
+	TEST_ASSERT_EQ(0, frame_hash_diff(a, b));
+
+	// region of interest is hashed same as the copy of it
+	cv::Mat gray = gray_frame(BACK);
+	for (int y = 0; y < HEIGHT; y++) {
+		for (int x = 0; x < WIDTH; x++) {
+			gray.at<uint8_t>(y, x) = (uint8_t)(x ^ y);
+		}
+	}
+	const cv::Mat roi(gray, cv::Rect(100, 60, 320, 240));
+	cv::Mat copy;
+	roi.copyTo(copy);
+	frame_hash(roi, a);
+	frame_hash(copy, b);
+	TEST_ASSERT_EQ(0, frame_hash_diff(a, b));
+	TEST_ASSERT(memcmp(a, b, sizeof(a)) == 0);
+}
+
+static void test_unchanged(void) {
+	frame_hash_state_t state;
+	frame_hash_reset(state);
+	const cv::Rect full(0, 0, WIDTH, HEIGHT);
+	const int threshold = 8;
+	const cv::Mat back = gray_frame(BACK);
+	cv::Mat small = gray_frame(BACK + threshold - 1);
+	cv::Mat large = gray_frame(BACK + threshold);
+
+	// disabled
+	TEST_ASSERT(!frame_hash_unchanged(state, back, full, 0));
+	TEST_ASSERT(!frame_hash_unchanged(state, back, full, 0));
+	// first frame is always processed
+	TEST_ASSERT(!frame_hash_unchanged(state, back, full, threshold));
+	TEST_ASSERT(frame_hash_unchanged(state, back, full, threshold));
+	TEST_ASSERT(frame_hash_unchanged(state, small, full, threshold));
+	// compared with last processed frame, not with last unchanged frame
+	TEST_ASSERT(!frame_hash_unchanged(state, large, full, threshold));
+	TEST_ASSERT(frame_hash_unchanged(state, large, full, threshold));
+
+	// other region of interest
+	TEST_ASSERT(!frame_hash_unchanged(state, large, cv::Rect(0, 0, WIDTH / 2, HEIGHT), threshold));
+	TEST_ASSERT(!frame_hash_unchanged(state, large, full, threshold));
+
+	// after MAX_UNCHANGED_FRAMES unchanged frames, next one is processed anyway
+	for (int i = 0; i < MAX_UNCHANGED_FRAMES; i++) {
+		TEST_ASSERT(frame_hash_unchanged(state, large, full, threshold));
+	}
+	TEST_ASSERT(!frame_hash_unchanged(state, large, full, threshold));
+	TEST_ASSERT_EQ(0, state.unchanged_frames);
+	int unchanged = 0;
+	for (int i = 0; i < MAX_UNCHANGED_FRAMES * 3; i++) {
+		unchanged += frame_hash_unchanged(state, large, full, threshold);
+	}
+	TEST_ASSERT_EQ(MAX_UNCHANGED_FRAMES * 3 - 2, unchanged);
+
+	// reset, e.g. new pipeline
+	frame_hash_reset(state);
+	TEST_ASSERT(!frame_hash_unchanged(state, large, full, threshold));
+	TEST_ASSERT(frame_hash_unchanged(state, large, full, threshold));
+	// disabling the check also forgets last frame
+	TEST_ASSERT(!frame_hash_unchanged(state, large, full, 0));
+	TEST_ASSERT(!frame_hash_unchanged(state, large, full, threshold));
+}
+
+int main(int argc, char *argv[]) {
+	test_hash();
+	test_rgba_and_roi();
+	test_unchanged();
+	return TEST_RESULT("frame_hash_test");
+}
@@ -0,0 +1,279 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+
+/*
+ * host test of frame queue/frame pool(IPFrame)
+ * checks queue policies, sequence numbers/drop counters, recycling of pooled frames
+ * without allocation in steady state, region of interest and
+ * a producer/consumer run on two threads.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "IPFrame.h"
+#include "IPFrameSource.h"
+#include "host_test.h"
+
+#define WIDTH 64
+#define HEIGHT 48
+
+class TestFrame : public IPFrame {
+public:
+	TestFrame() : IPFrame() {};
+	virtual ~TestFrame() {};
+	using IPFrame::initFrame;
+	using IPFrame::abortFrame;
+	using IPFrame::releaseFrame;
+	using IPFrame::getFrame;
+	using IPFrame::recycle;
+	using IPFrame::countProcessed;
+	using IPFrame::getReadRoi;
+	using IPFrame::queuedFrames;
+	using IPFrame::setSteadyState;
+};
+
+class TestSource : public IPFrameSource {
+public:
+	int discarded;
+	TestSource(IPFrame &frame) : IPFrameSource(frame), discarded(0) {};
+	virtual ~TestSource() {};
+	virtual bool discard(cv::Mat &frame) { discarded++; return false; };
+	using IPFrameSource::canAddFrame;
+
+	/** queue frame filled with the value */
+	int add(const int &value, const int &width = WIDTH, const int &height = HEIGHT, const int &type = CV_8UC4) {
+		cv::Mat frame = obtainFromPool(width, height, type);
+		memset(frame.data, value, frame.total() * frame.elemSize());
+		return addFrame(frame, 0, value);
+	};
+};
+
+static int take(TestFrame &frame, frame_info_t &info) {
+	cv::Mat mat = frame.getFrame(info, false);
+	if (mat.empty()) return -1;
+	const int value = mat.data[0];
+	frame.recycle(mat);
+	frame.countProcessed();
+	return value;
+}
+
+static void test_drop_oldest(void) {
+	TestFrame frame;
+	TestSource source(frame);
+	source.init(WIDTH, HEIGHT);
+	frame.initFrame(WIDTH, HEIGHT, &source, 2, 2, QUEUE_POLICY_DROP_OLDEST);
+	TEST_ASSERT_EQ(0, source.add(1));
+	TEST_ASSERT_EQ(0, source.add(2));
+	TEST_ASSERT(source.canAddFrame());
+	TEST_ASSERT_EQ(-1, source.add(3));
+	TEST_ASSERT_EQ(2, frame.queuedFrames());
+	TEST_ASSERT_EQ(1, source.discarded);
+
+	frame_info_t info;
+	TEST_ASSERT_EQ(2, take(frame, info));
+	TEST_ASSERT_EQ(1, info.seq);
+	TEST_ASSERT_EQ(2, info.source_timestamp_ns);
+	TEST_ASSERT_EQ(0, info.dropped);
+	TEST_ASSERT_EQ(3, take(frame, info));
+	TEST_ASSERT_EQ(2, info.seq);
+	TEST_ASSERT_EQ(1, info.dropped);
+	TEST_ASSERT_EQ(-1, take(frame, info));
+
+	frame_stats_t stats;
+	frame.getFrameStats(stats);
+	TEST_ASSERT_EQ(3, stats.readback);
+	TEST_ASSERT_EQ(3, stats.enqueued);
+	TEST_ASSERT_EQ(1, stats.dropped);
+	TEST_ASSERT_EQ(2, stats.processed);
+	frame.releaseFrame();
+}
+
+static void test_drop_newest(void) {
+	TestFrame frame;
+	TestSource source(frame);
+	source.init(WIDTH, HEIGHT);
+	frame.initFrame(WIDTH, HEIGHT, &source, 1, 2, QUEUE_POLICY_DROP_NEWEST);
+	TEST_ASSERT_EQ(0, source.add(1));
+	TEST_ASSERT(!source.canAddFrame());
+	TEST_ASSERT_EQ(1, source.add(2));
+	TEST_ASSERT_EQ(1, source.discarded);
+
+	frame_info_t info;
+	TEST_ASSERT_EQ(1, take(frame, info));
+	TEST_ASSERT_EQ(0, info.seq);
+	TEST_ASSERT(source.canAddFrame());
+	TEST_ASSERT_EQ(0, source.add(3));
+	TEST_ASSERT_EQ(3, take(frame, info));
+	TEST_ASSERT_EQ(2, info.seq);
+	TEST_ASSERT_EQ(1, info.dropped);
+	frame.releaseFrame();
+}
+
+static void test_block(void) {
+	TestFrame frame;
+	TestSource source(frame);
+	source.init(WIDTH, HEIGHT);
+	frame.initFrame(WIDTH, HEIGHT, &source, 1, 2, QUEUE_POLICY_BLOCK, 20);
+	TEST_ASSERT_EQ(0, source.add(1));
+	// nobody takes the frame, new frame is dropped after timeout
+	const nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
+	TEST_ASSERT_EQ(1, source.add(2));
+	const nsecs_t elapsed = systemTime(SYSTEM_TIME_MONOTONIC) - start;
+	TEST_ASSERT(elapsed >= ms2ns(15));
+	frame_info_t info;
+	TEST_ASSERT_EQ(1, take(frame, info));
+	frame.releaseFrame();
+}
+
+/** pooled frames are recycled and never allocated again even if their size/type changes */
+static void test_recycle(void) {
+	TestFrame frame;
+	TestSource source(frame);
+	source.init(WIDTH, HEIGHT);
+	frame.initFrame(WIDTH, HEIGHT, &source, 1, 2, QUEUE_POLICY_DROP_OLDEST);
+	frame_info_t info;
+	for (int i = 0; i < STEADY_STATE_FRAMES; i++) {
+		source.add(i);
+		take(frame, info);
+	}
+	frame.setSteadyState(true);
+	for (int i = 0; i < 300; i++) {
+		const int w = WIDTH - (i % 7) * 8;
+		const int h = HEIGHT - (i % 5) * 8;
+		const int type = i & 1 ? CV_8UC1 : CV_8UC4;
+		TEST_ASSERT(source.add(i & 0xff, w, h, type) <= 0);
+		cv::Mat mat = frame.getFrame(info, false);
+		TEST_ASSERT(!mat.empty());
+		if (mat.empty()) continue;
+		TEST_ASSERT_EQ(w, mat.cols);
+		TEST_ASSERT_EQ(h, mat.rows);
+		TEST_ASSERT_EQ(type, mat.type());
+		TEST_ASSERT(mat.isContinuous());
+		TEST_ASSERT_EQ(i & 0xff, mat.data[mat.total() * mat.elemSize() - 1]);
+		TEST_ASSERT_EQ(w, info.roi_width);
+		TEST_ASSERT_EQ(h, info.roi_height);
+		frame.recycle(mat);
+	}
+	frame_stats_t stats;
+	frame.getFrameStats(stats);
+	TEST_ASSERT_EQ(0, stats.steady_allocations);
+	frame.releaseFrame();
+}
+
+static void test_read_roi(void) {
+	TestFrame frame;
+	TestSource source(frame);
+	frame.initFrame(WIDTH, HEIGHT, &source);
+	int x, y, w, h;
+	frame.getReadRoi(x, y, w, h);
+	TEST_ASSERT(!x && !y && (w == WIDTH) && (h == HEIGHT));
+	frame.setReadRoi(10, 20, 30, 8);
+	frame.getReadRoi(x, y, w, h);
+	TEST_ASSERT(x == 10 && y == 20 && w == 30 && h == 8);
+	frame.setReadRoi(40, 40, 100, 100);
+	frame.getReadRoi(x, y, w, h);
+	TEST_ASSERT(x == 40 && y == 40 && w == WIDTH - 40 && h == HEIGHT - 40);
+	frame.setReadRoi(WIDTH, 0, 10, 10);
+	frame.getReadRoi(x, y, w, h);
+	TEST_ASSERT(!x && !y && (w == WIDTH) && (h == HEIGHT));
+	frame.setReadRoi(0, 0, 0, 0);
+	frame.getReadRoi(x, y, w, h);
+	TEST_ASSERT((w == WIDTH) && (h == HEIGHT));
+	frame.releaseFrame();
+}
+
+#define THREADED_FRAMES 20000
+
+typedef struct consumer_args {
+	TestFrame *frame;
+	int64_t last_seq;
+	int64_t received;
+	int errors;
+} consumer_args_t;
+
+static void *consumer_func(void *vptr_args) {
+	consumer_args_t *args = (consumer_args_t *)vptr_args;
+	frame_info_t info;
+	for ( ; ; ) {
+		cv::Mat mat = args->frame->getFrame(info, true);
+		if (mat.empty()) break;
+		// every pixel should have low 8 bits of the sequence number
+		const uint8_t expected = (uint8_t)info.seq;
+		if ((info.seq <= args->last_seq) || (mat.data[0] != expected)
+			|| (mat.data[mat.total() * mat.elemSize() - 1] != expected)) {
+			args->errors++;
+		}
+		args->last_seq = info.seq;
+		args->received++;
+		args->frame->recycle(mat);
+		args->frame->countProcessed();
+	}
+	return NULL;
+}
+
+/** frame source and worker thread on different threads, frames should never be torn or reordered */
+static void test_threads(const int &policy) {
+	TestFrame frame;
+	TestSource source(frame);
+	source.init(WIDTH, HEIGHT);
+	frame.initFrame(WIDTH, HEIGHT, &source, 2, 2, policy, 5);
+	consumer_args_t args;
+	args.frame = &frame;
+	args.last_seq = -1;
+	args.received = 0;
+	args.errors = 0;
+	pthread_t thread;
+	pthread_create(&thread, NULL, consumer_func, &args);
+	for (int i = 0; i < THREADED_FRAMES; i++) {
+		source.add(i & 0xff);
+	}
+	// wait until worker thread takes all queued frames
+	for (int i = 0; (i < 1000) && frame.queuedFrames(); i++) {
+		usleep(1000);
+	}
+	frame.abortFrame();
+	pthread_join(thread, NULL);
+	frame_stats_t stats;
+	frame.getFrameStats(stats);
+	TEST_ASSERT_EQ(0, args.errors);
+	TEST_ASSERT_EQ(THREADED_FRAMES, stats.readback);
+	TEST_ASSERT_EQ(args.received, stats.processed);
+	TEST_ASSERT_EQ(THREADED_FRAMES, stats.processed + stats.dropped);
+	printf("policy=%d,processed=%lld,dropped=%lld\n", policy,
+		(long long)stats.processed, (long long)stats.dropped);
+	frame.releaseFrame();
+}
+
+int main(int argc, char *argv[]) {
+	test_drop_oldest();
+	test_drop_newest();
+	test_block();
+	test_recycle();
+	test_read_roi();
+	test_threads(QUEUE_POLICY_DROP_OLDEST);
+	test_threads(QUEUE_POLICY_DROP_NEWEST);
+	test_threads(QUEUE_POLICY_BLOCK);
+	return TEST_RESULT("frame_queue_test");
+}
@@ -0,0 +1,444 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+
+/*
+ * host test of frame sources that do not need GL,
+ * IPMemFrameSource(RGBA/YUYV/NV21 raw buffers with stride, region of interest, resize,
+ * luminance only), IPMjpegFrameSource(scaled decoding on its own thread)
+ * and IPSyntheticFrameSource(synthetic pattern and recorded raw frames).
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+
+#include "IPFrame.h"
+#include "IPMemFrameSource.h"
+#include "IPSyntheticFrameSource.h"
+#include "IPMjpegFrameSource.h"
+#include "host_test.h"
+#include "host_jpeg.h"
+
+#define WIDTH 64
+#define HEIGHT 48
+
+class TestFrame : public IPFrame {
+public:
+	TestFrame() : IPFrame() {};
+	virtual ~TestFrame() {};
+	using IPFrame::initFrame;
+	using IPFrame::abortFrame;
+	using IPFrame::releaseFrame;
+	using IPFrame::getFrame;
+	using IPFrame::recycle;
+};
+
+/** take queued frame and copy it, return empty cv::Mat if nothing was queued */
+static cv::Mat take(TestFrame &frame, frame_info_t &info, const bool &wait = false) {
+	cv::Mat mat = frame.getFrame(info, wait);
+	cv::Mat result;
+	if (!mat.empty()) {
+		mat.copyTo(result);
+		frame.recycle(mat);
+	}
+	return result;
+}
+
+static inline int pattern(const int &x, const int &y) {
+	return (x * 3 + y * 5) & 0xff;
+}
+
+static void test_rgba(void) {
+	TestFrame frame;
+	IPMemFrameSource source(frame);
+	source.init(WIDTH, HEIGHT);
+	frame.initFrame(WIDTH, HEIGHT, &source);
+	// RGBA with row padding
+	const int stride = WIDTH * 4 + 32;
+	std::vector<uint8_t> buf(stride * HEIGHT);
+	for (int y = 0; y < HEIGHT; y++) {
+		for (int x = 0; x < WIDTH; x++) {
+			uint8_t *p = &buf[y * stride + x * 4];
+			p[0] = pattern(x, y); p[1] = x; p[2] = y; p[3] = 255;
+		}
+	}
+	frame_info_t info;
+	TEST_ASSERT_EQ(0, source.handleBuffer(&buf[0], buf.size(), WIDTH, HEIGHT, stride, 1234, PIXEL_FORMAT_RGBA));
+	cv::Mat mat = take(frame, info);
+	TEST_ASSERT(!mat.empty());
+	if (!mat.empty()) {
+		TEST_ASSERT_EQ(CV_8UC4, mat.type());
+		TEST_ASSERT_EQ(WIDTH, mat.cols);
+		TEST_ASSERT_EQ(HEIGHT, mat.rows);
+		TEST_ASSERT_EQ(1234, info.source_timestamp_ns);
+		int errors = 0;
+		for (int y = 0; y < HEIGHT; y++) {
+			for (int x = 0; x < WIDTH; x++) {
+				const cv::Vec4b v = mat.at<cv::Vec4b>(y, x);
+				if ((v[0] != pattern(x, y)) || (v[1] != x) || (v[2] != y)) errors++;
+			}
+		}
+		TEST_ASSERT_EQ(0, errors);
+	}
+	// only region of interest is copied
+	frame.setReadRoi(8, 4, 16, 10);
+	TEST_ASSERT_EQ(0, source.handleBuffer(&buf[0], buf.size(), WIDTH, HEIGHT, stride, 0, PIXEL_FORMAT_RGBA));
+	mat = take(frame, info);
+	TEST_ASSERT(!mat.empty());
+	if (!mat.empty()) {
+		TEST_ASSERT_EQ(16, mat.cols);
+		TEST_ASSERT_EQ(10, mat.rows);
+		TEST_ASSERT(info.roi_x == 8 && info.roi_y == 4 && info.roi_width == 16 && info.roi_height == 10);
+		TEST_ASSERT_EQ(8, mat.at<cv::Vec4b>(0, 0)[1]);
+		TEST_ASSERT_EQ(4, mat.at<cv::Vec4b>(0, 0)[2]);
+		TEST_ASSERT_EQ(23, mat.at<cv::Vec4b>(9, 15)[1]);
+		TEST_ASSERT_EQ(13, mat.at<cv::Vec4b>(9, 15)[2]);
+	}
+	frame.setReadRoi(0, 0, 0, 0);
+	// image larger than processing size is resized
+	std::vector<uint8_t> large(WIDTH * 2 * HEIGHT * 2 * 4);
+	for (int y = 0; y < HEIGHT * 2; y++) {
+		for (int x = 0; x < WIDTH * 2; x++) {
+			uint8_t *p = &large[(y * WIDTH * 2 + x) * 4];
+			p[0] = (x & 1) ? 100 : 50; p[1] = p[2] = 0; p[3] = 255;
+		}
+	}
+	TEST_ASSERT_EQ(0, source.handleBuffer(&large[0], large.size(), WIDTH * 2, HEIGHT * 2, 0, 0, PIXEL_FORMAT_RGBA));
+	mat = take(frame, info);
+	TEST_ASSERT(!mat.empty());
+	if (!mat.empty()) {
+		TEST_ASSERT_EQ(WIDTH, mat.cols);
+		TEST_ASSERT_EQ(HEIGHT, mat.rows);
+		TEST_ASSERT_EQ(75, mat.at<cv::Vec4b>(HEIGHT / 2, WIDTH / 2)[0]);
+	}
+	// invalid buffers
+	TEST_ASSERT_EQ(-1, source.handleBuffer(&buf[0], 100, WIDTH, HEIGHT, stride, 0, PIXEL_FORMAT_RGBA));
+	TEST_ASSERT_EQ(-1, source.handleBuffer(&buf[0], buf.size(), WIDTH, HEIGHT, stride, 0, PIXEL_FORMAT_MAX));
+	TEST_ASSERT_EQ(-1, source.handleBuffer(NULL, buf.size(), WIDTH, HEIGHT, stride, 0, PIXEL_FORMAT_RGBA));
+	TEST_ASSERT(take(frame, info).empty());
+	frame.releaseFrame();
+}
+
+/** packed YUYV, Y = pattern, U/V = 128(neutral) except marked pixel pair */
+static std::vector<uint8_t> make_yuyv(const int &stride) {
+	std::vector<uint8_t> buf(stride * HEIGHT);
+	for (int y = 0; y < HEIGHT; y++) {
+		for (int x = 0; x < WIDTH; x += 2) {
+			uint8_t *p = &buf[y * stride + x * 2];
+			p[0] = pattern(x, y); p[1] = 128; p[2] = pattern(x + 1, y); p[3] = 128;
+		}
+	}
+	// reddish pixel pair at (0, 0)-(1, 0)
+	buf[0] = buf[2] = 81; buf[1] = 90; buf[3] = 240;
+	return buf;
+}
+
+/** expected RGB value of neutral chroma, video range luminance is expanded */
+static inline int expand(const int &y) {
+	const int v = ((std::max(y - 16, 0) * 1220542) + (1 << 19)) >> 20;
+	return v > 255 ? 255 : v;
+}
+
+static void test_yuyv(void) {
+	const int stride = WIDTH * 2 + 16;
+	std::vector<uint8_t> buf = make_yuyv(stride);
+	frame_info_t info;
+	{	// luminance only, Y channel is extracted without conversion
+		TestFrame frame;
+		IPMemFrameSource source(frame, true);
+		source.init(WIDTH, HEIGHT);
+		frame.initFrame(WIDTH, HEIGHT, &source);
+		TEST_ASSERT_EQ(0, source.handleBuffer(&buf[0], buf.size(), WIDTH, HEIGHT, stride, 0, PIXEL_FORMAT_YUYV));
+		cv::Mat mat = take(frame, info);
+		TEST_ASSERT(!mat.empty());
+		if (!mat.empty()) {
+			TEST_ASSERT_EQ(CV_8UC1, mat.type());
+			int errors = 0;
+			for (int y = 0; y < HEIGHT; y++) {
+				for (int x = (y ? 0 : 2); x < WIDTH; x++) {
+					if (mat.at<uint8_t>(y, x) != pattern(x, y)) errors++;
+				}
+			}
+			TEST_ASSERT_EQ(0, errors);
+			TEST_ASSERT_EQ(81, mat.at<uint8_t>(0, 0));
+		}
+		// odd region of interest is allowed for luminance
+		frame.setReadRoi(3, 5, 7, 9);
+		TEST_ASSERT_EQ(0, source.handleBuffer(&buf[0], buf.size(), WIDTH, HEIGHT, stride, 0, PIXEL_FORMAT_YUYV));
+		mat = take(frame, info);
+		TEST_ASSERT(!mat.empty());
+		if (!mat.empty()) {
+			TEST_ASSERT(mat.cols == 7 && mat.rows == 9);
+			TEST_ASSERT_EQ(pattern(3, 5), mat.at<uint8_t>(0, 0));
+			TEST_ASSERT_EQ(pattern(9, 13), mat.at<uint8_t>(8, 6));
+		}
+		frame.releaseFrame();
+	}
+	{	// RGBA
+		TestFrame frame;
+		IPMemFrameSource source(frame, false);
+		source.init(WIDTH, HEIGHT);
+		frame.initFrame(WIDTH, HEIGHT, &source);
+		TEST_ASSERT_EQ(0, source.handleBuffer(&buf[0], buf.size(), WIDTH, HEIGHT, stride, 0, PIXEL_FORMAT_YUYV));
+		cv::Mat mat = take(frame, info);
+		TEST_ASSERT(!mat.empty());
+		if (!mat.empty()) {
+			TEST_ASSERT_EQ(CV_8UC4, mat.type());
+			const cv::Vec4b gray = mat.at<cv::Vec4b>(10, 11);
+			TEST_ASSERT_EQ(expand(pattern(11, 10)), gray[0]);
+			TEST_ASSERT(gray[0] == gray[1] && gray[1] == gray[2] && gray[3] == 255);
+			const cv::Vec4b red = mat.at<cv::Vec4b>(0, 0);
+			TEST_ASSERT(red[0] > 200 && red[1] < 60 && red[2] < 60);
+		}
+		frame.releaseFrame();
+	}
+}
+
+static void test_nv21(void) {
+	const int stride = WIDTH + 8;
+	std::vector<uint8_t> buf(stride * HEIGHT * 3 / 2, 128);
+	for (int y = 0; y < HEIGHT; y++) {
+		for (int x = 0; x < WIDTH; x++) {
+			buf[y * stride + x] = pattern(x, y);
+		}
+	}
+	frame_info_t info;
+	{	// luminance only, Y plane is copied
+		TestFrame frame;
+		IPMemFrameSource source(frame, true);
+		source.init(WIDTH, HEIGHT);
+		frame.initFrame(WIDTH, HEIGHT, &source);
+		frame.setReadRoi(16, 8, 32, 24);
+		TEST_ASSERT_EQ(0, source.handleBuffer(&buf[0], buf.size(), WIDTH, HEIGHT, stride, 0, PIXEL_FORMAT_NV21));
+		cv::Mat mat = take(frame, info);
+		TEST_ASSERT(!mat.empty());
+		if (!mat.empty()) {
+			TEST_ASSERT_EQ(CV_8UC1, mat.type());
+			TEST_ASSERT(mat.cols == 32 && mat.rows == 24);
+			int errors = 0;
+			for (int y = 0; y < 24; y++) {
+				for (int x = 0; x < 32; x++) {
+					if (mat.at<uint8_t>(y, x) != pattern(x + 16, y + 8)) errors++;
+				}
+			}
+			TEST_ASSERT_EQ(0, errors);
+		}
+		frame.releaseFrame();
+	}
+	{	// RGBA
+		TestFrame frame;
+		IPMemFrameSource source(frame, false);
+		source.init(WIDTH, HEIGHT);
+		frame.initFrame(WIDTH, HEIGHT, &source);
+		TEST_ASSERT_EQ(0, source.handleBuffer(&buf[0], buf.size(), WIDTH, HEIGHT, stride, 0, PIXEL_FORMAT_NV21));
+		cv::Mat mat = take(frame, info);
+		TEST_ASSERT(!mat.empty());
+		if (!mat.empty()) {
+			const cv::Vec4b v = mat.at<cv::Vec4b>(20, 30);
+			TEST_ASSERT_EQ(expand(pattern(30, 20)), v[0]);
+			TEST_ASSERT(v[0] == v[1] && v[1] == v[2]);
+		}
+		frame.releaseFrame();
+	}
+}
+
+/** when the new frame would be dropped, it is counted without conversion */
+static void test_drop(void) {
+	TestFrame frame;
+	IPMemFrameSource source(frame, true);
+	source.init(WIDTH, HEIGHT);
+	frame.initFrame(WIDTH, HEIGHT, &source, 1, 2, QUEUE_POLICY_DROP_NEWEST);
+	std::vector<uint8_t> buf(WIDTH * HEIGHT * 3 / 2, 0);
+	TEST_ASSERT_EQ(0, source.handleBuffer(&buf[0], buf.size(), WIDTH, HEIGHT, 0, 0, PIXEL_FORMAT_NV21));
+	TEST_ASSERT_EQ(1, source.handleBuffer(&buf[0], buf.size(), WIDTH, HEIGHT, 0, 0, PIXEL_FORMAT_NV21));
+	frame_stats_t stats;
+	frame.getFrameStats(stats);
+	TEST_ASSERT_EQ(2, stats.readback);
+	TEST_ASSERT_EQ(1, stats.enqueued);
+	TEST_ASSERT_EQ(1, stats.dropped);
+	frame.releaseFrame();
+}
+
+/**
+ * JPEG is decoded directly to the smallest scale not smaller than processing size,
+ * so the frame has processing size without resizing for 1/2, 1/4, 1/8 and odd sizes.
+ */
+static void test_mjpeg(void) {
+	const int jpeg_width = WIDTH * 8, jpeg_height = HEIGHT * 8;
+	std::vector<uint8_t> rgb(jpeg_width * jpeg_height * 3);
+	for (int y = 0; y < jpeg_height; y++) {
+		for (int x = 0; x < jpeg_width; x++) {
+			uint8_t *p = &rgb[(y * jpeg_width + x) * 3];
+			// left half is bright red, right half is dark gray
+			if (x < jpeg_width / 2) {
+				p[0] = 240; p[1] = p[2] = 20;
+			} else {
+				p[0] = p[1] = p[2] = 40;
+			}
+		}
+	}
+	const std::vector<uint8_t> jpeg = host_encode_jpeg(&rgb[0], jpeg_width, jpeg_height, 3, 90);
+	const int scales[] = { 1, 2, 4, 8 };
+	frame_info_t info;
+	for (int i = 0; i < 4; i++) {
+		for (int luma = 0; luma < 2; luma++) {
+			const int width = jpeg_width / scales[i], height = jpeg_height / scales[i];
+			TestFrame frame;
+			IPMemFrameSource source(frame, luma != 0);
+			source.init(width, height);
+			frame.initFrame(width, height, &source);
+			TEST_ASSERT_EQ(0, source.handleBuffer(&jpeg[0], jpeg.size(), 0, 0, 0, 0, PIXEL_FORMAT_MJPEG));
+			cv::Mat mat = take(frame, info);
+			TEST_ASSERT(!mat.empty());
+			if (mat.empty()) continue;
+			TEST_ASSERT_EQ(width, mat.cols);
+			TEST_ASSERT_EQ(height, mat.rows);
+			TEST_ASSERT_EQ(luma ? CV_8UC1 : CV_8UC4, mat.type());
+			if (luma) {
+				const int left = mat.at<uint8_t>(height / 2, width / 4);
+				const int right = mat.at<uint8_t>(height / 2, width * 3 / 4);
+				TEST_ASSERT((left > 70) && (left < 90));
+				TEST_ASSERT((right > 30) && (right < 50));
+			} else {
+				const cv::Vec4b left = mat.at<cv::Vec4b>(height / 2, width / 4);
+				TEST_ASSERT((left[0] > 220) && (left[1] < 40) && (left[2] < 40));
+			}
+			frame.releaseFrame();
+		}
+	}
+	{	// broken JPEG
+		TestFrame frame;
+		IPMemFrameSource source(frame, true);
+		source.init(WIDTH, HEIGHT);
+		frame.initFrame(WIDTH, HEIGHT, &source);
+		std::vector<uint8_t> broken(jpeg.begin(), jpeg.begin() + 64);
+		TEST_ASSERT_EQ(-1, source.handleBuffer(&broken[0], broken.size(), 0, 0, 0, 0, PIXEL_FORMAT_MJPEG));
+		frame.releaseFrame();
+	}
+	{	// decoder thread, only the newest compressed frame is kept while decoder is busy
+		TestFrame frame;
+		IPMjpegFrameSource source(frame, true);
+		frame.initFrame(WIDTH, HEIGHT, &source);
+		TEST_ASSERT_EQ(0, source.init(WIDTH, HEIGHT));
+		int received = 0;
+		for (int i = 0; i < 20; i++) {
+			TEST_ASSERT(source.handleBuffer(&jpeg[0], jpeg.size(), 0, 0, 0, i) >= 0);
+			cv::Mat mat = take(frame, info);
+			if (!mat.empty()) {
+				TEST_ASSERT(mat.cols == WIDTH && mat.rows == HEIGHT);
+				received++;
+			}
+		}
+		// every compressed frame is decoded or counted as dropped eventually
+		frame_stats_t stats;
+		for (int i = 0; i < 1000; i++) {
+			frame.getFrameStats(stats);
+			if (stats.readback >= 20) break;
+			usleep(1000);
+		}
+		TEST_ASSERT_EQ(20, stats.readback);
+		for ( ; !take(frame, info).empty() ; ) {
+			received++;
+		}
+		TEST_ASSERT(received > 0);
+		TEST_ASSERT_EQ(20, received + stats.dropped);
+		frame.abortFrame();
+		source.release();
+		frame.releaseFrame();
+	}
+}
+
+static void test_synthetic(void) {
+	TestFrame frame;
+	IPSyntheticFrameSource source(frame);
+	frame.initFrame(WIDTH, HEIGHT, &source);
+	TEST_ASSERT_EQ(0, source.init(WIDTH, HEIGHT));
+	frame_info_t info;
+	int64_t last_seq = -1;
+	int received = 0;
+	for (int i = 0; i < 10; i++) {
+		cv::Mat mat = take(frame, info, true);
+		TEST_ASSERT(!mat.empty());
+		if (mat.empty()) break;
+		TEST_ASSERT_EQ(CV_8UC4, mat.type());
+		TEST_ASSERT(info.seq > last_seq);
+		last_seq = info.seq;
+		// bar always passes through the center
+		TEST_ASSERT_EQ(255, mat.at<cv::Vec4b>(HEIGHT / 2, WIDTH / 2)[0]);
+		// gradient background at the corner
+		TEST_ASSERT_EQ(64, mat.at<cv::Vec4b>(0, 0)[0]);
+		received++;
+	}
+	TEST_ASSERT_EQ(10, received);
+	frame.abortFrame();
+	source.release();
+	frame.releaseFrame();
+}
+
+/** recorded raw frames are replayed through the same path as camera buffers */
+static void test_recorded(void) {
+	char path[] = "/tmp/frame_source_test_XXXXXX.yuyv";
+	const int fd = mkstemps(path, 5);
+	TEST_ASSERT(fd >= 0);
+	if (fd < 0) return;
+	for (int i = 0; i < 3; i++) {
+		std::vector<uint8_t> buf(WIDTH * HEIGHT * 2, 128);
+		for (size_t j = 0; j < buf.size(); j += 2) buf[j] = 10 + i;
+		TEST_ASSERT(write(fd, &buf[0], buf.size()) == (ssize_t)buf.size());
+	}
+	close(fd);
+	TestFrame frame;
+	IPSyntheticFrameSource source(frame, path, 0.0f, true);
+	frame.initFrame(WIDTH, HEIGHT, &source);
+	TEST_ASSERT_EQ(0, source.init(WIDTH, HEIGHT));
+	frame_info_t info;
+	int values[3] = { 0, 0, 0 };
+	for (int i = 0; i < 12; i++) {
+		cv::Mat mat = take(frame, info, true);
+		TEST_ASSERT(!mat.empty());
+		if (mat.empty()) break;
+		TEST_ASSERT_EQ(CV_8UC1, mat.type());
+		const int v = mat.at<uint8_t>(HEIGHT - 1, WIDTH - 1) - 10;
+		TEST_ASSERT((v >= 0) && (v < 3));
+		if ((v >= 0) && (v < 3)) values[v]++;
+	}
+	// all recorded frames are replayed
+	TEST_ASSERT(values[0] && values[1] && values[2]);
+	frame.abortFrame();
+	source.release();
+	frame.releaseFrame();
+	unlink(path);
+}
+
+int main(int argc, char *argv[]) {
+	test_rgba();
+	test_yuyv();
+	test_nv21();
+	test_drop();
+	test_mjpeg();
+	test_synthetic();
+	test_recorded();
+	return TEST_RESULT("frame_source_test");
+}
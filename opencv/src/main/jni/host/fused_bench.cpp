@@ -0,0 +1,114 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+
+/*
+ * benchmark of fused RGBA->gray->RGBA kernel of IPColorKernels
+ * vs two whole-frame passes of scalar cv::cvtColor(COLOR_RGBA2GRAY, COLOR_GRAY2RGBA) of OpenCV 3.2,
+ * which gray/rgba stages did before. the scalar passes are reproduced here
+ * because host does not have OpenCV library.
+ *   two-pass scalar: RGBA2GRAY + GRAY2RGBA, each over whole frame
+ *   two-pass simd:   same passes with SIMD kernels of IPColorKernels
+ *   fused simd:      one pass that writes both gray and RGBA
+ * outputs must be bit-exact, returns non-zero if they are not.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include "Timers.h"
+#include "IPColorKernels.h"
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+	#define KERNEL_PATH "neon"
+#elif defined(__SSE2__)
+	#define KERNEL_PATH "sse2"
+#else
+	#define KERNEL_PATH "scalar"
+#endif
+
+#define ITERATIONS 200
+
+// same table as RGB2Gray<uchar> of OpenCV 3.2
+static int gray_tab[256 * 3];
+
+static void cv_rgba2gray(const uint8_t *src, uint8_t *gray, const int &n) {
+	for (int i = 0; i < n; i++, src += 4) {
+		gray[i] = (uint8_t)((gray_tab[src[0]] + gray_tab[src[1] + 256] + gray_tab[src[2] + 512]) >> 14);
+	}
+}
+
+static void cv_gray2rgba(const uint8_t *gray, uint8_t *rgba, const int &n) {
+	for (int i = 0; i < n; i++, rgba += 4) {
+		rgba[0] = rgba[1] = rgba[2] = gray[i];
+		rgba[3] = 0xff;
+	}
+}
+
+static inline double elapsed_ms(const nsecs_t &start) {
+	return (systemTime(SYSTEM_TIME_MONOTONIC) - start) / 1e6 / ITERATIONS;
+}
+
+int main(int argc, char *argv[]) {
+	int r = 1 << 13, g = 0, b = 0;
+	for (int i = 0; i < 256; i++, r += 4899, g += 9617, b += 1868) {
+		gray_tab[i] = r;
+		gray_tab[i + 256] = g;
+		gray_tab[i + 512] = b;
+	}
+	printf("kernel path: %s\n", KERNEL_PATH);
+	const int sizes[][2] = { { 640, 480 }, { 1280, 720 }, { 1920, 1080 } };
+	int failed = 0;
+	for (int k = 0; k < 3; k++) {
+		const int width = sizes[k][0], height = sizes[k][1], n = width * height;
+		std::vector<uint8_t> src(n * 4), gray(n), rgba(n * 4), gray2(n), rgba2(n * 4);
+		for (int i = 0; i < n * 4; i++) {
+			src[i] = (uint8_t)((i * 2654435761u) >> 24);
+		}
+		nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
+		for (int i = 0; i < ITERATIONS; i++) {
+			cv_rgba2gray(&src[0], &gray[0], n);
+			cv_gray2rgba(&gray[0], &rgba[0], n);
+		}
+		const double two_pass_scalar = elapsed_ms(start);
+		start = systemTime(SYSTEM_TIME_MONOTONIC);
+		for (int i = 0; i < ITERATIONS; i++) {
+			rgba_to_gray_rgba(&src[0], &gray2[0], NULL, n);
+			gray_to_rgba(&gray2[0], &rgba2[0], n);
+		}
+		const double two_pass_simd = elapsed_ms(start);
+		bool ok = !memcmp(&gray[0], &gray2[0], n) && !memcmp(&rgba[0], &rgba2[0], n * 4);
+		memset(&gray2[0], 0, n);
+		memset(&rgba2[0], 0, n * 4);
+		start = systemTime(SYSTEM_TIME_MONOTONIC);
+		for (int i = 0; i < ITERATIONS; i++) {
+			rgba_to_gray_rgba(&src[0], &gray2[0], &rgba2[0], n);
+		}
+		const double fused_simd = elapsed_ms(start);
+		ok = ok && !memcmp(&gray[0], &gray2[0], n) && !memcmp(&rgba[0], &rgba2[0], n * 4);
+		printf("%4dx%-4d: two-pass scalar %.3f ms, two-pass simd %.3f ms, fused simd %.3f ms, bitexact=%d\n",
+			width, height, two_pass_scalar, two_pass_simd, fused_simd, ok);
+		if (!ok) failed++;
+	}
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,65 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+
+#ifndef FLIGHTDEMO_HOST_JPEG_H
+#define FLIGHTDEMO_HOST_JPEG_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include <jpeglib.h>
+
+/**
+ * encode RGB(components=3) or gray(components=1) image into JPEG with host libjpeg
+ * to make MJPEG frames for host tests and benchmarks
+ */
+static inline std::vector<uint8_t> host_encode_jpeg(const uint8_t *pixels,
+	const int &width, const int &height, const int &components, const int &quality = 80) {
+
+	struct jpeg_compress_struct cinfo;
+	struct jpeg_error_mgr err;
+	cinfo.err = jpeg_std_error(&err);
+	jpeg_create_compress(&cinfo);
+	unsigned char *out = NULL;
+	unsigned long out_size = 0;
+	jpeg_mem_dest(&cinfo, &out, &out_size);
+	cinfo.image_width = width;
+	cinfo.image_height = height;
+	cinfo.input_components = components;
+	cinfo.in_color_space = components == 3 ? JCS_RGB : JCS_GRAYSCALE;
+	jpeg_set_defaults(&cinfo);
+	jpeg_set_quality(&cinfo, quality, TRUE);
+	jpeg_start_compress(&cinfo, TRUE);
+	for ( ; cinfo.next_scanline < cinfo.image_height ; ) {
+		JSAMPROW row = (JSAMPROW)(pixels + (size_t)cinfo.next_scanline * width * components);
+		jpeg_write_scanlines(&cinfo, &row, 1);
+	}
+	jpeg_finish_compress(&cinfo);
+	jpeg_destroy_compress(&cinfo);
+	std::vector<uint8_t> result(out, out + out_size);
+	free(out);
+	return result;
+}
+
+#endif //FLIGHTDEMO_HOST_JPEG_H
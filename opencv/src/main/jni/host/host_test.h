@@ -0,0 +1,59 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+
+#ifndef FLIGHTDEMO_HOST_TEST_H
+#define FLIGHTDEMO_HOST_TEST_H
+
+#include <stdio.h>
+
+/*
+ * tiny helpers for host tests, each test is a plain executable
+ * that returns non-zero if any check failed so that `make test` can stop on it.
+ */
+static int host_test_failures = 0;
+
+#define TEST_ASSERT(cond) \
+	do { \
+		if (!(cond)) { \
+			fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+			host_test_failures++; \
+		} \
+	} while (0)
+
+#define TEST_ASSERT_EQ(expected, actual) \
+	do { \
+		const long long _e = (long long)(expected); \
+		const long long _a = (long long)(actual); \
+		if (_e != _a) { \
+			fprintf(stderr, "%s:%d: check failed: %s == %s (%lld != %lld)\n", \
+				__FILE__, __LINE__, #expected, #actual, _e, _a); \
+			host_test_failures++; \
+		} \
+	} while (0)
+
+#define TEST_RESULT(name) \
+	(printf("%s: %s\n", (name), host_test_failures ? "FAILED" : "OK"), \
+		host_test_failures ? 1 : 0)
+
+#endif //FLIGHTDEMO_HOST_TEST_H
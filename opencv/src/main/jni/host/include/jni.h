@@ -0,0 +1,91 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+
+#ifndef FLIGHTDEMO_HOST_JNI_H
+#define FLIGHTDEMO_HOST_JNI_H
+
+/*
+ * minimal jni.h for host(Linux) build of imageproc tests and benchmarks.
+ * only types are declared, there is no JavaVM on host and getVM() returns NULL,
+ * so the code that really calls JNI functions must not be linked into host targets.
+ */
+#include <stdint.h>
+#include <stdarg.h>
+
+typedef uint8_t		jboolean;
+typedef int8_t		jbyte;
+typedef uint16_t	jchar;
+typedef int16_t		jshort;
+typedef int32_t		jint;
+typedef int64_t		jlong;
+typedef float		jfloat;
+typedef double		jdouble;
+typedef jint		jsize;
+
+class _jobject {};
+typedef _jobject*	jobject;
+typedef jobject		jclass;
+typedef jobject		jstring;
+typedef jobject		jarray;
+typedef jobject		jobjectArray;
+typedef jobject		jbyteArray;
+typedef jobject		jintArray;
+typedef jobject		jlongArray;
+typedef jobject		jfloatArray;
+typedef jobject		jthrowable;
+typedef jobject		jweak;
+
+struct _jfieldID;
+typedef struct _jfieldID* jfieldID;
+struct _jmethodID;
+typedef struct _jmethodID* jmethodID;
+
+typedef struct {
+	const char* name;
+	const char* signature;
+	void* fnPtr;
+} JNINativeMethod;
+
+#define JNI_FALSE		0
+#define JNI_TRUE		1
+#define JNI_OK			(0)
+#define JNI_ERR			(-1)
+#define JNI_COMMIT		1
+#define JNI_ABORT		2
+#define JNI_VERSION_1_6	0x00010006
+
+#define JNIEXPORT	__attribute__ ((visibility ("default")))
+#define JNICALL
+
+struct _JNIEnv {};
+typedef _JNIEnv JNIEnv;
+
+struct _JavaVM {
+	jint AttachCurrentThread(JNIEnv **p_env, void *thr_args) { *p_env = NULL; return JNI_ERR; }
+	jint DetachCurrentThread() { return JNI_ERR; }
+	jint GetEnv(void **env, jint version) { *env = NULL; return JNI_ERR; }
+};
+typedef _JavaVM JavaVM;
+
+#endif //FLIGHTDEMO_HOST_JNI_H
@@ -0,0 +1,128 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+
+/*
+ * benchmark of MJPEG decoding at processing size with scaled IDCT,
+ *   decode:  cv::imdecode of 1920x1080 JPEG with IMREAD_XXX/IMREAD_REDUCED_XXX_2/4/8
+ *   ingest:  IPMemFrameSource(PIXEL_FORMAT_MJPEG) to frame queue for each processing size,
+ *            which selects the scale from SOF marker and decodes only once
+ * on host, cv::imdecode is host libjpeg(-turbo) through opencv_host.cpp.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "IPFrame.h"
+#include "IPMemFrameSource.h"
+#include "host_jpeg.h"
+
+#define JPEG_WIDTH 1920
+#define JPEG_HEIGHT 1080
+#define JPEG_QUALITY 80
+#define LOOP_NUM 40
+
+class BenchFrame : public IPFrame {
+public:
+	BenchFrame() : IPFrame() {};
+	virtual ~BenchFrame() {};
+	using IPFrame::initFrame;
+	using IPFrame::releaseFrame;
+	using IPFrame::getFrame;
+	using IPFrame::recycle;
+};
+
+static std::vector<uint8_t> make_jpeg(void) {
+	std::vector<uint8_t> rgb(JPEG_WIDTH * JPEG_HEIGHT * 3);
+	srand(1);
+	for (int y = 0; y < JPEG_HEIGHT; y++) {
+		for (int x = 0; x < JPEG_WIDTH; x++) {
+			uint8_t *p = &rgb[(y * JPEG_WIDTH + x) * 3];
+			// gradient + checker + noise, not too easy for entropy coding
+			p[0] = (x * 255 / JPEG_WIDTH) ^ (rand() & 15);
+			p[1] = y * 255 / JPEG_HEIGHT;
+			p[2] = ((x / 40 + y / 40) & 1) * 200 + (rand() & 31);
+		}
+	}
+	return host_encode_jpeg(&rgb[0], JPEG_WIDTH, JPEG_HEIGHT, 3, JPEG_QUALITY);
+}
+
+static void bench_decode(const std::vector<uint8_t> &jpeg) {
+	static const int color_flags[] = {
+		cv::IMREAD_COLOR, cv::IMREAD_REDUCED_COLOR_2, cv::IMREAD_REDUCED_COLOR_4, cv::IMREAD_REDUCED_COLOR_8 };
+	static const int gray_flags[] = {
+		cv::IMREAD_GRAYSCALE, cv::IMREAD_REDUCED_GRAYSCALE_2, cv::IMREAD_REDUCED_GRAYSCALE_4, cv::IMREAD_REDUCED_GRAYSCALE_8 };
+	const cv::Mat buf(1, (int)jpeg.size(), CV_8UC1, (void *)&jpeg[0]);
+	cv::Mat decoded;
+	for (int gray = 0; gray < 2; gray++) {
+		for (int i = 0; i < 4; i++) {
+			const int flags = gray ? gray_flags[i] : color_flags[i];
+			const nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
+			for (int j = 0; j < LOOP_NUM; j++) {
+				cv::imdecode(buf, flags, &decoded);
+			}
+			const double ms = (systemTime(SYSTEM_TIME_MONOTONIC) - start) / 1e6 / LOOP_NUM;
+			printf("decode %s 1/%d -> %dx%d: %.2f ms/frame\n", gray ? "gray " : "color",
+				1 << i, decoded.cols, decoded.rows, ms);
+		}
+	}
+}
+
+static int bench_ingest(const std::vector<uint8_t> &jpeg, const int &width, const int &height, const bool &luma) {
+	BenchFrame frame;
+	IPMemFrameSource source(frame, luma);
+	source.init(width, height);
+	frame.initFrame(width, height, &source);
+	frame_info_t info;
+	int errors = 0;
+	const nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
+	for (int i = 0; i < LOOP_NUM; i++) {
+		if (source.handleBuffer(&jpeg[0], jpeg.size(), JPEG_WIDTH, JPEG_HEIGHT, 0, 0, PIXEL_FORMAT_MJPEG)) {
+			errors++;
+		}
+		cv::Mat mat = frame.getFrame(info, false);
+		if (mat.empty() || (mat.cols != width) || (mat.rows != height)) {
+			errors++;
+		}
+		if (!mat.empty()) frame.recycle(mat);
+	}
+	const double ms = (systemTime(SYSTEM_TIME_MONOTONIC) - start) / 1e6 / LOOP_NUM;
+	printf("ingest %s %dx%d: %.2f ms/frame%s\n", luma ? "gray " : "color", width, height, ms,
+		errors ? " ERROR" : "");
+	frame.releaseFrame();
+	source.release();
+	return errors;
+}
+
+int main(int argc, char *argv[]) {
+	const std::vector<uint8_t> jpeg = make_jpeg();
+	printf("jpeg %dx%d q%d, %zu bytes\n", JPEG_WIDTH, JPEG_HEIGHT, JPEG_QUALITY, jpeg.size());
+	bench_decode(jpeg);
+	int errors = 0;
+	for (int luma = 0; luma < 2; luma++) {
+		for (int scale = 1; scale <= 8; scale *= 2) {
+			errors += bench_ingest(jpeg, JPEG_WIDTH / scale, JPEG_HEIGHT / scale, luma != 0);
+		}
+	}
+	return errors ? 1 : 0;
+}
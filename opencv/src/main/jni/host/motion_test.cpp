@@ -0,0 +1,206 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+
+/*
+ * host test of the motion detector(IPMotionDetector) on synthetic frames.
+ * checks gating of following stages(STAGE_SKIP_REST) and hold frames, regions of motion
+ * in full frame coordinates, background update(slow change is followed, still object is absorbed),
+ * relearning on change of whole frame and the motion mask written into result image.
+ * the frames are twice MOTION_WIDTH wide so that host resize(integer scale down) can be used.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "IPMotionDetector.h"
+#include "host_test.h"
+
+#define WIDTH (MOTION_WIDTH * 2)
+#define HEIGHT 120
+#define BACK 40
+#define FORE 220
+
+static void init_ctx(stage_context_t &ctx) {
+	memset(ctx.results, 0, sizeof(ctx.results));
+	ctx.width = WIDTH;
+	ctx.height = HEIGHT;
+	ctx.roi = cv::Rect(0, 0, WIDTH, HEIGHT);
+	ctx.result_frame_type = RESULT_FRAME_TYPE_NON;
+	ctx.result_format = RESULT_FORMAT_GRAY;
+	ctx.detect_type = TYPE_NON;
+	ctx.allocator = NULL;
+	ctx.unchanged = false;
+	ctx.result.release();
+}
+
+static cv::Mat frame(const int &value) {
+	cv::Mat gray(HEIGHT, WIDTH, CV_8UC1);
+	memset(gray.data, value, gray.total());
+	return gray;
+}
+
+static void fill(cv::Mat &gray, const cv::Rect &rect, const int &value) {
+	for (int y = rect.y; y < rect.y + rect.height; y++) {
+		memset(gray.ptr<uint8_t>(y) + rect.x, value, rect.width);
+	}
+}
+
+static int run(IPMotionDetector &detector, stage_context_t &ctx, const cv::Mat &src) {
+	init_ctx(ctx);
+	cv::Mat dst;
+	const int result = detector.process(ctx, src, dst);
+	TEST_ASSERT(dst.data == src.data);
+	return result;
+}
+
+static bool box_equals(const float *box, const cv::Rect &rect) {
+	return (box[0] == rect.x) && (box[1] == rect.y) && (box[2] == rect.width) && (box[3] == rect.height);
+}
+
+static void test_regions(void) {
+	IPMotionDetector detector;
+	stage_context_t ctx;
+	const cv::Mat back = frame(BACK);
+
+	// first frame is background, no motion and following stages are skipped
+	TEST_ASSERT_EQ(STAGE_SKIP_REST, run(detector, ctx, back));
+	TEST_ASSERT(ctx.results[RESULT_IX_MOTION_ACTIVITY] == 0.0f);
+	TEST_ASSERT_EQ(0, ctx.results[RESULT_IX_MOTION_REGIONS]);
+
+	// two objects, larger one first
+	const cv::Rect large(40, 30, 20, 20), small(100, 80, 10, 8);
+	cv::Mat gray = frame(BACK);
+	fill(gray, small, FORE);
+	fill(gray, large, FORE);
+	TEST_ASSERT_EQ(0, run(detector, ctx, gray));
+	const float expected = (large.area() + small.area()) / 4.0f / (MOTION_WIDTH * HEIGHT / 2);
+	TEST_ASSERT(fabsf(ctx.results[RESULT_IX_MOTION_ACTIVITY] - expected) < 1e-6f);
+	TEST_ASSERT_EQ(2, ctx.results[RESULT_IX_MOTION_REGIONS]);
+	TEST_ASSERT(box_equals(&ctx.results[RESULT_IX_MOTION_X], large | small));
+	TEST_ASSERT(box_equals(&ctx.results[RESULT_IX_MOTION_BOXES], large));
+	TEST_ASSERT(box_equals(&ctx.results[RESULT_IX_MOTION_BOXES + 4], small));
+	TEST_ASSERT(ctx.results[RESULT_IX_MOTION_BOXES + 8] == 0.0f);
+
+	// object disappeared, following stages keep running for hold frames
+	for (int i = 0; i < MOTION_HOLD_FRAMES; i++) {
+		TEST_ASSERT_EQ(0, run(detector, ctx, back));
+		TEST_ASSERT(ctx.results[RESULT_IX_MOTION_ACTIVITY] == 0.0f);
+	}
+	TEST_ASSERT_EQ(STAGE_SKIP_REST, run(detector, ctx, back));
+
+	// too small region is counted as activity but not as region, and does not open the gate
+	gray = frame(BACK);
+	fill(gray, cv::Rect(10, 10, 2, 2), FORE);
+	TEST_ASSERT_EQ(STAGE_SKIP_REST, run(detector, ctx, gray));
+	TEST_ASSERT(ctx.results[RESULT_IX_MOTION_ACTIVITY] > 0.0f);
+	TEST_ASSERT(ctx.results[RESULT_IX_MOTION_ACTIVITY] < MOTION_GATE_ACTIVITY);
+	TEST_ASSERT_EQ(0, ctx.results[RESULT_IX_MOTION_REGIONS]);
+}
+
+static void test_background(void) {
+	IPMotionDetector detector;
+	stage_context_t ctx;
+	run(detector, ctx, frame(BACK));
+
+	// slow change of lighting is followed by the background
+	for (int value = BACK; value <= BACK + 80; value += MOTION_THRESHOLD / 2) {
+		const cv::Mat gray = frame(value);
+		for (int i = 0; i < 60; i++) {
+			run(detector, ctx, gray);
+			TEST_ASSERT(ctx.results[RESULT_IX_MOTION_ACTIVITY] == 0.0f);
+		}
+	}
+	// background is close to current frame, so the change greater than threshold is motion again
+	cv::Mat gray = frame(BACK + 80);
+	fill(gray, cv::Rect(0, 0, WIDTH, 20), BACK + 80 + MOTION_THRESHOLD + 2);
+	run(detector, ctx, gray);
+	TEST_ASSERT(fabsf(ctx.results[RESULT_IX_MOTION_ACTIVITY] - 20.0f / HEIGHT) < 1e-6f);
+
+	// object that stays still is absorbed into background slowly
+	gray = frame(BACK + 80);
+	fill(gray, cv::Rect(40, 40, 40, 40), FORE);
+	int frames = 0;
+	for ( ; frames < 1000; frames++) {
+		run(detector, ctx, gray);
+		if (ctx.results[RESULT_IX_MOTION_ACTIVITY] == 0.0f) break;
+	}
+	// 1 / (1 << MOTION_SLOW_SHIFT) for each frame, tens of frames are never enough
+	TEST_ASSERT(frames > (1 << MOTION_SLOW_SHIFT));
+	TEST_ASSERT(frames < 1000);
+}
+
+static void test_relearn(void) {
+	IPMotionDetector detector;
+	stage_context_t ctx;
+	run(detector, ctx, frame(BACK));
+	// whole frame changed, e.g. auto exposure, background is relearned from this frame
+	TEST_ASSERT_EQ(0, run(detector, ctx, frame(FORE)));
+	TEST_ASSERT(ctx.results[RESULT_IX_MOTION_ACTIVITY] == 1.0f);
+	run(detector, ctx, frame(FORE));
+	TEST_ASSERT(ctx.results[RESULT_IX_MOTION_ACTIVITY] == 0.0f);
+	// reset also starts from next frame without motion
+	detector.reset();
+	TEST_ASSERT_EQ(STAGE_SKIP_REST, run(detector, ctx, frame(BACK)));
+	TEST_ASSERT(ctx.results[RESULT_IX_MOTION_ACTIVITY] == 0.0f);
+}
+
+static void test_mask(void) {
+	IPMotionDetector detector;
+	stage_context_t ctx;
+	cv::Mat dst;
+	const cv::Rect object(40, 30, 20, 20);
+	run(detector, ctx, frame(BACK));
+
+	// RGBA input and gray scale result image
+	cv::Mat rgba(HEIGHT, WIDTH, CV_8UC4);
+	cv::Mat gray = frame(BACK);
+	fill(gray, object, FORE);
+	for (size_t i = 0; i < gray.total(); i++) {
+		memset(rgba.data + i * 4, gray.data[i], 3);
+		rgba.data[i * 4 + 3] = 0xff;
+	}
+	init_ctx(ctx);
+	ctx.result_frame_type = RESULT_FRAME_TYPE_DST;
+	ctx.result = frame(0x80);
+	TEST_ASSERT_EQ(0, detector.process(ctx, rgba, dst));
+	TEST_ASSERT(dst.data == rgba.data);
+	TEST_ASSERT_EQ(1, ctx.results[RESULT_IX_MOTION_REGIONS]);
+	TEST_ASSERT(box_equals(&ctx.results[RESULT_IX_MOTION_X], object));
+	int errors = 0;
+	for (int y = 0; y < HEIGHT; y++) {
+		for (int x = 0; x < WIDTH; x++) {
+			const int expected = object.contains(cv::Point(x, y)) ? 0xff : 0;
+			errors += ctx.result.at<uint8_t>(y, x) != expected;
+		}
+	}
+	TEST_ASSERT_EQ(0, errors);
+}
+
+int main(int argc, char *argv[]) {
+	test_regions();
+	test_background();
+	test_relearn();
+	test_mask();
+	return TEST_RESULT("motion_test");
+}
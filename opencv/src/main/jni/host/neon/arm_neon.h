@@ -0,0 +1,153 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+
+#ifndef FLIGHTDEMO_HOST_ARM_NEON_H
+#define FLIGHTDEMO_HOST_ARM_NEON_H
+
+/*
+ * scalar emulation of the subset of arm_neon.h that IPColorKernels.cpp uses,
+ * so that its NEON path can be built with -D__ARM_NEON__ and compared with scalar path on host.
+ * each function does what ARM reference describes for one lane at a time,
+ * this checks the logic of the NEON path(lane order, widening, rounding and narrowing),
+ * but not the code that the ARM compiler generates.
+ */
+#include <stdint.h>
+#include <string.h>
+
+typedef struct { uint8_t v[8]; } uint8x8_t;
+typedef struct { uint8_t v[16]; } uint8x16_t;
+typedef struct { uint16_t v[4]; } uint16x4_t;
+typedef struct { uint16_t v[8]; } uint16x8_t;
+typedef struct { uint32_t v[4]; } uint32x4_t;
+typedef struct { uint8x16_t val[4]; } uint8x16x4_t;
+
+static inline uint8x16_t vdupq_n_u8(const uint8_t value) {
+	uint8x16_t r;
+	memset(r.v, value, sizeof(r.v));
+	return r;
+}
+
+static inline uint8x16_t vld1q_u8(const uint8_t *ptr) {
+	uint8x16_t r;
+	memcpy(r.v, ptr, sizeof(r.v));
+	return r;
+}
+
+static inline void vst1q_u8(uint8_t *ptr, const uint8x16_t &value) {
+	memcpy(ptr, value.v, sizeof(value.v));
+}
+
+/** load 16 elements of 4 interleaved channels, val[k] is k-th channel */
+static inline uint8x16x4_t vld4q_u8(const uint8_t *ptr) {
+	uint8x16x4_t r;
+	for (int i = 0; i < 16; i++) {
+		for (int k = 0; k < 4; k++) {
+			r.val[k].v[i] = ptr[i * 4 + k];
+		}
+	}
+	return r;
+}
+
+static inline void vst4q_u8(uint8_t *ptr, const uint8x16x4_t &value) {
+	for (int i = 0; i < 16; i++) {
+		for (int k = 0; k < 4; k++) {
+			ptr[i * 4 + k] = value.val[k].v[i];
+		}
+	}
+}
+
+static inline uint8x8_t vget_low_u8(const uint8x16_t &a) {
+	uint8x8_t r;
+	memcpy(r.v, a.v, sizeof(r.v));
+	return r;
+}
+
+static inline uint8x8_t vget_high_u8(const uint8x16_t &a) {
+	uint8x8_t r;
+	memcpy(r.v, a.v + 8, sizeof(r.v));
+	return r;
+}
+
+static inline uint16x4_t vget_low_u16(const uint16x8_t &a) {
+	uint16x4_t r;
+	memcpy(r.v, a.v, sizeof(r.v));
+	return r;
+}
+
+static inline uint16x4_t vget_high_u16(const uint16x8_t &a) {
+	uint16x4_t r;
+	memcpy(r.v, a.v + 4, sizeof(r.v));
+	return r;
+}
+
+static inline uint8x16_t vcombine_u8(const uint8x8_t &low, const uint8x8_t &high) {
+	uint8x16_t r;
+	memcpy(r.v, low.v, sizeof(low.v));
+	memcpy(r.v + 8, high.v, sizeof(high.v));
+	return r;
+}
+
+static inline uint16x8_t vcombine_u16(const uint16x4_t &low, const uint16x4_t &high) {
+	uint16x8_t r;
+	memcpy(r.v, low.v, sizeof(low.v));
+	memcpy(r.v + 4, high.v, sizeof(high.v));
+	return r;
+}
+
+/** widen 8 bits to 16 bits */
+static inline uint16x8_t vmovl_u8(const uint8x8_t &a) {
+	uint16x8_t r;
+	for (int i = 0; i < 8; i++) r.v[i] = a.v[i];
+	return r;
+}
+
+/** narrow 16 bits to 8 bits, upper bits are truncated */
+static inline uint8x8_t vmovn_u16(const uint16x8_t &a) {
+	uint8x8_t r;
+	for (int i = 0; i < 8; i++) r.v[i] = (uint8_t)a.v[i];
+	return r;
+}
+
+/** widening multiply by scalar */
+static inline uint32x4_t vmull_n_u16(const uint16x4_t &a, const uint16_t b) {
+	uint32x4_t r;
+	for (int i = 0; i < 4; i++) r.v[i] = (uint32_t)a.v[i] * b;
+	return r;
+}
+
+/** widening multiply-accumulate by scalar, wraps around on overflow */
+static inline uint32x4_t vmlal_n_u16(const uint32x4_t &acc, const uint16x4_t &a, const uint16_t b) {
+	uint32x4_t r;
+	for (int i = 0; i < 4; i++) r.v[i] = acc.v[i] + (uint32_t)a.v[i] * b;
+	return r;
+}
+
+/** rounding shift right and narrow, n must be [1, 16], upper bits are truncated */
+static inline uint16x4_t vrshrn_n_u32(const uint32x4_t &a, const int n) {
+	uint16x4_t r;
+	for (int i = 0; i < 4; i++) r.v[i] = (uint16_t)(((uint64_t)a.v[i] + (1u << (n - 1))) >> n);
+	return r;
+}
+
+#endif //FLIGHTDEMO_HOST_ARM_NEON_H
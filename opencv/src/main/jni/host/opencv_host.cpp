@@ -0,0 +1,926 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+
+/*
+ * subset of OpenCV core(3.2) implemented for host build of tests and benchmarks,
+ * prebuilt OpenCV libraries in this repository are for Android only.
+ * only what imageproc needs to manage cv::Mat(allocation, ROI, reshape, copy, fill, convert)
+ * is implemented here following the original implementation,
+ * and image processing functions that frame sources and tested stages use are implemented only
+ * for the formats they need(JPEG is decoded with host libjpeg),
+ * others raise cv::Exception(not supported on host).
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <setjmp.h>
+#include <jpeglib.h>
+
+#include "opencv2/opencv.hpp"
+
+// same alignment as cv::fastMalloc
+#define HOST_MALLOC_ALIGN 16
+
+namespace cv {
+
+//--------------------------------------------------------------------------------
+// memory
+//--------------------------------------------------------------------------------
+void *fastMalloc(size_t size) {
+	void *ptr = NULL;
+	if (posix_memalign(&ptr, HOST_MALLOC_ALIGN, size)) {
+		ptr = NULL;
+	}
+	if (!ptr) {
+		CV_Error(Error::StsNoMem, "Failed to allocate memory");
+	}
+	return ptr;
+}
+
+void fastFree(void *ptr) {
+	free(ptr);
+}
+
+char *String::allocate(size_t len) {
+	const size_t totalsize = alignSize(len + 1, (int)sizeof(int));
+	int *data = (int *)fastMalloc(totalsize + sizeof(int));
+	data[0] = 1;
+	cstr_ = (char *)(data + 1);
+	len_ = len;
+	cstr_[len] = 0;
+	return cstr_;
+}
+
+void String::deallocate() {
+	int *data = (int *)cstr_;
+	len_ = 0;
+	cstr_ = 0;
+	if (data && (1 == CV_XADD(data - 1, -1))) {
+		fastFree(data - 1);
+	}
+}
+
+//--------------------------------------------------------------------------------
+// error
+//--------------------------------------------------------------------------------
+Exception::Exception() {
+	code = 0;
+	line = 0;
+}
+
+Exception::Exception(int _code, const String &_err, const String &_func, const String &_file, int _line)
+: code(_code), err(_err), func(_func), file(_file), line(_line) {
+	formatMessage();
+}
+
+Exception::~Exception() throw() {}
+
+const char *Exception::what() const throw() {
+	return msg.c_str();
+}
+
+void Exception::formatMessage() {
+	char buf[1024];
+	snprintf(buf, sizeof(buf), "%s:%d: error: (%d) %s in function %s",
+		file.c_str(), line, code, err.c_str(), func.c_str());
+	msg = buf;
+}
+
+void error(const Exception &exc) {
+	fprintf(stderr, "OpenCV(host) %s\n", exc.what());
+	throw exc;
+}
+
+void error(int _code, const String &_err, const char *_func, const char *_file, int _line) {
+	error(Exception(_code, _err, _func, _file, _line));
+}
+
+//--------------------------------------------------------------------------------
+// allocator
+//--------------------------------------------------------------------------------
+UMatData::UMatData(const MatAllocator *allocator) {
+	prevAllocator = currAllocator = allocator;
+	urefcount = refcount = mapcount = 0;
+	data = origdata = 0;
+	size = 0;
+	flags = 0;
+	handle = 0;
+	userdata = 0;
+	allocatorFlags_ = 0;
+	originalUMatData = NULL;
+}
+
+UMatData::~UMatData() {
+	prevAllocator = currAllocator = 0;
+	urefcount = refcount = 0;
+	data = origdata = 0;
+	size = 0;
+	flags = 0;
+	handle = 0;
+	userdata = 0;
+	allocatorFlags_ = 0;
+	originalUMatData = NULL;
+}
+
+void MatAllocator::map(UMatData *, int) const {
+}
+
+void MatAllocator::unmap(UMatData *u) const {
+	if ((u->urefcount == 0) && (u->refcount == 0)) {
+		deallocate(u);
+	}
+}
+
+void MatAllocator::download(UMatData *, void *, int, const size_t[], const size_t[],
+	const size_t[], const size_t[]) const {
+	CV_Error(Error::StsNotImplemented, "not supported on host");
+}
+
+void MatAllocator::upload(UMatData *, const void *, int, const size_t[], const size_t[],
+	const size_t[], const size_t[]) const {
+	CV_Error(Error::StsNotImplemented, "not supported on host");
+}
+
+void MatAllocator::copy(UMatData *, UMatData *, int, const size_t[], const size_t[],
+	const size_t[], const size_t[], const size_t[], bool) const {
+	CV_Error(Error::StsNotImplemented, "not supported on host");
+}
+
+BufferPoolController *MatAllocator::getBufferPoolController(const char *) const {
+	return NULL;
+}
+
+class StdMatAllocator : public MatAllocator {
+public:
+	UMatData *allocate(int dims, const int *sizes, int type,
+		void *data0, size_t *step, int, UMatUsageFlags) const {
+
+		size_t total = CV_ELEM_SIZE(type);
+		for (int i = dims - 1; i >= 0; i--) {
+			if (step) {
+				if (data0 && step[i] != CV_AUTOSTEP) {
+					total = step[i];
+				} else {
+					step[i] = total;
+				}
+			}
+			total *= sizes[i];
+		}
+		uchar *data = data0 ? (uchar *)data0 : (uchar *)fastMalloc(total);
+		UMatData *u = new UMatData(this);
+		u->data = u->origdata = data;
+		u->size = total;
+		if (data0) {
+			u->flags |= UMatData::USER_ALLOCATED;
+		}
+		return u;
+	}
+
+	bool allocate(UMatData *u, int, UMatUsageFlags) const {
+		return u != NULL;
+	}
+
+	void deallocate(UMatData *u) const {
+		if (u) {
+			if (!(u->flags & UMatData::USER_ALLOCATED)) {
+				fastFree(u->origdata);
+				u->origdata = 0;
+			}
+			delete u;
+		}
+	}
+};
+
+MatAllocator *Mat::getStdAllocator() {
+	static StdMatAllocator allocator;
+	return &allocator;
+}
+
+//--------------------------------------------------------------------------------
+// Mat
+//--------------------------------------------------------------------------------
+static void setSize(Mat &m, int _dims, const int *_sz, const size_t *_steps, bool autoSteps = false) {
+	CV_Assert((0 <= _dims) && (_dims <= 2));
+	m.dims = _dims;
+	if (!_sz) return;
+	const size_t esz = CV_ELEM_SIZE(m.flags);
+	size_t total = esz;
+	for (int i = _dims - 1; i >= 0; i--) {
+		const int s = _sz[i];
+		CV_Assert(s >= 0);
+		m.size.p[i] = s;
+		if (_steps) {
+			m.step.p[i] = i < _dims - 1 ? _steps[i] : esz;
+		} else if (autoSteps) {
+			m.step.p[i] = total;
+			total *= (size_t)s;
+		}
+	}
+	if (_dims == 1) {
+		m.dims = 2;
+		m.cols = 1;
+		m.step[1] = esz;
+	}
+}
+
+static void updateContinuityFlag(Mat &m) {
+	int i, j;
+	for (i = 0; i < m.dims; i++) {
+		if (m.size[i] > 1) break;
+	}
+	for (j = m.dims - 1; j > i; j--) {
+		if (m.step[j] * m.size[j] < m.step[j - 1]) break;
+	}
+	if (j <= i) {
+		m.flags |= Mat::CONTINUOUS_FLAG;
+	} else {
+		m.flags &= ~Mat::CONTINUOUS_FLAG;
+	}
+}
+
+static void finalizeHdr(Mat &m) {
+	updateContinuityFlag(m);
+	const int d = m.dims;
+	if (m.u) {
+		m.datastart = m.data = m.u->data;
+	}
+	if (m.data) {
+		m.datalimit = m.datastart + m.size[0] * m.step[0];
+		if (m.size[0] > 0) {
+			m.dataend = m.ptr() + m.size[d - 1] * m.step[d - 1];
+			for (int i = 0; i < d - 1; i++) {
+				m.dataend += (m.size[i] - 1) * m.step[i];
+			}
+		} else {
+			m.dataend = m.datalimit;
+		}
+	} else {
+		m.dataend = m.datalimit = 0;
+	}
+}
+
+void Mat::create(int d, const int *_sizes, int _type) {
+	CV_Assert((0 <= d) && (d <= 2) && _sizes);
+	_type = CV_MAT_TYPE(_type);
+	if (data && ((d == dims) || ((d == 1) && (dims <= 2))) && (_type == type())) {
+		if ((d == 2) && (rows == _sizes[0]) && (cols == _sizes[1])) {
+			return;
+		}
+		int i;
+		for (i = 0; i < d; i++) {
+			if (size[i] != _sizes[i]) break;
+		}
+		if ((i == d) && ((d > 1) || (size[1] == 1))) {
+			return;
+		}
+	}
+	release();
+	if (d == 0) {
+		return;
+	}
+	flags = (_type & CV_MAT_TYPE_MASK) | MAGIC_VAL;
+	setSize(*this, d, _sizes, 0, true);
+	if (total() > 0) {
+		MatAllocator *a = allocator, *a0 = getStdAllocator();
+		if (!a) a = a0;
+		try {
+			u = a->allocate(dims, size, _type, 0, step.p, 0, USAGE_DEFAULT);
+			CV_Assert(u != 0);
+		} catch (...) {
+			if (a != a0) {
+				u = a0->allocate(dims, size, _type, 0, step.p, 0, USAGE_DEFAULT);
+			}
+			CV_Assert(u != 0);
+		}
+		CV_Assert(step[dims - 1] == (size_t)CV_ELEM_SIZE(flags));
+	}
+	addref();
+	finalizeHdr(*this);
+}
+
+void Mat::deallocate() {
+	if (u) {
+		(u->currAllocator ? u->currAllocator : allocator ? allocator : getStdAllocator())->unmap(u);
+	}
+	u = NULL;
+}
+
+void Mat::copySize(const Mat &m) {
+	setSize(*this, m.dims, 0, 0);
+	for (int i = 0; i < dims; i++) {
+		size[i] = m.size[i];
+		step[i] = m.step[i];
+	}
+}
+
+Mat::Mat(const Mat &m, const Range &_rowRange, const Range &_colRange)
+: flags(MAGIC_VAL), dims(0), rows(0), cols(0), data(0), datastart(0), dataend(0),
+  datalimit(0), allocator(0), u(0), size(&rows) {
+
+	CV_Assert(m.dims <= 2);
+	*this = m;
+	if ((_rowRange != Range::all()) && (_rowRange != Range(0, rows))) {
+		CV_Assert((0 <= _rowRange.start) && (_rowRange.start <= _rowRange.end) && (_rowRange.end <= m.rows));
+		rows = _rowRange.size();
+		data += step * _rowRange.start;
+		flags |= SUBMATRIX_FLAG;
+	}
+	if ((_colRange != Range::all()) && (_colRange != Range(0, cols))) {
+		CV_Assert((0 <= _colRange.start) && (_colRange.start <= _colRange.end) && (_colRange.end <= m.cols));
+		cols = _colRange.size();
+		data += _colRange.start * elemSize();
+		flags &= cols < m.cols ? ~CONTINUOUS_FLAG : -1;
+		flags |= SUBMATRIX_FLAG;
+	}
+	if (rows == 1) {
+		flags |= CONTINUOUS_FLAG;
+	}
+	if ((rows <= 0) || (cols <= 0)) {
+		release();
+		rows = cols = 0;
+	}
+}
+
+Mat::Mat(const Mat &m, const Rect &roi)
+: flags(m.flags), dims(2), rows(roi.height), cols(roi.width),
+  data(m.data + roi.y * m.step[0]), datastart(m.datastart), dataend(m.dataend),
+  datalimit(m.datalimit), allocator(m.allocator), u(m.u), size(&rows) {
+
+	CV_Assert(m.dims <= 2);
+	flags &= roi.width < m.cols ? ~CONTINUOUS_FLAG : -1;
+	flags |= roi.height == 1 ? CONTINUOUS_FLAG : 0;
+	const size_t esz = CV_ELEM_SIZE(flags);
+	data += roi.x * esz;
+	CV_Assert((0 <= roi.x) && (0 <= roi.width) && (roi.x + roi.width <= m.cols)
+		&& (0 <= roi.y) && (0 <= roi.height) && (roi.y + roi.height <= m.rows));
+	if (u) {
+		CV_XADD(&u->refcount, 1);
+	}
+	if ((roi.width < m.cols) || (roi.height < m.rows)) {
+		flags |= SUBMATRIX_FLAG;
+	}
+	step[0] = m.step[0];
+	step[1] = esz;
+	if ((rows <= 0) || (cols <= 0)) {
+		release();
+		rows = cols = 0;
+	}
+}
+
+Mat Mat::reshape(int new_cn, int new_rows) const {
+	const int cn = channels();
+	Mat hdr = *this;
+
+	CV_Assert(dims <= 2);
+	if (new_cn == 0) {
+		new_cn = cn;
+	}
+	int total_width = cols * cn;
+	if (((new_cn > total_width) || (total_width % new_cn != 0)) && (new_rows == 0)) {
+		new_rows = rows * total_width / new_cn;
+	}
+	if ((new_rows != 0) && (new_rows != rows)) {
+		const int total_size = total_width * rows;
+		if (!isContinuous()) {
+			CV_Error(Error::BadStep, "The matrix is not continuous, thus its number of rows can not be changed");
+		}
+		if ((unsigned)new_rows > (unsigned)total_size) {
+			CV_Error(Error::StsOutOfRange, "Bad new number of rows");
+		}
+		total_width = total_size / new_rows;
+		if (total_width * new_rows != total_size) {
+			CV_Error(Error::StsBadArg, "The total number of matrix elements is not divisible by the new number of rows");
+		}
+		hdr.rows = new_rows;
+		hdr.step[0] = total_width * elemSize1();
+	}
+	const int new_width = total_width / new_cn;
+	if (new_width * new_cn != total_width) {
+		CV_Error(Error::BadNumChannels, "The total width is not divisible by the new number of channels");
+	}
+	hdr.cols = new_width;
+	hdr.flags = (hdr.flags & ~CV_MAT_CN_MASK) | ((new_cn - 1) << CV_CN_SHIFT);
+	hdr.step[1] = CV_ELEM_SIZE(hdr.flags);
+	return hdr;
+}
+
+/** only cv::Mat is supported as destination on host */
+static Mat &host_output_mat(const _OutputArray &_dst) {
+	CV_Assert(_dst.kind() == _InputArray::MAT);
+	return *(Mat *)_dst.getObj();
+}
+
+void Mat::copyTo(OutputArray _dst) const {
+	Mat &dst = host_output_mat(_dst);
+	if (empty()) {
+		dst.release();
+		return;
+	}
+	if (data == dst.data) {
+		return;
+	}
+	dst.create(rows, cols, type());
+	const size_t len = cols * elemSize();
+	for (int y = 0; y < rows; y++) {
+		memcpy(dst.ptr(y), ptr(y), len);
+	}
+}
+
+/** only scalar value without mask is supported on host */
+Mat &Mat::setTo(InputArray _value, InputArray _mask) {
+	if (empty()) {
+		return *this;
+	}
+	CV_Assert((_value.kind() == _InputArray::MATX) && (_mask.kind() == _InputArray::NONE)
+		&& (channels() <= 4));
+	const double *value = (const double *)_value.getObj();
+	// one pixel of the value, then it is copied to all pixels
+	uchar pixel[CV_ELEM_SIZE(CV_64FC4)];
+	const int cn = channels();
+	for (int c = 0; c < cn; c++) {
+		switch (depth()) {
+		case CV_8U:  ((uchar *)pixel)[c] = saturate_cast<uchar>(value[c]); break;
+		case CV_16U: ((ushort *)pixel)[c] = saturate_cast<ushort>(value[c]); break;
+		case CV_32S: ((int *)pixel)[c] = saturate_cast<int>(value[c]); break;
+		case CV_32F: ((float *)pixel)[c] = saturate_cast<float>(value[c]); break;
+		default:
+			CV_Error(Error::StsNotImplemented, "not supported on host");
+		}
+	}
+	const size_t esz = elemSize();
+	for (int y = 0; y < rows; y++) {
+		uchar *d = ptr(y);
+		for (int x = 0; x < cols; x++, d += esz) {
+			memcpy(d, pixel, esz);
+		}
+	}
+	return *this;
+}
+
+template<typename S, typename D>
+static void host_convert(const Mat &src, Mat &dst, const double &alpha, const double &beta) {
+	const int n = src.cols * src.channels();
+	for (int y = 0; y < src.rows; y++) {
+		const S *s = src.ptr<S>(y);
+		D *d = dst.ptr<D>(y);
+		for (int x = 0; x < n; x++) {
+			d[x] = saturate_cast<D>(s[x] * alpha + beta);
+		}
+	}
+}
+
+template<typename S>
+static void host_convert(const Mat &src, Mat &dst, const double &alpha, const double &beta) {
+	switch (dst.depth()) {
+	case CV_8U:  host_convert<S, uchar>(src, dst, alpha, beta); break;
+	case CV_16U: host_convert<S, ushort>(src, dst, alpha, beta); break;
+	case CV_32F: host_convert<S, float>(src, dst, alpha, beta); break;
+	default:
+		CV_Error(Error::StsNotImplemented, "not supported on host");
+	}
+}
+
+/** only 8U/16U/32F are supported on host */
+void Mat::convertTo(OutputArray _dst, int _type, double alpha, double beta) const {
+	Mat &dst = host_output_mat(_dst);
+	if (empty()) {
+		dst.release();
+		return;
+	}
+	const int ddepth = _type < 0 ? depth() : CV_MAT_DEPTH(_type);
+	// converted into temporary matrix if the destination is the source itself
+	Mat temp;
+	Mat &out = (dst.data == data) ? temp : dst;
+	out.create(rows, cols, CV_MAKETYPE(ddepth, channels()));
+	switch (depth()) {
+	case CV_8U:  host_convert<uchar>(*this, out, alpha, beta); break;
+	case CV_16U: host_convert<ushort>(*this, out, alpha, beta); break;
+	case CV_32F: host_convert<float>(*this, out, alpha, beta); break;
+	default:
+		CV_Error(Error::StsNotImplemented, "not supported on host");
+	}
+	if (&out == &temp) {
+		dst = temp;
+	}
+}
+
+int _InputArray::kind() const {
+	return flags & KIND_MASK;
+}
+
+static _InputOutputArray _none;
+InputOutputArray noArray() {
+	return _none;
+}
+
+// parallel loops of imageproc run on WorkStealingPool, only the base class is needed
+ParallelLoopBody::~ParallelLoopBody() {}
+
+void RotatedRect::points(Point2f pt[]) const {
+	const double _angle = angle * CV_PI / 180.;
+	const float b = (float)cos(_angle) * 0.5f;
+	const float a = (float)sin(_angle) * 0.5f;
+	pt[0].x = center.x - a * size.height - b * size.width;
+	pt[0].y = center.y + b * size.height - a * size.width;
+	pt[1].x = center.x + a * size.height - b * size.width;
+	pt[1].y = center.y - b * size.height - a * size.width;
+	pt[2].x = 2 * center.x - pt[0].x;
+	pt[2].y = 2 * center.y - pt[0].y;
+	pt[3].x = 2 * center.x - pt[1].x;
+	pt[3].y = 2 * center.y - pt[1].y;
+}
+
+}	// namespace cv
+
+//--------------------------------------------------------------------------------
+// image processing, only what frame sources and tested stages use is implemented(8 bits only),
+// others raise cv::Exception(not supported on host)
+//--------------------------------------------------------------------------------
+namespace cv {
+
+static const Mat &host_input_mat(const _InputArray &_src) {
+	CV_Assert(_src.kind() == _InputArray::MAT);
+	return *(const Mat *)_src.getObj();
+}
+
+// YUV(BT.601, video range) to RGB in fixed point, same coefficients as OpenCV
+#define YUV_SHIFT 20
+#define YUV_CY 1220542
+#define YUV_CUB 2116026
+#define YUV_CUG (-409993)
+#define YUV_CVG (-852492)
+#define YUV_CVR 1673527
+
+static inline void yuv2rgba(const int &y, const int &u, const int &v, uchar *dst) {
+	const int yy = std::max(0, y - 16) * YUV_CY;
+	const int ruv = (1 << (YUV_SHIFT - 1)) + YUV_CVR * (v - 128);
+	const int guv = (1 << (YUV_SHIFT - 1)) + YUV_CVG * (v - 128) + YUV_CUG * (u - 128);
+	const int buv = (1 << (YUV_SHIFT - 1)) + YUV_CUB * (u - 128);
+	dst[0] = saturate_cast<uchar>((yy + ruv) >> YUV_SHIFT);
+	dst[1] = saturate_cast<uchar>((yy + guv) >> YUV_SHIFT);
+	dst[2] = saturate_cast<uchar>((yy + buv) >> YUV_SHIFT);
+	dst[3] = 255;
+}
+
+void cvtColor(InputArray _src, OutputArray _dst, int code, int dcn) {
+	const Mat src = host_input_mat(_src);
+	Mat &dst = host_output_mat(_dst);
+	CV_Assert(src.depth() == CV_8U);
+	switch (code) {
+	case COLOR_YUV2RGBA_YUY2:
+	{
+		CV_Assert((src.type() == CV_8UC2) && !(src.cols & 1));
+		dst.create(src.rows, src.cols, CV_8UC4);
+		for (int y = 0; y < src.rows; y++) {
+			const uchar *s = src.ptr(y);
+			uchar *d = dst.ptr(y);
+			for (int x = 0; x < src.cols; x += 2, s += 4, d += 8) {
+				yuv2rgba(s[0], s[1], s[3], d);
+				yuv2rgba(s[2], s[1], s[3], d + 4);
+			}
+		}
+		break;
+	}
+	case COLOR_YUV2RGBA_NV21:
+	{
+		CV_Assert((src.type() == CV_8UC1) && !(src.cols & 1) && (src.rows % 3 == 0));
+		const int height = src.rows * 2 / 3;
+		dst.create(height, src.cols, CV_8UC4);
+		for (int y = 0; y < height; y++) {
+			const uchar *s = src.ptr(y);
+			const uchar *vu = src.ptr(height + y / 2);
+			uchar *d = dst.ptr(y);
+			for (int x = 0; x < src.cols; x++, d += 4) {
+				yuv2rgba(s[x], vu[(x & ~1) + 1], vu[x & ~1], d);
+			}
+		}
+		break;
+	}
+	case COLOR_RGBA2GRAY:
+	{
+		// same fixed point coefficients as RGB2Gray<uchar>
+		CV_Assert(src.type() == CV_8UC4);
+		dst.create(src.rows, src.cols, CV_8UC1);
+		for (int y = 0; y < src.rows; y++) {
+			const uchar *s = src.ptr(y);
+			uchar *d = dst.ptr(y);
+			for (int x = 0; x < src.cols; x++, s += 4) {
+				d[x] = (uchar)((s[0] * 4899 + s[1] * 9617 + s[2] * 1868 + (1 << 13)) >> 14);
+			}
+		}
+		break;
+	}
+	case COLOR_BGR2RGBA:
+	{
+		CV_Assert(src.type() == CV_8UC3);
+		dst.create(src.rows, src.cols, CV_8UC4);
+		for (int y = 0; y < src.rows; y++) {
+			const uchar *s = src.ptr(y);
+			uchar *d = dst.ptr(y);
+			for (int x = 0; x < src.cols; x++, s += 3, d += 4) {
+				d[0] = s[2]; d[1] = s[1]; d[2] = s[0]; d[3] = 255;
+			}
+		}
+		break;
+	}
+	default:
+		CV_Error(Error::StsNotImplemented, "not supported on host");
+	}
+}
+
+void extractChannel(InputArray _src, OutputArray _dst, int coi) {
+	const Mat src = host_input_mat(_src);
+	Mat &dst = host_output_mat(_dst);
+	const int cn = src.channels();
+	CV_Assert((src.depth() == CV_8U) && (0 <= coi) && (coi < cn));
+	dst.create(src.rows, src.cols, CV_8UC1);
+	for (int y = 0; y < src.rows; y++) {
+		const uchar *s = src.ptr(y) + coi;
+		uchar *d = dst.ptr(y);
+		for (int x = 0; x < src.cols; x++, s += cn) {
+			d[x] = *s;
+		}
+	}
+}
+
+/**
+ * only INTER_NEAREST and INTER_AREA with integer scale down are supported,
+ * result of INTER_AREA is average of each block
+ */
+void resize(InputArray _src, OutputArray _dst, Size dsize, double, double, int interpolation) {
+	const Mat src = host_input_mat(_src);
+	Mat &dst = host_output_mat(_dst);
+	if ((interpolation == INTER_NEAREST) && !src.empty() && dsize.width && dsize.height) {
+		// same mapping as OpenCV, floor(x * src / dst)
+		const size_t esz = src.elemSize();
+		dst.create(dsize, src.type());
+		for (int y = 0; y < dsize.height; y++) {
+			const uchar *s = src.ptr(std::min(y * src.rows / dsize.height, src.rows - 1));
+			uchar *d = dst.ptr(y);
+			for (int x = 0; x < dsize.width; x++, d += esz) {
+				memcpy(d, s + std::min(x * src.cols / dsize.width, src.cols - 1) * esz, esz);
+			}
+		}
+		return;
+	}
+	if ((interpolation != INTER_AREA) || (src.depth() != CV_8U)
+		|| !dsize.width || !dsize.height
+		|| (src.cols % dsize.width) || (src.rows % dsize.height)) {
+		CV_Error(Error::StsNotImplemented, "not supported on host");
+	}
+	const int sx = src.cols / dsize.width, sy = src.rows / dsize.height;
+	const int cn = src.channels(), area = sx * sy;
+	dst.create(dsize, src.type());
+	for (int y = 0; y < dsize.height; y++) {
+		uchar *d = dst.ptr(y);
+		for (int x = 0; x < dsize.width; x++) {
+			for (int c = 0; c < cn; c++) {
+				int sum = 0;
+				for (int j = 0; j < sy; j++) {
+					const uchar *s = src.ptr(y * sy + j) + x * sx * cn + c;
+					for (int i = 0; i < sx; i++, s += cn) {
+						sum += *s;
+					}
+				}
+				*d++ = (uchar)((sum + area / 2) / area);
+			}
+		}
+	}
+}
+
+/** draw line by filling pixels within thickness / 2 from the segment, no anti-aliasing */
+void line(InputOutputArray _img, Point pt1, Point pt2, const Scalar &color,
+	int thickness, int lineType, int shift) {
+
+	Mat &img = host_output_mat(_img);
+	CV_Assert((img.depth() == CV_8U) && !shift);
+	const int cn = img.channels();
+	const double r = std::max(thickness, 1) / 2.0;
+	const double dx = pt2.x - pt1.x, dy = pt2.y - pt1.y;
+	const double len2 = dx * dx + dy * dy;
+	for (int y = 0; y < img.rows; y++) {
+		uchar *d = img.ptr(y);
+		for (int x = 0; x < img.cols; x++, d += cn) {
+			double t = len2 > 0 ? ((x - pt1.x) * dx + (y - pt1.y) * dy) / len2 : 0.0;
+			t = std::min(std::max(t, 0.0), 1.0);
+			const double ex = pt1.x + t * dx - x, ey = pt1.y + t * dy - y;
+			if (ex * ex + ey * ey <= r * r) {
+				for (int c = 0; c < cn; c++) {
+					d[c] = saturate_cast<uchar>(color[c]);
+				}
+			}
+		}
+	}
+}
+
+void polylines(InputOutputArray, InputArrayOfArrays, bool, const Scalar &, int, int, int) {
+	CV_Error(Error::StsNotImplemented, "not supported on host");
+}
+
+void rectangle(Mat &, Rect, const Scalar &, int, int, int) {
+	CV_Error(Error::StsNotImplemented, "not supported on host");
+}
+
+bool clipLine(Rect, Point &, Point &) {
+	CV_Error(Error::StsNotImplemented, "not supported on host");
+	return false;
+}
+
+void circle(InputOutputArray, Point, int, const Scalar &, int, int, int) {
+	CV_Error(Error::StsNotImplemented, "not supported on host");
+}
+
+void arrowedLine(InputOutputArray, Point, Point, const Scalar &, int, int, int, double) {
+	CV_Error(Error::StsNotImplemented, "not supported on host");
+}
+
+void Canny(InputArray, OutputArray, double, double, int, bool) {
+	CV_Error(Error::StsNotImplemented, "not supported on host");
+}
+
+void HoughLinesP(InputArray, OutputArray, double, double, int, double, double) {
+	CV_Error(Error::StsNotImplemented, "not supported on host");
+}
+
+void goodFeaturesToTrack(InputArray, OutputArray, int, double, double, InputArray, int, bool, double) {
+	CV_Error(Error::StsNotImplemented, "not supported on host");
+}
+
+int buildOpticalFlowPyramid(InputArray, OutputArrayOfArrays, Size, int, bool, int, int, bool) {
+	CV_Error(Error::StsNotImplemented, "not supported on host");
+	return 0;
+}
+
+void calcOpticalFlowPyrLK(InputArray, InputArray, InputArray, InputOutputArray,
+	OutputArray, OutputArray, Size, int, TermCriteria, int, double) {
+	CV_Error(Error::StsNotImplemented, "not supported on host");
+}
+
+void calcOpticalFlowFarneback(InputArray, InputArray, InputOutputArray,
+	double, int, int, int, int, double, int) {
+	CV_Error(Error::StsNotImplemented, "not supported on host");
+}
+
+/**
+ * 8-connectivity with CV_32S labels only,
+ * labels are numbered in raster order of the first pixel of each component same as OpenCV
+ */
+int connectedComponentsWithStats(InputArray _src, OutputArray _labels,
+	OutputArray _stats, OutputArray _centroids, int connectivity, int ltype) {
+
+	const Mat src = host_input_mat(_src);
+	Mat &labels = host_output_mat(_labels);
+	Mat &stats = host_output_mat(_stats);
+	Mat &centroids = host_output_mat(_centroids);
+	if ((connectivity != 8) || (ltype != CV_32S) || (src.type() != CV_8UC1)) {
+		CV_Error(Error::StsNotImplemented, "not supported on host");
+	}
+	labels.create(src.size(), CV_32S);
+	for (int y = 0; y < src.rows; y++) {
+		memset(labels.ptr(y), 0, src.cols * sizeof(int));
+	}
+	// flood fill of each component, label 0 is background
+	std::vector<Point> stack;
+	std::vector<int> stat;
+	std::vector<double> sum;
+	int n = 1;
+	stat.resize(CC_STAT_MAX);
+	sum.resize(2);
+	for (int y = 0; y < src.rows; y++) {
+		for (int x = 0; x < src.cols; x++) {
+			if (!src.at<uchar>(y, x) || labels.at<int>(y, x)) continue;
+			int left = x, top = y, right = x, bottom = y, area = 0;
+			double sx = 0, sy = 0;
+			labels.at<int>(y, x) = n;
+			stack.push_back(Point(x, y));
+			for ( ; !stack.empty() ; ) {
+				const Point p = stack.back();
+				stack.pop_back();
+				left = std::min(left, p.x); right = std::max(right, p.x);
+				top = std::min(top, p.y); bottom = std::max(bottom, p.y);
+				area++;
+				sx += p.x;
+				sy += p.y;
+				for (int j = std::max(p.y - 1, 0); j <= std::min(p.y + 1, src.rows - 1); j++) {
+					for (int i = std::max(p.x - 1, 0); i <= std::min(p.x + 1, src.cols - 1); i++) {
+						if (src.at<uchar>(j, i) && !labels.at<int>(j, i)) {
+							labels.at<int>(j, i) = n;
+							stack.push_back(Point(i, j));
+						}
+					}
+				}
+			}
+			stat.push_back(left);
+			stat.push_back(top);
+			stat.push_back(right - left + 1);
+			stat.push_back(bottom - top + 1);
+			stat.push_back(area);
+			sum.push_back(sx / area);
+			sum.push_back(sy / area);
+			n++;
+		}
+	}
+	// background
+	int left = src.cols, top = src.rows, right = -1, bottom = -1, area = 0;
+	double sx = 0, sy = 0;
+	for (int y = 0; y < src.rows; y++) {
+		for (int x = 0; x < src.cols; x++) {
+			if (!labels.at<int>(y, x)) {
+				left = std::min(left, x); right = std::max(right, x);
+				top = std::min(top, y); bottom = std::max(bottom, y);
+				area++;
+				sx += x;
+				sy += y;
+			}
+		}
+	}
+	stat[CC_STAT_LEFT] = left;
+	stat[CC_STAT_TOP] = top;
+	stat[CC_STAT_WIDTH] = right - left + 1;
+	stat[CC_STAT_HEIGHT] = bottom - top + 1;
+	stat[CC_STAT_AREA] = area;
+	sum[0] = area ? sx / area : 0;
+	sum[1] = area ? sy / area : 0;
+	stats.create(n, CC_STAT_MAX, CV_32S);
+	memcpy(stats.data, &stat[0], stat.size() * sizeof(int));
+	centroids.create(n, 2, CV_64F);
+	memcpy(centroids.data, &sum[0], sum.size() * sizeof(double));
+	return n;
+}
+
+/** image files can't be read on host, returns empty image same as when file is not found */
+Mat imread(const String &, int) {
+	return Mat();
+}
+
+typedef struct host_jpeg_error {
+	struct jpeg_error_mgr mgr;
+	jmp_buf jmp;
+} host_jpeg_error_t;
+
+static void host_jpeg_error_exit(j_common_ptr cinfo) {
+	longjmp(((host_jpeg_error_t *)cinfo->err)->jmp, 1);
+}
+
+/**
+ * decode JPEG with host libjpeg(-turbo) same as OpenCV does with its bundled libjpeg,
+ * IMREAD_REDUCED_XXX are passed as scale_denom so that scaled IDCT is used.
+ * only JPEG is supported, returns empty image on error
+ */
+Mat imdecode(InputArray _buf, int flags, Mat *dst) {
+	const Mat buf = host_input_mat(_buf);
+	Mat temp, &img = dst ? *dst : temp;
+	CV_Assert((buf.depth() == CV_8U) && buf.isContinuous());
+	const int scale = flags & IMREAD_REDUCED_GRAYSCALE_8 ? 8
+		: (flags & IMREAD_REDUCED_GRAYSCALE_4 ? 4
+		: (flags & IMREAD_REDUCED_GRAYSCALE_2 ? 2 : 1));
+	const bool color = (flags & IMREAD_COLOR) != 0;
+
+	struct jpeg_decompress_struct cinfo;
+	host_jpeg_error_t err;
+	cinfo.err = jpeg_std_error(&err.mgr);
+	err.mgr.error_exit = host_jpeg_error_exit;
+	jpeg_create_decompress(&cinfo);
+	if (setjmp(err.jmp)) {
+		jpeg_destroy_decompress(&cinfo);
+		img.release();
+		return img;
+	}
+	jpeg_mem_src(&cinfo, (unsigned char *)buf.data, (unsigned long)(buf.total() * buf.elemSize()));
+	jpeg_read_header(&cinfo, TRUE);
+	cinfo.scale_num = 1;
+	cinfo.scale_denom = scale;
+	cinfo.out_color_space = color ? JCS_EXT_BGR : JCS_GRAYSCALE;
+	jpeg_start_decompress(&cinfo);
+	img.create(cinfo.output_height, cinfo.output_width, color ? CV_8UC3 : CV_8UC1);
+	for ( ; cinfo.output_scanline < cinfo.output_height ; ) {
+		JSAMPROW row = img.ptr(cinfo.output_scanline);
+		jpeg_read_scanlines(&cinfo, &row, 1);
+	}
+	jpeg_finish_decompress(&cinfo);
+	jpeg_destroy_decompress(&cinfo);
+	return img;
+}
+
+}	// namespace cv
@@ -0,0 +1,215 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+
+/*
+ * host test of IPPboRing on any EGL/GLES3 implementation(e.g. Mesa surfaceless/llvmpipe)
+ * checks that the ring never blocks, maps only the newest signalled slot,
+ * keeps leased slots out of readback and reads only the requested region.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include "IPPboRing.h"
+#include "host_test.h"
+
+#define WIDTH 64
+#define HEIGHT 48
+#define DEPTH 3
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+/** create GLES3 context with offscreen frame buffer, return false if EGL/GLES3 is not available */
+static bool setup_gl(EGLDisplay &display) {
+	PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display
+		= (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	display = get_platform_display
+		? get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL)
+		: eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	if (!display || !eglInitialize(display, NULL, NULL)) {
+		display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+		if (!display || !eglInitialize(display, NULL, NULL)) return false;
+	}
+	const EGLint config_attribs[] = {
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_ES3_BIT_KHR,
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_NONE
+	};
+	EGLConfig config;
+	EGLint num_configs = 0;
+	if (!eglChooseConfig(display, config_attribs, &config, 1, &num_configs) || !num_configs) return false;
+	eglBindAPI(EGL_OPENGL_ES_API);
+	const EGLint context_attribs[] = { EGL_CONTEXT_CLIENT_VERSION, 3, EGL_NONE };
+	EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attribs);
+	if (context == EGL_NO_CONTEXT) return false;
+	if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) return false;
+	// render into texture attached to FBO, so no window/pbuffer surface is required
+	GLuint tex, fbo;
+	glGenTextures(1, &tex);
+	glBindTexture(GL_TEXTURE_2D, tex);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, WIDTH, HEIGHT, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glGenFramebuffers(1, &fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex, 0);
+	return glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+}
+
+static void clear(const int &value) {
+	glDisable(GL_SCISSOR_TEST);
+	glClearColor(value / 255.0f, 0, 0, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+}
+
+static void test_depth(void) {
+	IPPboRing ring;
+	TEST_ASSERT(!ring.isValid());
+	ring.init(WIDTH, HEIGHT, 0);
+	TEST_ASSERT_EQ(1, ring.depth());
+	ring.init(WIDTH, HEIGHT, MAX_PBO_NUM + 4);
+	TEST_ASSERT_EQ(MAX_PBO_NUM, ring.depth());
+	ring.init(WIDTH, HEIGHT, DEPTH);
+	TEST_ASSERT_EQ(DEPTH, ring.depth());
+	TEST_ASSERT(ring.isValid());
+	TEST_ASSERT_EQ(WIDTH * HEIGHT * 4, ring.size());
+	ring.release();
+	TEST_ASSERT(!ring.isValid());
+}
+
+/** requests beyond the depth are rejected instead of waiting and only the newest slot is mapped */
+static void test_newest(void) {
+	IPPboRing ring;
+	ring.init(WIDTH, HEIGHT, DEPTH);
+	for (int i = 0; i < DEPTH; i++) {
+		clear(10 * (i + 1));
+		TEST_ASSERT_EQ(0, ring.requestRead(100 + i));
+	}
+	TEST_ASSERT(ring.isFull());
+	TEST_ASSERT_EQ(DEPTH, ring.pending());
+	TEST_ASSERT_EQ(-1, ring.requestRead(200));
+	glFinish();
+
+	nsecs_t latency = -1;
+	int discarded = -1, slot = -1;
+	const uint8_t *p = ring.tryMap(latency, discarded, slot);
+	TEST_ASSERT(p != NULL);
+	if (p) {
+		TEST_ASSERT_EQ(DEPTH - 1, discarded);
+		TEST_ASSERT(latency >= 0);
+		TEST_ASSERT_EQ(100 + DEPTH - 1, ring.timestamp(slot));
+		TEST_ASSERT_EQ(10 * DEPTH, p[0]);
+		TEST_ASSERT_EQ(10 * DEPTH, p[(WIDTH * HEIGHT - 1) * 4]);
+		TEST_ASSERT_EQ(slot, ring.find(p));
+		TEST_ASSERT_EQ(1, ring.mapped());
+		TEST_ASSERT_EQ(0, ring.pending());
+	}
+	// nothing new was requested, so there is nothing to map
+	int slot2 = -1;
+	TEST_ASSERT(ring.tryMap(latency, discarded, slot2) == NULL);
+	TEST_ASSERT_EQ(-1, slot2);
+
+	// leased slot must not be overwritten while other slots are recycled,
+	// readback stops when head of the ring reaches the leased slot
+	int requested = 0;
+	for (int i = 0; i < DEPTH * 3; i++) {
+		clear(200 + i);
+		if (!ring.requestRead(300 + i)) requested++;
+		glFinish();
+		int s;
+		const uint8_t *q = ring.tryMap(latency, discarded, s);
+		if (q) {
+			TEST_ASSERT(s != slot);
+			TEST_ASSERT_EQ(200 + i, q[0]);
+			ring.unmap(s);
+		}
+	}
+	if (p) {
+		TEST_ASSERT_EQ(DEPTH - 1, requested);
+		TEST_ASSERT_EQ(10 * DEPTH, p[0]);
+		ring.unmap(slot);
+		TEST_ASSERT_EQ(-1, ring.find(p));
+		TEST_ASSERT_EQ(0, ring.requestRead(400));
+	}
+	TEST_ASSERT_EQ(0, ring.mapped());
+	ring.release();
+}
+
+/** only the requested region is transferred and the region is clipped by the frame */
+static void test_region(void) {
+	IPPboRing ring;
+	ring.init(WIDTH, HEIGHT, DEPTH);
+	const int rx = 10, ry = 20, rw = 30, rh = 8;
+	for (int i = 0; i < 2; i++) {
+		clear(0);
+		glEnable(GL_SCISSOR_TEST);
+		glScissor(rx, ry, rw, rh);
+		glClearColor(1.0f, 0, 0, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT);
+		glDisable(GL_SCISSOR_TEST);
+		if (i == 0) {
+			TEST_ASSERT_EQ(0, ring.requestRead(i, rx, ry, rw, rh));
+		} else {
+			TEST_ASSERT_EQ(0, ring.requestRead(i, 40, 40, 100, 100));
+		}
+		glFinish();
+		nsecs_t latency;
+		int discarded, slot;
+		const uint8_t *p = ring.tryMap(latency, discarded, slot);
+		TEST_ASSERT(p != NULL);
+		if (!p) continue;
+		int x, y, w, h;
+		ring.getRect(slot, x, y, w, h);
+		int red = 0;
+		for (int k = 0; k < w * h; k++) {
+			if (p[k * 4] == 255) red++;
+		}
+		if (i == 0) {
+			TEST_ASSERT_EQ(rx, x); TEST_ASSERT_EQ(ry, y);
+			TEST_ASSERT_EQ(rw, w); TEST_ASSERT_EQ(rh, h);
+			TEST_ASSERT_EQ(rw * rh, red);
+		} else {
+			TEST_ASSERT_EQ(40, x); TEST_ASSERT_EQ(40, y);
+			TEST_ASSERT_EQ(WIDTH - 40, w); TEST_ASSERT_EQ(HEIGHT - 40, h);
+			TEST_ASSERT_EQ(0, red);
+		}
+		ring.unmap(slot);
+	}
+	ring.release();
+}
+
+int main(int argc, char *argv[]) {
+	EGLDisplay display;
+	if (!setup_gl(display)) {
+		fprintf(stderr, "pbo_ring_test: EGL/GLES3 is not available, skipped\n");
+		return 0;
+	}
+	printf("GL_RENDERER=%s\n", glGetString(GL_RENDERER));
+	test_depth();
+	test_newest();
+	test_region();
+	TEST_ASSERT_EQ(GL_NO_ERROR, glGetError());
+	return TEST_RESULT("pbo_ring_test");
+}
@@ -0,0 +1,374 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+
+/*
+ * host test of stage pipeline(IPPipeline) with the stages that run on host.
+ * checks parsing of the spec, hand-off of the frames between segments(threads) in order,
+ * STAGE_SKIP_REST of "motion", replay of last results for unchanged frames,
+ * stage parameters/results by name and that packets return to the pipeline
+ * when a stage or preparing the result raises cv::Exception.
+ * "line" raises cv::Exception on host(Canny/HoughLinesP are not supported by opencv_host.cpp)
+ * and is used as a failing stage here.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <vector>
+
+#include "IPPipeline.h"
+#include "IPMotionDetector.h"
+#include "host_test.h"
+
+#define WIDTH 160
+#define HEIGHT 120
+// max waiting time for results[ms]
+#define MAX_WAIT_MS 5000
+
+typedef struct result_record {
+	int64_t seq;
+	int detect_type;
+	float activity;
+	// first pixel of gray scale result image, -1 if there is no result image
+	int pixel;
+	bool on_caller;
+} result_record_t;
+
+class TestListener : public IPPipelineListener {
+private:
+	Mutex mLock;
+	const pthread_t mCaller;
+	std::vector<result_record_t> mRecords;
+	int mReady;
+public:
+	TestListener() : mCaller(pthread_self()), mReady(0) {};
+	virtual ~TestListener() {};
+	virtual void onPipelineResult(JNIEnv *env, stage_context_t &ctx) {
+		result_record_t record;
+		record.seq = ctx.info.seq;
+		record.detect_type = ctx.detect_type;
+		record.activity = ctx.results[RESULT_IX_MOTION_ACTIVITY];
+		record.pixel = ctx.result.empty() ? -1 : ctx.result.data[0];
+		record.on_caller = pthread_equal(pthread_self(), mCaller) != 0;
+		Mutex::Autolock lock(mLock);
+		mRecords.push_back(record);
+	};
+	virtual void onPipelineReady() {
+		Mutex::Autolock lock(mLock);
+		mReady++;
+	};
+	int count() {
+		Mutex::Autolock lock(mLock);
+		return (int)mRecords.size();
+	};
+	int ready() {
+		Mutex::Autolock lock(mLock);
+		return mReady;
+	};
+	/** record of ix-th result, seq is -1 if it has not arrived */
+	result_record_t get(const int &ix) {
+		Mutex::Autolock lock(mLock);
+		if (ix < (int)mRecords.size()) {
+			return mRecords[ix];
+		}
+		result_record_t none;
+		memset(&none, 0, sizeof(none));
+		none.seq = none.pixel = -1;
+		return none;
+	};
+	/** wait until n results arrived */
+	bool wait(const int &n) {
+		for (int i = 0; (count() < n) && (i < MAX_WAIT_MS); i++) {
+			usleep(1000);
+		}
+		return count() >= n;
+	};
+	/** wait until all packets returned, i.e. n frames passed through last segment */
+	bool waitReady(const int &n) {
+		for (int i = 0; (ready() < n) && (i < MAX_WAIT_MS); i++) {
+			usleep(1000);
+		}
+		return ready() >= n;
+	};
+};
+
+static stage_context_t make_ctx(const int64_t &seq, const int &result_frame_type,
+	const bool &unchanged = false) {
+
+	stage_context_t ctx;
+	memset(&ctx.info, 0, sizeof(ctx.info));
+	ctx.info.seq = seq;
+	ctx.width = WIDTH;
+	ctx.height = HEIGHT;
+	ctx.roi = cv::Rect(0, 0, WIDTH, HEIGHT);
+	ctx.dequeued_time_ns = 0;
+	ctx.result_frame_type = result_frame_type;
+	ctx.result_format = RESULT_FORMAT_GRAY;
+	memset(ctx.results, 0, sizeof(ctx.results));
+	ctx.detect_type = TYPE_NON;
+	ctx.allocator = NULL;
+	ctx.unchanged = unchanged;
+	return ctx;
+}
+
+/** RGBA frame of the gray value */
+static cv::Mat rgba_frame(const int &value) {
+	cv::Mat rgba(HEIGHT, WIDTH, CV_8UC4);
+	for (size_t i = 0; i < rgba.total(); i++) {
+		uint8_t *p = rgba.data + i * 4;
+		p[0] = p[1] = p[2] = (uint8_t)value;
+		p[3] = 0xff;
+	}
+	return rgba;
+}
+
+/** RGBA frame of the gray value with a square of other value */
+static cv::Mat rgba_frame(const int &value, const cv::Rect &rect, const int &rect_value) {
+	cv::Mat rgba = rgba_frame(value);
+	for (int y = rect.y; y < rect.y + rect.height; y++) {
+		for (int x = rect.x; x < rect.x + rect.width; x++) {
+			uint8_t *p = rgba.ptr<uint8_t>(y) + x * 4;
+			p[0] = p[1] = p[2] = (uint8_t)rect_value;
+		}
+	}
+	return rgba;
+}
+
+/** wait until the pipeline can accept the frame and pass it */
+static int feed(IPPipeline &pipeline, stage_context_t ctx, const cv::Mat &frame) {
+	for (int i = 0; !pipeline.canAccept() && (i < MAX_WAIT_MS); i++) {
+		usleep(1000);
+	}
+	return pipeline.process(NULL, ctx, frame);
+}
+
+static void test_create(void) {
+	static const char *invalid[] = {
+		"unknown", "gray,unknown", "|gray", "gray||rgba", " , ", "gray|rgba|rgba|rgba|rgba",
+	};
+	for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+		IPPipeline *pipeline = IPPipeline::create(invalid[i]);
+		if (pipeline) {
+			fprintf(stderr, "spec should be rejected:%s\n", invalid[i]);
+		}
+		TEST_ASSERT(!pipeline);
+		delete pipeline;
+	}
+	IPPipeline *pipeline = IPPipeline::create(NULL);
+	TEST_ASSERT(pipeline && !strcmp(DEFAULT_PIPELINE, pipeline->spec()) && (pipeline->size() == 1));
+	delete pipeline;
+	pipeline = IPPipeline::create(" gray , motion | rgba ");
+	TEST_ASSERT(pipeline && (pipeline->size() == 3) && (pipeline->segments() == 2));
+	delete pipeline;
+}
+
+static void test_segments(const char *spec, const int &num_segments) {
+	TestListener listener;
+	IPPipeline *pipeline = IPPipeline::create(spec);
+	TEST_ASSERT(pipeline && (pipeline->segments() == num_segments));
+	if (!pipeline) return;
+	// not started yet
+	stage_context_t ctx = make_ctx(0, RESULT_FRAME_TYPE_DST);
+	TEST_ASSERT_EQ(-1, pipeline->process(NULL, ctx, rgba_frame(0)));
+	TEST_ASSERT_EQ(0, pipeline->start(&listener));
+
+	const int n = 100;
+	for (int i = 0; i < n; i++) {
+		TEST_ASSERT_EQ(0, feed(*pipeline, make_ctx(i, RESULT_FRAME_TYPE_DST), rgba_frame(20 + i)));
+	}
+	TEST_ASSERT(listener.wait(n));
+	pipeline->stop();
+	TEST_ASSERT_EQ(n, listener.count());
+	int errors = 0;
+	for (int i = 0; i < listener.count(); i++) {
+		const result_record_t r = listener.get(i);
+		// in order, and each frame kept its own data while later segments processed it
+		errors += (r.seq != i) || (r.pixel != 20 + i);
+		errors += r.on_caller != (num_segments == 1);
+	}
+	TEST_ASSERT_EQ(0, errors);
+
+	stage_stats_t stats[PIPELINE_MAX_STAGES];
+	const int num = pipeline->getStats(stats, PIPELINE_MAX_STAGES);
+	TEST_ASSERT_EQ(pipeline->size(), num);
+	for (int i = 0; i < num; i++) {
+		TEST_ASSERT_EQ(n, stats[i].count);
+	}
+	TEST_ASSERT_EQ(num_segments - 1, stats[num - 1].segment);
+	delete pipeline;
+}
+
+static void test_skip_rest(void) {
+	TestListener listener;
+	IPPipeline *pipeline = IPPipeline::create("gray,motion|rgba");
+	TEST_ASSERT(pipeline != NULL);
+	if (!pipeline) return;
+	pipeline->start(&listener);
+	// still frames, then an object appears for a few frames, then still frames again
+	const int n = 40, moving_from = 10, moving_to = 12;
+	const cv::Rect object(40, 40, 40, 40);
+	for (int i = 0; i < n; i++) {
+		const bool moving = (i >= moving_from) && (i < moving_to);
+		feed(*pipeline, make_ctx(i, RESULT_FRAME_TYPE_NON), rgba_frame(40, object, moving ? 200 : 40));
+	}
+	TEST_ASSERT(listener.wait(n));
+	pipeline->stop();
+	// results of skipped frames are still passed to the listener
+	TEST_ASSERT_EQ(n, listener.count());
+	int activities = 0;
+	for (int i = 0; i < listener.count(); i++) {
+		activities += listener.get(i).activity > 0;
+	}
+	TEST_ASSERT_EQ(moving_to - moving_from, activities);
+	stage_stats_t stats[3];
+	pipeline->getStats(stats, 3);
+	TEST_ASSERT_EQ(n, stats[0].count);
+	TEST_ASSERT_EQ(n, stats[1].count);
+	// "rgba" runs only while motion and hold frames
+	TEST_ASSERT_EQ(moving_to - moving_from + MOTION_HOLD_FRAMES, stats[2].count);
+	delete pipeline;
+}
+
+static void test_unchanged(void) {
+	TestListener listener;
+	IPPipeline *pipeline = IPPipeline::create("gray|motion");
+	TEST_ASSERT(pipeline != NULL);
+	if (!pipeline) return;
+	pipeline->start(&listener);
+	feed(*pipeline, make_ctx(0, RESULT_FRAME_TYPE_DST), rgba_frame(40));
+	feed(*pipeline, make_ctx(1, RESULT_FRAME_TYPE_DST), rgba_frame(40, cv::Rect(40, 40, 40, 40), 200));
+	// stages are skipped and results of last processed frame are passed again without result image
+	for (int i = 2; i < 6; i++) {
+		feed(*pipeline, make_ctx(i, RESULT_FRAME_TYPE_DST, true), rgba_frame(40));
+	}
+	TEST_ASSERT(listener.wait(6));
+	pipeline->stop();
+	const result_record_t last = listener.get(1);
+	TEST_ASSERT(last.activity > 0);
+	TEST_ASSERT(last.pixel >= 0);
+	for (int i = 2; i < listener.count(); i++) {
+		const result_record_t r = listener.get(i);
+		TEST_ASSERT(r.activity == last.activity);
+		TEST_ASSERT_EQ(last.detect_type, r.detect_type);
+		TEST_ASSERT_EQ(-1, r.pixel);
+	}
+	stage_stats_t stats[2];
+	pipeline->getStats(stats, 2);
+	TEST_ASSERT_EQ(2, stats[0].count);
+	TEST_ASSERT_EQ(2, stats[1].count);
+	// results are not replayed after reset
+	pipeline->reset();
+	pipeline->start(&listener);
+	feed(*pipeline, make_ctx(6, RESULT_FRAME_TYPE_DST, true), rgba_frame(40));
+	TEST_ASSERT(listener.wait(7));
+	pipeline->stop();
+	TEST_ASSERT(listener.get(6).activity == 0.0f);
+	delete pipeline;
+}
+
+static void test_parameter(void) {
+	const float interval = 5;
+	const float color[] = { 0, 30, 50, 255, 50, 255 };
+	const float bad_color[] = { 0, 30, 200, 100, 50, 255 };
+	TEST_ASSERT_EQ(0, IPPipeline::validateParameter("curve", "detect_interval", &interval, 1));
+	TEST_ASSERT_EQ(0, IPPipeline::validateParameter("line", "detect_interval", &interval, 1));
+	TEST_ASSERT_EQ(0, IPPipeline::validateParameter("color", "color", color, 6));
+	TEST_ASSERT_EQ(-1, IPPipeline::validateParameter("color", "color", bad_color, 6));
+	TEST_ASSERT_EQ(-1, IPPipeline::validateParameter("color", "detect_interval", &interval, 1));
+	TEST_ASSERT_EQ(-1, IPPipeline::validateParameter("gray", "detect_interval", &interval, 1));
+	TEST_ASSERT_EQ(-1, IPPipeline::validateParameter("unknown", "detect_interval", &interval, 1));
+	TEST_ASSERT_EQ(-1, IPPipeline::validateParameter("curve", "detect_interval", &interval, -1));
+	TEST_ASSERT_EQ(-1, IPPipeline::validateParameter("curve", "detect_interval", NULL, 1));
+
+	IPPipeline *pipeline = IPPipeline::create("gray,curve|curve,color");
+	TEST_ASSERT(pipeline != NULL);
+	if (!pipeline) return;
+	// number of the stages that the parameter was set
+	TEST_ASSERT_EQ(2, pipeline->setParameter("curve", "detect_interval", &interval, 1));
+	TEST_ASSERT_EQ(1, pipeline->setParameter("color", "color", color, 6));
+	TEST_ASSERT_EQ(0, pipeline->setParameter("line", "detect_interval", &interval, 1));
+	TEST_ASSERT_EQ(-1, pipeline->setParameter("gray", "detect_interval", &interval, 1));
+	float values[4];
+	int64_t seq = 0;
+	TEST_ASSERT_EQ(-1, pipeline->getResult("gray", "flow", values, 4, seq));
+	TEST_ASSERT_EQ(-1, pipeline->getResult("dense_flow", "flow", values, 4, seq));
+	delete pipeline;
+}
+
+static void test_exception(const char *spec) {
+	TestListener listener;
+	IPPipeline *pipeline = IPPipeline::create(spec);
+	TEST_ASSERT(pipeline != NULL);
+	if (!pipeline) return;
+	pipeline->start(&listener);
+	// more frames than packets, process would fail if a dropped packet was lost
+	const int n = 12;
+	for (int i = 0; i < n; i++) {
+		TEST_ASSERT_EQ(0, feed(*pipeline, make_ctx(i, RESULT_FRAME_TYPE_NON), rgba_frame(40)));
+	}
+	// all frames went through last segment
+	TEST_ASSERT(listener.waitReady(n));
+	// dropped frames are not passed to the listener
+	TEST_ASSERT_EQ(0, listener.count());
+	pipeline->stop();
+	delete pipeline;
+}
+
+static void test_result_exception(void) {
+	TestListener listener;
+	IPPipeline *pipeline = IPPipeline::create("gray|rgba");
+	TEST_ASSERT(pipeline != NULL);
+	if (!pipeline) return;
+	pipeline->start(&listener);
+	// region of interest outside of the result image, preparing the result raises cv::Exception
+	const int n = 10;
+	for (int i = 0; i < n; i++) {
+		stage_context_t ctx = make_ctx(i, RESULT_FRAME_TYPE_SRC_LINE);
+		ctx.roi = cv::Rect(WIDTH / 2, 0, WIDTH, HEIGHT);
+		TEST_ASSERT_EQ(0, feed(*pipeline, ctx, rgba_frame(40)));
+	}
+	TEST_ASSERT(listener.waitReady(n));
+	TEST_ASSERT_EQ(0, listener.count());
+	// and the pipeline still works
+	TEST_ASSERT_EQ(0, feed(*pipeline, make_ctx(n, RESULT_FRAME_TYPE_DST), rgba_frame(40)));
+	TEST_ASSERT(listener.wait(1));
+	pipeline->stop();
+	TEST_ASSERT_EQ(40, listener.get(0).pixel);
+	delete pipeline;
+}
+
+int main(int argc, char *argv[]) {
+	test_create();
+	test_segments("gray_rgba", 1);
+	test_segments("gray|rgba", 2);
+	test_segments("gray|rgba|rgba", 3);
+	test_skip_rest();
+	test_unchanged();
+	test_parameter();
+	test_exception("line");
+	test_exception("gray|line");
+	test_exception("gray|rgba,line|rgba");
+	test_result_exception();
+	return TEST_RESULT("pipeline_test");
+}
@@ -0,0 +1,147 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+
+/*
+ * scaling benchmark of WorkStealingPool with 1 to 8 threads(including caller thread),
+ * runs RGBA->gray kernel of 1920x1080 frame as tiles of about TILE_BYTES, same as tile-parallel stages.
+ *   uniform: every tile costs same
+ *   skewed:  the last quarter of tiles costs 8 times more, work stealing should balance it
+ * the speedup is limited by the number of online cpus that is also printed.
+ * every iteration must be executed exactly once and output must match single thread result,
+ * returns non-zero if they fail.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+
+#include "Timers.h"
+#include "WorkStealingPool.h"
+#include "IPParallel.h"
+
+#define WIDTH 1920
+#define HEIGHT 1080
+#define ITERATIONS 50
+#define MAX_THREADS 8
+#define SKEW 8
+
+class GrayTask : public WorkStealingTask {
+public:
+	const uint8_t *src;
+	uint8_t *dst;
+	int tile_rows;
+	// tiles from this index repeat the kernel SKEW times
+	int skew_from;
+	virtual void run(const int &begin, const int &end) {
+		for (int tile = begin; tile < end; tile++) {
+			const int repeat = tile >= skew_from ? SKEW : 1;
+			const int y0 = tile * tile_rows;
+			const int y1 = y0 + tile_rows < HEIGHT ? y0 + tile_rows : HEIGHT;
+			for (int n = 0; n < repeat; n++) {
+				for (int y = y0; y < y1; y++) {
+					const uint8_t *s = src + (size_t)y * WIDTH * 4;
+					uint8_t *d = dst + (size_t)y * WIDTH;
+					for (int x = 0; x < WIDTH; x++, s += 4) {
+						d[x] = (uint8_t)((s[0] * 77 + s[1] * 150 + s[2] * 29) >> 8);
+					}
+				}
+			}
+		}
+	};
+};
+
+class CountTask : public WorkStealingTask {
+public:
+	volatile int *hits;
+	virtual void run(const int &begin, const int &end) {
+		for (int i = begin; i < end; i++) {
+			__sync_fetch_and_add(&hits[i], 1);
+		}
+	};
+};
+
+static double measure(WorkStealingPool &pool, GrayTask &task, const int &tiles) {
+	// warm up
+	pool.parallelFor(0, tiles, 1, task);
+	const nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
+	for (int i = 0; i < ITERATIONS; i++) {
+		pool.parallelFor(0, tiles, 1, task);
+	}
+	return (systemTime(SYSTEM_TIME_MONOTONIC) - start) / 1e6 / ITERATIONS;
+}
+
+int main(int argc, char *argv[]) {
+	std::vector<uint8_t> src((size_t)WIDTH * HEIGHT * 4), dst(WIDTH * HEIGHT), expected(WIDTH * HEIGHT);
+	for (size_t i = 0; i < src.size(); i++) {
+		src[i] = (uint8_t)((i * 2654435761u) >> 24);
+	}
+	WorkStealingPool &pool = WorkStealingPool::getInstance();
+	GrayTask task;
+	task.src = &src[0];
+	task.tile_rows = TILE_BYTES / (WIDTH * 4) > 0 ? TILE_BYTES / (WIDTH * 4) : 1;
+	const int tiles = (HEIGHT + task.tile_rows - 1) / task.tile_rows;
+	task.dst = &expected[0];
+	task.skew_from = tiles;
+	task.run(0, tiles);
+
+	printf("online cpus=%ld, %dx%d RGBA->gray, %d tiles of %d rows\n",
+		sysconf(_SC_NPROCESSORS_ONLN), WIDTH, HEIGHT, tiles, task.tile_rows);
+	printf("threads  uniform[ms]  speedup  skewed[ms]  speedup\n");
+	int failed = 0;
+	double base_uniform = 0, base_skewed = 0;
+	for (int n = 1; n <= MAX_THREADS; n++) {
+		// worker threads except caller thread
+		pool.setNumThreads(n - 1);
+		// every iteration is executed exactly once with odd grain
+		std::vector<int> hits(10007);
+		CountTask count;
+		count.hits = &hits[0];
+		if (pool.parallelFor(0, (int)hits.size(), 3, count)) failed++;
+		for (size_t i = 0; i < hits.size(); i++) {
+			if (hits[i] != 1) {
+				fprintf(stderr, "threads=%d: iteration %d executed %d times\n", n, (int)i, hits[i]);
+				failed++;
+				break;
+			}
+		}
+		task.dst = &dst[0];
+		task.skew_from = tiles;
+		memset(&dst[0], 0, dst.size());
+		const double uniform = measure(pool, task, tiles);
+		if (memcmp(&dst[0], &expected[0], dst.size())) {
+			fprintf(stderr, "threads=%d: output mismatch\n", n);
+			failed++;
+		}
+		task.skew_from = tiles - tiles / 4;
+		const double skewed = measure(pool, task, tiles);
+		if (n == 1) {
+			base_uniform = uniform;
+			base_skewed = skewed;
+		}
+		printf("%7d  %11.3f  %7.2f  %10.3f  %7.2f\n", pool.getNumThreads(),
+			uniform, base_uniform / uniform, skewed, base_skewed / skewed);
+	}
+	return failed ? 1 : 0;
+}
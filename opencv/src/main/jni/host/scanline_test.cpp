@@ -0,0 +1,139 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+
+/*
+ * host test of the scanline search and robust line fit(IPScanline)
+ * that line/curve detectors use while tracking.
+ * checks pairing of rising/falling edges on rows and columns, single edge fallback,
+ * contrast threshold, and that the line fit rejects outliers and counts inliers.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+
+#include "IPScanline.h"
+#include "host_test.h"
+
+#define LEN 64
+#define BACK 50
+#define FORE 200
+
+/** fill the scanline with background and a band of foreground[from, to] */
+static void fill_band(uint8_t *p, const int &stride, const int &from, const int &to) {
+	for (int i = 0; i < LEN; i++) {
+		p[i * stride] = (i >= from) && (i <= to) ? FORE : BACK;
+	}
+}
+
+static void test_pair(void) {
+	uint8_t row[LEN];
+	int strength;
+	fill_band(row, 1, 20, 27);
+	const float center = scan_line_center(row, 1, LEN, 24, 16, strength);
+	TEST_ASSERT(fabsf(center - 23.5f) <= 1.0f);
+	TEST_ASSERT_EQ(FORE - BACK, strength);
+
+	// same band on a column of the image
+	const int stride = 5;
+	uint8_t col[LEN * stride];
+	memset(col, 0, sizeof(col));
+	fill_band(col + 2, stride, 20, 27);
+	const float center2 = scan_line_center(col + 2, stride, LEN, 24, 16, strength);
+	TEST_ASSERT(center2 == center);
+	TEST_ASSERT_EQ(FORE - BACK, strength);
+}
+
+static void test_single_edge(void) {
+	uint8_t row[LEN];
+	int strength;
+	// band is wider than max_width, edges are not paired and rising edge wins the tie
+	fill_band(row, 1, 20, 59);
+	const float center = scan_line_center(row, 1, LEN, 24, 16, strength);
+	TEST_ASSERT(fabsf(center - 19.5f) <= 1.0f);
+	TEST_ASSERT_EQ(FORE - BACK, strength);
+	// only falling edge
+	fill_band(row, 1, 0, 40);
+	const float center2 = scan_line_center(row, 1, LEN, 24, 16, strength);
+	TEST_ASSERT(fabsf(center2 - 40.5f) <= 1.0f);
+	TEST_ASSERT_EQ(FORE - BACK, strength);
+}
+
+static void test_no_edge(void) {
+	uint8_t row[LEN];
+	int strength = 1;
+	fill_band(row, 1, 20, 27);
+	// contrast is less than threshold
+	TEST_ASSERT(scan_line_center(row, 1, LEN, FORE - BACK + 1, 16, strength) < 0);
+	TEST_ASSERT_EQ(0, strength);
+	// flat
+	memset(row, BACK, sizeof(row));
+	TEST_ASSERT(scan_line_center(row, 1, LEN, 24, 16, strength) < 0);
+	// too short
+	TEST_ASSERT(scan_line_center(row, 1, 2, 24, 16, strength) < 0);
+}
+
+static void test_fit(void) {
+	std::vector<cv::Point2f> points;
+	std::vector<float> work;
+	cv::Point2f center, dir;
+	// y = 0.5x + 10 with small noise and gross outliers
+	for (int i = 0; i < 20; i++) {
+		const float x = i * 4.0f;
+		points.push_back(cv::Point2f(x, 0.5f * x + 10.0f + ((i & 1) ? 0.5f : -0.5f)));
+	}
+	points.push_back(cv::Point2f(10.0f, 60.0f));
+	points.push_back(cv::Point2f(30.0f, -20.0f));
+	points.push_back(cv::Point2f(70.0f, 90.0f));
+	const int inliers = fit_line_robust(points, center, dir, 2.0f, work);
+	TEST_ASSERT_EQ(20, inliers);
+	TEST_ASSERT(fabsf(dir.x * dir.x + dir.y * dir.y - 1.0f) < 1e-4f);
+	TEST_ASSERT(fabsf(dir.y / dir.x - 0.5f) < 0.02f);
+	TEST_ASSERT(fabsf(center.y - (0.5f * center.x + 10.0f)) < 0.5f);
+
+	// vertical line
+	points.clear();
+	for (int i = 0; i < 10; i++) {
+		points.push_back(cv::Point2f(5.0f, i * 3.0f));
+	}
+	TEST_ASSERT_EQ(10, fit_line_robust(points, center, dir, 1.0f, work));
+	TEST_ASSERT(fabsf(dir.x) < 1e-4f);
+	TEST_ASSERT(fabsf(center.x - 5.0f) < 1e-4f);
+
+	// two points are enough, one is not
+	points.resize(2);
+	TEST_ASSERT_EQ(2, fit_line_robust(points, center, dir, 1.0f, work));
+	points.resize(1);
+	TEST_ASSERT_EQ(0, fit_line_robust(points, center, dir, 1.0f, work));
+	points.clear();
+	TEST_ASSERT_EQ(0, fit_line_robust(points, center, dir, 1.0f, work));
+}
+
+int main(int argc, char *argv[]) {
+	test_pair();
+	test_single_edge();
+	test_no_edge();
+	test_fit();
+	return TEST_RESULT("scanline_test");
+}
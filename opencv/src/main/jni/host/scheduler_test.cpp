@@ -0,0 +1,215 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+
+/*
+ * host test of IPScheduler
+ * checks priority/frame budget, that each client is processed by one worker thread at a time,
+ * that #signal wakes up idle worker thread without lost wake up,
+ * and that adding/removing clients from several threads never hangs.
+ */
+#include <stdio.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <vector>
+#include <algorithm>
+
+#include "IPScheduler.h"
+#include "host_test.h"
+
+// the whole test is killed by SIGALRM if it hangs[s]
+#define WATCHDOG_SEC 120
+
+class TestClient : public IPSchedulerClient {
+public:
+	volatile int queued;
+	volatile int processed;
+	volatile int concurrent;
+	int max_concurrent;
+	useconds_t work_us;
+	// time when the frame was queued, to measure wake up latency
+	volatile nsecs_t queued_time_ns;
+	std::vector<nsecs_t> latency;
+
+	TestClient(const useconds_t &work = 0)
+	: queued(0), processed(0), concurrent(0), max_concurrent(0), work_us(work), queued_time_ns(0) {};
+	virtual ~TestClient() {};
+	void queue() {
+		if (__sync_fetch_and_add(&queued, 0) < 1) {
+			queued_time_ns = systemTime(SYSTEM_TIME_MONOTONIC);
+			__sync_fetch_and_add(&queued, 1);
+		}
+	};
+	virtual bool hasFrame() { return __sync_fetch_and_add(&queued, 0) > 0; };
+	virtual void processFrame(JNIEnv *env) {
+		const int c = __sync_add_and_fetch(&concurrent, 1);
+		if (c > max_concurrent) max_concurrent = c;
+		if (__sync_fetch_and_add(&queued, 0) > 0) {
+			latency.push_back(systemTime(SYSTEM_TIME_MONOTONIC) - queued_time_ns);
+			__sync_fetch_and_sub(&queued, 1);
+			__sync_fetch_and_add(&processed, 1);
+		}
+		if (work_us) usleep(work_us);
+		__sync_fetch_and_sub(&concurrent, 1);
+	};
+};
+
+static void test_priority(void) {
+	IPScheduler &scheduler = IPScheduler::getInstance();
+	scheduler.setNumThreads(2);
+	TestClient a(5000), b(5000), c(5000);
+	TEST_ASSERT_EQ(0, scheduler.add(&a, 10, 0.0f));
+	TEST_ASSERT_EQ(0, scheduler.add(&b, 0, 20.0f));
+	TEST_ASSERT_EQ(0, scheduler.add(&c, 0, 0.0f));
+	TEST_ASSERT_EQ(-1, scheduler.add(&c, 0, 0.0f));
+	const nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
+	for (int i = 0; i < 100; i++) {
+		a.queue(); b.queue(); c.queue();
+		scheduler.signal();
+		usleep(10000);
+	}
+	const double sec = (systemTime(SYSTEM_TIME_MONOTONIC) - start) / 1e9;
+	scheduler_stats_t stats, total;
+	int num_threads, num_clients;
+	TEST_ASSERT_EQ(0, scheduler.getStats(&a, stats, total, num_threads, num_clients));
+	TEST_ASSERT_EQ(a.processed, stats.processed);
+	TEST_ASSERT_EQ(2, num_threads);
+	TEST_ASSERT_EQ(3, num_clients);
+	printf("%.2fs: a(priority 10)=%d, b(budget 20fps)=%d, c=%d\n", sec, a.processed, b.processed, c.processed);
+	TEST_ASSERT(a.processed >= 90);
+	TEST_ASSERT(b.processed <= (int)(sec * 20 + 2));
+	TEST_ASSERT(c.processed > 0);
+	TEST_ASSERT(a.max_concurrent == 1 && b.max_concurrent == 1 && c.max_concurrent == 1);
+	scheduler.remove(&b);
+	scheduler.getStats(NULL, stats, total, num_threads, num_clients);
+	TEST_ASSERT_EQ(2, num_clients);
+	scheduler.remove(&a);
+	scheduler.remove(&c);
+	// stats of removed clients are kept until worker threads start again
+	scheduler.getStats(NULL, stats, total, num_threads, num_clients);
+	TEST_ASSERT_EQ(a.processed + b.processed + c.processed, total.processed);
+	TEST_ASSERT_EQ(0, num_threads);
+	TEST_ASSERT_EQ(0, num_clients);
+	// restart, stats are since worker threads started
+	TestClient d;
+	TEST_ASSERT_EQ(0, scheduler.add(&d));
+	scheduler.getStats(&d, stats, total, num_threads, num_clients);
+	TEST_ASSERT_EQ(2, num_threads);
+	TEST_ASSERT_EQ(0, total.processed);
+	scheduler.remove(&d);
+}
+
+/** every frame should be picked up soon after #signal, not after the safety timeout of worker thread */
+static void test_wakeup(void) {
+	IPScheduler &scheduler = IPScheduler::getInstance();
+	scheduler.setNumThreads(2);
+	TestClient a;
+	scheduler.add(&a);
+	const int num = 500;
+	for (int i = 0; i < num; i++) {
+		// wait until previous frame was processed so that every frame needs wake up
+		for (int j = 0; (j < 1000) && a.hasFrame(); j++) {
+			usleep(100);
+		}
+		a.queue();
+		scheduler.signal();
+		usleep(1000);
+	}
+	for (int j = 0; (j < 1000) && a.hasFrame(); j++) {
+		usleep(1000);
+	}
+	scheduler.remove(&a);
+	std::vector<nsecs_t> &latency = a.latency;
+	TEST_ASSERT_EQ(num, (int)latency.size());
+	if (!latency.empty()) {
+		std::sort(latency.begin(), latency.end());
+		const nsecs_t p50 = latency[latency.size() / 2], max = latency.back();
+		printf("wake up latency: p50 %.1f us, max %.1f us\n", p50 / 1000.0, max / 1000.0);
+		// lost wake up would take 100ms(safety timeout of worker thread)
+		TEST_ASSERT(max < ms2ns(50));
+	}
+}
+
+typedef struct churn_args {
+	TestClient *client;
+	int loops;
+} churn_args_t;
+
+static void *churn_func(void *vptr_args) {
+	churn_args_t *args = (churn_args_t *)vptr_args;
+	IPScheduler &scheduler = IPScheduler::getInstance();
+	for (int i = 0; i < args->loops; i++) {
+		scheduler.add(args->client);
+		args->client->queue();
+		scheduler.signal();
+		if (i & 1) usleep(100);
+		scheduler.remove(args->client);
+	}
+	return NULL;
+}
+
+/** add/remove of the last client from several threads must not hang or leak worker threads */
+static void test_churn(void) {
+	IPScheduler &scheduler = IPScheduler::getInstance();
+	scheduler.setNumThreads(2);
+	const int num = 3;
+	TestClient clients[num];
+	churn_args_t args[num];
+	pthread_t threads[num];
+	for (int i = 0; i < num; i++) {
+		args[i].client = &clients[i];
+		args[i].loops = 1000;
+		pthread_create(&threads[i], NULL, churn_func, &args[i]);
+	}
+	for (int i = 0; i < num; i++) {
+		pthread_join(threads[i], NULL);
+	}
+	scheduler_stats_t stats, total;
+	int num_threads, num_clients;
+	scheduler.getStats(NULL, stats, total, num_threads, num_clients);
+	TEST_ASSERT_EQ(0, num_threads);
+	TEST_ASSERT_EQ(0, num_clients);
+	for (int i = 0; i < num; i++) {
+		TEST_ASSERT(clients[i].max_concurrent <= 1);
+	}
+	// still works after churn
+	TestClient a;
+	scheduler.add(&a);
+	a.queue();
+	scheduler.signal();
+	for (int j = 0; (j < 1000) && a.hasFrame(); j++) {
+		usleep(1000);
+	}
+	TEST_ASSERT_EQ(1, a.processed);
+	scheduler.getStats(&a, stats, total, num_threads, num_clients);
+	TEST_ASSERT_EQ(1, total.processed);
+	scheduler.remove(&a);
+}
+
+int main(int argc, char *argv[]) {
+	alarm(WATCHDOG_SEC);
+	test_priority();
+	test_wakeup();
+	test_churn();
+	return TEST_RESULT("scheduler_test");
+}
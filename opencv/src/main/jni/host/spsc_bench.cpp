@@ -0,0 +1,247 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+
+/*
+ * microbenchmark of frame hand-off from frame source to worker thread,
+ * IPSpscRing(lock-free, futex wait) vs Mutex/Condition + std::queue that was used before.
+ * both run with drop-oldest policy and queue size 1 same as IPFrame by default.
+ *   uncontended: push + pop on one thread
+ *   saturated:   producer pushes as fast as possible
+ *   paced:       producer pushes every 100us, measures producer cost and wake up latency
+ * ordering and pushed = popped + evicted are checked, returns non-zero if they fail.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <queue>
+#include <vector>
+#include <algorithm>
+
+#include "utilbase.h"
+#include "Mutex.h"
+#include "Condition.h"
+#include "Timers.h"
+#include "IPSpscRing.h"
+
+using namespace android;
+
+#define SATURATED_NUM 2000000
+#define PACED_NUM 20000
+#define PACED_INTERVAL_NS 100000
+#define STAMP_NUM 8
+
+class Channel {
+public:
+	virtual ~Channel() {};
+	virtual void init() = 0;
+	/** push new value, evict the oldest one if full, return true if evicted */
+	virtual bool push(const int &value, int &evicted) = 0;
+	/** block until value is available, return false when finished */
+	virtual bool pop(int &value) = 0;
+	virtual void finish() = 0;
+	virtual const char *name() const = 0;
+};
+
+class SpscChannel : public Channel {
+private:
+	IPSpscRing mRing;
+	volatile bool mFinished;
+public:
+	virtual void init() { mRing.init(1); mFinished = false; };
+	virtual bool push(const int &value, int &evicted) {
+		bool result = false;
+		if (mRing.size() >= 1) {
+			intptr_t v;
+			// this may fail when consumer took it just now
+			if (mRing.pop(v)) {
+				evicted = (int)v;
+				result = true;
+			}
+		}
+		mRing.push(value);
+		return result;
+	};
+	virtual bool pop(int &value) {
+		for ( ; ; ) {
+			const int seq = mRing.pushSeq();
+			intptr_t v;
+			if (mRing.pop(v)) {
+				value = (int)v;
+				return true;
+			}
+			if (mFinished) return false;
+			mRing.waitPush(seq);
+		}
+	};
+	virtual void finish() { mFinished = true; __sync_synchronize(); mRing.wakeAll(); };
+	virtual const char *name() const { return "spsc "; };
+};
+
+class MutexChannel : public Channel {
+private:
+	Mutex mLock;
+	Condition mSync;
+	std::queue<int> mQueue;
+	bool mFinished;
+public:
+	virtual void init() { mFinished = false; };
+	virtual bool push(const int &value, int &evicted) {
+		bool result = false;
+		Mutex::Autolock lock(mLock);
+		if (mQueue.size() >= 1) {
+			evicted = mQueue.front();
+			mQueue.pop();
+			result = true;
+		}
+		mQueue.push(value);
+		mSync.signal();
+		return result;
+	};
+	virtual bool pop(int &value) {
+		Mutex::Autolock lock(mLock);
+		for ( ; mQueue.empty() && !mFinished ; ) {
+			mSync.wait(mLock);
+		}
+		if (mQueue.empty()) return false;
+		value = mQueue.front();
+		mQueue.pop();
+		return true;
+	};
+	virtual void finish() { Mutex::Autolock lock(mLock); mFinished = true; mSync.broadcast(); };
+	virtual const char *name() const { return "mutex"; };
+};
+
+typedef struct consumer {
+	Channel *channel;
+	int received;
+	int errors;
+	int64_t sum;
+	// send time of the value, indexed by value % STAMP_NUM, only for paced run
+	volatile nsecs_t *stamps;
+	std::vector<nsecs_t> latency;
+} consumer_t;
+
+static void *consumer_func(void *vptr_args) {
+	consumer_t *c = (consumer_t *)vptr_args;
+	int value, last = -1;
+	for ( ; c->channel->pop(value) ; ) {
+		if (c->stamps) {
+			c->latency.push_back(systemTime(SYSTEM_TIME_MONOTONIC) - c->stamps[value % STAMP_NUM]);
+		}
+		if (value <= last) c->errors++;
+		last = value;
+		c->sum += value;
+		c->received++;
+	}
+	return NULL;
+}
+
+static int uncontended(Channel &channel) {
+	channel.init();
+	int value, evicted;
+	const nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
+	for (int i = 0; i < SATURATED_NUM; i++) {
+		channel.push(i, evicted);
+		channel.pop(value);
+	}
+	const nsecs_t elapsed = systemTime(SYSTEM_TIME_MONOTONIC) - start;
+	printf("%s uncontended push+pop: %.1f ns\n", channel.name(), elapsed / (double)SATURATED_NUM);
+	return 0;
+}
+
+static int saturated(Channel &channel) {
+	channel.init();
+	consumer_t c;
+	c.channel = &channel;
+	c.received = c.errors = 0;
+	c.sum = 0;
+	c.stamps = NULL;
+	pthread_t thread;
+	pthread_create(&thread, NULL, consumer_func, &c);
+	int64_t sum = 0, sum_evicted = 0;
+	int num_evicted = 0;
+	const nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
+	for (int i = 0; i < SATURATED_NUM; i++) {
+		int evicted;
+		if (channel.push(i, evicted)) {
+			num_evicted++;
+			sum_evicted += evicted;
+		}
+		sum += i;
+	}
+	channel.finish();
+	pthread_join(thread, NULL);
+	const nsecs_t elapsed = systemTime(SYSTEM_TIME_MONOTONIC) - start;
+	const bool ok = !c.errors && (c.received + num_evicted == SATURATED_NUM) && (sum == c.sum + sum_evicted);
+	printf("%s saturated: %.1f ns/frame, received=%d, evicted=%d, %s\n", channel.name(),
+		elapsed / (double)SATURATED_NUM, c.received, num_evicted, ok ? "consistent" : "INCONSISTENT");
+	return ok ? 0 : 1;
+}
+
+static int paced(Channel &channel) {
+	channel.init();
+	volatile nsecs_t stamps[STAMP_NUM];
+	consumer_t c;
+	c.channel = &channel;
+	c.received = c.errors = 0;
+	c.sum = 0;
+	c.stamps = stamps;
+	c.latency.reserve(PACED_NUM);
+	pthread_t thread;
+	pthread_create(&thread, NULL, consumer_func, &c);
+	const struct timespec interval = { 0, PACED_INTERVAL_NS };
+	nsecs_t total = 0;
+	int num_evicted = 0;
+	for (int i = 0; i < PACED_NUM; i++) {
+		nanosleep(&interval, NULL);
+		const nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
+		stamps[i % STAMP_NUM] = start;
+		int evicted;
+		if (channel.push(i, evicted)) num_evicted++;
+		total += systemTime(SYSTEM_TIME_MONOTONIC) - start;
+	}
+	channel.finish();
+	pthread_join(thread, NULL);
+	std::vector<nsecs_t> &latency = c.latency;
+	std::sort(latency.begin(), latency.end());
+	const bool ok = !c.errors && (c.received + num_evicted == PACED_NUM) && !latency.empty();
+	if (!latency.empty()) {
+		printf("%s paced(%dus): producer %.0f ns/frame, wake latency p50 %.1f us, p99 %.1f us, received=%d\n",
+			channel.name(), PACED_INTERVAL_NS / 1000, total / (double)PACED_NUM,
+			latency[latency.size() / 2] / 1000.0, latency[latency.size() * 99 / 100] / 1000.0, c.received);
+	}
+	return ok ? 0 : 1;
+}
+
+int main(int argc, char *argv[]) {
+	printf("cpus=%ld\n", sysconf(_SC_NPROCESSORS_ONLN));
+	SpscChannel spsc;
+	MutexChannel mutex;
+	Channel *channels[] = { &spsc, &mutex };
+	int result = 0;
+	for (int i = 0; i < 2; i++) result |= uncontended(*channels[i]);
+	for (int i = 0; i < 2; i++) result |= saturated(*channels[i]);
+	for (int i = 0; i < 2; i++) result |= paced(*channels[i]);
+	return result;
+}
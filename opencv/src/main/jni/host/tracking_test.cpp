@@ -0,0 +1,289 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+
+/*
+ * host test of detect/track scheduling of IPTrackingStage with a scripted detector.
+ * checks fallback to full detection when nothing is tracked and after lost_frames misses,
+ * scheduled full detection by detect_interval, its parameter validation,
+ * ROI change/reset, detection stats and gray scale conversion of RGBA input.
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "IPTrackingStage.h"
+#include "host_test.h"
+
+#define WIDTH 32
+#define HEIGHT 24
+#define MIN_CONFIDENCE 0.5f
+#define LOST_FRAMES 3
+#define FULL_SEARCH_IX 0
+
+/** detector that returns given confidences and counts the calls */
+class FakeTracker : public IPTrackingStage {
+public:
+	float detect_confidence;
+	float track_confidence;
+	int detects, tracks, accepts, reports;
+	float reported_confidence;
+	int gray_type;
+	int gray_value;
+
+	FakeTracker()
+	:	IPTrackingStage("fake", MIN_CONFIDENCE, LOST_FRAMES, FULL_SEARCH_IX),
+		detect_confidence(0), track_confidence(0) {
+		clear();
+	};
+	virtual ~FakeTracker() {};
+	using IPTrackingStage::isTracking;
+
+	void clear() {
+		detects = tracks = accepts = reports = 0;
+		reported_confidence = -1;
+		gray_type = gray_value = -1;
+	};
+protected:
+	virtual float detect(const cv::Mat &gray) {
+		detects++;
+		gray_type = gray.type();
+		gray_value = gray.at<uint8_t>(0, 0);
+		return detect_confidence;
+	};
+	virtual float track(const cv::Mat &gray) {
+		tracks++;
+		return track_confidence;
+	};
+	virtual void accept() {
+		accepts++;
+	};
+	virtual void report(stage_context_t &ctx, const float &confidence, const bool &full_search) {
+		reports++;
+		reported_confidence = confidence;
+	};
+};
+
+static bool full_search;
+
+static void run(FakeTracker &tracker, const cv::Mat &src, const cv::Rect &roi = cv::Rect(0, 0, WIDTH, HEIGHT)) {
+	stage_context_t ctx;
+	memset(ctx.results, 0, sizeof(ctx.results));
+	ctx.width = WIDTH;
+	ctx.height = HEIGHT;
+	ctx.roi = roi;
+	ctx.result_frame_type = RESULT_FRAME_TYPE_NON;
+	ctx.detect_type = TYPE_NON;
+	ctx.allocator = NULL;
+	ctx.unchanged = false;
+	tracker.clear();
+	cv::Mat dst;
+	TEST_ASSERT_EQ(0, tracker.process(ctx, src, dst));
+	TEST_ASSERT(dst.data == src.data);
+	full_search = ctx.results[FULL_SEARCH_IX] != 0.0f;
+}
+
+static cv::Mat gray_frame(void) {
+	cv::Mat gray(HEIGHT, WIDTH, CV_8UC1);
+	memset(gray.data, 100, gray.total());
+	return gray;
+}
+
+static void test_fallback(void) {
+	FakeTracker tracker;
+	const cv::Mat gray = gray_frame();
+	int64_t detect_count, fallback_count;
+
+	// nothing found, full detection on every frame
+	for (int i = 0; i < 3; i++) {
+		run(tracker, gray);
+		TEST_ASSERT(full_search);
+		TEST_ASSERT_EQ(1, tracker.detects);
+		TEST_ASSERT_EQ(0, tracker.tracks);
+		TEST_ASSERT_EQ(0, tracker.reports);
+		TEST_ASSERT(!tracker.isTracking());
+	}
+	// found, tracked on following frames without full detection
+	tracker.detect_confidence = 0.9f;
+	run(tracker, gray);
+	TEST_ASSERT(full_search);
+	TEST_ASSERT_EQ(1, tracker.accepts);
+	TEST_ASSERT_EQ(1, tracker.reports);
+	TEST_ASSERT(tracker.reported_confidence == 0.9f);
+	tracker.track_confidence = 0.8f;
+	for (int i = 0; i < 10; i++) {
+		run(tracker, gray);
+		TEST_ASSERT(!full_search);
+		TEST_ASSERT_EQ(0, tracker.detects);
+		TEST_ASSERT_EQ(1, tracker.tracks);
+		TEST_ASSERT_EQ(1, tracker.accepts);
+		TEST_ASSERT(tracker.reported_confidence == 0.8f);
+	}
+	// lost, previous object is reported with confidence 0 until lost_frames misses
+	tracker.track_confidence = 0.2f;
+	tracker.detect_confidence = 0.0f;
+	for (int i = 0; i < LOST_FRAMES - 1; i++) {
+		run(tracker, gray);
+		TEST_ASSERT(!full_search);
+		TEST_ASSERT_EQ(0, tracker.detects);
+		TEST_ASSERT_EQ(1, tracker.reports);
+		TEST_ASSERT(tracker.reported_confidence == 0.0f);
+	}
+	// full detection runs on the same frame that the object is lost
+	run(tracker, gray);
+	TEST_ASSERT(full_search);
+	TEST_ASSERT_EQ(1, tracker.tracks);
+	TEST_ASSERT_EQ(1, tracker.detects);
+	TEST_ASSERT_EQ(0, tracker.reports);
+	TEST_ASSERT(!tracker.isTracking());
+
+	tracker.getDetectStats(detect_count, fallback_count);
+	TEST_ASSERT_EQ(5, detect_count);
+	TEST_ASSERT_EQ(5, fallback_count);
+
+	// a miss that is shorter than lost_frames does not cause full detection
+	tracker.detect_confidence = 0.9f;
+	run(tracker, gray);
+	tracker.track_confidence = 0.2f;
+	run(tracker, gray);
+	tracker.track_confidence = 0.8f;
+	for (int i = 0; i < LOST_FRAMES; i++) {
+		run(tracker, gray);
+		TEST_ASSERT(!full_search);
+		TEST_ASSERT_EQ(0, tracker.detects);
+	}
+}
+
+static void test_interval(void) {
+	FakeTracker tracker;
+	const cv::Mat gray = gray_frame();
+	const int interval = 4;
+	const float value = interval;
+	int64_t detect_count, fallback_count;
+
+	TEST_ASSERT_EQ(0, tracker.setParameter("detect_interval", &value, 1));
+	tracker.detect_confidence = 0.9f;
+	tracker.track_confidence = 0.8f;
+	run(tracker, gray);
+	TEST_ASSERT(full_search);
+	for (int frame = 1; frame <= interval * 3; frame++) {
+		run(tracker, gray);
+		const bool scheduled = !(frame % interval);
+		TEST_ASSERT_EQ(scheduled, full_search);
+		TEST_ASSERT_EQ(scheduled ? 1 : 0, tracker.detects);
+		// scheduled detection found the object, so it is not tracked on that frame
+		TEST_ASSERT_EQ(scheduled ? 0 : 1, tracker.tracks);
+	}
+	tracker.getDetectStats(detect_count, fallback_count);
+	TEST_ASSERT_EQ(4, detect_count);
+	TEST_ASSERT_EQ(1, fallback_count);
+
+	// scheduled detection failed, tracking continues on the same frame
+	tracker.detect_confidence = 0.0f;
+	for (int frame = 1; frame <= interval; frame++) {
+		run(tracker, gray);
+	}
+	TEST_ASSERT(full_search);
+	TEST_ASSERT_EQ(1, tracker.detects);
+	TEST_ASSERT_EQ(1, tracker.tracks);
+	TEST_ASSERT(tracker.reported_confidence == 0.8f);
+	TEST_ASSERT(tracker.isTracking());
+	tracker.getDetectStats(detect_count, fallback_count);
+	TEST_ASSERT_EQ(5, detect_count);
+	TEST_ASSERT_EQ(1, fallback_count);
+
+	// interval 0 disables scheduled detection
+	const float zero = 0;
+	TEST_ASSERT_EQ(0, tracker.setParameter("detect_interval", &zero, 1));
+	for (int frame = 0; frame < interval * 3; frame++) {
+		run(tracker, gray);
+		TEST_ASSERT(!full_search);
+	}
+}
+
+static void test_parameter(void) {
+	FakeTracker tracker;
+	const float values[] = { 10, 20 };
+	const float negative = -1;
+	const float too_large = MAX_DETECT_INTERVAL + 1;
+	TEST_ASSERT_EQ(0, IPTrackingStage::validateParameter("detect_interval", values, 1));
+	TEST_ASSERT_EQ(-1, IPTrackingStage::validateParameter("detect_interval", values, 2));
+	TEST_ASSERT_EQ(-1, IPTrackingStage::validateParameter("detect_interval", values, 0));
+	TEST_ASSERT_EQ(-1, IPTrackingStage::validateParameter("detect_interval", &negative, 1));
+	TEST_ASSERT_EQ(-1, IPTrackingStage::validateParameter("detect_interval", &too_large, 1));
+	TEST_ASSERT_EQ(-1, IPTrackingStage::validateParameter("interval", values, 1));
+	// rejected values do not change the interval
+	TEST_ASSERT_EQ(-1, tracker.setParameter("detect_interval", &too_large, 1));
+	TEST_ASSERT_EQ(-1, tracker.setParameter("unknown", values, 1));
+	const cv::Mat gray = gray_frame();
+	tracker.detect_confidence = 0.9f;
+	tracker.track_confidence = 0.8f;
+	for (int i = 0; i < 20; i++) {
+		run(tracker, gray);
+		TEST_ASSERT_EQ(!i, full_search);
+	}
+}
+
+static void test_roi_and_reset(void) {
+	FakeTracker tracker;
+	const cv::Mat gray = gray_frame();
+	tracker.detect_confidence = 0.9f;
+	tracker.track_confidence = 0.8f;
+	run(tracker, gray);
+	run(tracker, gray);
+	TEST_ASSERT(!full_search);
+	// default onRoiChanged can't move the object, so it is detected again
+	run(tracker, gray, cv::Rect(0, 0, WIDTH / 2, HEIGHT));
+	TEST_ASSERT(full_search);
+	TEST_ASSERT_EQ(0, tracker.tracks);
+	run(tracker, gray, cv::Rect(0, 0, WIDTH / 2, HEIGHT));
+	TEST_ASSERT(!full_search);
+	tracker.reset();
+	TEST_ASSERT(!tracker.isTracking());
+	run(tracker, gray, cv::Rect(0, 0, WIDTH / 2, HEIGHT));
+	TEST_ASSERT(full_search);
+}
+
+static void test_rgba(void) {
+	FakeTracker tracker;
+	cv::Mat rgba(HEIGHT, WIDTH, CV_8UC4);
+	for (size_t i = 0; i < rgba.total(); i++) {
+		uint8_t *p = rgba.data + i * 4;
+		p[0] = 200; p[1] = 100; p[2] = 50; p[3] = 255;
+	}
+	run(tracker, rgba);
+	TEST_ASSERT_EQ(CV_8UC1, tracker.gray_type);
+	TEST_ASSERT_EQ((200 * 4899 + 100 * 9617 + 50 * 1868 + (1 << 13)) >> 14, tracker.gray_value);
+	const cv::Mat gray = gray_frame();
+	run(tracker, gray);
+	TEST_ASSERT_EQ(CV_8UC1, tracker.gray_type);
+	TEST_ASSERT_EQ(100, tracker.gray_value);
+}
+
+int main(int argc, char *argv[]) {
+	test_fallback();
+	test_interval();
+	test_parameter();
+	test_roi_and_reset();
+	test_rgba();
+	return TEST_RESULT("tracking_test");
+}
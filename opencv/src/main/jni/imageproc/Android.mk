@@ -58,11 +58,37 @@ LOCAL_LDLIBS += -lEGL -lGLESv3				# OpenGL|ES 2.0|ES 3ライブラリ
 LOCAL_SHARED_LIBRARIES += common
 
 LOCAL_SRC_FILES := \
+	IPArenaAllocator.cpp \
 	IPBase.cpp \
 	IPFrame.cpp \
+	IPFrameSource.cpp \
+	IPGLFrameSource.cpp \
+	IPMemFrameSource.cpp \
+	IPMjpegFrameSource.cpp \
+	IPSyntheticFrameSource.cpp \
+	IPPboRing.cpp \
+	IPScheduler.cpp \
+	IPStage.cpp \
+	IPBasicStages.cpp \
+	IPColorKernels.cpp \
+	IPFrameHash.cpp \
+	IPScanline.cpp \
+	IPTrackingStage.cpp \
+	IPLineDetector.cpp \
+	IPCurveDetector.cpp \
+	IPColorExtractor.cpp \
+	IPMotionDetector.cpp \
+	IPKltTracker.cpp \
+	IPDenseFlow.cpp \
+	IPPipeline.cpp \
+	IPParallel.cpp \
 	ImageProcessor.cpp \
 
 LOCAL_ARM_MODE := arm
+# NEON path of IPColorKernels, armeabi-v7a devices without NEON(e.g. Tegra 2) are not supported
+ifeq ($(TARGET_ARCH_ABI),armeabi-v7a)
+LOCAL_ARM_NEON := true
+endif
 LOCAL_MODULE := imageproc
 include $(BUILD_SHARED_LIBRARY)
 
@@ -0,0 +1,321 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+#if 1	// set 0 to enable debug output, otherwise set 1
+	#ifndef LOG_NDEBUG
+		#define	LOG_NDEBUG		// disable LOGV/LOGD/MARK
+	#endif
+	#undef USE_LOGALL			// enable specific LOGx only
+#else
+//	#define USE_LOGALL
+	#define USE_LOGD
+	#undef LOG_NDEBUG
+	#undef NDEBUG
+#endif
+
+#include <new>
+#include <stdlib.h>
+#include <sys/mman.h>
+
+#include "utilbase.h"
+
+#include "IPArenaAllocator.h"
+
+// size of huge page on most of arm/x86 devices
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+IPArenaAllocator::IPArenaAllocator()
+: mArena(NULL),
+  mArenaSize(0),
+  mIsHugePages(false),
+  mFlags(0),
+  mNumBlocks(0),
+  mNumFreeUMatData(0),
+  mUMatStorage(NULL),
+  mNumUsed(0),
+  mIsSteadyState(false),
+  mSteadyAllocations(0),
+  mFallbackAllocations(0) {
+
+	ENTER();
+
+	// prepare storage for UMatData here so that we never need new/delete for them
+	mUMatStorage = malloc(sizeof(cv::UMatData) * ARENA_MAX_BLOCKS);
+	if (LIKELY(mUMatStorage)) {
+		cv::UMatData *p = (cv::UMatData *)mUMatStorage;
+		for (int i = 0; i < ARENA_MAX_BLOCKS; i++) {
+			mUMatData[mNumFreeUMatData++] = p + i;
+		}
+	}
+
+	EXIT();
+}
+
+IPArenaAllocator::~IPArenaAllocator() {
+	ENTER();
+
+	release();
+	if (LIKELY(!mNumUsed)) {
+		SAFE_FREE(mUMatStorage);
+	}
+
+	EXIT();
+}
+
+/**
+ * allocate and pre-fault the arena,
+ * this should be called while no buffer is allocated from this allocator
+ * @param size size of the arena[bytes]
+ * @param flags ARENA_FLAG_XXX
+ * return 0 on success, otherwise buffers are allocated by the standard allocator
+ */
+int IPArenaAllocator::init(const size_t &size, const int &flags) {
+	ENTER();
+
+	release();
+
+	Mutex::Autolock lock(mLock);
+
+	if (UNLIKELY(mNumUsed)) {
+		LOGW("%d buffer(s) are still in use, keep current arena", mNumUsed);
+		RETURN(-1, int);
+	}
+	mFlags = flags;
+	mIsSteadyState = false;
+	mSteadyAllocations = mFallbackAllocations = 0;
+	if (!size) {
+		RETURN(0, int);
+	}
+	const size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+	size_t arena_size = ALIGN_UP(size, page_size);
+	uint8_t *arena = NULL;
+	bool huge = false;
+#ifdef MAP_HUGETLB
+	if (flags & ARENA_FLAG_HUGE_PAGES) {
+		// this works only when the kernel has reserved huge pages
+		const size_t huge_size = ALIGN_UP(size, HUGE_PAGE_SIZE);
+		void *p = mmap(NULL, huge_size, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if (p != MAP_FAILED) {
+			arena = (uint8_t *)p;
+			arena_size = huge_size;
+			huge = true;
+		}
+	}
+#endif
+	if (!arena) {
+		void *p = mmap(NULL, arena_size, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (UNLIKELY(p == MAP_FAILED)) {
+			LOGE("failed to allocate arena(%u bytes)", (unsigned)arena_size);
+			RETURN(-1, int);
+		}
+		arena = (uint8_t *)p;
+#ifdef MADV_HUGEPAGE
+		if (flags & ARENA_FLAG_HUGE_PAGES) {
+			// transparent huge pages, this is just a hint
+			huge = !madvise(arena, arena_size, MADV_HUGEPAGE);
+		}
+#endif
+	}
+	// touch all pages now so that no page fault happens in the hot loop
+	memset(arena, 0, arena_size);
+	mArena = arena;
+	mArenaSize = arena_size;
+	mIsHugePages = huge;
+	mBlocks[0].offset = 0;
+	mBlocks[0].size = arena_size;
+	mBlocks[0].used = false;
+	mNumBlocks = 1;
+	LOGI("arena:%u bytes, huge pages=%d", (unsigned)arena_size, huge);
+
+	RETURN(0, int);
+}
+
+/**
+ * release the arena, if some buffers are still in use, the arena is kept
+ */
+void IPArenaAllocator::release() {
+	ENTER();
+
+	Mutex::Autolock lock(mLock);
+
+	if (mArena) {
+		if (LIKELY(!mNumUsed)) {
+			munmap(mArena, mArenaSize);
+			mArena = NULL;
+			mArenaSize = 0;
+			mNumBlocks = 0;
+			mIsHugePages = false;
+		} else {
+			LOGW("%d buffer(s) are still in use, keep current arena", mNumUsed);
+		}
+	}
+
+	EXIT();
+}
+
+/**
+ * start/stop counting allocations, after this every allocation is treated as
+ * heap churn in the hot loop
+ */
+void IPArenaAllocator::setSteadyState(const bool &steady) {
+	ENTER();
+
+	mIsSteadyState = steady;
+
+	EXIT();
+}
+
+/*private*/
+void IPArenaAllocator::countAllocation(const size_t &size, const bool &fallback) const {
+	if (UNLIKELY(fallback)) {
+		__sync_fetch_and_add(&mFallbackAllocations, 1);
+	}
+	if (UNLIKELY(mIsSteadyState)) {
+		const int n = __sync_add_and_fetch(&mSteadyAllocations, 1);
+		LOGW("allocation in steady state:%u bytes, fallback=%d, total=%d", (unsigned)size, fallback, n);
+		if (mFlags & ARENA_FLAG_ASSERT_NO_ALLOC) {
+			LOGE("abort because of ARENA_FLAG_ASSERT_NO_ALLOC");
+			abort();
+		}
+	}
+}
+
+/**
+ * find free block with first-fit and split it,
+ * mLock should be locked
+ * return index of allocated block, -1 if the arena is exhausted
+ */
+/*private*/
+int IPArenaAllocator::allocBlock(const size_t &size) const {
+	for (int i = 0; i < mNumBlocks; i++) {
+		arena_block_t &block = mBlocks[i];
+		if (!block.used && (block.size >= size)) {
+			if ((block.size > size) && (mNumBlocks < ARENA_MAX_BLOCKS)) {
+				// split the block and keep remaining part as free block
+				memmove(&mBlocks[i + 2], &mBlocks[i + 1], sizeof(arena_block_t) * (mNumBlocks - i - 1));
+				mBlocks[i + 1].offset = block.offset + size;
+				mBlocks[i + 1].size = block.size - size;
+				mBlocks[i + 1].used = false;
+				block.size = size;
+				mNumBlocks++;
+			}
+			block.used = true;
+			return i;
+		}
+	}
+	return -1;
+}
+
+/**
+ * return the block to the arena and merge it with free neighbour(s),
+ * mLock should be locked
+ */
+/*private*/
+void IPArenaAllocator::freeBlock(const size_t &offset) const {
+	// blocks are sorted by offset
+	int lo = 0, hi = mNumBlocks - 1, i = -1;
+	for ( ; lo <= hi ; ) {
+		const int mid = (lo + hi) / 2;
+		if (mBlocks[mid].offset == offset) {
+			i = mid;
+			break;
+		} else if (mBlocks[mid].offset < offset) {
+			lo = mid + 1;
+		} else {
+			hi = mid - 1;
+		}
+	}
+	if (UNLIKELY(i < 0)) {
+		LOGE("unknown block:offset=%u", (unsigned)offset);
+		return;
+	}
+	mBlocks[i].used = false;
+	if ((i + 1 < mNumBlocks) && !mBlocks[i + 1].used) {
+		mBlocks[i].size += mBlocks[i + 1].size;
+		memmove(&mBlocks[i + 1], &mBlocks[i + 2], sizeof(arena_block_t) * (mNumBlocks - i - 2));
+		mNumBlocks--;
+	}
+	if ((i > 0) && !mBlocks[i - 1].used) {
+		mBlocks[i - 1].size += mBlocks[i].size;
+		memmove(&mBlocks[i], &mBlocks[i + 1], sizeof(arena_block_t) * (mNumBlocks - i - 1));
+		mNumBlocks--;
+	}
+}
+
+cv::UMatData *IPArenaAllocator::allocate(int dims, const int *sizes, int type,
+	void *data0, size_t *step, int flags, cv::UMatUsageFlags usageFlags) const {
+
+	if (UNLIKELY(data0)) {
+		// user allocated memory, nothing to allocate
+		return cv::Mat::getStdAllocator()->allocate(dims, sizes, type, data0, step, flags, usageFlags);
+	}
+	// same as the standard allocator of OpenCV
+	size_t total = CV_ELEM_SIZE(type);
+	for (int i = dims - 1; i >= 0; i--) {
+		if (step) {
+			step[i] = total;
+		}
+		total *= sizes[i];
+	}
+
+	cv::UMatData *u = NULL;
+	mLock.lock();
+	if (LIKELY(mArena && mNumFreeUMatData)) {
+		const int ix = allocBlock(ALIGN_UP(total, ARENA_ALIGNMENT));
+		if (LIKELY(ix >= 0)) {
+			u = new(mUMatData[--mNumFreeUMatData]) cv::UMatData(this);
+			u->data = u->origdata = mArena + mBlocks[ix].offset;
+			u->size = total;
+			mNumUsed++;
+		}
+	}
+	mLock.unlock();
+
+	if (UNLIKELY(!u)) {
+		// the arena is exhausted or not initialized
+		u = cv::Mat::getStdAllocator()->allocate(dims, sizes, type, data0, step, flags, usageFlags);
+	}
+	countAllocation(total, !u || (u->currAllocator != this));
+
+	return u;
+}
+
+bool IPArenaAllocator::allocate(cv::UMatData *u, int accessflags, cv::UMatUsageFlags usageFlags) const {
+	return u != NULL;
+}
+
+void IPArenaAllocator::deallocate(cv::UMatData *u) const {
+	if (UNLIKELY(!u)) return;
+
+	CV_Assert(u->urefcount == 0);
+	CV_Assert(u->refcount == 0);
+
+	Mutex::Autolock lock(mLock);
+
+	freeBlock((size_t)(u->origdata - mArena));
+	u->~UMatData();
+	mUMatData[mNumFreeUMatData++] = u;
+	mNumUsed--;
+}
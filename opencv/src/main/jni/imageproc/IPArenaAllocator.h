@@ -0,0 +1,109 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+#ifndef FLIGHTDEMO_IPARENAALLOCATOR_H
+#define FLIGHTDEMO_IPARENAALLOCATOR_H
+
+#include "opencv2/opencv.hpp"
+
+#include "Mutex.h"
+
+using namespace android;
+
+// alignment of every buffer in the arena[bytes], same as cache line size
+#define ARENA_ALIGNMENT 64
+#ifndef ALIGN_UP
+// round up v to multiple of a, a should be power of 2
+#define ALIGN_UP(v, a) (((v) + (a) - 1) & ~((size_t)(a) - 1))
+#endif
+// max number of buffers that the arena can serve at the same time
+#define ARENA_MAX_BLOCKS 128
+
+// flags for #init
+// try to back the arena with huge pages(MAP_HUGETLB, then MADV_HUGEPAGE)
+#define ARENA_FLAG_HUGE_PAGES 0x01
+// abort when buffer is allocated in steady state, otherwise just log and count it
+#define ARENA_FLAG_ASSERT_NO_ALLOC 0x02
+
+/**
+ * cv::MatAllocator that serves 64 bytes aligned buffers from pre-allocated
+ * and pre-faulted arena. if the arena is exhausted, buffers are allocated
+ * by the standard allocator of OpenCV instead.
+ * After #setSteadyState(true), every allocation(both from the arena and fallback)
+ * is counted so that you can check heap churn in the hot loop.
+ * Every cv::Mat allocated by this allocator should be released
+ * before this is destroyed or re-initialized.
+ */
+class IPArenaAllocator : public cv::MatAllocator {
+private:
+	typedef struct arena_block {
+		size_t offset;
+		size_t size;
+		bool used;
+	} arena_block_t;
+
+	mutable Mutex mLock;
+	uint8_t *mArena;
+	size_t mArenaSize;
+	bool mIsHugePages;
+	int mFlags;
+	// partition of the arena sorted by offset
+	mutable arena_block_t mBlocks[ARENA_MAX_BLOCKS];
+	mutable int mNumBlocks;
+	// storage of UMatData, we don't want to use new/delete for them
+	mutable cv::UMatData *mUMatData[ARENA_MAX_BLOCKS];
+	mutable int mNumFreeUMatData;
+	void *mUMatStorage;
+	// number of buffers currently allocated from the arena
+	mutable int mNumUsed;
+	volatile bool mIsSteadyState;
+	// number of allocations after #setSteadyState(true)
+	mutable volatile int mSteadyAllocations;
+	// number of allocations that the arena could not serve
+	mutable volatile int mFallbackAllocations;
+
+	int allocBlock(const size_t &size) const;
+	void freeBlock(const size_t &offset) const;
+	void countAllocation(const size_t &size, const bool &fallback) const;
+public:
+	IPArenaAllocator();
+	virtual ~IPArenaAllocator();
+	int init(const size_t &size, const int &flags = 0);
+	void release();
+
+	virtual cv::UMatData *allocate(int dims, const int *sizes, int type,
+		void *data, size_t *step, int flags, cv::UMatUsageFlags usageFlags) const;
+	virtual bool allocate(cv::UMatData *data, int accessflags, cv::UMatUsageFlags usageFlags) const;
+	virtual void deallocate(cv::UMatData *data) const;
+
+	void setSteadyState(const bool &steady);
+	inline const bool isSteadyState() const { return mIsSteadyState; };
+	inline const int steadyAllocations() const { return mSteadyAllocations; };
+	inline const int fallbackAllocations() const { return mFallbackAllocations; };
+	inline const bool isValid() const { return mArena != NULL; };
+	inline const size_t size() const { return mArenaSize; };
+	inline const bool isHugePages() const { return mIsHugePages; };
+	inline const int used() const { Mutex::Autolock lock(mLock); return mNumUsed; };
+};
+
+#endif //FLIGHTDEMO_IPARENAALLOCATOR_H
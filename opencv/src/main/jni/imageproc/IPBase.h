@@ -38,6 +38,61 @@
 #define RESULT_FRAME_TYPE_DST_LINE 4
 #define RESULT_FRAME_TYPE_MAX 5
 
+// pixel format of result image passed to Java
+#define RESULT_FORMAT_RGBA 0			// 4 bytes per pixel
+#define RESULT_FORMAT_GRAY 1			// 1 byte per pixel(gray scale)
+#define RESULT_FORMAT_MAX 2
+
+// number of values in result array for Java callback
+#define RESULT_NUM 40
+// values of line/curve detector, each detector has its own slots so that both can run in same pipeline,
+// type of the detector that reported last is passed to Java as DetectType
+// confidence of the detection(0-1), 0 if not detected in this frame
+#define RESULT_IX_LINE_CONFIDENCE 0
+// angle of the line from x axis[deg](-90, 90]
+#define RESULT_IX_LINE_ANGLE 1
+// signed distance of the line from the center of region of interest[px]
+#define RESULT_IX_LINE_OFFSET 2
+// 1 if the detector searched whole frame in this frame, 0 if it tracked previous result
+#define RESULT_IX_LINE_FULL_SEARCH 3
+#define RESULT_IX_CURVE_CONFIDENCE 4
+// coefficients of the curve u = a * v^3 + b * v^2 + c * v + d[px] relative to the center of region of interest
+#define RESULT_IX_CURVE_A 5
+#define RESULT_IX_CURVE_B 6
+#define RESULT_IX_CURVE_C 7
+#define RESULT_IX_CURVE_D 8
+// axis of the curve, 0 if (u, v) = (x, y), 1 if (u, v) = (y, x)
+#define RESULT_IX_CURVE_AXIS 9
+#define RESULT_IX_CURVE_FULL_SEARCH 10
+// values of color extraction
+// ratio of extracted pixels in region of interest(0-1)
+#define RESULT_IX_COLOR_AREA 11
+// centroid of extracted pixels relative to the center of region of interest[px]
+#define RESULT_IX_COLOR_X 12
+#define RESULT_IX_COLOR_Y 13
+// values of motion detection
+// ratio of the pixels in motion in region of interest(0-1)
+#define RESULT_IX_MOTION_ACTIVITY 14
+// number of the regions of motion
+#define RESULT_IX_MOTION_REGIONS 15
+// bounding box of all regions of motion relative to top left of region of interest[px]
+#define RESULT_IX_MOTION_X 16
+#define RESULT_IX_MOTION_Y 17
+#define RESULT_IX_MOTION_WIDTH 18
+#define RESULT_IX_MOTION_HEIGHT 19
+// bounding box(x, y, width, height) of each region of motion relative to top left of region of interest[px],
+// up to RESULT_MOTION_MAX_BOXES largest regions in descending order of area, unused boxes are 0
+#define RESULT_IX_MOTION_BOXES 20
+#define RESULT_MOTION_MAX_BOXES 4
+// values of optical flow
+// global motion of the frame from previous frame[px]
+#define RESULT_IX_FLOW_DX 36
+#define RESULT_IX_FLOW_DY 37
+// number of the tracked features that follow global motion
+#define RESULT_IX_FLOW_TRACKS 38
+// latency of readback of the frame from GPU[ms]
+#define RESULT_IX_READBACK_LATENCY 39
+
 typedef struct Coeff4 {
 	float a, b, c, d;
 } Coeff4_t;
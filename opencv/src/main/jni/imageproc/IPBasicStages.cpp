@@ -0,0 +1,137 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+
+#if 1	// set 0 to enable debug output, otherwise set 1
+	#ifndef LOG_NDEBUG
+		#define	LOG_NDEBUG		// disable LOGV/LOGD/MARK
+	#endif
+	#undef USE_LOGALL			// enable specific LOGx only
+#else
+//	#define USE_LOGALL
+	#define USE_LOGD
+	#undef LOG_NDEBUG
+	#undef NDEBUG
+#endif
+
+#include "utilbase.h"
+
+#include "IPColorKernels.h"
+#include "IPBasicStages.h"
+
+//================================================================================
+IPGrayStage::IPGrayStage(const char *name)
+: IPStage(name) {
+}
+
+IPGrayStage::~IPGrayStage() {
+}
+
+int IPGrayStage::outputType(const int &src_type) const {
+	// 1 channel frame is passed through without buffer
+	return CV_MAT_CN(src_type) == 1 ? -1 : CV_8UC1;
+}
+
+int IPGrayStage::process(stage_context_t &ctx, const cv::Mat &src, cv::Mat &dst) {
+	ENTER();
+
+	if (src.channels() == 1) {
+		// frame source already queued luminance only
+		cv::Mat none;
+		processTile(ctx, src, none, cv::Range(0, src.rows));
+		dst = src;
+	} else {
+		// convert to gray scale(RGBA->Y)
+		dst.create(src.size(), CV_8UC1);
+		processTile(ctx, src, dst, cv::Range(0, src.rows));
+	}
+
+	RETURN(0, int);
+}
+
+void IPGrayStage::processTile(stage_context_t &ctx,
+	const cv::Mat &src, cv::Mat &dst, const cv::Range &rows) {
+
+	// 1 channel frame is passed through(dst is empty)
+	if (!dst.empty()) {
+		for (int y = rows.start; y < rows.end; y++) {
+			rgba_to_gray_rgba(src.ptr<uint8_t>(y), dst.ptr<uint8_t>(y), NULL, src.cols);
+		}
+	}
+}
+
+//================================================================================
+IPGrayRgbaStage::IPGrayRgbaStage()
+: IPGrayStage("gray_rgba") {
+}
+
+IPGrayRgbaStage::~IPGrayRgbaStage() {
+}
+
+void IPGrayRgbaStage::processTile(stage_context_t &ctx,
+	const cv::Mat &src, cv::Mat &dst, const cv::Range &rows) {
+
+	if (!writes_result(ctx)) {
+		// result is not needed or is not processed image
+		IPGrayStage::processTile(ctx, src, dst, rows);
+		return;
+	}
+	cv::Mat out = ctx.result(ctx.roi);
+	if (dst.empty() || (out.channels() == 1)) {
+		// 1 channel frame is passed through or result is also gray scale
+		IPGrayStage::processTile(ctx, src, dst, rows);
+		writeImage(dst.empty() ? src : dst, out, rows);
+	} else {
+		// single pass, read RGBA once and write gray scale and RGBA for callback
+		for (int y = rows.start; y < rows.end; y++) {
+			rgba_to_gray_rgba(src.ptr<uint8_t>(y), dst.ptr<uint8_t>(y), out.ptr<uint8_t>(y), src.cols);
+		}
+	}
+}
+
+//================================================================================
+IPRgbaStage::IPRgbaStage()
+: IPStage("rgba") {
+}
+
+IPRgbaStage::~IPRgbaStage() {
+}
+
+int IPRgbaStage::process(stage_context_t &ctx, const cv::Mat &src, cv::Mat &dst) {
+	ENTER();
+
+	processTile(ctx, src, dst, cv::Range(0, src.rows));
+	dst = src;
+
+	RETURN(0, int);
+}
+
+void IPRgbaStage::processTile(stage_context_t &ctx,
+	const cv::Mat &src, cv::Mat &dst, const cv::Range &rows) {
+
+	// dst is empty, so src is passed through to next stage
+	if (writes_result(ctx)) {
+		cv::Mat out = ctx.result(ctx.roi);
+		writeImage(src, out, rows);
+	}
+}
@@ -0,0 +1,70 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+
+#ifndef FLIGHTDEMO_IPBASICSTAGES_H
+#define FLIGHTDEMO_IPBASICSTAGES_H
+
+#include "IPStage.h"
+
+/**
+ * "gray": convert RGBA frame to gray scale, 1 channel frame is passed through as is
+ */
+class IPGrayStage : public IPStage {
+public:
+	IPGrayStage(const char *name = "gray");
+	virtual ~IPGrayStage();
+	virtual int outputType(const int &src_type) const;
+	virtual int process(stage_context_t &ctx, const cv::Mat &src, cv::Mat &dst);
+	virtual bool isTileParallel() const { return true; };
+	virtual void processTile(stage_context_t &ctx,
+		const cv::Mat &src, cv::Mat &dst, const cv::Range &rows);
+};
+
+/**
+ * "gray_rgba": same as "gray" followed by "rgba" but RGBA frame is read only once
+ * and gray scale and result image are written in same pass
+ */
+class IPGrayRgbaStage : public IPGrayStage {
+public:
+	IPGrayRgbaStage();
+	virtual ~IPGrayRgbaStage();
+	virtual void processTile(stage_context_t &ctx,
+		const cv::Mat &src, cv::Mat &dst, const cv::Range &rows);
+};
+
+/**
+ * "rgba": write gray scale/RGBA input into the region of interest of the result image
+ * for callback(converted to RESULT_FORMAT_XXX) and pass the input through to next stage
+ */
+class IPRgbaStage : public IPStage {
+public:
+	IPRgbaStage();
+	virtual ~IPRgbaStage();
+	virtual int process(stage_context_t &ctx, const cv::Mat &src, cv::Mat &dst);
+	virtual bool isTileParallel() const { return true; };
+	virtual void processTile(stage_context_t &ctx,
+		const cv::Mat &src, cv::Mat &dst, const cv::Range &rows);
+};
+
+#endif //FLIGHTDEMO_IPBASICSTAGES_H
@@ -0,0 +1,290 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+
+
+#if 1	// set 0 to enable debug output, otherwise set 1
+	#ifndef LOG_NDEBUG
+		#define	LOG_NDEBUG		// disable LOGV/LOGD/MARK
+	#endif
+	#undef USE_LOGALL			// enable specific LOGx only
+#else
+//	#define USE_LOGALL
+	#define USE_LOGD
+	#undef LOG_NDEBUG
+	#undef NDEBUG
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "utilbase.h"
+
+#include "IPColorKernels.h"
+#include "IPParallel.h"
+#include "IPColorExtractor.h"
+
+/**
+ * classify rows of each tile and accumulate the number and position of extracted pixels
+ */
+class ClassifyBody : public cv::ParallelLoopBody {
+private:
+	const cv::Mat &mSrc;
+	cv::Mat &mDst;
+	const uint8_t *mLut;
+	// region of interest of the result image, empty if the mask is not written
+	cv::Mat &mResult;
+public:
+	mutable int64_t count, sum_x, sum_y;
+	ClassifyBody(const cv::Mat &src, cv::Mat &dst, const uint8_t *lut, cv::Mat &result)
+	:	mSrc(src), mDst(dst), mLut(lut), mResult(result),
+		count(0), sum_x(0), sum_y(0) {
+	};
+	virtual void operator()(const cv::Range &rows) const {
+		int64_t c = 0, sx = 0, sy = 0;
+		for (int y = rows.start; y < rows.end; y++) {
+			const int n = classify_rgba(mSrc.ptr<uint8_t>(y), mLut, mDst.ptr<uint8_t>(y), mSrc.cols, sx);
+			c += n;
+			sy += (int64_t)n * y;
+		}
+		if (!mResult.empty()) {
+			IPStage::writeImage(mDst, mResult, rows);
+		}
+		__sync_fetch_and_add(&count, c);
+		__sync_fetch_and_add(&sum_x, sx);
+		__sync_fetch_and_add(&sum_y, sy);
+	};
+};
+
+// lookup table of default range shared by all instances, it is never written after it is built
+static Mutex sDefaultLutLock;
+static cv::Mat sDefaultLut;
+
+IPColorExtractor::IPColorExtractor()
+:	IPStage("color"),
+	mRangeSeq(0),
+	mBuilding(false),
+	mHasThread(false) {
+
+	ENTER();
+
+	// default table is built only once so that creating pipelines does not take a while
+	// and this stage works from the first frame
+	sDefaultLutLock.lock();
+	{
+		if (UNLIKELY(sDefaultLut.empty())) {
+			sDefaultLut = buildLut(
+				DEFAULT_EXTRACT_H_MIN, DEFAULT_EXTRACT_H_MAX,
+				DEFAULT_EXTRACT_S_MIN, DEFAULT_EXTRACT_S_MAX,
+				DEFAULT_EXTRACT_V_MIN, DEFAULT_EXTRACT_V_MAX);
+		}
+		mLut = sDefaultLut;
+	}
+	sDefaultLutLock.unlock();
+
+	EXIT();
+}
+
+IPColorExtractor::~IPColorExtractor() {
+	ENTER();
+
+	mThreadLock.lock();
+	{
+		// wait for the table that is being built
+		if (mHasThread && (pthread_join(lut_thread, NULL) != EXIT_SUCCESS)) {
+			LOGW("terminate lut thread: pthread_join failed");
+		}
+		mHasThread = false;
+	}
+	mThreadLock.unlock();
+
+	EXIT();
+}
+
+/**
+ * check the parameter without the instance(see IPPipeline::validateParameter)
+ * return 0 if valid, -1 if unknown key or invalid values
+ */
+/*public static*/
+int IPColorExtractor::validateParameter(const std::string &key, const float *values, const int &num) {
+	if ((key != "color") || (num != 6)) {
+		return -1;
+	}
+	const int h_min = (int)values[0], h_max = (int)values[1];
+	const int s_min = (int)values[2], s_max = (int)values[3];
+	const int v_min = (int)values[4], v_max = (int)values[5];
+	if ((h_min < 0) || (h_min >= 180) || (h_max < 0) || (h_max >= 180)
+		|| (s_min < 0) || (s_max > 255) || (s_min > s_max)
+		|| (v_min < 0) || (v_max > 255) || (v_min > v_max)) {
+
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * set range of HSV to extract("color"), applied to the frames after the table is built.
+ * only the latest range is built if this is called again while building
+ */
+/*public*/
+int IPColorExtractor::setParameter(const std::string &key, const float *values, const int &num) {
+	ENTER();
+
+	if (UNLIKELY(validateParameter(key, values, num))) {
+		RETURN(-1, int);
+	}
+	const int h_min = (int)values[0], h_max = (int)values[1];
+	const int s_min = (int)values[2], s_max = (int)values[3];
+	const int v_min = (int)values[4], v_max = (int)values[5];
+	int result = 0;
+	Mutex::Autolock thread_lock(mThreadLock);
+	bool start_thread = false;
+	mLutLock.lock();
+	{
+		mRange[0] = h_min;
+		mRange[1] = h_max;
+		mRange[2] = s_min;
+		mRange[3] = s_max;
+		mRange[4] = v_min;
+		mRange[5] = v_max;
+		mRangeSeq++;
+		if (!mBuilding) {
+			mBuilding = start_thread = true;
+		}
+	}
+	mLutLock.unlock();
+	if (start_thread) {
+		// previous thread already finished building or is just exiting
+		if (mHasThread && (pthread_join(lut_thread, NULL) != EXIT_SUCCESS)) {
+			LOGW("terminate lut thread: pthread_join failed");
+		}
+		mHasThread = false;
+		result = pthread_create(&lut_thread, NULL, lut_thread_func, (void *)this);
+		if (LIKELY(!result)) {
+			mHasThread = true;
+		} else {
+			LOGE("pthread_create failed:%d", result);
+			mLutLock.lock();
+			{
+				mBuilding = false;
+			}
+			mLutLock.unlock();
+		}
+	}
+
+	RETURN(result, int);
+}
+
+/** static member thread function */
+/*private*/
+void *IPColorExtractor::lut_thread_func(void *vptr_args) {
+	ENTER();
+
+	IPColorExtractor *stage = reinterpret_cast<IPColorExtractor *>(vptr_args);
+	if (LIKELY(stage)) {
+		stage->do_build();
+	}
+
+	PRE_EXIT();
+	pthread_exit(NULL);
+}
+
+/**
+ * build lookup table of the latest requested range until no newer request comes while building
+ */
+/*private*/
+void IPColorExtractor::do_build() {
+	ENTER();
+
+	int range[6];
+	int seq;
+	mLutLock.lock();
+	for ( ; ; ) {
+		memcpy(range, mRange, sizeof(range));
+		seq = mRangeSeq;
+		mLutLock.unlock();
+		cv::Mat lut = buildLut(range[0], range[1], range[2], range[3], range[4], range[5]);
+		mLutLock.lock();
+		// previous table is released when the frame that uses it is finished
+		mLut = lut;
+		if (seq == mRangeSeq) {
+			mBuilding = false;
+			break;
+		}
+	}
+	mLutLock.unlock();
+
+	EXIT();
+}
+
+/*public static*/
+cv::Mat IPColorExtractor::buildLut(const int &h_min, const int &h_max,
+	const int &s_min, const int &s_max, const int &v_min, const int &v_max) {
+
+	ENTER();
+
+	cv::Mat lut(1, COLOR_LUT_SIZE, CV_8UC1);
+	build_hsv_lut(lut.ptr<uint8_t>(), h_min, h_max, s_min, s_max, v_min, v_max);
+
+	RET(lut);
+}
+
+/*public*/
+int IPColorExtractor::outputType(const int &src_type) const {
+	// 1 channel frame is passed through without buffer
+	return CV_MAT_CN(src_type) == 4 ? CV_8UC1 : -1;
+}
+
+/*public*/
+int IPColorExtractor::process(stage_context_t &ctx, const cv::Mat &src, cv::Mat &dst) {
+	ENTER();
+
+	if (UNLIKELY(src.channels() != 4)) {
+		dst = src;
+		RETURN(0, int);
+	}
+	cv::Mat lut;
+	mLutLock.lock();
+	{
+		// keep reference so that the table is not released while processing
+		lut = mLut;
+	}
+	mLutLock.unlock();
+	cv::Mat out;
+	if (writes_result(ctx)) {
+		out = ctx.result(ctx.roi);
+	}
+	ClassifyBody body(src, dst, lut.ptr<uint8_t>(), out);
+	int result = ip_parallel_for_tiles(src.rows, src.cols * src.elemSize(), body);
+	if (LIKELY(!result)) {
+		const int64_t total = (int64_t)src.cols * src.rows;
+		ctx.results[RESULT_IX_COLOR_AREA] = total ? body.count / (float)total : 0.0f;
+		if (body.count) {
+			// relative to the center of region of interest
+			ctx.results[RESULT_IX_COLOR_X] = body.sum_x / (float)body.count - src.cols * 0.5f;
+			ctx.results[RESULT_IX_COLOR_Y] = body.sum_y / (float)body.count - src.rows * 0.5f;
+		}
+	}
+
+	RETURN(result, int);
+}
@@ -0,0 +1,84 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+
+#ifndef FLIGHTDEMO_IPCOLOREXTRACTOR_H
+#define FLIGHTDEMO_IPCOLOREXTRACTOR_H
+
+#include <pthread.h>
+
+#include "Mutex.h"
+#include "IPStage.h"
+
+// default range of HSV to extract(white)
+#define DEFAULT_EXTRACT_H_MIN 0
+#define DEFAULT_EXTRACT_H_MAX 179
+#define DEFAULT_EXTRACT_S_MIN 0
+#define DEFAULT_EXTRACT_S_MAX 64
+#define DEFAULT_EXTRACT_V_MIN 192
+#define DEFAULT_EXTRACT_V_MAX 255
+
+/**
+ * "color": classify each pixel of RGBA frame by the range of HSV and output 1 channel mask(0 or 255).
+ * pixels are classified by lookup table instead of cv::cvtColor(COLOR_RGB2HSV) + cv::inRange,
+ * the table is built on its own thread when the color is changed and swapped when it is completed,
+ * so neither the caller of #setParameter nor processing waits for building it.
+ * ratio and centroid of extracted pixels are attached to results(RESULT_IX_COLOR_XXX).
+ * 1 channel input is passed through as is because the color is already lost.
+ * parameter:
+ *   "color" range of HSV(h_min, h_max, s_min, s_max, v_min, v_max),
+ *           hue [0, 180) wraps around if h_min > h_max, saturation and value [0, 255]
+ */
+class IPColorExtractor : public IPStage {
+private:
+	// guard for members below
+	mutable Mutex mLutLock;
+	// current lookup table, replaced with new table when it is built
+	cv::Mat mLut;
+	// latest requested range of HSV and its sequence number
+	int mRange[6];
+	int mRangeSeq;
+	// whether or not lut_thread is building the table
+	bool mBuilding;
+	// serialize join/start of lut_thread
+	Mutex mThreadLock;
+	pthread_t lut_thread;
+	bool mHasThread;
+	static void *lut_thread_func(void *vptr_args);
+	void do_build();
+public:
+	IPColorExtractor();
+	virtual ~IPColorExtractor();
+	virtual int outputType(const int &src_type) const;
+	virtual int process(stage_context_t &ctx, const cv::Mat &src, cv::Mat &dst);
+	virtual int setParameter(const std::string &key, const float *values, const int &num);
+	static int validateParameter(const std::string &key, const float *values, const int &num);
+	/**
+	 * build lookup table of RGB(5 bits each) -> 0xff if the color should be extracted,
+	 * this takes a while(~32K HSV conversions), so call this on other thread than the pipeline
+	 */
+	static cv::Mat buildLut(const int &h_min, const int &h_max,
+		const int &s_min, const int &s_max, const int &v_min, const int &v_max);
+};
+
+#endif //FLIGHTDEMO_IPCOLOREXTRACTOR_H
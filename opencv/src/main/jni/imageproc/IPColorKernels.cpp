@@ -0,0 +1,221 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+	#include <arm_neon.h>
+	#define USE_NEON 1
+#elif defined(__SSE2__)
+	#include <emmintrin.h>
+	#define USE_SSE2 1
+#endif
+
+#include <algorithm>
+
+#include "IPColorKernels.h"
+
+// coefficients of OpenCV for RGB->Y, fixed point of 14 bits
+#define GRAY_SHIFT 14
+#define R2Y 4899
+#define G2Y 9617
+#define B2Y 1868
+
+static inline uint8_t rgba_to_y(const uint8_t *p) {
+	return (uint8_t)((p[0] * R2Y + p[1] * G2Y + p[2] * B2Y + (1 << (GRAY_SHIFT - 1))) >> GRAY_SHIFT);
+}
+
+#if USE_SSE2
+/** Y of 4 RGBA pixels as 32 bits integers */
+static inline __m128i sse2_y4(const __m128i &v, const __m128i &coeff, const __m128i &round) {
+	const __m128i zero = _mm_setzero_si128();
+	// (R * R2Y + G * G2Y, B * B2Y + A * 0) for each pixel
+	const __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi8(v, zero), coeff);
+	const __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi8(v, zero), coeff);
+	const __m128i rg = _mm_castps_si128(_mm_shuffle_ps(
+		_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(2, 0, 2, 0)));
+	const __m128i ba = _mm_castps_si128(_mm_shuffle_ps(
+		_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(3, 1, 3, 1)));
+	return _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(rg, ba), round), GRAY_SHIFT);
+}
+
+/** expand 16 gray scale pixels to 16 RGBA pixels */
+static inline void sse2_store_rgba16(uint8_t *rgba, const __m128i &y) {
+	const __m128i alpha = _mm_set1_epi8((char)0xff);
+	const __m128i yy_lo = _mm_unpacklo_epi8(y, y);
+	const __m128i yy_hi = _mm_unpackhi_epi8(y, y);
+	const __m128i ya_lo = _mm_unpacklo_epi8(y, alpha);
+	const __m128i ya_hi = _mm_unpackhi_epi8(y, alpha);
+	_mm_storeu_si128((__m128i *)(rgba +  0), _mm_unpacklo_epi16(yy_lo, ya_lo));
+	_mm_storeu_si128((__m128i *)(rgba + 16), _mm_unpackhi_epi16(yy_lo, ya_lo));
+	_mm_storeu_si128((__m128i *)(rgba + 32), _mm_unpacklo_epi16(yy_hi, ya_hi));
+	_mm_storeu_si128((__m128i *)(rgba + 48), _mm_unpackhi_epi16(yy_hi, ya_hi));
+}
+#endif
+
+void rgba_to_gray_rgba(const uint8_t *src, uint8_t *gray, uint8_t *rgba, const int &n) {
+	int i = 0;
+#if USE_NEON
+	const uint8x16_t alpha = vdupq_n_u8(0xff);
+	for ( ; i + 16 <= n; i += 16) {
+		const uint8x16x4_t v = vld4q_u8(src + i * 4);
+		uint32x4_t y[4];
+		const uint16x8_t r_lo = vmovl_u8(vget_low_u8(v.val[0])), r_hi = vmovl_u8(vget_high_u8(v.val[0]));
+		const uint16x8_t g_lo = vmovl_u8(vget_low_u8(v.val[1])), g_hi = vmovl_u8(vget_high_u8(v.val[1]));
+		const uint16x8_t b_lo = vmovl_u8(vget_low_u8(v.val[2])), b_hi = vmovl_u8(vget_high_u8(v.val[2]));
+		y[0] = vmull_n_u16(vget_low_u16(r_lo), R2Y);
+		y[1] = vmull_n_u16(vget_high_u16(r_lo), R2Y);
+		y[2] = vmull_n_u16(vget_low_u16(r_hi), R2Y);
+		y[3] = vmull_n_u16(vget_high_u16(r_hi), R2Y);
+		y[0] = vmlal_n_u16(y[0], vget_low_u16(g_lo), G2Y);
+		y[1] = vmlal_n_u16(y[1], vget_high_u16(g_lo), G2Y);
+		y[2] = vmlal_n_u16(y[2], vget_low_u16(g_hi), G2Y);
+		y[3] = vmlal_n_u16(y[3], vget_high_u16(g_hi), G2Y);
+		y[0] = vmlal_n_u16(y[0], vget_low_u16(b_lo), B2Y);
+		y[1] = vmlal_n_u16(y[1], vget_high_u16(b_lo), B2Y);
+		y[2] = vmlal_n_u16(y[2], vget_low_u16(b_hi), B2Y);
+		y[3] = vmlal_n_u16(y[3], vget_high_u16(b_hi), B2Y);
+		// rounding shift is same as adding (1 << (GRAY_SHIFT - 1)) before shift
+		const uint8x16_t yv = vcombine_u8(
+			vmovn_u16(vcombine_u16(vrshrn_n_u32(y[0], GRAY_SHIFT), vrshrn_n_u32(y[1], GRAY_SHIFT))),
+			vmovn_u16(vcombine_u16(vrshrn_n_u32(y[2], GRAY_SHIFT), vrshrn_n_u32(y[3], GRAY_SHIFT))));
+		vst1q_u8(gray + i, yv);
+		if (rgba) {
+			uint8x16x4_t out;
+			out.val[0] = out.val[1] = out.val[2] = yv;
+			out.val[3] = alpha;
+			vst4q_u8(rgba + i * 4, out);
+		}
+	}
+#elif USE_SSE2
+	const __m128i coeff = _mm_setr_epi16(R2Y, G2Y, B2Y, 0, R2Y, G2Y, B2Y, 0);
+	const __m128i round = _mm_set1_epi32(1 << (GRAY_SHIFT - 1));
+	for ( ; i + 16 <= n; i += 16) {
+		const uint8_t *p = src + i * 4;
+		const __m128i y0 = sse2_y4(_mm_loadu_si128((const __m128i *)(p +  0)), coeff, round);
+		const __m128i y1 = sse2_y4(_mm_loadu_si128((const __m128i *)(p + 16)), coeff, round);
+		const __m128i y2 = sse2_y4(_mm_loadu_si128((const __m128i *)(p + 32)), coeff, round);
+		const __m128i y3 = sse2_y4(_mm_loadu_si128((const __m128i *)(p + 48)), coeff, round);
+		// values are [0, 255], so saturation never happens
+		const __m128i yv = _mm_packus_epi16(_mm_packs_epi32(y0, y1), _mm_packs_epi32(y2, y3));
+		_mm_storeu_si128((__m128i *)(gray + i), yv);
+		if (rgba) {
+			sse2_store_rgba16(rgba + i * 4, yv);
+		}
+	}
+#endif
+	for ( ; i < n; i++) {
+		const uint8_t y = rgba_to_y(src + i * 4);
+		gray[i] = y;
+		if (rgba) {
+			uint8_t *q = rgba + i * 4;
+			q[0] = q[1] = q[2] = y;
+			q[3] = 0xff;
+		}
+	}
+}
+
+void gray_to_rgba(const uint8_t *src, uint8_t *rgba, const int &n) {
+	int i = 0;
+#if USE_NEON
+	const uint8x16_t alpha = vdupq_n_u8(0xff);
+	for ( ; i + 16 <= n; i += 16) {
+		uint8x16x4_t out;
+		out.val[0] = out.val[1] = out.val[2] = vld1q_u8(src + i);
+		out.val[3] = alpha;
+		vst4q_u8(rgba + i * 4, out);
+	}
+#elif USE_SSE2
+	for ( ; i + 16 <= n; i += 16) {
+		sse2_store_rgba16(rgba + i * 4, _mm_loadu_si128((const __m128i *)(src + i)));
+	}
+#endif
+	for ( ; i < n; i++) {
+		uint8_t *q = rgba + i * 4;
+		q[0] = q[1] = q[2] = src[i];
+		q[3] = 0xff;
+	}
+}
+
+/** same as cv::cvtColor(COLOR_RGB2HSV) of one 8 bits pixel */
+static void rgb_to_hsv(const int &r, const int &g, const int &b, int &h, int &s, int &v) {
+	const int max = std::max(r, std::max(g, b));
+	const int min = std::min(r, std::min(g, b));
+	const int diff = max - min;
+	v = max;
+	s = max ? (diff * 255 + max / 2) / max : 0;
+	if (!diff) {
+		h = 0;
+		return;
+	}
+	float hue;	// [deg]
+	if (max == r) {
+		hue = 60.0f * (g - b) / diff;
+	} else if (max == g) {
+		hue = 120.0f + 60.0f * (b - r) / diff;
+	} else {
+		hue = 240.0f + 60.0f * (r - g) / diff;
+	}
+	if (hue < 0) {
+		hue += 360.0f;
+	}
+	h = ((int)(hue * 0.5f + 0.5f)) % 180;
+}
+
+void build_hsv_lut(uint8_t *lut,
+	const int &h_min, const int &h_max,
+	const int &s_min, const int &s_max,
+	const int &v_min, const int &v_max) {
+
+	const int levels = 1 << COLOR_LUT_BITS;
+	const int shift = 8 - COLOR_LUT_BITS;
+	const int half = 1 << (shift - 1);
+	int h, s, v;
+	for (int r = 0; r < levels; r++) {
+		for (int g = 0; g < levels; g++) {
+			for (int b = 0; b < levels; b++) {
+				rgb_to_hsv((r << shift) + half, (g << shift) + half, (b << shift) + half, h, s, v);
+				const bool in_hue = h_min <= h_max
+					? (h >= h_min) && (h <= h_max)
+					: (h >= h_min) || (h <= h_max);
+				*lut++ = in_hue && (s >= s_min) && (s <= s_max) && (v >= v_min) && (v <= v_max)
+					? 0xff : 0;
+			}
+		}
+	}
+}
+
+int classify_rgba(const uint8_t *src, const uint8_t *lut, uint8_t *mask, const int &n, int64_t &sum_x) {
+	const int shift = 8 - COLOR_LUT_BITS;
+	int count = 0;
+	int64_t sum = 0;
+	for (int i = 0; i < n; i++, src += 4) {
+		const uint8_t m = lut[((src[0] >> shift) << (COLOR_LUT_BITS * 2))
+			| ((src[1] >> shift) << COLOR_LUT_BITS) | (src[2] >> shift)];
+		mask[i] = m;
+		// m is 0 or 0xff
+		count += m & 1;
+		sum += i & -(int)(m & 1);
+	}
+	sum_x += sum;
+	return count;
+}
@@ -0,0 +1,70 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+
+#ifndef FLIGHTDEMO_IPCOLORKERNELS_H
+#define FLIGHTDEMO_IPCOLORKERNELS_H
+
+#include <stdint.h>
+
+/**
+ * convert one row of RGBA pixels to gray scale and, in same pass,
+ * write the gray scale as RGBA(Y, Y, Y, 255).
+ * gray scale uses same fixed point coefficients as cv::cvtColor(COLOR_RGBA2GRAY)
+ * @param src RGBA pixels, 4 * n bytes
+ * @param gray 1 channel output, n bytes
+ * @param rgba RGBA output, 4 * n bytes, can be NULL if you need only gray scale
+ * @param n number of pixels
+ */
+void rgba_to_gray_rgba(const uint8_t *src, uint8_t *gray, uint8_t *rgba, const int &n);
+/**
+ * convert one row of gray scale to RGBA(Y, Y, Y, 255),
+ * same as cv::cvtColor(COLOR_GRAY2RGBA)
+ */
+void gray_to_rgba(const uint8_t *src, uint8_t *rgba, const int &n);
+
+// bits of each channel of the index of RGB lookup table, 32x32x32 entries
+#define COLOR_LUT_BITS 5
+#define COLOR_LUT_SIZE (1 << (COLOR_LUT_BITS * 3))
+
+/**
+ * build lookup table from RGB to 0xff if the color is in the range of HSV, otherwise 0,
+ * each entry is classified by the center of its RGB cube.
+ * HSV is same as cv::cvtColor(COLOR_RGB2HSV) of 8 bits image, H is [0, 180), S and V are [0, 255]
+ * @param lut COLOR_LUT_SIZE bytes
+ * @param h_min h_max range of hue, range wraps around 180 if h_min > h_max(e.g. red)
+ */
+void build_hsv_lut(uint8_t *lut,
+	const int &h_min, const int &h_max,
+	const int &s_min, const int &s_max,
+	const int &v_min, const int &v_max);
+/**
+ * classify one row of RGBA pixels by the lookup table of #build_hsv_lut,
+ * this is one table lookup for each pixel instead of RGB->HSV conversion and range check
+ * @param mask 1 channel output, n bytes
+ * @param sum_x sum of the index of the pixels in the range is added
+ * @return number of the pixels in the range
+ */
+int classify_rgba(const uint8_t *src, const uint8_t *lut, uint8_t *mask, const int &n, int64_t &sum_x);
+
+#endif //FLIGHTDEMO_IPCOLORKERNELS_H
@@ -0,0 +1,336 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+
+
+#if 1	// set 0 to enable debug output, otherwise set 1
+	#ifndef LOG_NDEBUG
+		#define	LOG_NDEBUG		// disable LOGV/LOGD/MARK
+	#endif
+	#undef USE_LOGALL			// enable specific LOGx only
+#else
+//	#define USE_LOGALL
+	#define USE_LOGD
+	#undef LOG_NDEBUG
+	#undef NDEBUG
+#endif
+
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+#include "utilbase.h"
+
+#include "IPScanline.h"
+#include "IPCurveDetector.h"
+
+// small regularization of cubic and quadratic terms so that
+// the curve becomes straight instead of diverging when the points are in short range
+#define RIDGE 1e-4
+
+static inline float eval_cubic(const Coeff4_t &c, const float &t) {
+	return ((c.a * t + c.b) * t + c.c) * t + c.d;
+}
+
+static inline void lsq_clear(cubic_lsq_t &lsq) {
+	memset(&lsq, 0, sizeof(lsq));
+}
+
+/** add(sign = 1) or remove(sign = -1) a point */
+static void lsq_update(cubic_lsq_t &lsq, const float &t, const float &u, const int &sign) {
+	const double row[4] = { (double)t * t * t, (double)t * t, t, 1.0 };
+	for (int i = 0; i < 4; i++) {
+		for (int j = 0; j < 4; j++) {
+			lsq.ata[i][j] += sign * row[i] * row[j];
+		}
+		lsq.atu[i] += sign * row[i] * u;
+	}
+	lsq.n += sign;
+}
+
+/** solve normal equations by gaussian elimination, return false if they are singular */
+static bool lsq_solve(const cubic_lsq_t &lsq, Coeff4_t &coeff) {
+	if (lsq.n < 4) {
+		return false;
+	}
+	double m[4][5];
+	for (int i = 0; i < 4; i++) {
+		memcpy(m[i], lsq.ata[i], sizeof(lsq.ata[i]));
+		m[i][4] = lsq.atu[i];
+	}
+	m[0][0] += RIDGE * lsq.n;
+	m[1][1] += RIDGE * lsq.n;
+	for (int i = 0; i < 4; i++) {
+		int pivot = i;
+		for (int j = i + 1; j < 4; j++) {
+			if (fabs(m[j][i]) > fabs(m[pivot][i])) pivot = j;
+		}
+		if (fabs(m[pivot][i]) < EPS) {
+			return false;
+		}
+		if (pivot != i) {
+			for (int k = 0; k < 5; k++) std::swap(m[i][k], m[pivot][k]);
+		}
+		for (int j = i + 1; j < 4; j++) {
+			const double f = m[j][i] / m[i][i];
+			for (int k = i; k < 5; k++) m[j][k] -= f * m[i][k];
+		}
+	}
+	double x[4];
+	for (int i = 3; i >= 0; i--) {
+		double v = m[i][4];
+		for (int k = i + 1; k < 4; k++) v -= m[i][k] * x[k];
+		x[i] = v / m[i][i];
+	}
+	coeff.a = (float)x[0];
+	coeff.b = (float)x[1];
+	coeff.c = (float)x[2];
+	coeff.d = (float)x[3];
+	return true;
+}
+
+IPCurveDetector::IPCurveDetector()
+:	IPTrackingStage("curve", CURVE_MIN_CONFIDENCE, CURVE_LOST_FRAMES, RESULT_IX_CURVE_FULL_SEARCH),
+	mVertical(true),
+	mFoundVertical(true),
+	mRandom(0x12345678) {
+
+	ENTER();
+
+	memset(&mCoeff, 0, sizeof(mCoeff));
+	memset(&mFoundCoeff, 0, sizeof(mFoundCoeff));
+
+	EXIT();
+}
+
+IPCurveDetector::~IPCurveDetector() {
+	ENTER();
+
+	EXIT();
+}
+
+/*protected*/
+void IPCurveDetector::accept() {
+	mVertical = mFoundVertical;
+	mCoeff = mFoundCoeff;
+}
+
+/*protected*/
+void IPCurveDetector::report(stage_context_t &ctx, const float &confidence, const bool &full_search) {
+	ctx.detect_type = TYPE_CURVE;
+	// coefficients for pixels instead of normalized t
+	const float s = (mVertical ? ctx.roi.height : ctx.roi.width) * 0.5f;
+	ctx.results[RESULT_IX_CURVE_CONFIDENCE] = confidence;
+	ctx.results[RESULT_IX_CURVE_A] = mCoeff.a / (s * s * s);
+	ctx.results[RESULT_IX_CURVE_B] = mCoeff.b / (s * s);
+	ctx.results[RESULT_IX_CURVE_C] = mCoeff.c / s;
+	ctx.results[RESULT_IX_CURVE_D] = mCoeff.d;
+	ctx.results[RESULT_IX_CURVE_AXIS] = mVertical ? 0.0f : 1.0f;
+	if (draws_overlay(ctx)) {
+		drawCurve(ctx, confidence > 0 ? COLOR_GREEN : COLOR_YELLOW);
+	}
+}
+
+/**
+ * search the line on one scanline at the center of each band
+ * @param vertical true if the scanlines are rows
+ * @param prev search only around this curve, whole scanline if NULL
+ * @return number of sampled scanlines
+ */
+/*private*/
+int IPCurveDetector::sample(const cv::Mat &gray, const bool &vertical, const Coeff4_t *prev) {
+	mPoints.clear();
+	const int len_v = vertical ? gray.rows : gray.cols;
+	const int len_u = vertical ? gray.cols : gray.rows;
+	const float center_v = len_v * 0.5f;
+	const float center_u = len_u * 0.5f;
+	int sampled = 0;
+	int strength;
+	for (int k = 0; k < CURVE_NUM_BANDS; k++) {
+		const int v = (2 * k + 1) * len_v / (2 * CURVE_NUM_BANDS);
+		const float t = (v - center_v) / center_v;
+		int u0 = 0, u1 = len_u;
+		if (prev) {
+			const int u = cvRound(eval_cubic(*prev, t) + center_u);
+			u0 = std::max(0, u - CURVE_SEARCH_HALF_WIDTH);
+			u1 = std::min(len_u, u + CURVE_SEARCH_HALF_WIDTH + 1);
+			if (u1 - u0 < 3) continue;
+		}
+		sampled++;
+		const float pos = vertical
+			? scan_line_center(gray.ptr<uint8_t>(v) + u0, 1, u1 - u0,
+				CURVE_MIN_CONTRAST, CURVE_MAX_WIDTH, strength)
+			: scan_line_center(gray.ptr<uint8_t>(u0) + v, (int)gray.step, u1 - u0,
+				CURVE_MIN_CONTRAST, CURVE_MAX_WIDTH, strength);
+		if (pos >= 0) {
+			const curve_point_t point = { t, u0 + pos - center_u, false };
+			mPoints.push_back(point);
+		}
+	}
+	return sampled;
+}
+
+/**
+ * fit the curve to the sampled points starting from coeff,
+ * outliers are removed from(and points that became inliers are added to)
+ * the normal equations one by one while the threshold is tightened
+ * @param coeff initial curve, replaced with fitted curve
+ * @return number of inliers, 0 if the curve can't be fitted
+ */
+/*private*/
+int IPCurveDetector::fitIncremental(Coeff4_t &coeff) {
+	static const float thresholds[] = {
+		CURVE_SEARCH_HALF_WIDTH, CURVE_MAX_ERROR * 4, CURVE_MAX_ERROR * 2, CURVE_MAX_ERROR,
+	};
+	static const int num_thresholds = sizeof(thresholds) / sizeof(float);
+
+	cubic_lsq_t lsq;
+	lsq_clear(lsq);
+	for (int th = 0; th < num_thresholds; th++) {
+		for (std::vector<curve_point_t>::iterator iter = mPoints.begin(); iter != mPoints.end(); iter++) {
+			curve_point_t &point = *iter;
+			const bool inlier = fabsf(point.u - eval_cubic(coeff, point.t)) <= thresholds[th];
+			if (inlier != point.inlier) {
+				lsq_update(lsq, point.t, point.u, inlier ? 1 : -1);
+				point.inlier = inlier;
+			}
+		}
+		if ((lsq.n < CURVE_MIN_POINTS) || !lsq_solve(lsq, coeff)) {
+			return 0;
+		}
+	}
+	int result = 0;
+	for (std::vector<curve_point_t>::const_iterator iter = mPoints.begin(); iter != mPoints.end(); iter++) {
+		if (fabsf(iter->u - eval_cubic(coeff, iter->t)) <= CURVE_MAX_ERROR) {
+			result++;
+		}
+	}
+	return result;
+}
+
+/**
+ * fit the curve to the points that contain many outliers
+ * by the best of random 4 points hypotheses followed by #fitIncremental
+ * @return number of inliers, 0 if the curve can't be fitted
+ */
+/*private*/
+int IPCurveDetector::fitRansac(Coeff4_t &coeff) {
+	const int n = (int)mPoints.size();
+	if (n < CURVE_MIN_POINTS) {
+		return 0;
+	}
+	int best = 0;
+	Coeff4_t best_coeff;
+	cubic_lsq_t lsq;
+	for (int i = 0; i < CURVE_RANSAC_ITERATIONS; i++) {
+		// 4 distinct points by xorshift
+		int ix[4];
+		for (int j = 0; j < 4; j++) {
+			bool dup;
+			do {
+				mRandom ^= mRandom << 13;
+				mRandom ^= mRandom >> 17;
+				mRandom ^= mRandom << 5;
+				ix[j] = (int)(mRandom % n);
+				dup = false;
+				for (int k = 0; k < j; k++) dup |= (ix[k] == ix[j]);
+			} while (dup);
+		}
+		lsq_clear(lsq);
+		for (int j = 0; j < 4; j++) {
+			lsq_update(lsq, mPoints[ix[j]].t, mPoints[ix[j]].u, 1);
+		}
+		Coeff4_t c;
+		if (!lsq_solve(lsq, c)) continue;
+		// 4 points curve amplifies noise, so hypotheses are scored with looser threshold
+		int inliers = 0;
+		for (int j = 0; j < n; j++) {
+			if (fabsf(mPoints[j].u - eval_cubic(c, mPoints[j].t)) <= CURVE_MAX_ERROR * 2) {
+				inliers++;
+			}
+		}
+		if (inliers > best) {
+			best = inliers;
+			best_coeff = c;
+		}
+	}
+	if (best < CURVE_MIN_POINTS) {
+		return 0;
+	}
+	coeff = best_coeff;
+	return fitIncremental(coeff);
+}
+
+/**
+ * search only around the previous curve and fit the curve starting from it
+ * @return confidence, ratio of the inliers to sampled scanlines
+ */
+/*protected*/
+float IPCurveDetector::track(const cv::Mat &gray) {
+	mFoundVertical = mVertical;
+	mFoundCoeff = mCoeff;
+	const int sampled = sample(gray, mVertical, &mCoeff);
+	if (!sampled || ((int)mPoints.size() < CURVE_MIN_POINTS)) {
+		return 0;
+	}
+	return fitIncremental(mFoundCoeff) / (float)sampled;
+}
+
+/**
+ * search whole scanlines of both rows and columns
+ * @return confidence of the better direction
+ */
+/*protected*/
+float IPCurveDetector::detect(const cv::Mat &gray) {
+	float result = 0;
+	for (int i = 0; i < 2; i++) {
+		const bool v = !i;
+		const int sampled = sample(gray, v, NULL);
+		Coeff4_t c;
+		const int inliers = sampled ? fitRansac(c) : 0;
+		if (inliers && (inliers / (float)sampled > result)) {
+			result = inliers / (float)sampled;
+			mFoundVertical = v;
+			mFoundCoeff = c;
+		}
+	}
+	return result;
+}
+
+/** draw tracked curve in the region of interest of the result image */
+/*private*/
+void IPCurveDetector::drawCurve(stage_context_t &ctx, const cv::Scalar &color) {
+	const int len_v = mVertical ? ctx.roi.height : ctx.roi.width;
+	const int len_u = mVertical ? ctx.roi.width : ctx.roi.height;
+	const float center_v = len_v * 0.5f;
+	const float center_u = len_u * 0.5f;
+	mPolyline.clear();
+	for (int k = 0; k <= CURVE_NUM_BANDS; k++) {
+		const int v = k * len_v / CURVE_NUM_BANDS;
+		const int u = cvRound(eval_cubic(mCoeff, (v - center_v) / center_v) + center_u);
+		mPolyline.push_back(mVertical
+			? cv::Point(ctx.roi.x + u, ctx.roi.y + v)
+			: cv::Point(ctx.roi.x + v, ctx.roi.y + u));
+	}
+	cv::polylines(ctx.result, mPolyline, false, color, 2);
+}
@@ -0,0 +1,104 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+
+#ifndef FLIGHTDEMO_IPCURVEDETECTOR_H
+#define FLIGHTDEMO_IPCURVEDETECTOR_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "IPTrackingStage.h"
+
+// number of bands along the curve, one scanline is sampled at the center of each band
+#define CURVE_NUM_BANDS 32
+// half width of the window around the previous curve that is searched while tracking[px]
+#define CURVE_SEARCH_HALF_WIDTH 24
+// maximum width of the line, rising and falling edges further apart are not paired[px]
+#define CURVE_MAX_WIDTH 32
+// minimum difference of the luminance across the edge of the line
+#define CURVE_MIN_CONTRAST 24
+// maximum distance of inliers from the curve along scanline[px]
+#define CURVE_MAX_ERROR 3.0f
+// minimum number of inliers and ratio of them to sampled scanlines
+#define CURVE_MIN_POINTS 8
+#define CURVE_MIN_CONFIDENCE 0.4f
+// number of frames that the curve is not found until the detector searches whole frame again
+#define CURVE_LOST_FRAMES 3
+// number of hypotheses of full search
+#define CURVE_RANSAC_ITERATIONS 64
+
+/**
+ * normal equations of least squares of cubic polynomial u = a * t^3 + b * t^2 + c * t + d,
+ * points can be added and removed one by one without touching other points
+ */
+typedef struct cubic_lsq {
+	double ata[4][4];
+	double atu[4];
+	int n;
+} cubic_lsq_t;
+
+/**
+ * "curve": detect a curved line(DetectType TYPE_CURVE) as cubic polynomial and track it over frames.
+ * the curve is u = a * v^3 + b * v^2 + c * v + d where v is along the curve and u is across it,
+ * (x, y) or (y, x) in pixels relative to the center of the region of interest, see RESULT_IX_CURVE_XXX.
+ * while tracking, one scanline of each band is searched only around the previous curve
+ * and the curve is fitted again by incremental least squares rejecting outliers,
+ * so the cost is proportional to the number of the bands instead of the size of the frame.
+ * whole frame is searched(RANSAC on strongest edges of each band)
+ * only when IPTrackingStage schedules full detection.
+ */
+class IPCurveDetector : public IPTrackingStage {
+private:
+	typedef struct curve_point {
+		float t;		// normalized position along the curve, [-1, 1]
+		float u;		// position across the curve relative to the center[px]
+		bool inlier;
+	} curve_point_t;
+
+	// true if u = f(y)(sample rows), false if u = f(x)(sample columns)
+	bool mVertical;
+	// coefficients for normalized t
+	Coeff4_t mCoeff;
+	// curve found by last #detect/#track
+	bool mFoundVertical;
+	Coeff4_t mFoundCoeff;
+	uint32_t mRandom;
+	// buffers reused between frames
+	std::vector<curve_point_t> mPoints;
+	std::vector<cv::Point> mPolyline;
+	int sample(const cv::Mat &gray, const bool &vertical, const Coeff4_t *prev);
+	int fitIncremental(Coeff4_t &coeff);
+	int fitRansac(Coeff4_t &coeff);
+	void drawCurve(stage_context_t &ctx, const cv::Scalar &color);
+protected:
+	virtual float detect(const cv::Mat &gray);
+	virtual float track(const cv::Mat &gray);
+	virtual void accept();
+	virtual void report(stage_context_t &ctx, const float &confidence, const bool &full_search);
+public:
+	IPCurveDetector();
+	virtual ~IPCurveDetector();
+};
+
+#endif //FLIGHTDEMO_IPCURVEDETECTOR_H
@@ -0,0 +1,268 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+
+
+#if 1	// set 0 to enable debug output, otherwise set 1
+	#ifndef LOG_NDEBUG
+		#define	LOG_NDEBUG		// disable LOGV/LOGD/MARK
+	#endif
+	#undef USE_LOGALL			// enable specific LOGx only
+#else
+//	#define USE_LOGALL
+	#define USE_LOGD
+	#undef LOG_NDEBUG
+	#undef NDEBUG
+#endif
+
+#include <string.h>
+#include <algorithm>
+
+#include "utilbase.h"
+
+#include "opencv2/video/tracking.hpp"
+
+#include "IPDenseFlow.h"
+
+IPDenseFlow::IPDenseFlow()
+:	IPStage("dense_flow"),
+	mResultSeq(-1),
+	mFrames(0),
+	mHasFlow(false) {
+
+	ENTER();
+
+	mParams.width = DEFAULT_FLOW_WIDTH;
+	mParams.interval = DEFAULT_FLOW_INTERVAL;
+	mParams.grid_cols = DEFAULT_FLOW_GRID_COLS;
+	mParams.grid_rows = DEFAULT_FLOW_GRID_ROWS;
+
+	EXIT();
+}
+
+IPDenseFlow::~IPDenseFlow() {
+	ENTER();
+
+	EXIT();
+}
+
+/*public*/
+void IPDenseFlow::reset() {
+	ENTER();
+
+	mFrames = 0;
+	mPrevRect = cv::Rect();
+	mHasFlow = false;
+	mGray.release();
+	mPrevSmall.release();
+	mSmall.release();
+	mFlow.release();
+	mCells.release();
+
+	EXIT();
+}
+
+/**
+ * check the parameter without the instance(see IPPipeline::validateParameter)
+ * "flow": width, interval, grid_cols, grid_rows
+ * "roi": x, y, width, height of the full frame, zero width or height means whole frame
+ * return 0 if valid, -1 if unknown key or invalid values
+ */
+/*public static*/
+int IPDenseFlow::validateParameter(const std::string &key, const float *values, const int &num) {
+	if ((key == "flow") && (num == 4)) {
+		const int width = (int)values[0], interval = (int)values[1];
+		const int grid_cols = (int)values[2], grid_rows = (int)values[3];
+		if ((width >= MIN_FLOW_WIDTH) && (width <= MAX_FLOW_WIDTH)
+			&& (interval >= 1) && (interval <= MAX_FLOW_INTERVAL)
+			&& (grid_cols >= 0) && (grid_cols <= MAX_FLOW_GRID)
+			&& (grid_rows >= 0) && (grid_rows <= MAX_FLOW_GRID)) {
+
+			return 0;
+		}
+	} else if ((key == "roi") && (num == 4)) {
+		return 0;
+	}
+	return -1;
+}
+
+/*public*/
+int IPDenseFlow::setParameter(const std::string &key, const float *values, const int &num) {
+	ENTER();
+
+	if (UNLIKELY(validateParameter(key, values, num))) {
+		RETURN(-1, int);
+	}
+	Mutex::Autolock lock(mParamsLock);
+	if (key == "flow") {
+		mParams.width = (int)values[0];
+		mParams.interval = (int)values[1];
+		mParams.grid_cols = (int)values[2];
+		mParams.grid_rows = (int)values[3];
+	} else {
+		const int width = (int)values[2], height = (int)values[3];
+		mParams.roi = (width > 0) && (height > 0)
+			? cv::Rect((int)values[0], (int)values[1], width, height) : cv::Rect();
+	}
+
+	RETURN(0, int);
+}
+
+/**
+ * "flow": cols and rows followed by (dx, dy) of each cell[px]
+ */
+/*public*/
+int IPDenseFlow::getResult(const std::string &key, float *values, const int &max_num, int64_t &seq) const {
+	ENTER();
+
+	if (key != "flow") {
+		RETURN(-1, int);
+	}
+	Mutex::Autolock lock(mResultLock);
+	const int n = (int)mResult.size();
+	seq = mResultSeq;
+	if (n && (max_num > 0)) {
+		memcpy(values, &mResult[0], std::min(n, max_num) * sizeof(float));
+	}
+
+	RETURN(n, int);
+}
+
+/*public*/
+int IPDenseFlow::process(stage_context_t &ctx, const cv::Mat &src, cv::Mat &dst) {
+	ENTER();
+
+	dst = src;
+	flow_params_t params;
+	mParamsLock.lock();
+	{
+		params = mParams;
+	}
+	mParamsLock.unlock();
+	// region to compute flow relative to the input
+	cv::Rect rect(0, 0, src.cols, src.rows);
+	if (params.roi.area() > 0) {
+		rect &= params.roi - ctx.roi.tl();
+	}
+	if (UNLIKELY(rect.area() <= 0)) {
+		// region is out of the frame
+		mPrevSmall.release();
+		mHasFlow = false;
+		RETURN(0, int);
+	}
+	const cv::Mat part = src(rect);
+	const cv::Mat *gray = &part;
+	if (part.channels() != 1) {
+		cv::cvtColor(part, mGray, cv::COLOR_RGBA2GRAY);
+		gray = &mGray;
+	}
+	const int w = std::min(std::max(params.width, MIN_FLOW_WIDTH), rect.width);
+	const int h = std::max(1, rect.height * w / rect.width);
+	std::swap(mPrevSmall, mSmall);
+	cv::resize(*gray, mSmall, cv::Size(w, h), 0, 0, cv::INTER_AREA);
+
+	const bool compute = (++mFrames >= params.interval)
+		&& (mPrevSmall.size() == mSmall.size()) && (rect == mPrevRect);
+	if (compute) {
+		mFrames = 0;
+		// previous flow is good initial guess only when it is the flow of previous frame
+		const int flags = mHasFlow && (params.interval <= 1) && (mFlow.size() == mSmall.size())
+			? cv::OPTFLOW_USE_INITIAL_FLOW : 0;
+		cv::calcOpticalFlowFarneback(mPrevSmall, mSmall, mFlow,
+			FLOW_PYR_SCALE, FLOW_LEVELS, FLOW_WIN_SIZE, FLOW_ITERATIONS,
+			FLOW_POLY_N, FLOW_POLY_SIGMA, flags);
+		mHasFlow = true;
+		output(ctx, params, w / (float)rect.width);
+		if (draws_overlay(ctx)) {
+			drawFlow(ctx, rect);
+		}
+	} else if (rect != mPrevRect) {
+		mHasFlow = false;
+	}
+	mPrevRect = rect;
+
+	RETURN(0, int);
+}
+
+/**
+ * average the flow in grid cells in pixels of the input and keep it for #getResult
+ * @param scale scale of downscaled frame
+ */
+/*private*/
+void IPDenseFlow::output(stage_context_t &ctx, const flow_params_t &params, const float &scale) {
+	const bool per_pixel = (params.grid_cols <= 0) || (params.grid_rows <= 0);
+	const int cols = per_pixel ? mFlow.cols : std::min(params.grid_cols, mFlow.cols);
+	const int rows = per_pixel ? mFlow.rows : std::min(params.grid_rows, mFlow.rows);
+	if (UNLIKELY((mCells.cols != cols) || (mCells.rows != rows) || (mCells.type() != CV_32FC2))) {
+		mCells.allocator = ctx.allocator;
+		mCells.create(rows, cols, CV_32FC2);
+	}
+	const float s = 1.0f / scale;
+	for (int gy = 0; gy < rows; gy++) {
+		const int y0 = gy * mFlow.rows / rows;
+		const int y1 = (gy + 1) * mFlow.rows / rows;
+		cv::Point2f *out = mCells.ptr<cv::Point2f>(gy);
+		for (int gx = 0; gx < cols; gx++) {
+			const int x0 = gx * mFlow.cols / cols;
+			const int x1 = (gx + 1) * mFlow.cols / cols;
+			cv::Point2f sum;
+			for (int y = y0; y < y1; y++) {
+				const cv::Point2f *p = mFlow.ptr<cv::Point2f>(y);
+				for (int x = x0; x < x1; x++) {
+					sum += p[x];
+				}
+			}
+			out[gx] = sum * (s / ((y1 - y0) * (x1 - x0)));
+		}
+	}
+	// keep the flow until Java reads it
+	Mutex::Autolock lock(mResultLock);
+	mResult.resize(2 + cols * rows * 2);
+	mResult[0] = (float)cols;
+	mResult[1] = (float)rows;
+	for (int gy = 0; gy < rows; gy++) {
+		memcpy(&mResult[2 + gy * cols * 2], mCells.ptr<float>(gy), cols * 2 * sizeof(float));
+	}
+	mResultSeq = ctx.info.seq;
+}
+
+/**
+ * draw the flow of each cell from its center
+ * @param rect region of the input that flow was computed
+ */
+/*private*/
+void IPDenseFlow::drawFlow(stage_context_t &ctx, const cv::Rect &rect) {
+	const cv::Mat &flow = mCells;
+	const float cw = rect.width / (float)flow.cols, ch = rect.height / (float)flow.rows;
+	// per pixel flow is too dense to draw all of it
+	const int step = std::max(1, (int)(16 / std::min(cw, ch)));
+	const cv::Point2f offset((float)(ctx.roi.x + rect.x), (float)(ctx.roi.y + rect.y));
+	for (int gy = step / 2; gy < flow.rows; gy += step) {
+		const cv::Point2f *p = flow.ptr<cv::Point2f>(gy);
+		for (int gx = step / 2; gx < flow.cols; gx += step) {
+			const cv::Point2f center = cv::Point2f((gx + 0.5f) * cw, (gy + 0.5f) * ch) + offset;
+			cv::arrowedLine(ctx.result, center, center + p[gx], COLOR_ACUA, 1);
+		}
+	}
+	cv::rectangle(ctx.result, rect + ctx.roi.tl(), COLOR_ACUA, 1);
+}
@@ -0,0 +1,109 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+
+#ifndef FLIGHTDEMO_IPDENSEFLOW_H
+#define FLIGHTDEMO_IPDENSEFLOW_H
+
+#include <vector>
+
+#include "Mutex.h"
+#include "IPStage.h"
+
+// default and range of flow_params_t
+#define DEFAULT_FLOW_WIDTH 160
+#define MIN_FLOW_WIDTH 16
+#define MAX_FLOW_WIDTH 320
+#define DEFAULT_FLOW_INTERVAL 1
+#define MAX_FLOW_INTERVAL 1000
+#define DEFAULT_FLOW_GRID_COLS 16
+#define DEFAULT_FLOW_GRID_ROWS 12
+#define MAX_FLOW_GRID 64
+// parameters of calcOpticalFlowFarneback
+#define FLOW_PYR_SCALE 0.5
+#define FLOW_LEVELS 3
+#define FLOW_WIN_SIZE 13
+#define FLOW_ITERATIONS 3
+#define FLOW_POLY_N 5
+#define FLOW_POLY_SIGMA 1.1
+
+/**
+ * parameters of "dense_flow" stage
+ */
+typedef struct flow_params {
+	// width of downscaled frame that flow is computed on[px]
+	int width;
+	// flow is computed every interval frames
+	int interval;
+	// number of the cells that flow is averaged in, 0 means flow of each pixel of downscaled frame
+	int grid_cols, grid_rows;
+	// region of the full frame to compute flow, empty means whole frame
+	cv::Rect roi;
+} flow_params_t;
+
+/**
+ * "dense_flow": dense optical flow by Farneback on downscaled frame(see flow_params_t).
+ * every frame is downscaled so that the flow is always the motion from previous frame,
+ * but the flow is computed only every interval frames.
+ * flow is averaged in grid cells(or of each pixel of downscaled frame if grid is 0)
+ * and scaled to the pixels of the input.
+ * RGBA input is converted to gray scale and the input is passed through to next stage.
+ * parameter:
+ *   "flow" width, interval, grid_cols, grid_rows of flow_params_t
+ *   "roi"  x, y, width, height of the region of the full frame, zero width or height means whole frame
+ * result:
+ *   "flow" cols and rows followed by (dx, dy) of each cell[px] of latest computed flow
+ */
+class IPDenseFlow : public IPStage {
+private:
+	// parameters set from other thread, guarded by mParamsLock
+	mutable Mutex mParamsLock;
+	flow_params_t mParams;
+	// latest flow for #getResult, guarded by mResultLock, this grows only when the flow gets larger
+	mutable Mutex mResultLock;
+	std::vector<float> mResult;
+	int64_t mResultSeq;
+	int mFrames;
+	// region of the input that flow was computed last time, flow is used as initial flow
+	// of next frame only while it is same
+	cv::Rect mPrevRect;
+	bool mHasFlow;
+	cv::Mat mGray;
+	// downscaled frame of previous and current frame, swapped for each frame
+	cv::Mat mPrevSmall, mSmall;
+	cv::Mat mFlow;
+	// flow averaged in grid cells(CV_32FC2, [px])
+	cv::Mat mCells;
+	void output(stage_context_t &ctx, const flow_params_t &params, const float &scale);
+	void drawFlow(stage_context_t &ctx, const cv::Rect &rect);
+public:
+	IPDenseFlow();
+	virtual ~IPDenseFlow();
+	virtual int process(stage_context_t &ctx, const cv::Mat &src, cv::Mat &dst);
+	virtual void reset();
+	virtual int setParameter(const std::string &key, const float *values, const int &num);
+	static int validateParameter(const std::string &key, const float *values, const int &num);
+	virtual int getResult(const std::string &key, float *values, const int &max_num, int64_t &seq) const;
+};
+
+#endif //FLIGHTDEMO_IPDENSEFLOW_H
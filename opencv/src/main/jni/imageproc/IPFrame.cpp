@@ -36,19 +36,27 @@
 #include "utilbase.h"
 
 #include "IPFrame.h"
+#include "IPFrameSource.h"
 
 #include "common_utils.h"
 
-#define USE_PBO 1
-
 IPFrame::IPFrame()
-: pbo_ix(0), pbo_width(0), pbo_height(0), pbo_size(0) {
+: mMaxQueuedFrames(DEFAULT_QUEUED_FRAMES),
+  mQueuePolicy(QUEUE_POLICY_DROP_OLDEST),
+  mBlockTimeoutNs(ms2ns(DEFAULT_BLOCK_TIMEOUT_MS)),
+  mNumSlots(0),
+  mProducerSlot(-1),
+  mNumSpareSlots(0),
+  mConsumerSlot(-1),
+  frame_width(0), frame_height(0),
+  mReadRoi(0),
+  mIsFrameActive(false),
+  mFrameSource(NULL) {
 
 	ENTER();
 
-#if USE_PBO
-	pbo[0] = pbo[1] = 0;
-#endif
+	memset(&mStats, 0, sizeof(mStats));
+	memset(mInfo, 0, sizeof(mInfo));
 
 	EXIT();
 }
@@ -64,211 +72,419 @@ IPFrame::~IPFrame() {
 //================================================================================
 //
 //================================================================================
-void IPFrame::initFrame(const int &width, const int &height) {
+/**
+ * prepare frame queue, this should be called before frame source and worker thread start
+ * @param width
+ * @param height
+ * @param source frame source that provides frames into this frame queue
+ * @param queue_size max number of frames in frame queue, [1, MAX_QUEUED_FRAMES]
+ * @param pool_size number of spare frames in addition to frame queue, [MIN_POOL_SIZE, MAX_POOL_SIZE]
+ * @param policy what to do when frame queue is full, one of QUEUE_POLICY_XXX
+ * @param timeout_ms max waiting time for QUEUE_POLICY_BLOCK[ms]
+ * @param arena_flags ARENA_FLAG_XXX for the arena that serves frames and buffers of worker thread
+ */
+void IPFrame::initFrame(const int &width, const int &height, IPFrameSource *source,
+	const int &queue_size, const int &pool_size, const int &policy, const int &timeout_ms,
+	const int &arena_flags) {
+
 	ENTER();
 
-	Mutex::Autolock lock(mPboMutex);
-
-#if USE_PBO
-	// prepare PBOs for glReadPixels
-	pbo_width = width;
-	pbo_height = height;
-	pbo_size = (GLsizeiptr)width * height * 4;
-	// generate 2 PBO
-	glGenBuffers(2, pbo);
-	glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo[0]);
-	glBufferData(GL_PIXEL_PACK_BUFFER, pbo_size, NULL, GL_DYNAMIC_READ);
-	glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo[1]);
-	glBufferData(GL_PIXEL_PACK_BUFFER, pbo_size, NULL, GL_DYNAMIC_READ);
-	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
-	pbo_ix = 0;
-#endif
+	Mutex::Autolock lock(mFrameMutex);
+
+	frame_width = width;
+	frame_height = height;
+	mFrameSource = source;
+	mMaxQueuedFrames = std::min(std::max(queue_size, 1), MAX_QUEUED_FRAMES);
+	mNumSlots = mMaxQueuedFrames + std::min(std::max(pool_size, MIN_POOL_SIZE), MAX_POOL_SIZE);
+	mQueuePolicy = (policy >= 0) && (policy < QUEUE_POLICY_MAX) ? policy : QUEUE_POLICY_DROP_OLDEST;
+	mBlockTimeoutNs = ms2ns(std::max(timeout_ms, 0));
+	memset(&mStats, 0, sizeof(mStats));
+	mFrames.init(mMaxQueuedFrames);
+	mFreeSlots.init(mNumSlots);
+	// all slots are owned by frame source at first
+	for (int i = 0; i < MAX_FRAME_SLOTS; i++) {
+		mSlots[i].release();
+		mBuffers[i].release();
+		mSpareSlots[i] = mNumSlots - i - 1;
+	}
+	// frames of all slots and buffers of worker thread are served from the arena
+	const size_t frame_bytes = ALIGN_UP((size_t)width * height * 4, ARENA_ALIGNMENT);
+	mAllocator.init(frame_bytes * (mNumSlots + ARENA_WORK_FRAMES), arena_flags);
+	mNumSpareSlots = mNumSlots;
+	mProducerSlot = mConsumerSlot = -1;
+	mIsFrameActive = true;
+	__sync_synchronize();
 
 	EXIT();
 }
 
-void IPFrame::releaseFrame() {
+/**
+ * wake up worker thread that is waiting in #getFrame
+ * and frame source that is waiting in #addFrame,
+ * #getFrame returns empty frame after this call until #initFrame is called again
+ */
+void IPFrame::abortFrame() {
 	ENTER();
 
-	LOGI("");
-#if USE_PBO
-	mPboMutex.lock();
-	{
-		pbo_size = 0;
-		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
-		glDeleteBuffers(2, pbo);
-		pbo[0] = pbo[1] = 0;
-		pbo_width = pbo_height = 0;
-	}
-	mPboMutex.unlock();
-#endif
-
-	mFrameMutex.lock();
-	{
-		mFrameSync.broadcast();
-	}
-	mFrameMutex.unlock();
-
-	LOGI("finished");
+	mIsFrameActive = false;
+	__sync_synchronize();
+	mFrames.wakeAll();
+	mFreeSlots.wakeAll();
 
 	EXIT();
 }
 
-/** get image from frame buffer of OpenGL|ES, call this on drawing thread of Java */
-/*public*/
-int IPFrame::handleFrame(const int &, const int &, const int &) {
+void IPFrame::releaseFrame() {
 	ENTER();
 
-	cv::Mat frame;
-	mPboMutex.lock();
+	LOGI("");
+	abortFrame();
+	mFrameMutex.lock();
 	{
-		if (UNLIKELY(!pbo_size)) {
-			mPboMutex.unlock();
-			RETURN(1, int);	// dropped
-		}
-		// re-use cv::Mat
-		frame = obtainFromPool(pbo_width, pbo_height);
-#if USE_PBO
-		// index of PBO that read now
-		const int read_ix = pbo_ix;
-		// index of PBO to request read(will actually read into memory on next frame
-		const int next_ix = pbo_ix = (pbo_ix + 1) % 2;
-		//　bind PBO to read asynchronously
-		glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo[next_ix]);
-		// request asynchronously read frame buffer into PBO
-		glReadPixels(0, 0, pbo_width, pbo_height, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
-		// bind PBO to read image data from PBO
-		glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo[read_ix]);
-		// map PBO
-		const uint8_t *read_data = (uint8_t *)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, pbo_size, GL_MAP_READ_BIT);
-		if (LIKELY(read_data)) {
-			// copy PBO into memory
-			memcpy(frame.data, read_data, pbo_size);
-			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
-		}
-		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
-#else
-		glReadPixels(0, 0, pbo_width, pbo_height, GL_RGBA, GL_UNSIGNED_BYTE, frame.data);
-#endif
+		mFrameSource = NULL;
+		frame_width = frame_height = 0;
 	}
-	mPboMutex.unlock();
+	mFrameMutex.unlock();
 
-	if (LIKELY(canAddFrame())) {
-		addFrame(frame);
-	} else {
-		recycle(frame);
-	}
+	LOGI("finished");
 
-	RETURN(0, int);
+	EXIT();
 }
 
 //================================================================================
 // frame queue
 //================================================================================
+/**
+ * release all frames, this should be called after frame source and worker thread terminated
+ */
 /*protected*/
 void IPFrame::clearFrames() {
 	ENTER();
 
-	mPoolMutex.lock();
-	{
-		mPool.clear();
-	}
-	mPoolMutex.unlock();
+	Mutex::Autolock lock(mFrameMutex);
 
-	mFrameMutex.lock();
-	{
-		for ( ; !mFrames.empty(); ) {
-			mFrames.pop();
-		}
+	mFrames.clear();
+	mFreeSlots.clear();
+	for (int i = 0; i < MAX_FRAME_SLOTS; i++) {
+		mSlots[i].release();
+		mBuffers[i].release();
 	}
-	mFrameMutex.unlock();
+	mAllocator.release();
+	mNumSpareSlots = 0;
+	mProducerSlot = mConsumerSlot = -1;
 
 	EXIT();
 }
 
-/** get frame, if frame queue is empty, block until ready */
+/** get free slot, call this only from frame source,
+ * return -1 if all slots are in use */
+/*private*/
+int IPFrame::obtainSlot() {
+	if (LIKELY(mNumSpareSlots > 0)) {
+		return mSpareSlots[--mNumSpareSlots];
+	}
+	intptr_t slot;
+	if (mFreeSlots.pop(slot)) {
+		return (int)slot;
+	}
+	return -1;
+}
+
+/** keep slot for next frame, call this only from frame source
+ * @param discard the frame in the slot was dropped, if it is owned by frame source,
+ *                return it to frame source */
+/*private*/
+void IPFrame::releaseSlot(const int &slot, const bool &discard) {
+	if (discard && mFrameSource) {
+		mFrameSource->discard(mSlots[slot]);
+	}
+	// backing buffer is kept in mBuffers
+	mSlots[slot].release();
+	mSpareSlots[mNumSpareSlots++] = slot;
+}
+
+/** get frame, if frame queue is empty, block until ready.
+ * call this only from worker thread and return the frame with #recycle
+ * @param wait if false, return empty frame immediately when frame queue is empty */
 /*protected*/
-cv::Mat IPFrame::getFrame(long &last_queued_ms) {
+cv::Mat IPFrame::getFrame(frame_info_t &info, const bool &wait) {
 	ENTER();
 
 	cv::Mat result;
 
-	Mutex::Autolock lock(mFrameMutex);
-
-	if (UNLIKELY(mFrames.empty())) {
-		mFrameSync.wait(mFrameMutex);
+	if (UNLIKELY(mConsumerSlot >= 0)) {
+		// previous frame was not recycled
+		cv::Mat prev = mSlots[mConsumerSlot];
+		recycle(prev);
 	}
-	if (pbo_size && !mFrames.empty()) {
-		result = mFrames.front();
-		mFrames.pop();
-		last_queued_ms = last_queued_time_ms;
+	intptr_t slot;
+	for ( ; mIsFrameActive ; ) {
+		const int seq = mFrames.pushSeq();
+		if (mFrames.pop(slot)) {
+			mConsumerSlot = (int)slot;
+			result = mSlots[slot];
+			info = mInfo[slot];
+			break;
+		}
+		if (!wait) break;
+		// frame queue is empty, wait until frame source pushes new frame
+		mFrames.waitPush(seq);
 	}
 
 	RET(result);
 }
 
-/** obtain empty frame(cv::Mat) from frame pool,
-  * if frame pool is empty, generate new one  */
+/** obtain empty frame(cv::Mat) from frame pool, call this only from frame source.
+  * if all slots are in use, generate new one.
+  * frames smaller than the full frame(e.g. region of interest) share
+  * full frame size buffer of the slot, so changing their size never allocates
+  * @param type CV_8UC4(RGBA) or CV_8UC1(luminance only) */
 /*protected*/
-cv::Mat IPFrame::obtainFromPool(const int &width, const int &height) {
+cv::Mat IPFrame::obtainFromPool(const int &width, const int &height, const int &type) {
 	ENTER();
 
-	Mutex::Autolock lock(mPoolMutex);
-
+	if (UNLIKELY(mProducerSlot >= 0)) {
+		// previous frame was not added
+		releaseSlot(mProducerSlot, false);
+		mProducerSlot = -1;
+	}
 	cv::Mat frame;
-	if (LIKELY(!mPool.empty())) {
-		frame = mPool.back();
-		mPool.pop_back();
+	const int slot = obtainSlot();
+	if (LIKELY(slot >= 0)) {
+		mProducerSlot = slot;
+		cv::Mat &buf = mBuffers[slot];
+		if (UNLIKELY(buf.allocator != &mAllocator)) {
+			buf.release();
+			buf.allocator = &mAllocator;
+		}
+		if (LIKELY((size_t)width * height * CV_ELEM_SIZE(type) <= (size_t)frame_width * frame_height * 4)) {
+			buf.create(frame_height, frame_width, CV_8UC4);
+		} else {
+			buf.create(height, width, type);
+		}
+		// XXX Note: rows=height, cols=width
+		frame = continuousView(buf, width, height, type);
+	} else {
+		frame.create(height, width, type);
 	}
-	frame.create(height, width, CV_8UC4);	// XXX Note: rows=height, cols=width, as 8 bits RGBA
 
 	RET(frame);
 }
 
-/** return frame into frame pool to recycle/re-use */
+/** return frame to frame pool to recycle/re-use, call this only from worker thread.
+ * if the frame is owned by frame source(e.g. leased PBO), return it to the frame source */
 /*protected*/
 void IPFrame::recycle(cv::Mat &frame) {
 	ENTER();
 
-	if (LIKELY(!frame.empty())) {
-		Mutex::Autolock lock(mPoolMutex);
-
-		if (mPool.size() < MAX_POOL_SIZE) {
-			mPool.push_back(frame);
-		}
+	const int slot = mConsumerSlot;
+	mConsumerSlot = -1;
+	if (mFrameSource) {
+		mFrameSource->recycle(frame);
+	}
+	if (LIKELY(slot >= 0)) {
+		// backing buffer is kept in mBuffers
+		mSlots[slot].release();
+		mFreeSlots.push(slot);
 	}
 
 	EXIT();
 }
 
-/** append frame to frame queue.
-  * if number of frames in frame queue exceeds limit,
-  * return top of the frame(s) to frame pool */
+/**
+ * whether or not new frame will be queued without being dropped now.
+ * frame source can use this to skip acquiring/copying frame that will be dropped.
+ */
+/*protected*/
+const bool IPFrame::canAddFrame() {
+	return (mQueuePolicy != QUEUE_POLICY_DROP_NEWEST)
+		|| (mFrames.size() < mMaxQueuedFrames);
+}
+
+/** append frame to frame queue, call this only from frame source.
+  * this takes ownership of the frame.
+  * if frame queue is full, drop the oldest queued frame or the new frame
+  * or wait for worker thread depending on queue policy.
+  * return 0 if the frame was queued without dropping,
+  * -1 if the oldest queued frame was dropped, 1 if the new frame was dropped
+  * @param capture_time_ns time when the frame was captured or readback was requested
+  *                        [ns, SYSTEM_TIME_MONOTONIC], zero means now
+  * @param source_timestamp_ns timestamp from frame source(e.g. SurfaceTexture#getTimestamp)
+  * @param roi_x, roi_y position of the frame in the full frame when the frame is region of interest
+  */
 /*protected*/
-int IPFrame::addFrame(cv::Mat &frame) {
+int IPFrame::addFrame(cv::Mat &frame,
+	const nsecs_t &capture_time_ns, const int64_t &source_timestamp_ns,
+	const int &roi_x, const int &roi_y) {
+
 	ENTER();
 
 	int result = 0;
-	cv::Mat *temp = NULL;
 
-	mFrameMutex.lock();
-	{
-		last_queued_time_ms = getTimeMilliseconds();
-		if (mFrames.size() >= MAX_QUEUED_FRAMES) {
-			// return to frame pool
-			temp = &mFrames.front();
-			mFrames.pop();
+	// only frame source updates this counter, so this is the sequence number of the frame
+	const int64_t seq = __sync_fetch_and_add(&mStats.readback, 1);
+	int slot = mProducerSlot;
+	mProducerSlot = -1;
+	if ((slot >= 0) && UNLIKELY(mBuffers[slot].data != frame.data)) {
+		// the frame was not obtained from frame pool
+		releaseSlot(slot, false);
+		slot = -1;
+	}
+	if (slot < 0) {
+		slot = obtainSlot();
+		if (UNLIKELY(slot < 0)) {
+			// all slots are in use, worker thread keeps too many frames
+			if (mFrameSource) {
+				mFrameSource->discard(frame);
+			}
+			__sync_fetch_and_add(&mStats.dropped, 1);
+			RETURN(1, int);
 		}
-		mFrames.push(frame);
-		mFrameSync.signal();
 	}
-	mFrameMutex.unlock();
-
-	if (UNLIKELY(temp)) {
-		recycle(*temp);
-		result = -1;
+	mSlots[slot] = frame;
+	if (mFrames.size() >= mMaxQueuedFrames) {
+		switch (mQueuePolicy) {
+		case QUEUE_POLICY_DROP_NEWEST:
+			result = 1;
+			break;
+		case QUEUE_POLICY_BLOCK:
+		{
+			const nsecs_t limit = systemTime(SYSTEM_TIME_MONOTONIC) + mBlockTimeoutNs;
+			for ( ; mIsFrameActive ; ) {
+				const int seq = mFrames.popSeq();
+				if (mFrames.size() < mMaxQueuedFrames) break;
+				const nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC);
+				if (now >= limit) break;
+				mFrames.waitPop(seq, limit - now);
+			}
+			result = mFrames.size() >= mMaxQueuedFrames ? 1 : 0;
+			break;
+		}
+		default:	// QUEUE_POLICY_DROP_OLDEST
+		{
+			intptr_t oldest;
+			// this may fail when worker thread took it just now
+			if (mFrames.pop(oldest)) {
+				releaseSlot((int)oldest, true);
+				result = -1;
+			}
+			break;
+		}
+		}
+	}
+	if (LIKELY(result <= 0)) {
+		frame_info_t &info = mInfo[slot];
+		info.seq = seq;
+		info.queued_time_ns = systemTime(SYSTEM_TIME_MONOTONIC);
+		info.capture_time_ns = capture_time_ns ? capture_time_ns : info.queued_time_ns;
+		info.source_timestamp_ns = source_timestamp_ns;
+		info.dropped = mStats.dropped + (result ? 1 : 0);
+		info.roi_x = roi_x;
+		info.roi_y = roi_y;
+		info.roi_width = frame.cols;
+		info.roi_height = frame.rows;
+		mFrames.push(slot);
+		__sync_fetch_and_add(&mStats.enqueued, 1);
+		onFrameQueued();
+	} else {
+		releaseSlot(slot, true);
+	}
+	if (result) {
+		__sync_fetch_and_add(&mStats.dropped, 1);
 	}
 
 	RETURN(result, int);
 }
 
+/** count the frame(s) that frame source skipped because they would be dropped,
+ * sequence number is consumed so that worker thread can see the gap
+ * @param backpressure frame source skipped them because worker thread was busy */
+/*protected*/
+void IPFrame::skipFrame(const int &num, const bool &backpressure) {
+	__sync_fetch_and_add(&mStats.readback, num);
+	__sync_fetch_and_add(&mStats.dropped, num);
+	if (backpressure) {
+		__sync_fetch_and_add(&mStats.backpressure, num);
+	}
+}
+
+/** count the frame that worker thread finished processing */
+/*protected*/
+void IPFrame::countProcessed() {
+	__sync_fetch_and_add(&mStats.processed, 1);
+}
+
+/** count the frame that skipped stages because it was same as last processed frame */
+/*protected*/
+void IPFrame::countUnchanged() {
+	__sync_fetch_and_add(&mStats.unchanged, 1);
+}
+
+/** get frame counters since #initFrame, this can be called from any thread */
+/*public*/
+void IPFrame::getFrameStats(frame_stats_t &stats) const {
+	frame_stats_t *s = const_cast<frame_stats_t *>(&mStats);
+	stats.readback = __sync_fetch_and_add(&s->readback, 0);
+	stats.enqueued = __sync_fetch_and_add(&s->enqueued, 0);
+	stats.dropped = __sync_fetch_and_add(&s->dropped, 0);
+	stats.processed = __sync_fetch_and_add(&s->processed, 0);
+	stats.steady_allocations = mAllocator.steadyAllocations();
+	stats.backpressure = __sync_fetch_and_add(&s->backpressure, 0);
+	stats.unchanged = __sync_fetch_and_add(&s->unchanged, 0);
+}
+
+/**
+ * set region of interest that frame source reads back, this can be called from any thread
+ * (e.g. from Java or from worker thread to follow tracked target).
+ * frame source applies this to the next frame and reports actual region in frame_info_t.
+ * coordinates are those of the full frame as cv::Mat(same as glReadPixels for GL frame source)
+ * @param width, height zero or negative value means full frame
+ */
+/*public*/
+void IPFrame::setReadRoi(const int &x, const int &y, const int &width, const int &height) {
+	int64_t roi = 0;
+	if ((width > 0) && (height > 0)) {
+		roi = ((int64_t)(std::min(std::max(x, 0), 0xffff)) << 48)
+			| ((int64_t)(std::min(std::max(y, 0), 0xffff)) << 32)
+			| ((int64_t)std::min(width, 0xffff) << 16)
+			| (int64_t)std::min(height, 0xffff);
+	}
+	for ( ; ; ) {
+		const int64_t prev = mReadRoi;
+		if (__sync_bool_compare_and_swap(&mReadRoi, prev, roi)) break;
+	}
+}
+
+/**
+ * get region of interest clipped by current frame size, call this from frame source
+ */
+/*protected*/
+void IPFrame::getReadRoi(int &x, int &y, int &width, int &height) const {
+	const int64_t roi = __sync_fetch_and_add(const_cast<volatile int64_t *>(&mReadRoi), 0);
+	x = (int)((roi >> 48) & 0xffff);
+	y = (int)((roi >> 32) & 0xffff);
+	width = (int)((roi >> 16) & 0xffff);
+	height = (int)(roi & 0xffff);
+	if (!width || !height || (x >= frame_width) || (y >= frame_height)) {
+		x = y = 0;
+		width = frame_width;
+		height = frame_height;
+	} else {
+		width = std::min(width, frame_width - x);
+		height = std::min(height, frame_height - y);
+	}
+}
+
+/**
+ * make cv::Mat header of width x height that shares the beginning of continuous buffer
+ * without allocation, the header keeps reference to the buffer.
+ * only 8 bits depth is supported, buffer should have enough size
+ */
+/*public*/
+cv::Mat IPFrame::continuousView(cv::Mat &buf, const int &width, const int &height, const int &type) {
+	if ((buf.cols == width) && (buf.rows == height) && (buf.type() == type)) {
+		return buf;
+	}
+	const int cn = CV_MAT_CN(type);
+	return buf.reshape(1, 1).colRange(0, width * height * cn).reshape(cn, height);
+}
@@ -24,54 +24,191 @@
 #ifndef FLIGHTDEMO_IPFRAME_H
 #define FLIGHTDEMO_IPFRAME_H
 
-#include <queue>
-#include <vector>
-#include <GLES3/gl3.h>		// API>=18
-#include <GLES3/gl3ext.h>	// API>=18
 #include "opencv2/opencv.hpp"
 
 #include "Mutex.h"
-#include "Condition.h"
+#include "Timers.h"
+#include "IPSpscRing.h"
+#include "IPArenaAllocator.h"
 
-// max number of frames in frame queue
-#define MAX_QUEUED_FRAMES 1
-// max number of frames in frame pool
-#define MAX_POOL_SIZE 2
+// default max number of frames in frame queue
+#define DEFAULT_QUEUED_FRAMES 1
+// default number of spare frames in addition to frame queue,
+// one for frame source and one for worker thread
+#define DEFAULT_POOL_SIZE 2
+#define MIN_POOL_SIZE 2
+// upper limit of frame queue/pool size
+#define MAX_QUEUED_FRAMES 32
+#define MAX_POOL_SIZE 34
+#define MAX_FRAME_SLOTS (MAX_QUEUED_FRAMES + MAX_POOL_SIZE)
+// number of RGBA frames reserved in the arena for buffers of worker thread
+#define ARENA_WORK_FRAMES 4
+// number of processed frames until steady state, after this allocations are counted
+#define STEADY_STATE_FRAMES 30
+
+// what to do when frame queue is full
+// drop the oldest queued frame and append new one(lowest latency)
+#define QUEUE_POLICY_DROP_OLDEST 0
+// drop the new frame and keep queued frames
+#define QUEUE_POLICY_DROP_NEWEST 1
+// block frame source until worker thread takes queued frame or timeout,
+// the new frame is dropped when timeout
+#define QUEUE_POLICY_BLOCK 2
+#define QUEUE_POLICY_MAX 3
+// default timeout for QUEUE_POLICY_BLOCK[ms]
+#define DEFAULT_BLOCK_TIMEOUT_MS 30
+
+typedef struct frame_stats {
+	// number of frames that frame source read back/generated
+	int64_t readback;
+	// number of frames appended to frame queue
+	int64_t enqueued;
+	// number of frames dropped by queue policy,
+	// includes both new frames that were not queued and queued frames that were evicted
+	int64_t dropped;
+	// number of frames that worker thread finished processing
+	int64_t processed;
+	// number of buffer allocations after steady state, should be zero
+	int64_t steady_allocations;
+	// number of frames that frame source did not read back because worker thread was busy,
+	// these are also counted as dropped
+	int64_t backpressure;
+	// number of frames that were same as last processed frame and skipped stages,
+	// these are also counted as processed
+	int64_t unchanged;
+} frame_stats_t;
+
+/**
+ * metadata that travels with each frame from frame source to worker thread
+ */
+typedef struct frame_info {
+	// sequence number of the frame since #initFrame, gaps mean dropped frames
+	int64_t seq;
+	// time when the frame was captured or readback was requested[ns, SYSTEM_TIME_MONOTONIC]
+	nsecs_t capture_time_ns;
+	// time when the frame was queued[ns, SYSTEM_TIME_MONOTONIC]
+	nsecs_t queued_time_ns;
+	// timestamp passed from frame source(e.g. SurfaceTexture#getTimestamp)[ns], zero if not available
+	int64_t source_timestamp_ns;
+	// total number of frames dropped before this frame was queued
+	int64_t dropped;
+	// region of the full frame that this frame contains, the frame is roi_width x roi_height.
+	// add roi_x/roi_y to coordinates in the frame to map them back to the full frame
+	int roi_x, roi_y, roi_width, roi_height;
+} frame_info_t;
+
+// index of frame info in the array passed to Java
+#define FRAME_INFO_IX_SEQ 0
+#define FRAME_INFO_IX_CAPTURE_TIME 1
+#define FRAME_INFO_IX_QUEUED_TIME 2
+#define FRAME_INFO_IX_SOURCE_TIMESTAMP 3
+#define FRAME_INFO_IX_DROPPED 4
+#define FRAME_INFO_IX_DEQUEUED_TIME 5
+#define FRAME_INFO_IX_RESULT_TIME 6
+#define FRAME_INFO_IX_ROI_X 7
+#define FRAME_INFO_IX_ROI_Y 8
+#define FRAME_INFO_IX_ROI_WIDTH 9
+#define FRAME_INFO_IX_ROI_HEIGHT 10
+#define FRAME_INFO_IX_RESULT_FORMAT 11
+#define FRAME_INFO_NUM 12
+
+// index of frame counters in the array passed to Java
+#define FRAME_STATS_IX_READBACK 0
+#define FRAME_STATS_IX_ENQUEUED 1
+#define FRAME_STATS_IX_DROPPED 2
+#define FRAME_STATS_IX_PROCESSED 3
+#define FRAME_STATS_IX_STEADY_ALLOCATIONS 4
+#define FRAME_STATS_IX_BACKPRESSURE 5
+#define FRAME_STATS_IX_UNCHANGED 6
+#define FRAME_STATS_NUM 7
 
 using namespace android;
 
+class IPFrameSource;
+
+/**
+ * frame queue and frame pool between frame source and worker thread,
+ * this class does not depend on OpenGL|ES.
+ * frames are kept in fixed number of slots and only slot indices are passed
+ * through lock-free rings, so no lock is taken and nothing is allocated per frame.
+ * frame source(producer) and worker thread(consumer) should be single thread each.
+ */
 class IPFrame {
+friend class IPFrameSource;
 private:
-	mutable Mutex mPboMutex;
+	// guard for #initFrame/#releaseFrame, never used on the hot path
 	mutable Mutex mFrameMutex;
-	mutable Mutex mPoolMutex;
-	Condition mFrameSync;
-	// frame pool
-	std::vector<cv::Mat> mPool;
-	// frame queue
-	std::queue<cv::Mat> mFrames;
-	long last_queued_time_ms;
-	// PBO name for asynchronous call of glReadPixels
-	GLuint pbo[2];
-	int pbo_ix;
-	int pbo_width, pbo_height;
-	volatile GLsizeiptr pbo_size;
+	int mMaxQueuedFrames;
+	int mQueuePolicy;
+	nsecs_t mBlockTimeoutNs;
+	frame_stats_t mStats;
+	// allocator for frames and buffers of worker thread, this should be destroyed after mSlots
+	IPArenaAllocator mAllocator;
+	// frame queue, index of mSlots from frame source to worker thread
+	IPSpscRing mFrames;
+	// index of mSlots that worker thread finished, returned to frame source
+	IPSpscRing mFreeSlots;
+	// full frame size buffers allocated from the arena for each slot
+	cv::Mat mBuffers[MAX_FRAME_SLOTS];
+	// frames as queued(view of mBuffers or memory owned by frame source) and their metadata,
+	// only the side that holds the index can access them
+	cv::Mat mSlots[MAX_FRAME_SLOTS];
+	frame_info_t mInfo[MAX_FRAME_SLOTS];
+	int mNumSlots;
+	// accessed only from frame source
+	int mProducerSlot;
+	int mSpareSlots[MAX_FRAME_SLOTS];
+	int mNumSpareSlots;
+	// accessed only from worker thread
+	int mConsumerSlot;
+	int frame_width, frame_height;
+	// region of interest to read back, packed into 16 bits each(x, y, width, height)
+	// so that it can be published/read atomically, zero means full frame
+	volatile int64_t mReadRoi;
+	// whether or not #getFrame can wait for frames
+	volatile bool mIsFrameActive;
+	// current frame source, frames owned by it are returned to it on #recycle
+	IPFrameSource *mFrameSource;
+
+	int obtainSlot();
+	void releaseSlot(const int &slot, const bool &discard);
 protected:
 	IPFrame();
 	virtual ~IPFrame();
-	void initFrame(const int &width, const int &height);
+	void initFrame(const int &width, const int &height, IPFrameSource *source,
+		const int &queue_size = DEFAULT_QUEUED_FRAMES, const int &pool_size = DEFAULT_POOL_SIZE,
+		const int &policy = QUEUE_POLICY_DROP_OLDEST, const int &timeout_ms = DEFAULT_BLOCK_TIMEOUT_MS,
+		const int &arena_flags = 0);
+	void abortFrame();
 	void releaseFrame();
+	/** called on the thread of frame source after new frame was queued */
+	virtual void onFrameQueued() {};
 
-	cv::Mat getFrame(long &last_queued_ms);
-	cv::Mat obtainFromPool(const int &width, const int &height);
+	cv::Mat getFrame(frame_info_t &info, const bool &wait = true);
+	cv::Mat obtainFromPool(const int &width, const int &height, const int &type = CV_8UC4);
 	void recycle(cv::Mat &frame);
-	inline const bool canAddFrame() { Mutex::Autolock lock(mFrameMutex);  return mFrames.size() < MAX_QUEUED_FRAMES; };
-	int addFrame(cv::Mat &frame);
+	const bool canAddFrame();
+	int addFrame(cv::Mat &frame,
+		const nsecs_t &capture_time_ns = 0, const int64_t &source_timestamp_ns = 0,
+		const int &roi_x = 0, const int &roi_y = 0);
+	void skipFrame(const int &num = 1, const bool &backpressure = false);
+	void countProcessed();
+	void countUnchanged();
 	void clearFrames();
+	void getReadRoi(int &x, int &y, int &width, int &height) const;
+	inline const int queueSize() const { return mMaxQueuedFrames; };
+	/** allocator that worker thread should use for its buffers */
+	inline cv::MatAllocator *frameAllocator() { return &mAllocator; };
+	inline void setSteadyState(const bool &steady) { mAllocator.setSteadyState(steady); };
+	inline const int queuedFrames() const { return mFrames.size(); };
+	/** whether or not frame queue is full, i.e. worker thread has not taken queued frame(s) yet */
+	inline const bool isQueueFull() const { return mFrames.size() >= mMaxQueuedFrames; };
 
-	inline const int width() const { return pbo_width; };
-	inline const int height() const { return pbo_height; };
+	inline const int width() const { return frame_width; };
+	inline const int height() const { return frame_height; };
 public:
-	int handleFrame(const int &, const int &, const int &);
+	void getFrameStats(frame_stats_t &stats) const;
+	void setReadRoi(const int &x, const int &y, const int &width, const int &height);
+	static cv::Mat continuousView(cv::Mat &buf, const int &width, const int &height, const int &type);
 };
 #endif //FLIGHTDEMO_IPFRAME_H
@@ -0,0 +1,105 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+
+
+#if 1	// set 0 to enable debug output, otherwise set 1
+	#ifndef LOG_NDEBUG
+		#define	LOG_NDEBUG		// disable LOGV/LOGD/MARK
+	#endif
+	#undef USE_LOGALL			// enable specific LOGx only
+#else
+//	#define USE_LOGALL
+	#define USE_LOGD
+	#undef LOG_NDEBUG
+	#undef NDEBUG
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "utilbase.h"
+
+#include "IPFrameHash.h"
+
+void frame_hash(const cv::Mat &frame, uint8_t *hash) {
+	const int cn = frame.channels();
+	// green of RGBA
+	const int offset = cn >= 3 ? 1 : 0;
+	for (int by = 0; by < FRAME_HASH_ROWS; by++) {
+		const int y0 = by * frame.rows / FRAME_HASH_ROWS;
+		const int y1 = (by + 1) * frame.rows / FRAME_HASH_ROWS;
+		for (int bx = 0; bx < FRAME_HASH_COLS; bx++) {
+			const int x0 = bx * frame.cols / FRAME_HASH_COLS;
+			const int x1 = (bx + 1) * frame.cols / FRAME_HASH_COLS;
+			uint32_t sum = 0, n = 0;
+			for (int y = y0; y < y1; y += 2) {
+				const uint8_t *p = frame.ptr<uint8_t>(y) + offset;
+				for (int x = x0; x < x1; x += 2) {
+					sum += p[x * cn];
+				}
+				n += (x1 - x0 + 1) / 2;
+			}
+			hash[by * FRAME_HASH_COLS + bx] = n ? (uint8_t)((sum + n / 2) / n) : 0;
+		}
+	}
+}
+
+int frame_hash_diff(const uint8_t *a, const uint8_t *b) {
+	int result = 0;
+	for (int i = 0; i < FRAME_HASH_SIZE; i++) {
+		const int d = abs((int)a[i] - (int)b[i]);
+		if (d > result) {
+			result = d;
+		}
+	}
+	return result;
+}
+
+void frame_hash_reset(frame_hash_state_t &state) {
+	state.roi = cv::Rect();
+	state.valid = false;
+	state.unchanged_frames = 0;
+}
+
+bool frame_hash_unchanged(frame_hash_state_t &state,
+	const cv::Mat &frame, const cv::Rect &roi, const int &threshold) {
+
+	if (threshold <= 0) {
+		state.valid = false;
+		return false;
+	}
+	uint8_t hash[FRAME_HASH_SIZE];
+	frame_hash(frame, hash);
+	if (state.valid && (roi == state.roi) && (state.unchanged_frames < MAX_UNCHANGED_FRAMES)
+		&& (frame_hash_diff(hash, state.hash) < threshold)) {
+
+		state.unchanged_frames++;
+		return true;
+	}
+	memcpy(state.hash, hash, sizeof(state.hash));
+	state.roi = roi;
+	state.valid = true;
+	state.unchanged_frames = 0;
+	return false;
+}
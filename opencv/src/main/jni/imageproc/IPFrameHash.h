@@ -0,0 +1,82 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+
+#ifndef FLIGHTDEMO_IPFRAMEHASH_H
+#define FLIGHTDEMO_IPFRAMEHASH_H
+
+#include <stdint.h>
+
+#include "opencv2/core.hpp"
+
+// frame is divided into FRAME_HASH_COLS x FRAME_HASH_ROWS blocks
+#define FRAME_HASH_COLS 32
+#define FRAME_HASH_ROWS 24
+#define FRAME_HASH_SIZE (FRAME_HASH_COLS * FRAME_HASH_ROWS)
+// frames whose difference from last processed frame is less than this are regarded as unchanged,
+// 0 disables the check
+#define DEFAULT_UNCHANGED_THRESHOLD 0
+#define MAX_UNCHANGED_THRESHOLD 255
+// max number of consecutive unchanged frames, then the frame is processed anyway
+// so that changes of settings and slow drift of the scene are applied
+#define MAX_UNCHANGED_FRAMES 30
+
+/**
+ * hash of the frame as mean luminance of each block, pixels are sampled every 2 pixels
+ * in both directions so this reads only a quarter of the frame.
+ * green is used as luminance of RGBA frame.
+ * small object that moves inside one block(20x20px for 640x480) does not change the hash.
+ * @param frame gray scale or RGBA frame(or region of interest of it)
+ * @param hash FRAME_HASH_SIZE bytes
+ */
+void frame_hash(const cv::Mat &frame, uint8_t *hash);
+
+/**
+ * difference of two frames as maximum difference of the mean luminance of the blocks,
+ * this does not miss small change that the sum of the differences averages out
+ * @return [0, 255]
+ */
+int frame_hash_diff(const uint8_t *a, const uint8_t *b);
+
+/** hash of last processed frame and number of unchanged frames since then */
+typedef struct frame_hash_state {
+	uint8_t hash[FRAME_HASH_SIZE];
+	cv::Rect roi;
+	bool valid;
+	int unchanged_frames;
+} frame_hash_state_t;
+
+/** forget last processed frame, next frame is always processed */
+void frame_hash_reset(frame_hash_state_t &state);
+
+/**
+ * whether or not the frame is same as last processed frame.
+ * hash of the frame is kept as last processed frame when it changed(or region of interest changed),
+ * frame is regarded as changed after MAX_UNCHANGED_FRAMES consecutive unchanged frames
+ * @param roi region of interest of the frame, frame of other region is always changed
+ * @param threshold see #frame_hash_diff, 0 disables the check
+ */
+bool frame_hash_unchanged(frame_hash_state_t &state,
+	const cv::Mat &frame, const cv::Rect &roi, const int &threshold);
+
+#endif //FLIGHTDEMO_IPFRAMEHASH_H
@@ -0,0 +1,287 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+#if 1	// set 0 to enable debug output, otherwise set 1
+	#ifndef LOG_NDEBUG
+		#define	LOG_NDEBUG		// disable LOGV/LOGD/MARK
+	#endif
+	#undef USE_LOGALL			// enable specific LOGx only
+#else
+//	#define USE_LOGALL
+	#define USE_LOGD
+	#undef LOG_NDEBUG
+	#undef NDEBUG
+#endif
+
+#include <algorithm>
+
+#include "utilbase.h"
+
+#include "IPFrameSource.h"
+
+/**
+ * @param luma_only frames from YUV/JPEG image are queued as luminance only(CV_8UC1)
+ *                  when worker thread does not need color
+ */
+IPFrameSource::IPFrameSource(IPFrame &frame, const bool &luma_only)
+: mFrame(frame),
+  mWidth(0), mHeight(0),
+  mLumaOnly(luma_only) {
+
+	ENTER();
+
+	EXIT();
+}
+
+IPFrameSource::~IPFrameSource() {
+	ENTER();
+
+	EXIT();
+}
+
+int IPFrameSource::init(const int &width, const int &height) {
+	ENTER();
+
+	mWidth = width;
+	mHeight = height;
+
+	RETURN(0, int);
+}
+
+void IPFrameSource::release() {
+	ENTER();
+
+	mWidth = mHeight = 0;
+	mConverted.release();
+	mDecoded.release();
+
+	EXIT();
+}
+
+bool IPFrameSource::recycle(cv::Mat &frame) {
+	return false;
+}
+
+bool IPFrameSource::discard(cv::Mat &frame) {
+	return false;
+}
+
+const bool IPFrameSource::isBusy() const {
+	return isQueueFull();
+}
+
+/**
+ * map region of interest in processing size into the image of width x height
+ */
+static cv::Rect map_roi(const cv::Rect &roi, const int &frame_width, const int &frame_height,
+	const int &width, const int &height) {
+
+	if ((width == frame_width) && (height == frame_height)) {
+		return roi;
+	}
+	const int x0 = roi.x * width / frame_width;
+	const int y0 = roi.y * height / frame_height;
+	const int x1 = std::max((roi.x + roi.width) * width / frame_width, x0 + 1);
+	const int y1 = std::max((roi.y + roi.height) * height / frame_height, y0 + 1);
+	return cv::Rect(x0, y0, x1 - x0, y1 - y0);
+}
+
+/**
+ * get image size from SOFn marker of JPEG without decoding, return false if not found
+ */
+static bool jpeg_size(const uint8_t *data, const size_t &size, int &width, int &height) {
+	size_t pos = 2;	// skip SOI
+	for ( ; pos + 9 < size ; ) {
+		if (UNLIKELY(data[pos] != 0xff)) return false;
+		const uint8_t marker = data[pos + 1];
+		if ((marker == 0xff) || (marker == 0x01) || ((marker >= 0xd0) && (marker <= 0xd7))) {
+			// fill byte or markers without length
+			pos += marker == 0xff ? 1 : 2;
+			continue;
+		}
+		if ((marker >= 0xc0) && (marker <= 0xcf)
+			&& (marker != 0xc4) && (marker != 0xc8) && (marker != 0xcc)) {
+			// SOFn: length(2), precision(1), height(2), width(2)
+			height = (data[pos + 5] << 8) | data[pos + 6];
+			width = (data[pos + 7] << 8) | data[pos + 8];
+			return (width > 0) && (height > 0);
+		}
+		if (marker == 0xda) return false;	// SOS before SOF
+		pos += 2 + ((data[pos + 2] << 8) | data[pos + 3]);
+	}
+	return false;
+}
+
+/**
+ * flags for cv::imdecode to decode JPEG of width x height with scaled IDCT(1/2, 1/4, 1/8)
+ * so that decoded image is smallest one that is not smaller than processing size
+ */
+static int jpeg_decode_flags(const int &width, const int &height,
+	const int &frame_width, const int &frame_height, const bool &luma) {
+
+	int scale = 1;
+	for ( ; (scale < 8)
+		&& (width / (scale * 2) >= frame_width) && (height / (scale * 2) >= frame_height) ; ) {
+		scale *= 2;
+	}
+	switch (scale) {
+	case 2: return luma ? cv::IMREAD_REDUCED_GRAYSCALE_2 : cv::IMREAD_REDUCED_COLOR_2;
+	case 4: return luma ? cv::IMREAD_REDUCED_GRAYSCALE_4 : cv::IMREAD_REDUCED_COLOR_4;
+	case 8: return luma ? cv::IMREAD_REDUCED_GRAYSCALE_8 : cv::IMREAD_REDUCED_COLOR_8;
+	default: return luma ? cv::IMREAD_GRAYSCALE : cv::IMREAD_COLOR;
+	}
+}
+
+/**
+ * convert raw image into frame and append it to frame queue,
+ * only region of interest is converted and it is resized if the image size is
+ * different from processing size. RGBA image and Y plane of NV21 are copied without conversion,
+ * if #mLumaOnly is true, YUV/JPEG image is queued as luminance(CV_8UC1) without color conversion.
+ * JPEG image is decoded directly to the scale nearest to processing size with scaled IDCT.
+ * call this only from the thread that provides frames.
+ * @param data pointer to image
+ * @param size size of buffer[bytes]
+ * @param width width of the image, ignored for PIXEL_FORMAT_MJPEG
+ * @param height height of the image, ignored for PIXEL_FORMAT_MJPEG
+ * @param stride row stride of the image(Y plane for NV21)[bytes], 0 means packed
+ * @param format one of PIXEL_FORMAT_XXX
+ * @param capture_time_ns
+ * @param source_timestamp_ns
+ * return 1 if the frame was dropped, negative value on error
+ */
+/*protected*/
+int IPFrameSource::ingestBuffer(const uint8_t *data, const size_t &size,
+	const int &width, const int &height, const int &stride, const int &format,
+	const nsecs_t &capture_time_ns, const int64_t &source_timestamp_ns) {
+
+	ENTER();
+
+	size_t step = 0, required = 0;
+	switch (format) {
+	case PIXEL_FORMAT_RGBA:
+		step = stride > 0 ? stride : width * 4;
+		required = step * (height - 1) + width * 4;
+		break;
+	case PIXEL_FORMAT_YUYV:
+		step = stride > 0 ? stride : width * 2;
+		required = step * (height - 1) + width * 2;
+		break;
+	case PIXEL_FORMAT_NV21:
+		step = stride > 0 ? stride : width;
+		required = step * (height * 3 / 2 - 1) + width;
+		break;
+	case PIXEL_FORMAT_MJPEG:
+		required = 1;
+		break;
+	default:
+		LOGW("unsupported pixel format:%d", format);
+		RETURN(-1, int);
+	}
+	// image size of JPEG is taken from the image itself
+	const bool has_size = (format == PIXEL_FORMAT_MJPEG) || ((width > 0) && (height > 0));
+	if (UNLIKELY(!data || !mWidth || !has_size || (size < required))) {
+		RETURN(-1, int);
+	}
+	if (UNLIKELY(!canAddFrame())) {
+		// frame queue is full and new frame will be dropped, skip conversion
+		skipFrame();
+		RETURN(1, int);	// dropped
+	}
+	const bool luma = mLumaOnly && (format != PIXEL_FORMAT_RGBA);
+	int roi_x, roi_y, roi_width, roi_height;
+	getReadRoi(roi_x, roi_y, roi_width, roi_height);
+	const cv::Rect roi(roi_x, roi_y, roi_width, roi_height);
+	// re-use cv::Mat
+	cv::Mat frame = obtainFromPool(roi_width, roi_height, luma ? CV_8UC1 : CV_8UC4);
+	// region of interest of the image, converted into RGBA or luminance
+	cv::Mat src;
+	bool converted = false;
+	switch (format) {
+	case PIXEL_FORMAT_RGBA:
+		src = cv::Mat(height, width, CV_8UC4, (void *)data, step)(
+			map_roi(roi, mWidth, mHeight, width, height));
+		break;
+	case PIXEL_FORMAT_YUYV:
+	{
+		cv::Rect rect = map_roi(roi, mWidth, mHeight, width, height);
+		if (!luma) {
+			// chroma is shared by 2 pixels
+			rect.x &= ~1;
+			rect.width = std::min((rect.width + 1) & ~1, width - rect.x) & ~1;
+		}
+		const cv::Mat yuyv = cv::Mat(height, width, CV_8UC2, (void *)data, step)(rect);
+		// convert directly into the frame if its size matches
+		converted = rect.size() == frame.size();
+		cv::Mat &dst = converted ? frame : mConverted;
+		if (luma) {
+			cv::extractChannel(yuyv, dst, 0);
+		} else {
+			cv::cvtColor(yuyv, dst, cv::COLOR_YUV2RGBA_YUY2);
+		}
+		src = dst;
+		break;
+	}
+	case PIXEL_FORMAT_NV21:
+		if (luma) {
+			// Y plane is luminance itself
+			src = cv::Mat(height, width, CV_8UC1, (void *)data, step)(
+				map_roi(roi, mWidth, mHeight, width, height));
+		} else {
+			cv::cvtColor(cv::Mat(height * 3 / 2, width, CV_8UC1, (void *)data, step),
+				mConverted, cv::COLOR_YUV2RGBA_NV21);
+			src = mConverted(map_roi(roi, mWidth, mHeight, width, height));
+		}
+		break;
+	case PIXEL_FORMAT_MJPEG:
+	{
+		// libjpeg skips color conversion when only luminance is required
+		// and skips IDCT of high frequency components when the image is scaled down
+		int jpeg_width, jpeg_height;
+		const int flags = jpeg_size(data, size, jpeg_width, jpeg_height)
+			? jpeg_decode_flags(jpeg_width, jpeg_height, mWidth, mHeight, luma)
+			: (luma ? cv::IMREAD_GRAYSCALE : cv::IMREAD_COLOR);
+		cv::imdecode(cv::Mat(1, (int)size, CV_8UC1, (void *)data), flags, &mDecoded);
+		if (UNLIKELY(mDecoded.empty())) {
+			LOGW("failed to decode jpeg");
+			RETURN(-1, int);
+		}
+		if (luma) {
+			src = mDecoded(map_roi(roi, mWidth, mHeight, mDecoded.cols, mDecoded.rows));
+		} else {
+			cv::cvtColor(mDecoded, mConverted, cv::COLOR_BGR2RGBA);
+			src = mConverted(map_roi(roi, mWidth, mHeight, mConverted.cols, mConverted.rows));
+		}
+		break;
+	}
+	}
+	if (!converted) {
+		if (src.size() == frame.size()) {
+			src.copyTo(frame);
+		} else {
+			cv::resize(src, frame, frame.size(), 0, 0, cv::INTER_AREA);
+		}
+	}
+	const int result = addFrame(frame, capture_time_ns, source_timestamp_ns, roi_x, roi_y) > 0 ? 1 : 0;
+
+	RETURN(result, int);
+}
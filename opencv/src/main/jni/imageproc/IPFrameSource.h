@@ -0,0 +1,128 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+#ifndef FLIGHTDEMO_IPFRAMESOURCE_H
+#define FLIGHTDEMO_IPFRAMESOURCE_H
+
+#include "opencv2/opencv.hpp"
+
+#include "Timers.h"
+#include "IPFrame.h"
+
+// read back images from frame buffer of OpenGL|ES via PBO
+#define FRAME_SOURCE_GL 0
+// raw image buffer pushed from Java
+#define FRAME_SOURCE_MEMORY 1
+// image file(s) or synthetic pattern generated on its own thread, no GL/Java required
+#define FRAME_SOURCE_SYNTHETIC 2
+// MJPEG frame pushed from Java and decoded on its own thread
+#define FRAME_SOURCE_MJPEG 3
+#define FRAME_SOURCE_MAX 4
+
+// pixel format of raw image buffer passed to FRAME_SOURCE_MEMORY
+// RGBA, 4 bytes per pixel
+#define PIXEL_FORMAT_RGBA 0
+// packed YUV 4:2:2(Y0 U Y1 V), 2 bytes per pixel, e.g. raw frame of UVC camera
+#define PIXEL_FORMAT_YUYV 1
+// Y plane followed by interleaved V/U plane(4:2:0), e.g. preview frame of Android camera
+#define PIXEL_FORMAT_NV21 2
+// one JPEG image per buffer, e.g. MJPEG frame of UVC camera
+#define PIXEL_FORMAT_MJPEG 3
+#define PIXEL_FORMAT_MAX 4
+
+#ifndef DEFAULT_PBO_NUM
+// default number of PBOs for FRAME_SOURCE_GL
+#define DEFAULT_PBO_NUM 3
+#endif
+
+/**
+ * abstract class to provide frames into frame queue of IPFrame.
+ * each implementation decides how/when frames are generated,
+ * IPFrame does not depend on any specific frame source.
+ */
+class IPFrameSource {
+private:
+	IPFrame &mFrame;
+	// work buffers for #ingestBuffer
+	cv::Mat mConverted, mDecoded;
+protected:
+	int mWidth, mHeight;
+	// queue only luminance(CV_8UC1) of YUV/JPEG image instead of converting it to RGBA
+	const bool mLumaOnly;
+
+	IPFrameSource(IPFrame &frame, const bool &luma_only = false);
+
+	int ingestBuffer(const uint8_t *data, const size_t &size,
+		const int &width, const int &height, const int &stride, const int &format,
+		const nsecs_t &capture_time_ns, const int64_t &source_timestamp_ns);
+
+	// helper methods to access frame pool/queue of IPFrame
+	inline cv::Mat obtainFromPool(const int &width, const int &height, const int &type = CV_8UC4) {
+		return mFrame.obtainFromPool(width, height, type); };
+	inline const bool canAddFrame() { return mFrame.canAddFrame(); };
+	inline int addFrame(cv::Mat &frame,
+		const nsecs_t &capture_time_ns = 0, const int64_t &source_timestamp_ns = 0,
+		const int &roi_x = 0, const int &roi_y = 0) {
+		return mFrame.addFrame(frame, capture_time_ns, source_timestamp_ns, roi_x, roi_y); };
+	/** region of interest that should be read back for next frame, full frame if not set */
+	inline void getReadRoi(int &x, int &y, int &width, int &height) const {
+		mFrame.getReadRoi(x, y, width, height); };
+	inline void skipFrame(const int &num = 1, const bool &backpressure = false) {
+		mFrame.skipFrame(num, backpressure); };
+	inline const bool isQueueFull() const { return mFrame.isQueueFull(); };
+	inline const int queueSize() const { return mFrame.queueSize(); };
+	inline const int queuedFrames() const { return mFrame.queuedFrames(); };
+public:
+	virtual ~IPFrameSource();
+	/**
+	 * prepare frame source, called from ImageProcessor#start.
+	 * GL frame source expects this is called on GL thread.
+	 */
+	virtual int init(const int &width, const int &height);
+	/**
+	 * release all resources, called from ImageProcessor#stop after worker thread terminated.
+	 * GL frame source expects this is called on GL thread.
+	 */
+	virtual void release();
+	/**
+	 * called on worker thread when the frame is recycled,
+	 * return true if the frame is owned by this frame source and was returned to it,
+	 * otherwise the frame is returned to frame pool.
+	 */
+	virtual bool recycle(cv::Mat &frame);
+	/**
+	 * called on the thread that provides frames when queued or new frame is dropped,
+	 * return true if the frame is owned by this frame source and was returned to it.
+	 */
+	virtual bool discard(cv::Mat &frame);
+	/**
+	 * whether or not worker thread is busy and new frame should not be acquired now,
+	 * caller can use this to skip preparing the frame(e.g. rendering for readback)
+	 */
+	virtual const bool isBusy() const;
+
+	inline const int width() const { return mWidth; };
+	inline const int height() const { return mHeight; };
+};
+
+#endif //FLIGHTDEMO_IPFRAMESOURCE_H
@@ -0,0 +1,259 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+#if 1	// set 0 to enable debug output, otherwise set 1
+	#ifndef LOG_NDEBUG
+		#define	LOG_NDEBUG		// disable LOGV/LOGD/MARK
+	#endif
+	#undef USE_LOGALL			// enable specific LOGx only
+#else
+//	#define USE_LOGALL
+	#define USE_LOGD
+	#undef LOG_NDEBUG
+	#undef NDEBUG
+#endif
+
+#include <algorithm>
+
+#include "utilbase.h"
+
+#include "IPGLFrameSource.h"
+
+#define USE_PBO 1
+
+/**
+ * @param pbo_num number of PBOs in the ring, more PBOs add latency but
+ *                reduce chance of skipping frames on slow GPU
+ * @param use_lease if true, worker thread receives cv::Mat that wraps mapped PBO
+ *                and PBO is returned to the ring when the frame is recycled.
+ *                This saves one full frame copy on GL thread.
+ */
+IPGLFrameSource::IPGLFrameSource(IPFrame &frame,
+	const int &pbo_num, const bool &use_lease)
+: IPFrameSource(frame),
+  mPboNum(pbo_num),
+  mUseLease(use_lease),
+  pbo_size(0) {
+
+	ENTER();
+
+	EXIT();
+}
+
+IPGLFrameSource::~IPGLFrameSource() {
+	ENTER();
+
+	EXIT();
+}
+
+/**
+ * prepare for readback, this should be called on GL thread
+ * @param width
+ * @param height
+ */
+int IPGLFrameSource::init(const int &width, const int &height) {
+	ENTER();
+
+	IPFrameSource::init(width, height);
+#if USE_PBO
+	// in lease mode, queued frame(s) and the frame on worker thread keep PBO mapped,
+	// so at least one more PBO is required for readback
+	const int num = mUseLease ? std::max(mPboNum, queueSize() + 2) : mPboNum;
+	// prepare PBOs for glReadPixels
+	mPboRing.init(width, height, num);
+	mReturnedLeases.init(MAX_PBO_NUM);
+#endif
+	pbo_size = (GLsizeiptr)width * height * 4;
+
+	RETURN(0, int);
+}
+
+/**
+ * release PBOs, this should be called on GL thread
+ * XXX this unmaps PBOs leased to worker thread,
+ *     so worker thread should be terminated before calling this
+ */
+void IPGLFrameSource::release() {
+	ENTER();
+
+	pbo_size = 0;
+#if USE_PBO
+	mPboRing.release();
+	mReturnedLeases.clear();
+#endif
+	IPFrameSource::release();
+
+	EXIT();
+}
+
+/**
+ * if the frame wraps leased PBO, return the PBO to the ring.
+ * this is called on worker thread, so this only passes its address to GL thread
+ */
+bool IPGLFrameSource::recycle(cv::Mat &frame) {
+	ENTER();
+
+	bool result = false;
+#if USE_PBO
+	// leased frame wraps mapped PBO and does not own its memory
+	if (mUseLease && LIKELY(!frame.empty() && !frame.u)) {
+		// PBO should be unmapped on GL thread
+		result = mReturnedLeases.push((intptr_t)frame.data);
+		frame.release();
+	}
+#endif
+
+	RET(result);
+}
+
+/**
+ * if the dropped frame wraps leased PBO, unmap it now.
+ * this is called on GL thread
+ */
+bool IPGLFrameSource::discard(cv::Mat &frame) {
+	ENTER();
+
+	bool result = false;
+#if USE_PBO
+	if (mUseLease && LIKELY(!frame.empty() && !frame.u)) {
+		const int slot = mPboRing.find(frame.data);
+		if (slot >= 0) {
+			mPboRing.unmap(slot);
+			frame.release();
+			result = true;
+		}
+	}
+#endif
+
+	RET(result);
+}
+
+/**
+ * worker thread has not taken queued frame(s) yet and newer frame is already in flight,
+ * so new readback would only replace it. call this on GL thread
+ */
+const bool IPGLFrameSource::isBusy() const {
+#if USE_PBO
+	return isQueueFull() && (mPboRing.pending() > 0);
+#else
+	return isQueueFull();
+#endif
+}
+
+/** get image from frame buffer of OpenGL|ES, call this on drawing thread of Java
+ * this never waits for GPU, image is read asynchronously into PBO ring
+ * and queued on later call after its readback has completed.
+ * return 1 if the frame was dropped
+ * @param timestamp_ns timestamp of current frame(SurfaceTexture#getTimestamp),
+ *                     this travels with the frame read back on later call
+ * @param readback false if caller skipped rendering current frame because of #isBusy,
+ *                     completed readbacks are still queued but new readback is not requested.
+ *                     even if this is true, readback is skipped when #isBusy */
+int IPGLFrameSource::handleFrame(const int &, const int &, const int &, const int64_t &timestamp_ns,
+	const bool &readback) {
+
+	ENTER();
+
+	int result = 0;
+	cv::Mat frame;
+	nsecs_t latency_ns = 0;
+	nsecs_t capture_time_ns = 0;
+	int64_t source_timestamp_ns = 0;
+	int roi_x = 0, roi_y = 0, roi_width = mWidth, roi_height = mHeight;
+	if (UNLIKELY(!pbo_size)) {
+		RETURN(1, int);	// dropped
+	}
+#if USE_PBO
+	// unmap PBOs that were returned from worker thread
+	intptr_t returned;
+	for ( ; mReturnedLeases.pop(returned) ; ) {
+		const int slot = mPboRing.find((const void *)returned);
+		if (LIKELY(slot >= 0)) {
+			mPboRing.unmap(slot);
+		}
+	}
+	int discarded = 0, slot = -1;
+	// map the newest PBO whose readback has already completed
+	const uint8_t *read_data = mPboRing.tryMap(latency_ns, discarded, slot);
+	if (UNLIKELY(discarded)) {
+		// these readbacks were superseded by newer one
+		skipFrame(discarded);
+	}
+	if (UNLIKELY(read_data && !canAddFrame())) {
+		// frame queue is full and this frame will be dropped by queue policy, skip copying
+		mPboRing.unmap(slot);
+		skipFrame(1, true);
+	} else if (LIKELY(read_data)) {
+		capture_time_ns = mPboRing.requestTime(slot);
+		source_timestamp_ns = mPboRing.timestamp(slot);
+		// PBO contains only the region that was requested when it was read
+		mPboRing.getRect(slot, roi_x, roi_y, roi_width, roi_height);
+		if (mUseLease) {
+			// lend mapped PBO to worker thread without copying,
+			// it will be unmapped after it is returned via #recycle
+			frame = cv::Mat(roi_height, roi_width, CV_8UC4, (void *)read_data);
+		} else {
+			// re-use cv::Mat
+			frame = obtainFromPool(roi_width, roi_height);
+			// copy PBO into memory
+			memcpy(frame.data, read_data, (size_t)roi_width * roi_height * 4);
+			mPboRing.unmap(slot);
+		}
+	}
+	LOGV_IF(discarded, "discarded %d readback(s)", discarded);
+	// backpressure, worker thread is still processing and queue is full,
+	// skip readback of current frame to save GPU bandwidth
+	if (!readback || isBusy()) {
+		skipFrame(1, true);
+		result = 1;
+	} else {
+		// request asynchronously read region of interest of current frame buffer into free PBO,
+		// so cost of readback and copying scales with the region
+		int x, y, width, height;
+		getReadRoi(x, y, width, height);
+		if (UNLIKELY(mPboRing.requestRead(timestamp_ns, x, y, width, height))) {
+			// all PBOs are still in flight, skip this frame
+			// and count it so that its sequence number is consumed as well as other skips
+			skipFrame(1);
+			result = 1;
+		}
+	}
+#else
+	if (!readback || isBusy()) {
+		// backpressure, skip readback and copy of current frame
+		skipFrame(1, true);
+		RETURN(1, int);
+	}
+	getReadRoi(roi_x, roi_y, roi_width, roi_height);
+	// re-use cv::Mat
+	frame = obtainFromPool(roi_width, roi_height);
+	glReadPixels(roi_x, roi_y, roi_width, roi_height, GL_RGBA, GL_UNSIGNED_BYTE, frame.data);
+#endif
+
+	if (!frame.empty()) {
+		// queue policy decides whether this frame or queued one is dropped
+		addFrame(frame, capture_time_ns, source_timestamp_ns, roi_x, roi_y);
+	}
+
+	RETURN(result, int);
+}
@@ -0,0 +1,63 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+#ifndef FLIGHTDEMO_IPGLFRAMESOURCE_H
+#define FLIGHTDEMO_IPGLFRAMESOURCE_H
+
+#include <GLES3/gl3.h>		// API>=18
+#include <GLES3/gl3ext.h>	// API>=18
+
+#include "IPSpscRing.h"
+#include "IPPboRing.h"
+#include "IPFrameSource.h"
+
+/**
+ * frame source that reads back images from frame buffer of OpenGL|ES
+ * asynchronously using ring of fenced PBOs.
+ * all methods except #recycle should be called on GL thread.
+ */
+class IPGLFrameSource : public IPFrameSource {
+private:
+	// ring of fenced PBOs for asynchronous call of glReadPixels
+	IPPboRing mPboRing;
+	const int mPboNum;
+	// lend mapped PBOs to worker thread instead of copying them into pooled cv::Mat
+	const bool mUseLease;
+	// address of leased PBOs that were returned from worker thread
+	// and should be unmapped on GL thread
+	IPSpscRing mReturnedLeases;
+	volatile GLsizeiptr pbo_size;
+public:
+	IPGLFrameSource(IPFrame &frame,
+		const int &pbo_num = DEFAULT_PBO_NUM, const bool &use_lease = false);
+	virtual ~IPGLFrameSource();
+	virtual int init(const int &width, const int &height);
+	virtual void release();
+	virtual bool recycle(cv::Mat &frame);
+	virtual bool discard(cv::Mat &frame);
+	virtual const bool isBusy() const;
+	int handleFrame(const int &, const int &, const int &, const int64_t &timestamp_ns = 0,
+		const bool &readback = true);
+};
+
+#endif //FLIGHTDEMO_IPGLFRAMESOURCE_H
@@ -0,0 +1,233 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+
+
+#if 1	// set 0 to enable debug output, otherwise set 1
+	#ifndef LOG_NDEBUG
+		#define	LOG_NDEBUG		// disable LOGV/LOGD/MARK
+	#endif
+	#undef USE_LOGALL			// enable specific LOGx only
+#else
+//	#define USE_LOGALL
+	#define USE_LOGD
+	#undef LOG_NDEBUG
+	#undef NDEBUG
+#endif
+
+#include <algorithm>
+
+#include "utilbase.h"
+
+#include "opencv2/video/tracking.hpp"
+
+#include "IPKltTracker.h"
+
+// same as cv::TermCriteria::COUNT | cv::TermCriteria::EPS, EPS is a macro of IPBase.h
+#define KLT_TERM_TYPE (CV_TERMCRIT_ITER | CV_TERMCRIT_EPS)
+
+IPKltTracker::IPKltTracker()
+:	IPStage("klt"),
+	mSeedCooldown(0),
+	mSeedCount(0),
+	mBackoffCount(0) {
+
+	ENTER();
+
+	mPrevPoints.reserve(KLT_MAX_FEATURES);
+	mPoints.reserve(KLT_MAX_FEATURES);
+	mSeeds.reserve(KLT_MAX_FEATURES);
+	mWork.reserve(KLT_MAX_FEATURES);
+
+	EXIT();
+}
+
+IPKltTracker::~IPKltTracker() {
+	ENTER();
+
+	EXIT();
+}
+
+/*public*/
+void IPKltTracker::reset() {
+	ENTER();
+
+	mGray.release();
+	mPrevRoi = cv::Rect();
+	mPrevPyramid.clear();
+	mPyramid.clear();
+	mPrevPoints.clear();
+	mPoints.clear();
+	mMask.release();
+	mSeedCooldown = 0;
+	mSeedCount = 0;
+	mBackoffCount = 0;
+
+	EXIT();
+}
+
+/**
+ * seeding features is counted as full detection,
+ * and the seeding that could not find enough features and started back-off as fallback
+ */
+/*public*/
+void IPKltTracker::getDetectStats(int64_t &detect_count, int64_t &fallback_count) const {
+	detect_count = mSeedCount;
+	fallback_count = mBackoffCount;
+}
+
+/*public*/
+int IPKltTracker::process(stage_context_t &ctx, const cv::Mat &src, cv::Mat &dst) {
+	ENTER();
+
+	dst = src;
+	const cv::Mat *gray = &src;
+	if (src.channels() != 1) {
+		cv::cvtColor(src, mGray, cv::COLOR_RGBA2GRAY);
+		gray = &mGray;
+	}
+	if (UNLIKELY(ctx.roi != mPrevRoi)) {
+		// coordinates of the features and previous pyramid are not valid anymore
+		mPrevRoi = ctx.roi;
+		mPrevPyramid.clear();
+		mPrevPoints.clear();
+		mSeedCooldown = 0;
+	}
+	// src may be a view of the buffer that is overwritten by next frame,
+	// so the pyramid never refers it(tryReuseInputImage = false).
+	// buffers of the pyramid are reused while the size is same
+	cv::buildOpticalFlowPyramid(*gray, mPyramid, cv::Size(KLT_WIN_SIZE, KLT_WIN_SIZE), KLT_MAX_LEVEL,
+		true, cv::BORDER_REFLECT_101, cv::BORDER_CONSTANT, false);
+
+	cv::Point2f motion;
+	const int tracked = track(motion);
+	ctx.results[RESULT_IX_FLOW_DX] = motion.x;
+	ctx.results[RESULT_IX_FLOW_DY] = motion.y;
+	ctx.results[RESULT_IX_FLOW_TRACKS] = (float)tracked;
+	if (draws_overlay(ctx)) {
+		drawTracks(ctx, motion);
+	}
+
+	// current frame becomes previous frame
+	std::swap(mPrevPyramid, mPyramid);
+	std::swap(mPrevPoints, mPoints);
+	if (mSeedCooldown > 0) {
+		mSeedCooldown--;
+	} else if ((int)mPrevPoints.size() < KLT_MIN_FEATURES) {
+		seed(*gray);
+		if ((int)mPrevPoints.size() < KLT_MIN_FEATURES) {
+			// scene does not have enough texture, seeding again on next frame would find same features
+			LOGV("too few features:%d, back off seeding", (int)mPrevPoints.size());
+			mSeedCooldown = KLT_SEED_COOLDOWN;
+			mBackoffCount++;
+		}
+	}
+
+	RETURN(0, int);
+}
+
+/**
+ * track features of previous frame into current frame,
+ * features that failed are removed from mPoints(and mPrevPoints for #drawTracks)
+ * @param motion median of the motion of tracked features[px]
+ * @return number of the features whose motion is close to the median
+ */
+/*private*/
+int IPKltTracker::track(cv::Point2f &motion) {
+	motion = cv::Point2f();
+	mPoints.clear();
+	if (mPrevPoints.empty() || mPrevPyramid.empty()) {
+		return 0;
+	}
+	cv::calcOpticalFlowPyrLK(mPrevPyramid, mPyramid, mPrevPoints, mPoints, mStatus, mError,
+		cv::Size(KLT_WIN_SIZE, KLT_WIN_SIZE), KLT_MAX_LEVEL,
+		cv::TermCriteria(KLT_TERM_TYPE, 20, 0.03));
+	// remove lost features in place
+	int n = 0;
+	const int num = (int)mPoints.size();
+	for (int i = 0; i < num; i++) {
+		if (mStatus[i]) {
+			mPrevPoints[n] = mPrevPoints[i];
+			mPoints[n] = mPoints[i];
+			n++;
+		}
+	}
+	mPrevPoints.resize(n);
+	mPoints.resize(n);
+	if (!n) {
+		return 0;
+	}
+	// median is robust against the features on moving objects
+	mWork.resize(n);
+	for (int i = 0; i < n; i++) {
+		mWork[i] = mPoints[i].x - mPrevPoints[i].x;
+	}
+	std::nth_element(mWork.begin(), mWork.begin() + n / 2, mWork.end());
+	motion.x = mWork[n / 2];
+	for (int i = 0; i < n; i++) {
+		mWork[i] = mPoints[i].y - mPrevPoints[i].y;
+	}
+	std::nth_element(mWork.begin(), mWork.begin() + n / 2, mWork.end());
+	motion.y = mWork[n / 2];
+	int inliers = 0;
+	for (int i = 0; i < n; i++) {
+		const cv::Point2f d = mPoints[i] - mPrevPoints[i] - motion;
+		if (d.dot(d) <= KLT_INLIER_DIST * KLT_INLIER_DIST) {
+			inliers++;
+		}
+	}
+	return inliers;
+}
+
+/**
+ * add features away from tracked features(mPrevPoints) up to KLT_MAX_FEATURES
+ */
+/*private*/
+void IPKltTracker::seed(const cv::Mat &gray) {
+	const int n = KLT_MAX_FEATURES - (int)mPrevPoints.size();
+	if (UNLIKELY((mMask.cols != gray.cols) || (mMask.rows != gray.rows))) {
+		mMask.create(gray.size(), CV_8UC1);
+	}
+	mMask.setTo(cv::Scalar::all(255));
+	for (std::vector<cv::Point2f>::const_iterator iter = mPrevPoints.begin(); iter != mPrevPoints.end(); iter++) {
+		cv::circle(mMask, *iter, KLT_MIN_DISTANCE, cv::Scalar::all(0), -1);
+	}
+	cv::goodFeaturesToTrack(gray, mSeeds, n, KLT_QUALITY_LEVEL, KLT_MIN_DISTANCE, mMask);
+	mPrevPoints.insert(mPrevPoints.end(), mSeeds.begin(), mSeeds.end());
+	mSeedCount++;
+}
+
+/**
+ * draw the motion of tracked features, green for the features that follow global motion
+ */
+/*private*/
+void IPKltTracker::drawTracks(stage_context_t &ctx, const cv::Point2f &motion) {
+	const cv::Point2f offset((float)ctx.roi.x, (float)ctx.roi.y);
+	const int n = (int)mPoints.size();
+	for (int i = 0; i < n; i++) {
+		const cv::Point2f d = mPoints[i] - mPrevPoints[i] - motion;
+		const cv::Scalar &color = d.dot(d) <= KLT_INLIER_DIST * KLT_INLIER_DIST ? COLOR_GREEN : COLOR_RED;
+		cv::line(ctx.result, mPrevPoints[i] + offset, mPoints[i] + offset, color, 1);
+		cv::circle(ctx.result, mPoints[i] + offset, 2, color, -1);
+	}
+}
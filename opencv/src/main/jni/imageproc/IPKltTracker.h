@@ -0,0 +1,85 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+
+#ifndef FLIGHTDEMO_IPKLTTRACKER_H
+#define FLIGHTDEMO_IPKLTTRACKER_H
+
+#include <vector>
+
+#include "IPStage.h"
+
+// max number of tracked features
+#define KLT_MAX_FEATURES 100
+// features are seeded again when the number of tracked features drops below this
+#define KLT_MIN_FEATURES 50
+// frames to wait before seeding again when seeding could not find KLT_MIN_FEATURES features,
+// so that low texture scene does not run goodFeaturesToTrack on every frame
+#define KLT_SEED_COOLDOWN 15
+// parameters of goodFeaturesToTrack
+#define KLT_QUALITY_LEVEL 0.01
+#define KLT_MIN_DISTANCE 10
+// search window of calcOpticalFlowPyrLK[px] and number of pyramid levels above the frame
+#define KLT_WIN_SIZE 21
+#define KLT_MAX_LEVEL 3
+// max distance of tracked motion from global motion to be counted as inlier[px]
+#define KLT_INLIER_DIST 2.0f
+
+/**
+ * "klt": track sparse features by pyramidal Lucas-Kanade and estimate global motion of the frame.
+ * pyramid of each frame is built once and kept as previous pyramid for next frame,
+ * features are seeded by goodFeaturesToTrack only when the number of tracked features dropped,
+ * and if seeding could not find enough features(e.g. low texture scene), it backs off
+ * for KLT_SEED_COOLDOWN frames instead of seeding on every frame.
+ * global motion(median of the motion of tracked features) and number of the features
+ * that follow it are attached to results(RESULT_IX_FLOW_XXX).
+ * RGBA input is converted to gray scale and the input is passed through to next stage.
+ */
+class IPKltTracker : public IPStage {
+private:
+	cv::Mat mGray;
+	cv::Rect mPrevRoi;
+	// pyramid of previous and current frame, swapped for each frame
+	std::vector<cv::Mat> mPrevPyramid, mPyramid;
+	std::vector<cv::Point2f> mPrevPoints, mPoints, mSeeds;
+	std::vector<uchar> mStatus;
+	std::vector<float> mError;
+	std::vector<float> mWork;
+	cv::Mat mMask;
+	// frames to wait until next seeding
+	int mSeedCooldown;
+	// updated and read only on the thread of the pipeline
+	int64_t mSeedCount;
+	int64_t mBackoffCount;
+	int track(cv::Point2f &motion);
+	void seed(const cv::Mat &gray);
+	void drawTracks(stage_context_t &ctx, const cv::Point2f &motion);
+public:
+	IPKltTracker();
+	virtual ~IPKltTracker();
+	virtual int process(stage_context_t &ctx, const cv::Mat &src, cv::Mat &dst);
+	virtual void reset();
+	virtual void getDetectStats(int64_t &detect_count, int64_t &fallback_count) const;
+};
+
+#endif //FLIGHTDEMO_IPKLTTRACKER_H
@@ -0,0 +1,263 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+
+#if 1	// set 0 to enable debug output, otherwise set 1
+	#ifndef LOG_NDEBUG
+		#define	LOG_NDEBUG		// disable LOGV/LOGD/MARK
+	#endif
+	#undef USE_LOGALL			// enable specific LOGx only
+#else
+//	#define USE_LOGALL
+	#define USE_LOGD
+	#undef LOG_NDEBUG
+	#undef NDEBUG
+#endif
+
+#include <math.h>
+#include <algorithm>
+
+#include "utilbase.h"
+
+#include "IPScanline.h"
+#include "IPLineDetector.h"
+
+// number of longest segments of full search that are tried as the seed of tracking
+#define NUM_SEEDS 3
+
+static bool longer_segment(const cv::Vec4i &a, const cv::Vec4i &b) {
+	const int la = (a[2] - a[0]) * (a[2] - a[0]) + (a[3] - a[1]) * (a[3] - a[1]);
+	const int lb = (b[2] - b[0]) * (b[2] - b[0]) + (b[3] - b[1]) * (b[3] - b[1]);
+	return la > lb;
+}
+
+IPLineDetector::IPLineDetector()
+:	IPTrackingStage("line", LINE_MIN_CONFIDENCE, LINE_LOST_FRAMES, RESULT_IX_LINE_FULL_SEARCH),
+	mStep(LINE_MIN_STEP * 2),
+	mFullSearchWidth(LINE_FULL_SEARCH_WIDTH) {
+
+	ENTER();
+
+	EXIT();
+}
+
+IPLineDetector::~IPLineDetector() {
+	ENTER();
+
+	EXIT();
+}
+
+/*public*/
+void IPLineDetector::reset() {
+	ENTER();
+
+	IPTrackingStage::reset();
+	mSmall.release();
+	mEdges.release();
+
+	EXIT();
+}
+
+/*protected*/
+float IPLineDetector::detect(const cv::Mat &gray) {
+	const nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
+	const float result = search(gray, mFoundCenter, mFoundDir);
+	updateBudget(systemTime(SYSTEM_TIME_MONOTONIC) - start, true);
+	return result;
+}
+
+/*protected*/
+float IPLineDetector::track(const cv::Mat &gray) {
+	const nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
+	const float result = searchWindow(gray, mCenter, mDir, mFoundCenter, mFoundDir);
+	updateBudget(systemTime(SYSTEM_TIME_MONOTONIC) - start, false);
+	return result;
+}
+
+/*protected*/
+void IPLineDetector::accept() {
+	mCenter = mFoundCenter;
+	mDir = mFoundDir;
+	// direction is kept in (-90, 90] degrees
+	if ((mDir.x < 0) || ((mDir.x == 0) && (mDir.y < 0))) {
+		mDir = -mDir;
+	}
+}
+
+/*protected*/
+void IPLineDetector::report(stage_context_t &ctx, const float &confidence, const bool &full_search) {
+	ctx.detect_type = TYPE_LINE;
+	const cv::Point2f d = mCenter - cv::Point2f(ctx.roi.width * 0.5f, ctx.roi.height * 0.5f);
+	ctx.results[RESULT_IX_LINE_CONFIDENCE] = confidence;
+	ctx.results[RESULT_IX_LINE_ANGLE] = (float)(atan2(mDir.y, mDir.x) * 180.0 / CV_PI);
+	// positive when the line is right of or above the center
+	ctx.results[RESULT_IX_LINE_OFFSET] = d.x * mDir.y - d.y * mDir.x;
+	if (draws_overlay(ctx)) {
+		drawLine(ctx, confidence > 0 ? COLOR_GREEN : COLOR_YELLOW);
+	}
+}
+
+/**
+ * tracked line is kept in coordinates of the region of interest,
+ * so it is moved when only the position of the region changed
+ */
+/*protected*/
+bool IPLineDetector::onRoiChanged(const cv::Rect &prev, const cv::Rect &roi) {
+	if (roi.size() == prev.size()) {
+		mCenter += cv::Point2f((float)(prev.x - roi.x), (float)(prev.y - roi.y));
+		return true;
+	}
+	return false;
+}
+
+/**
+ * sample scanlines across the window around the line and fit a line to the found points
+ * @return confidence, ratio of the points on the fitted line to sampled scanlines
+ */
+/*private*/
+float IPLineDetector::searchWindow(const cv::Mat &gray, const cv::Point2f &center, const cv::Point2f &dir,
+	cv::Point2f &found_center, cv::Point2f &found_dir) {
+
+	mPoints.clear();
+	int sampled = 0;
+	int strength;
+	if (fabsf(dir.x) >= fabsf(dir.y)) {
+		// mostly horizontal line, sample columns
+		const float slope = dir.y / dir.x;
+		for (int x = mStep / 2; x < gray.cols; x += mStep) {
+			const int y = cvRound(center.y + (x - center.x) * slope);
+			const int y0 = std::max(0, y - LINE_SEARCH_HALF_WIDTH);
+			const int y1 = std::min(gray.rows, y + LINE_SEARCH_HALF_WIDTH + 1);
+			if (y1 - y0 < 3) continue;
+			sampled++;
+			const float pos = scan_line_center(gray.ptr<uint8_t>(y0) + x, (int)gray.step, y1 - y0,
+				LINE_MIN_CONTRAST, LINE_MAX_WIDTH, strength);
+			if (pos >= 0) {
+				mPoints.push_back(cv::Point2f((float)x, y0 + pos));
+			}
+		}
+	} else {
+		// mostly vertical line, sample rows
+		const float slope = dir.x / dir.y;
+		for (int y = mStep / 2; y < gray.rows; y += mStep) {
+			const int x = cvRound(center.x + (y - center.y) * slope);
+			const int x0 = std::max(0, x - LINE_SEARCH_HALF_WIDTH);
+			const int x1 = std::min(gray.cols, x + LINE_SEARCH_HALF_WIDTH + 1);
+			if (x1 - x0 < 3) continue;
+			sampled++;
+			const float pos = scan_line_center(gray.ptr<uint8_t>(y) + x0, 1, x1 - x0,
+				LINE_MIN_CONTRAST, LINE_MAX_WIDTH, strength);
+			if (pos >= 0) {
+				mPoints.push_back(cv::Point2f(x0 + pos, (float)y));
+			}
+		}
+	}
+	if ((int)mPoints.size() < LINE_MIN_POINTS) {
+		return 0;
+	}
+	const int inliers = fit_line_robust(mPoints, found_center, found_dir, LINE_MAX_ERROR, mWork);
+	if (inliers < LINE_MIN_POINTS) {
+		return 0;
+	}
+	// the line can't turn quickly, this is more likely other edge in the window
+	const float sin_change = fabsf(dir.x * found_dir.y - dir.y * found_dir.x);
+	if (sin_change > sinf((float)(LINE_MAX_ANGLE_CHANGE * CV_PI / 180.0))) {
+		return 0;
+	}
+	return inliers / (float)sampled;
+}
+
+/**
+ * search whole frame by Canny + HoughLinesP on downscaled frame
+ * and refine longest segments by #searchWindow on the frame
+ * @return confidence of the best line
+ */
+/*private*/
+float IPLineDetector::search(const cv::Mat &gray, cv::Point2f &found_center, cv::Point2f &found_dir) {
+	int scale = 1;
+	while (gray.cols / scale > mFullSearchWidth) {
+		scale <<= 1;
+	}
+	const cv::Mat *img = &gray;
+	if (scale > 1) {
+		cv::resize(gray, mSmall, cv::Size(gray.cols / scale, gray.rows / scale), 0, 0, cv::INTER_AREA);
+		img = &mSmall;
+	}
+	cv::Canny(*img, mEdges, 50, 150);
+	const int min_length = std::max(img->cols, img->rows) / 8;
+	cv::HoughLinesP(mEdges, mSegments, 1, CV_PI / 180, min_length, min_length, 3);
+	const int n = std::min((int)mSegments.size(), NUM_SEEDS);
+	std::partial_sort(mSegments.begin(), mSegments.begin() + n, mSegments.end(), longer_segment);
+
+	float result = 0;
+	cv::Point2f center, dir;
+	for (int i = 0; i < n; i++) {
+		const cv::Vec4i &s = mSegments[i];
+		const cv::Point2f p0((s[0] + 0.5f) * scale, (s[1] + 0.5f) * scale);
+		const cv::Point2f p1((s[2] + 0.5f) * scale, (s[3] + 0.5f) * scale);
+		const cv::Point2f v = p1 - p0;
+		const float len = sqrtf(v.dot(v));
+		if (len < 1.0f) continue;
+		const float confidence = searchWindow(gray, (p0 + p1) * 0.5f, v * (1.0f / len), center, dir);
+		if (confidence > result) {
+			result = confidence;
+			found_center = center;
+			found_dir = dir;
+		}
+	}
+	return result;
+}
+
+/**
+ * make sampling coarser when the detector exceeded its time budget and finer when it has enough time
+ */
+/*private*/
+void IPLineDetector::updateBudget(const nsecs_t &elapsed_ns, const bool &full_search) {
+	if (full_search) {
+		if ((elapsed_ns > LINE_TIME_BUDGET_NS) && (mFullSearchWidth > LINE_MIN_FULL_SEARCH_WIDTH)) {
+			mFullSearchWidth >>= 1;
+			LOGD("full search width=%d", mFullSearchWidth);
+		} else if ((elapsed_ns < LINE_TIME_BUDGET_NS / 4) && (mFullSearchWidth < LINE_FULL_SEARCH_WIDTH)) {
+			mFullSearchWidth <<= 1;
+		}
+	} else {
+		if ((elapsed_ns > LINE_TIME_BUDGET_NS) && (mStep < LINE_MAX_STEP)) {
+			mStep <<= 1;
+			LOGD("step=%d", mStep);
+		} else if ((elapsed_ns < LINE_TIME_BUDGET_NS / 4) && (mStep > LINE_MIN_STEP)) {
+			mStep >>= 1;
+		}
+	}
+}
+
+/** draw tracked line across the region of interest of the result image */
+/*private*/
+void IPLineDetector::drawLine(stage_context_t &ctx, const cv::Scalar &color) {
+	const float len = (float)(ctx.roi.width + ctx.roi.height);
+	const cv::Point2f offset((float)ctx.roi.x, (float)ctx.roi.y);
+	cv::Point p0 = mCenter - mDir * len + offset;
+	cv::Point p1 = mCenter + mDir * len + offset;
+	if (cv::clipLine(ctx.roi, p0, p1)) {
+		cv::line(ctx.result, p0, p1, color, 2);
+	}
+}
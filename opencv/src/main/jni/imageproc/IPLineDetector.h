@@ -0,0 +1,93 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+
+#ifndef FLIGHTDEMO_IPLINEDETECTOR_H
+#define FLIGHTDEMO_IPLINEDETECTOR_H
+
+#include <vector>
+
+#include "IPTrackingStage.h"
+
+// half width of the window around the previous line that is searched while tracking[px]
+#define LINE_SEARCH_HALF_WIDTH 24
+// maximum width of the line, rising and falling edges further apart are not paired[px]
+#define LINE_MAX_WIDTH 32
+// minimum difference of the luminance across the edge of the line
+#define LINE_MIN_CONTRAST 24
+// maximum distance of the sampled points from fitted line[px]
+#define LINE_MAX_ERROR 3.0f
+// maximum change of the angle between frames while tracking[deg]
+#define LINE_MAX_ANGLE_CHANGE 15
+// minimum number of the points on the line and ratio of them to sampled scanlines
+#define LINE_MIN_POINTS 8
+#define LINE_MIN_CONFIDENCE 0.3f
+// number of frames that the line is not found until the detector searches whole frame again
+#define LINE_LOST_FRAMES 3
+// full search runs on downscaled frame whose width is this or less
+#define LINE_FULL_SEARCH_WIDTH 320
+#define LINE_MIN_FULL_SEARCH_WIDTH 160
+// interval of the scanlines while tracking[px]
+#define LINE_MIN_STEP 2
+#define LINE_MAX_STEP 16
+// time budget of the detector per frame[ns], sampling is made coarser when it is exceeded
+#define LINE_TIME_BUDGET_NS 4000000LL
+
+/**
+ * "line": detect a line(DetectType TYPE_LINE) in gray scale frame and track it over frames.
+ * once the line is found, only narrow window around the previous line is sampled
+ * with scanlines and whole frame is searched(Canny + HoughLinesP on downscaled frame)
+ * only when IPTrackingStage schedules full detection.
+ */
+class IPLineDetector : public IPTrackingStage {
+private:
+	// interval of scanlines and width of downscaled frame for full search, adjusted by time budget
+	int mStep;
+	int mFullSearchWidth;
+	// tracked line in coordinates of the region of interest, point on the line and unit direction
+	cv::Point2f mCenter, mDir;
+	// line found by last #detect/#track
+	cv::Point2f mFoundCenter, mFoundDir;
+	// buffers reused between frames
+	cv::Mat mSmall, mEdges;
+	std::vector<cv::Vec4i> mSegments;
+	std::vector<cv::Point2f> mPoints;
+	std::vector<float> mWork;
+	float searchWindow(const cv::Mat &gray, const cv::Point2f &center, const cv::Point2f &dir,
+		cv::Point2f &found_center, cv::Point2f &found_dir);
+	float search(const cv::Mat &gray, cv::Point2f &found_center, cv::Point2f &found_dir);
+	void updateBudget(const nsecs_t &elapsed_ns, const bool &full_search);
+	void drawLine(stage_context_t &ctx, const cv::Scalar &color);
+protected:
+	virtual float detect(const cv::Mat &gray);
+	virtual float track(const cv::Mat &gray);
+	virtual void accept();
+	virtual void report(stage_context_t &ctx, const float &confidence, const bool &full_search);
+	virtual bool onRoiChanged(const cv::Rect &prev, const cv::Rect &roi);
+public:
+	IPLineDetector();
+	virtual ~IPLineDetector();
+	virtual void reset();
+};
+
+#endif //FLIGHTDEMO_IPLINEDETECTOR_H
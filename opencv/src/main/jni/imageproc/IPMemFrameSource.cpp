@@ -0,0 +1,78 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+#if 1	// set 0 to enable debug output, otherwise set 1
+	#ifndef LOG_NDEBUG
+		#define	LOG_NDEBUG		// disable LOGV/LOGD/MARK
+	#endif
+	#undef USE_LOGALL			// enable specific LOGx only
+#else
+//	#define USE_LOGALL
+	#define USE_LOGD
+	#undef LOG_NDEBUG
+	#undef NDEBUG
+#endif
+
+#include "utilbase.h"
+
+#include "IPMemFrameSource.h"
+
+IPMemFrameSource::IPMemFrameSource(IPFrame &frame, const bool &luma_only)
+: IPFrameSource(frame, luma_only) {
+
+	ENTER();
+
+	EXIT();
+}
+
+IPMemFrameSource::~IPMemFrameSource() {
+	ENTER();
+
+	EXIT();
+}
+
+/**
+ * convert raw image into frame queue,
+ * if the image size is different from processing size, it is resized.
+ * only region of interest(in processing size) is converted/copied if it is set.
+ * @param data pointer to image
+ * @param size size of buffer[bytes]
+ * @param width width of the image
+ * @param height height of the image
+ * @param stride row stride of the image(Y plane for NV21)[bytes], 0 means packed
+ * @param timestamp_ns timestamp of the image from caller[ns], passed through to worker thread
+ * @param format one of PIXEL_FORMAT_XXX
+ * return 1 if the frame was dropped, negative value on error
+ */
+int IPMemFrameSource::handleBuffer(const uint8_t *data, const size_t &size,
+	const int &width, const int &height, const int &stride, const int64_t &timestamp_ns,
+	const int &format) {
+
+	ENTER();
+
+	const nsecs_t capture_time_ns = systemTime(SYSTEM_TIME_MONOTONIC);
+	const int result = ingestBuffer(data, size, width, height, stride, format,
+		capture_time_ns, timestamp_ns);
+
+	RETURN(result, int);
+}
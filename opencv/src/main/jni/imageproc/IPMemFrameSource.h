@@ -0,0 +1,42 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+#ifndef FLIGHTDEMO_IPMEMFRAMESOURCE_H
+#define FLIGHTDEMO_IPMEMFRAMESOURCE_H
+
+#include "IPFrameSource.h"
+
+/**
+ * frame source that receives raw image buffer pushed from Java(or any other thread),
+ * e.g. frame callback of UVC camera without OpenGL|ES
+ */
+class IPMemFrameSource : public IPFrameSource {
+public:
+	IPMemFrameSource(IPFrame &frame, const bool &luma_only = false);
+	virtual ~IPMemFrameSource();
+	virtual int handleBuffer(const uint8_t *data, const size_t &size,
+		const int &width, const int &height, const int &stride = 0,
+		const int64_t &timestamp_ns = 0, const int &format = PIXEL_FORMAT_RGBA);
+};
+
+#endif //FLIGHTDEMO_IPMEMFRAMESOURCE_H
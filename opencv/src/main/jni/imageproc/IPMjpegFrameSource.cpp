@@ -0,0 +1,183 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+
+#if 1	// set 0 to enable debug output, otherwise set 1
+	#ifndef LOG_NDEBUG
+		#define	LOG_NDEBUG		// disable LOGV/LOGD/MARK
+	#endif
+	#undef USE_LOGALL			// enable specific LOGx only
+#else
+//	#define USE_LOGALL
+	#define USE_LOGD
+	#undef LOG_NDEBUG
+	#undef NDEBUG
+#endif
+
+#include <stdlib.h>
+
+#include "utilbase.h"
+
+#include "IPMjpegFrameSource.h"
+
+IPMjpegFrameSource::IPMjpegFrameSource(IPFrame &frame, const bool &luma_only)
+: IPMemFrameSource(frame, luma_only),
+  mNumSpareBuffers(0),
+  mIsRunning(false) {
+
+	ENTER();
+
+	EXIT();
+}
+
+IPMjpegFrameSource::~IPMjpegFrameSource() {
+	ENTER();
+
+	release();
+
+	EXIT();
+}
+
+int IPMjpegFrameSource::init(const int &width, const int &height) {
+	ENTER();
+
+	int result = -1;
+	if (!mIsRunning) {
+		IPMemFrameSource::init(width, height);
+		mQueued.init(1);
+		mFree.init(MJPEG_BUFFER_NUM);
+		// all buffers are owned by caller at first
+		for (int i = 0; i < MJPEG_BUFFER_NUM; i++) {
+			mSpareBuffers[i] = i;
+		}
+		mNumSpareBuffers = MJPEG_BUFFER_NUM;
+		mIsRunning = true;
+		result = pthread_create(&decoder_thread, NULL, decoder_thread_func, (void *)this);
+		if (UNLIKELY(result)) {
+			LOGE("pthread_create failed:%d", result);
+			mIsRunning = false;
+		}
+	}
+
+	RETURN(result, int);
+}
+
+void IPMjpegFrameSource::release() {
+	ENTER();
+
+	if (mIsRunning) {
+		mIsRunning = false;
+		mQueued.wakeAll();
+		if (pthread_join(decoder_thread, NULL) != EXIT_SUCCESS) {
+			LOGW("terminate decoder thread: pthread_join failed");
+		}
+	}
+	mQueued.clear();
+	mFree.clear();
+	mNumSpareBuffers = 0;
+	for (int i = 0; i < MJPEG_BUFFER_NUM; i++) {
+		std::vector<uint8_t>().swap(mBuffers[i].data);
+	}
+	IPMemFrameSource::release();
+
+	EXIT();
+}
+
+/**
+ * copy MJPEG frame and pass it to decoder thread, this never waits for decoding.
+ * if decoder thread is busy, previously queued frame that is not decoded yet is dropped.
+ * return 1 if the frame was dropped, negative value on error(including other pixel formats)
+ */
+int IPMjpegFrameSource::handleBuffer(const uint8_t *data, const size_t &size,
+	const int &width, const int &height, const int &stride, const int64_t &timestamp_ns,
+	const int &format) {
+
+	ENTER();
+
+	if (UNLIKELY((format != PIXEL_FORMAT_MJPEG) || !mIsRunning || !data || !size)) {
+		RETURN(-1, int);
+	}
+	int result = 0;
+	intptr_t ix;
+	if (LIKELY(mNumSpareBuffers > 0)) {
+		ix = mSpareBuffers[--mNumSpareBuffers];
+	} else if (!mFree.pop(ix)) {
+		// never happens unless decoder thread keeps more than one buffer
+		skipFrame();
+		RETURN(1, int);
+	}
+	mjpeg_buffer_t &buf = mBuffers[ix];
+	buf.capture_time_ns = systemTime(SYSTEM_TIME_MONOTONIC);
+	buf.timestamp_ns = timestamp_ns;
+	// capacity of the buffer grows only at first few frames
+	buf.data.assign(data, data + size);
+	intptr_t oldest;
+	if (mQueued.size() >= mQueued.capacity() && mQueued.pop(oldest)) {
+		// decoder thread is busy, drop the frame that is not decoded yet
+		mSpareBuffers[mNumSpareBuffers++] = (int)oldest;
+		skipFrame();
+		result = 1;
+	}
+	mQueued.push(ix);
+
+	RETURN(result, int);
+}
+
+/** static member thread function */
+/*private*/
+void *IPMjpegFrameSource::decoder_thread_func(void *vptr_args) {
+	ENTER();
+
+	IPMjpegFrameSource *source = reinterpret_cast<IPMjpegFrameSource *>(vptr_args);
+	if (LIKELY(source)) {
+		source->do_decode();
+	}
+
+	PRE_EXIT();
+	pthread_exit(NULL);
+}
+
+/*private*/
+void IPMjpegFrameSource::do_decode() {
+	ENTER();
+
+	intptr_t ix;
+	for ( ; mIsRunning ; ) {
+		const int seq = mQueued.pushSeq();
+		if (!mQueued.pop(ix)) {
+			// wait until caller pushes new frame
+			mQueued.waitPush(seq);
+			continue;
+		}
+		const mjpeg_buffer_t &buf = mBuffers[ix];
+		try {
+			ingestBuffer(&buf.data[0], buf.data.size(), mWidth, mHeight, 0, PIXEL_FORMAT_MJPEG,
+				buf.capture_time_ns, buf.timestamp_ns);
+		} catch (const cv::Exception &e) {
+			LOGE("failed to decode:%s", e.msg.c_str());
+		}
+		mFree.push(ix);
+	}
+
+	EXIT();
+}
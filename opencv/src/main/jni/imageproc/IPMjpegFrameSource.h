@@ -0,0 +1,75 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+
+#ifndef FLIGHTDEMO_IPMJPEGFRAMESOURCE_H
+#define FLIGHTDEMO_IPMJPEGFRAMESOURCE_H
+
+#include <pthread.h>
+#include <vector>
+
+#include "IPSpscRing.h"
+#include "IPMemFrameSource.h"
+
+// number of buffers for compressed frames,
+// one for caller, one queued and one being decoded
+#define MJPEG_BUFFER_NUM 3
+
+/**
+ * frame source that decodes MJPEG frames pushed from Java(e.g. frame callback of UVC camera)
+ * on its own thread, so decoding of next frame is pipelined with processing of current one.
+ * JPEG is decoded directly to the scale nearest to processing size with scaled IDCT
+ * and as luminance only if worker thread does not need color.
+ * only the newest compressed frame is kept while decoder thread is busy.
+ * use FRAME_SOURCE_MEMORY for other pixel formats.
+ */
+class IPMjpegFrameSource : public IPMemFrameSource {
+private:
+	typedef struct mjpeg_buffer {
+		std::vector<uint8_t> data;
+		nsecs_t capture_time_ns;
+		int64_t timestamp_ns;
+	} mjpeg_buffer_t;
+	mjpeg_buffer_t mBuffers[MJPEG_BUFFER_NUM];
+	// index of mBuffers from caller to decoder thread
+	IPSpscRing mQueued;
+	// index of mBuffers that decoder thread finished, returned to caller
+	IPSpscRing mFree;
+	// accessed only from caller
+	int mSpareBuffers[MJPEG_BUFFER_NUM];
+	int mNumSpareBuffers;
+	volatile bool mIsRunning;
+	pthread_t decoder_thread;
+	static void *decoder_thread_func(void *vptr_args);
+	void do_decode();
+public:
+	IPMjpegFrameSource(IPFrame &frame, const bool &luma_only = false);
+	virtual ~IPMjpegFrameSource();
+	virtual int init(const int &width, const int &height);
+	virtual void release();
+	virtual int handleBuffer(const uint8_t *data, const size_t &size,
+		const int &width, const int &height, const int &stride = 0,
+		const int64_t &timestamp_ns = 0, const int &format = PIXEL_FORMAT_MJPEG);
+};
+
+#endif //FLIGHTDEMO_IPMJPEGFRAMESOURCE_H
@@ -0,0 +1,199 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+
+
+#if 1	// set 0 to enable debug output, otherwise set 1
+	#ifndef LOG_NDEBUG
+		#define	LOG_NDEBUG		// disable LOGV/LOGD/MARK
+	#endif
+	#undef USE_LOGALL			// enable specific LOGx only
+#else
+//	#define USE_LOGALL
+	#define USE_LOGD
+	#undef LOG_NDEBUG
+	#undef NDEBUG
+#endif
+
+#include <stdlib.h>
+#include <algorithm>
+
+#include "utilbase.h"
+
+#include "IPMotionDetector.h"
+
+static inline bool larger_area(const cv::Rect &a, const cv::Rect &b) {
+	return a.area() > b.area();
+}
+
+IPMotionDetector::IPMotionDetector()
+:	IPStage("motion"),
+	mHold(0) {
+
+	ENTER();
+
+	EXIT();
+}
+
+IPMotionDetector::~IPMotionDetector() {
+	ENTER();
+
+	EXIT();
+}
+
+/*public*/
+void IPMotionDetector::reset() {
+	ENTER();
+
+	mHold = 0;
+	mGray.release();
+	mSmall.release();
+	mBackground.release();
+	mMask.release();
+	mLabels.release();
+	mStats.release();
+	mCentroids.release();
+	mRegions.clear();
+
+	EXIT();
+}
+
+/*public*/
+int IPMotionDetector::process(stage_context_t &ctx, const cv::Mat &src, cv::Mat &dst) {
+	ENTER();
+
+	dst = src;
+	const cv::Mat *gray = &src;
+	if (src.channels() != 1) {
+		cv::cvtColor(src, mGray, cv::COLOR_RGBA2GRAY);
+		gray = &mGray;
+	}
+	// downscale keeping aspect, area interpolation also suppresses sensor noise
+	const int w = std::min(MOTION_WIDTH, gray->cols);
+	const int h = std::max(1, gray->rows * w / gray->cols);
+	cv::resize(*gray, mSmall, cv::Size(w, h), 0, 0, cv::INTER_AREA);
+	if (UNLIKELY(mBackground.size() != mSmall.size())) {
+		// first frame or size changed, start from current frame without motion
+		mSmall.convertTo(mBackground, CV_16UC1, 256.0);
+		mMask.create(mSmall.size(), CV_8UC1);
+		mMask.setTo(cv::Scalar::all(0));
+	}
+
+	const int count = updateBackground();
+	const float activity = count / (float)mSmall.total();
+	ctx.results[RESULT_IX_MOTION_ACTIVITY] = activity;
+	if (UNLIKELY(activity >= MOTION_RELEARN_ACTIVITY)) {
+		// slow update of background takes too long to follow changes of whole frame
+		mSmall.convertTo(mBackground, CV_16UC1, 256.0);
+	}
+	// scale from downscaled frame, before writeMask that reuses mGray
+	const float sx = gray->cols / (float)w, sy = gray->rows / (float)h;
+	if (writes_result(ctx)) {
+		// mask first, regions are drawn on it
+		writeMask(ctx);
+	}
+	if (count) {
+		// regions of motion, bounding box of the regions that are large enough
+		const int n = cv::connectedComponentsWithStats(mMask, mLabels, mStats, mCentroids, 8, CV_32S);
+		const bool draw = draws_overlay(ctx);
+		mRegions.clear();
+		cv::Rect bounds;
+		for (int i = 1; i < n; i++) {	// label 0 is background
+			const int *stats = mStats.ptr<int>(i);
+			if (stats[cv::CC_STAT_AREA] < MOTION_MIN_AREA) continue;
+			const cv::Rect rect(
+				cvFloor(stats[cv::CC_STAT_LEFT] * sx), cvFloor(stats[cv::CC_STAT_TOP] * sy),
+				cvCeil(stats[cv::CC_STAT_WIDTH] * sx), cvCeil(stats[cv::CC_STAT_HEIGHT] * sy));
+			bounds = mRegions.empty() ? rect : (bounds | rect);
+			mRegions.push_back(rect);
+			if (draw) {
+				cv::rectangle(ctx.result, rect + ctx.roi.tl(), COLOR_RED, 2);
+			}
+		}
+		ctx.results[RESULT_IX_MOTION_REGIONS] = (float)mRegions.size();
+		ctx.results[RESULT_IX_MOTION_X] = (float)bounds.x;
+		ctx.results[RESULT_IX_MOTION_Y] = (float)bounds.y;
+		ctx.results[RESULT_IX_MOTION_WIDTH] = (float)bounds.width;
+		ctx.results[RESULT_IX_MOTION_HEIGHT] = (float)bounds.height;
+		// largest regions first
+		const int num = std::min((int)mRegions.size(), RESULT_MOTION_MAX_BOXES);
+		std::partial_sort(mRegions.begin(), mRegions.begin() + num, mRegions.end(), larger_area);
+		float *box = &ctx.results[RESULT_IX_MOTION_BOXES];
+		for (int i = 0; i < num; i++, box += 4) {
+			const cv::Rect &rect = mRegions[i];
+			box[0] = (float)rect.x;
+			box[1] = (float)rect.y;
+			box[2] = (float)rect.width;
+			box[3] = (float)rect.height;
+		}
+	}
+
+	int result = 0;
+	if (activity >= MOTION_GATE_ACTIVITY) {
+		mHold = MOTION_HOLD_FRAMES;
+	} else if (mHold > 0) {
+		mHold--;
+	} else {
+		// nothing moves, following stages are not needed
+		result = STAGE_SKIP_REST;
+	}
+
+	RETURN(result, int);
+}
+
+/**
+ * compare downscaled frame with background and update background,
+ * background follows slowly where motion is detected
+ * @return number of the pixels in motion
+ */
+/*private*/
+int IPMotionDetector::updateBackground() {
+	int count = 0;
+	for (int y = 0; y < mSmall.rows; y++) {
+		const uint8_t *p = mSmall.ptr<uint8_t>(y);
+		uint16_t *b = mBackground.ptr<uint16_t>(y);
+		uint8_t *m = mMask.ptr<uint8_t>(y);
+		for (int x = 0; x < mSmall.cols; x++) {
+			const int v = p[x] << 8;
+			const int bg = b[x];
+			const bool motion = abs(v - bg) > (MOTION_THRESHOLD << 8);
+			m[x] = motion ? 0xff : 0;
+			count += motion;
+			b[x] = (uint16_t)(bg + ((v - bg) >> (motion ? MOTION_SLOW_SHIFT : MOTION_SHIFT)));
+		}
+	}
+	return count;
+}
+
+/** write motion mask into the region of interest of result image */
+/*private*/
+void IPMotionDetector::writeMask(stage_context_t &ctx) {
+	cv::Mat out = ctx.result(ctx.roi);
+	if (out.channels() == 1) {
+		cv::resize(mMask, out, out.size(), 0, 0, cv::INTER_NEAREST);
+	} else {
+		// reuse mGray as upscaled mask, it is not used for gray scale input
+		cv::resize(mMask, mGray, out.size(), 0, 0, cv::INTER_NEAREST);
+		IPStage::writeImage(mGray, out, cv::Range(0, out.rows));
+	}
+}
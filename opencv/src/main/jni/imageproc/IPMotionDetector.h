@@ -0,0 +1,77 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+
+#ifndef FLIGHTDEMO_IPMOTIONDETECTOR_H
+#define FLIGHTDEMO_IPMOTIONDETECTOR_H
+
+#include "IPStage.h"
+
+// width of downscaled luminance that the background model works on[px]
+#define MOTION_WIDTH 80
+// minimum difference of the luminance from background to be motion
+#define MOTION_THRESHOLD 16
+// rate of background update, 1 / (1 << shift) for each frame,
+// slower for the pixels in motion so that moving object is not absorbed soon
+#define MOTION_SHIFT 4
+#define MOTION_SLOW_SHIFT 7
+// ratio of the pixels in motion to be regarded as change of lighting or camera movement,
+// background is relearned from current frame then
+#define MOTION_RELEARN_ACTIVITY 0.5f
+// minimum area of the region of motion in downscaled frame[px]
+#define MOTION_MIN_AREA 4
+// minimum ratio of the pixels in motion to pass the frame to following stages
+#define MOTION_GATE_ACTIVITY 0.002f
+// number of frames that following stages keep running after the motion stopped
+#define MOTION_HOLD_FRAMES 5
+
+/**
+ * "motion": detect motion against running average background of heavily downscaled luminance.
+ * activity(ratio of the pixels in motion), number of the regions of motion,
+ * bounding box of all regions and boxes of the largest regions are attached to results(RESULT_IX_MOTION_XXX).
+ * the motion mask is written into result image for RESULT_FRAME_TYPE_DST/DST_LINE
+ * and regions are drawn for RESULT_FRAME_TYPE_XXX_LINE.
+ * while there is no motion, this returns STAGE_SKIP_REST so that following stages
+ * are gated off(results are still passed to Java), put this stage last to disable gating.
+ * input is passed through to next stage.
+ */
+class IPMotionDetector : public IPStage {
+private:
+	int mHold;
+	// buffers reused between frames
+	cv::Mat mGray, mSmall;
+	// background, luminance in fixed point of 8 bits fraction(CV_16UC1)
+	cv::Mat mBackground;
+	cv::Mat mMask, mLabels, mStats, mCentroids;
+	// regions of motion of current frame
+	std::vector<cv::Rect> mRegions;
+	int updateBackground();
+	void writeMask(stage_context_t &ctx);
+public:
+	IPMotionDetector();
+	virtual ~IPMotionDetector();
+	virtual int process(stage_context_t &ctx, const cv::Mat &src, cv::Mat &dst);
+	virtual void reset();
+};
+
+#endif //FLIGHTDEMO_IPMOTIONDETECTOR_H
@@ -0,0 +1,73 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+
+#if 1	// set 0 to enable debug output, otherwise set 1
+	#ifndef LOG_NDEBUG
+		#define	LOG_NDEBUG		// disable LOGV/LOGD/MARK
+	#endif
+	#undef USE_LOGALL			// enable specific LOGx only
+#else
+//	#define USE_LOGALL
+	#define USE_LOGD
+	#undef LOG_NDEBUG
+	#undef NDEBUG
+#endif
+
+#include <algorithm>
+
+#include "utilbase.h"
+#include "WorkStealingPool.h"
+
+#include "IPParallel.h"
+
+/**
+ * adapter to execute cv::ParallelLoopBody on WorkStealingPool,
+ * each iteration of the pool is (tile_rows) rows of the body
+ */
+class ParallelLoopTask : public WorkStealingTask {
+private:
+	const cv::ParallelLoopBody &mBody;
+	const int mStart;
+	const int mEnd;
+	const int mStep;
+public:
+	ParallelLoopTask(const cv::ParallelLoopBody &body, const int &start, const int &end, const int &step)
+	: mBody(body), mStart(start), mEnd(end), mStep(step) {
+	};
+	virtual void run(const int &begin, const int &end) {
+		mBody(cv::Range(mStart + begin * mStep, std::min(mStart + end * mStep, mEnd)));
+	};
+};
+
+int ip_parallel_for(const cv::Range &range, const cv::ParallelLoopBody &body, const int &grain) {
+	ParallelLoopTask task(body, range.start, range.end, 1);
+	return WorkStealingPool::getInstance().parallelFor(0, range.end - range.start, grain, task);
+}
+
+int ip_parallel_for_tiles(const int &rows, const size_t &row_bytes, const cv::ParallelLoopBody &body) {
+	const int tile_rows = std::max(1, (int)(TILE_BYTES / std::max(row_bytes, (size_t)1)));
+	const int tiles = (rows + tile_rows - 1) / tile_rows;
+	ParallelLoopTask task(body, 0, rows, tile_rows);
+	return WorkStealingPool::getInstance().parallelFor(0, tiles, 1, task);
+}
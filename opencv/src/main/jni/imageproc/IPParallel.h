@@ -0,0 +1,47 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+
+#ifndef FLIGHTDEMO_IPPARALLEL_H
+#define FLIGHTDEMO_IPPARALLEL_H
+
+#include "opencv2/core.hpp"
+
+// size of one horizontal tile for per-pixel processing[bytes],
+// so that source and destination of the tile stay in L1/L2 cache of little cores
+#define TILE_BYTES (32 * 1024)
+
+/**
+ * same as cv::parallel_for_ but executed on WorkStealingPool
+ * return 0 if success, -1 if the body threw exception
+ * @param grain min number of iterations that is executed at once
+ */
+int ip_parallel_for(const cv::Range &range, const cv::ParallelLoopBody &body, const int &grain = 1);
+/**
+ * split rows into horizontal tiles of about TILE_BYTES and
+ * execute body for row range of each tile on WorkStealingPool
+ * @param row_bytes bytes of one row of the image(e.g. cols * elemSize)
+ */
+int ip_parallel_for_tiles(const int &rows, const size_t &row_bytes, const cv::ParallelLoopBody &body);
+
+#endif //FLIGHTDEMO_IPPARALLEL_H
@@ -0,0 +1,242 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+#if 1	// set 0 to enable debug output, otherwise set 1
+	#ifndef LOG_NDEBUG
+		#define	LOG_NDEBUG		// disable LOGV/LOGD/MARK
+	#endif
+	#undef USE_LOGALL			// enable specific LOGx only
+#else
+//	#define USE_LOGALL
+	#define USE_LOGD
+	#undef LOG_NDEBUG
+	#undef NDEBUG
+#endif
+
+#include <algorithm>
+
+#include "utilbase.h"
+
+#include "IPPboRing.h"
+
+IPPboRing::IPPboRing()
+: mHead(0), mTail(0), mPending(0), mMapped(0),
+  mWidth(0), mHeight(0), mSize(0) {
+
+	ENTER();
+
+	EXIT();
+}
+
+IPPboRing::~IPPboRing() {
+	ENTER();
+
+	// XXX GL context is required to delete PBOs/fences, so we can't release them here
+	LOGW_IF(!mSlots.empty(), "release was not called");
+
+	EXIT();
+}
+
+/**
+ * generate PBOs, this should be called on GL thread
+ * @param width
+ * @param height
+ * @param depth number of PBOs, will be limited to [1, MAX_PBO_NUM]
+ */
+int IPPboRing::init(const int &width, const int &height, const int &depth) {
+	ENTER();
+
+	release();
+
+	const int n = depth < 1 ? 1 : (depth > MAX_PBO_NUM ? MAX_PBO_NUM : depth);
+	mWidth = width;
+	mHeight = height;
+	const GLsizeiptr size = (GLsizeiptr)width * height * 4;
+	mSlots.resize(n);
+	for (int i = 0; i < n; i++) {
+		pbo_slot_t &slot = mSlots[i];
+		slot.fence = 0;
+		slot.request_time_ns = 0;
+		slot.timestamp = 0;
+		slot.x = slot.y = 0;
+		slot.width = width;
+		slot.height = height;
+		slot.bytes = size;
+		slot.mapped = NULL;
+		glGenBuffers(1, &slot.pbo);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+		glBufferData(GL_PIXEL_PACK_BUFFER, size, NULL, GL_DYNAMIC_READ);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	mHead = mTail = mPending = mMapped = 0;
+	mSize = size;
+
+	RETURN(0, int);
+}
+
+/**
+ * delete all PBOs and fences, this should be called on GL thread
+ */
+void IPPboRing::release() {
+	ENTER();
+
+	for (std::vector<pbo_slot_t>::iterator itr = mSlots.begin(); itr != mSlots.end(); itr++) {
+		if ((*itr).mapped) {
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, (*itr).pbo);
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+			(*itr).mapped = NULL;
+		}
+		releaseSlot(*itr);
+		if ((*itr).pbo) {
+			glDeleteBuffers(1, &(*itr).pbo);
+			(*itr).pbo = 0;
+		}
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	mSlots.clear();
+	mHead = mTail = mPending = mMapped = 0;
+	mWidth = mHeight = 0;
+	mSize = 0;
+
+	EXIT();
+}
+
+/*private*/
+void IPPboRing::releaseSlot(pbo_slot_t &slot) {
+	if (slot.fence) {
+		glDeleteSync(slot.fence);
+		slot.fence = 0;
+	}
+}
+
+/**
+ * query fence status without waiting/flushing
+ * XXX fence will be flushed by glFlush on Java side after #handleFrame
+ */
+/*private*/
+const bool IPPboRing::isSignalled(const pbo_slot_t &slot) const {
+	if (UNLIKELY(!slot.fence)) return true;
+	GLint status = GL_UNSIGNALED;
+	GLsizei len = 0;
+	glGetSynciv(slot.fence, GL_SYNC_STATUS, 1, &len, &status);
+	return status == GL_SIGNALED;
+}
+
+int IPPboRing::requestRead(const int64_t &timestamp,
+	const int &x, const int &y, const int &width, const int &height) {
+
+	ENTER();
+
+	if (UNLIKELY(!mSize || isFull() || mSlots[mHead].mapped || mSlots[mHead].fence)) {
+		// all slots are in flight or slot at head is still leased
+		RETURN(-1, int);
+	}
+	pbo_slot_t &slot = mSlots[mHead];
+	// clip the region by the frame, PBO has enough size for whole frame
+	if ((width > 0) && (height > 0)) {
+		slot.x = std::min(std::max(x, 0), mWidth - 1);
+		slot.y = std::min(std::max(y, 0), mHeight - 1);
+		slot.width = std::min(width, mWidth - slot.x);
+		slot.height = std::min(height, mHeight - slot.y);
+	} else {
+		slot.x = slot.y = 0;
+		slot.width = mWidth;
+		slot.height = mHeight;
+	}
+	slot.bytes = (GLsizeiptr)slot.width * slot.height * 4;
+	// bind PBO to read asynchronously
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+	// request asynchronously read the region of frame buffer into PBO
+	glReadPixels(slot.x, slot.y, slot.width, slot.height, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	// fence will signal when glReadPixels into this PBO has completed
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	slot.request_time_ns = systemTime(SYSTEM_TIME_MONOTONIC);
+	slot.timestamp = timestamp;
+	mHead = (mHead + 1) % depth();
+	mPending++;
+
+	RETURN(0, int);
+}
+
+const uint8_t *IPPboRing::tryMap(nsecs_t &latency_ns, int &discarded, int &slot_ix) {
+	ENTER();
+
+	const uint8_t *result = NULL;
+	int found = -1;
+	discarded = 0;
+	// fences signal in the order they were inserted, so check from oldest one
+	for ( ; (mPending > 0) && isSignalled(mSlots[mTail]) ; ) {
+		if (found >= 0) {
+			// there is newer frame, discard older one without mapping
+			discarded++;
+		}
+		found = mTail;
+		releaseSlot(mSlots[mTail]);
+		mTail = (mTail + 1) % depth();
+		mPending--;
+	}
+	slot_ix = -1;
+	if (found >= 0) {
+		pbo_slot_t &slot = mSlots[found];
+		latency_ns = systemTime(SYSTEM_TIME_MONOTONIC) - slot.request_time_ns;
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+		result = (const uint8_t *)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, slot.bytes, GL_MAP_READ_BIT);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		if (LIKELY(result)) {
+			slot.mapped = result;
+			slot_ix = found;
+			mMapped++;
+		} else {
+			LOGW("glMapBufferRange failed:err=0x%x", glGetError());
+		}
+	}
+
+	RET(result);
+}
+
+void IPPboRing::unmap(const int &slot_ix) {
+	ENTER();
+
+	if (LIKELY((slot_ix >= 0) && (slot_ix < depth()) && mSlots[slot_ix].mapped)) {
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, mSlots[slot_ix].pbo);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		mSlots[slot_ix].mapped = NULL;
+		mMapped--;
+	}
+
+	EXIT();
+}
+
+int IPPboRing::find(const void *data) const {
+	if (LIKELY(data)) {
+		const int n = depth();
+		for (int i = 0; i < n; i++) {
+			if (mSlots[i].mapped == data) {
+				return i;
+			}
+		}
+	}
+	return -1;
+}
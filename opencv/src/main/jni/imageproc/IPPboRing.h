@@ -0,0 +1,127 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+#ifndef FLIGHTDEMO_IPPBORING_H
+#define FLIGHTDEMO_IPPBORING_H
+
+#include <vector>
+#include <GLES3/gl3.h>		// API>=18
+#include <GLES3/gl3ext.h>	// API>=18
+
+#include "Timers.h"
+
+#ifndef DEFAULT_PBO_NUM
+// default number of PBOs in the ring
+#define DEFAULT_PBO_NUM 3
+#endif
+// max number of PBOs in the ring
+#define MAX_PBO_NUM 8
+
+/**
+ * ring of PBOs for asynchronous glReadPixels.
+ * each slot is guarded by a fence(glFenceSync) and is mapped only after
+ * its fence has signalled, so the caller(GL thread) never blocks on readback.
+ * This class does not depend on OpenCV, so you can run it
+ * on any EGL/GLES3 implementation including software one.
+ * All methods should be called on the thread that has the GL context.
+ */
+class IPPboRing {
+private:
+	typedef struct pbo_slot {
+		GLuint pbo;
+		GLsync fence;
+		// time when glReadPixels was requested[ns, SYSTEM_TIME_MONOTONIC]
+		nsecs_t request_time_ns;
+		// timestamp of the image that caller passed to #requestRead(e.g. SurfaceTexture#getTimestamp)
+		int64_t timestamp;
+		// region of frame buffer that was read into this slot
+		int x, y, width, height;
+		GLsizeiptr bytes;
+		// pointer to mapped image data, NULL if this slot is not mapped
+		const uint8_t *mapped;
+	} pbo_slot_t;
+
+	std::vector<pbo_slot_t> mSlots;
+	// index of slot to request next readback
+	int mHead;
+	// index of oldest pending slot
+	int mTail;
+	// number of pending(requested but not mapped yet) slots
+	int mPending;
+	// number of currently mapped slots
+	int mMapped;
+	int mWidth, mHeight;
+	GLsizeiptr mSize;
+	const bool isSignalled(const pbo_slot_t &slot) const;
+	void releaseSlot(pbo_slot_t &slot);
+public:
+	IPPboRing();
+	~IPPboRing();
+	int init(const int &width, const int &height, const int &depth = DEFAULT_PBO_NUM);
+	void release();
+	/**
+	 * request to read current frame buffer into free slot, return -1 if ring is full
+	 * @param timestamp timestamp of current frame buffer, you can get it with #timestamp after mapping
+	 * @param x, y, width, height region to read, zero or negative width/height means whole frame,
+	 *                only this region is transferred and mapped, so readback cost scales with it.
+	 *                the region is clipped by the frame, you can get actual region with #getRect
+	 */
+	int requestRead(const int64_t &timestamp = 0,
+		const int &x = 0, const int &y = 0, const int &width = 0, const int &height = 0);
+	/**
+	 * map the newest signalled slot and return pointer to its image data,
+	 * older signalled slots are discarded without mapping.
+	 * return NULL if there is no signalled slot(never wait for GPU).
+	 * you should call #unmap after you finished to access returned pointer.
+	 * mapped slot is never used for readback until it is unmapped,
+	 * so you can keep it mapped and lend its memory to other thread.
+	 * @param latency_ns time from requesting readback to mapping[ns]
+	 * @param discarded number of signalled slots discarded without mapping
+	 * @param slot index of mapped slot
+	 */
+	const uint8_t *tryMap(nsecs_t &latency_ns, int &discarded, int &slot);
+	void unmap(const int &slot);
+	/** return index of the slot that is mapped at the specific address, -1 if not found */
+	int find(const void *data) const;
+
+	/** time when readback was requested for the slot[ns, SYSTEM_TIME_MONOTONIC] */
+	inline const nsecs_t requestTime(const int &slot) const { return mSlots[slot].request_time_ns; };
+	/** timestamp that was passed to #requestRead for the slot */
+	inline const int64_t timestamp(const int &slot) const { return mSlots[slot].timestamp; };
+	/** region of frame buffer that was read into the slot */
+	inline void getRect(const int &slot, int &x, int &y, int &width, int &height) const {
+		const pbo_slot_t &s = mSlots[slot];
+		x = s.x; y = s.y; width = s.width; height = s.height;
+	};
+
+	inline const bool isValid() const { return mSize > 0; };
+	inline const bool isFull() const { return mPending + mMapped >= (int)mSlots.size(); };
+	inline const int depth() const { return (int)mSlots.size(); };
+	inline const int pending() const { return mPending; };
+	inline const int mapped() const { return mMapped; };
+	inline const int width() const { return mWidth; };
+	inline const int height() const { return mHeight; };
+	inline const GLsizeiptr size() const { return mSize; };
+};
+
+#endif //FLIGHTDEMO_IPPBORING_H
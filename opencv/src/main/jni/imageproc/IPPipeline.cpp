@@ -0,0 +1,752 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+
+#if 1	// set 0 to enable debug output, otherwise set 1
+	#ifndef LOG_NDEBUG
+		#define	LOG_NDEBUG		// disable LOGV/LOGD/MARK
+	#endif
+	#undef USE_LOGALL			// enable specific LOGx only
+#else
+//	#define USE_LOGALL
+	#define USE_LOGD
+	#undef LOG_NDEBUG
+	#undef NDEBUG
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <sstream>
+
+#include "utilbase.h"
+#include "common_utils.h"
+
+#include "IPParallel.h"
+#include "IPPipeline.h"
+#include "IPBasicStages.h"
+#include "IPLineDetector.h"
+#include "IPCurveDetector.h"
+#include "IPColorExtractor.h"
+#include "IPMotionDetector.h"
+#include "IPKltTracker.h"
+#include "IPDenseFlow.h"
+
+// max waiting time of segment threads[ns], queues are woken up on #stop, so this is just for safety
+#define MAX_WAIT_NS 100000000LL
+
+/** whether or not the image is a view of the buffer */
+static inline bool is_view_of(const cv::Mat &buf, const cv::Mat &image) {
+	return buf.data && (image.data >= buf.datastart) && (image.data < buf.dataend);
+}
+
+/**
+ * clear the area of the result image that previous region of interest wrote
+ * but current region of interest does not cover, at most 4 bands around current region
+ */
+static void clear_uncovered(cv::Mat &image, const cv::Rect &prev, const cv::Rect &roi) {
+	const cv::Rect cover = prev & roi;
+	if (cover.area() <= 0) {
+		if (prev.area() > 0) {
+			image(prev).setTo(cv::Scalar::all(0));
+		}
+		return;
+	}
+	// top and bottom bands over full width of previous region
+	if (cover.y > prev.y) {
+		image(cv::Rect(prev.x, prev.y, prev.width, cover.y - prev.y)).setTo(cv::Scalar::all(0));
+	}
+	if (cover.br().y < prev.br().y) {
+		image(cv::Rect(prev.x, cover.br().y, prev.width, prev.br().y - cover.br().y)).setTo(cv::Scalar::all(0));
+	}
+	// left and right bands within the rows of the covered area
+	if (cover.x > prev.x) {
+		image(cv::Rect(prev.x, cover.y, cover.x - prev.x, cover.height)).setTo(cv::Scalar::all(0));
+	}
+	if (cover.br().x < prev.br().x) {
+		image(cv::Rect(cover.br().x, cover.y, prev.br().x - cover.br().x, cover.height)).setTo(cv::Scalar::all(0));
+	}
+}
+
+/**
+ * execute IPStage#processTile for each tile
+ */
+class StageTileBody : public cv::ParallelLoopBody {
+private:
+	IPStage *mStage;
+	stage_context_t &mCtx;
+	const cv::Mat &mSrc;
+	cv::Mat &mDst;
+public:
+	StageTileBody(IPStage *stage, stage_context_t &ctx, const cv::Mat &src, cv::Mat &dst)
+	: mStage(stage), mCtx(ctx), mSrc(src), mDst(dst) {
+	};
+	virtual void operator()(const cv::Range &rows) const {
+		mStage->processTile(mCtx, mSrc, mDst, rows);
+	};
+};
+
+/**
+ * copy the frame into result image for each tile
+ */
+class WriteImageBody : public cv::ParallelLoopBody {
+private:
+	const cv::Mat &mSrc;
+	cv::Mat &mDst;
+public:
+	WriteImageBody(const cv::Mat &src, cv::Mat &dst)
+	: mSrc(src), mDst(dst) {
+	};
+	virtual void operator()(const cv::Range &rows) const {
+		IPStage::writeImage(mSrc, mDst, rows);
+	};
+};
+
+/*private*/
+IPPipeline::IPPipeline(const char *spec, const int &queue_depth)
+:	mSpec(spec ? spec : ""),
+	mQueueDepth(queue_depth < 1 ? 1
+		: (queue_depth > MAX_STAGE_QUEUE_DEPTH ? MAX_STAGE_QUEUE_DEPTH : queue_depth)),
+	mIsRunning(false),
+	mListener(NULL),
+	mNumSegments(0),
+	mLastDetectType(TYPE_NON) {
+
+	ENTER();
+
+	memset(mSegments, 0, sizeof(mSegments));
+	memset(mLastResults, 0, sizeof(mLastResults));
+
+	EXIT();
+}
+
+IPPipeline::~IPPipeline() {
+	ENTER();
+
+	stop();
+	reset();
+	for (std::vector<IPStage *>::iterator iter = mStages.begin(); iter != mStages.end(); iter++) {
+		delete *iter;
+	}
+	mStages.clear();
+
+	EXIT();
+}
+
+/**
+ * create stage by its name, return NULL if the name is unknown
+ */
+/*public static*/
+IPStage *IPPipeline::createStage(const std::string &name) {
+	ENTER();
+
+	IPStage *result = NULL;
+	if (name == "gray") {
+		result = new IPGrayStage();
+	} else if (name == "gray_rgba") {
+		result = new IPGrayRgbaStage();
+	} else if (name == "rgba") {
+		result = new IPRgbaStage();
+	} else if (name == "line") {
+		result = new IPLineDetector();
+	} else if (name == "curve") {
+		result = new IPCurveDetector();
+	} else if (name == "color") {
+		result = new IPColorExtractor();
+	} else if (name == "motion") {
+		result = new IPMotionDetector();
+	} else if (name == "klt") {
+		result = new IPKltTracker();
+	} else if (name == "dense_flow") {
+		result = new IPDenseFlow();
+	}
+
+	RET(result);
+}
+
+/**
+ * check the parameter of the stage of the name without creating the stage,
+ * each stage that has parameters should be listed here as well as #createStage
+ * return 0 if valid, -1 if unknown stage, unknown key or invalid values
+ */
+/*public static*/
+int IPPipeline::validateParameter(const std::string &stage, const std::string &key,
+	const float *values, const int &num) {
+
+	ENTER();
+
+	int result = -1;
+	if (UNLIKELY((num < 0) || (num && !values))) {
+		RETURN(result, int);
+	}
+	if ((stage == "line") || (stage == "curve")) {
+		result = IPTrackingStage::validateParameter(key, values, num);
+	} else if (stage == "color") {
+		result = IPColorExtractor::validateParameter(key, values, num);
+	} else if (stage == "dense_flow") {
+		result = IPDenseFlow::validateParameter(key, values, num);
+	}
+
+	RETURN(result, int);
+}
+
+/**
+ * create pipeline from stage names, stages are separated by ','
+ * and '|' starts new segment that runs on its own thread(e.g. "gray|rgba")
+ * return NULL if the spec contains unknown stage, too many stages or too many segments
+ * @param queue_depth max number of frames that can wait between segments
+ */
+/*public static*/
+IPPipeline *IPPipeline::create(const char *spec, const int &queue_depth) {
+	ENTER();
+
+	const std::string s(spec && strlen(spec) ? spec : DEFAULT_PIPELINE);
+	IPPipeline *pipeline = new IPPipeline(s.c_str(), queue_depth);
+	std::istringstream segments(s);
+	std::string segment;
+	while (std::getline(segments, segment, '|')) {
+		if (UNLIKELY(pipeline->segments() >= PIPELINE_MAX_SEGMENTS)) {
+			LOGE("too many segments:%s", s.c_str());
+			SAFE_DELETE(pipeline);
+			RET(pipeline);
+		}
+		pipeline->addSegment();
+		std::istringstream stream(segment);
+		std::string name;
+		while (std::getline(stream, name, ',')) {
+			// trim white spaces
+			const size_t first = name.find_first_not_of(" \t");
+			if (first == std::string::npos) {
+				continue;
+			}
+			name = name.substr(first, name.find_last_not_of(" \t") - first + 1);
+			IPStage *stage = pipeline->size() < PIPELINE_MAX_STAGES ? createStage(name) : NULL;
+			if (UNLIKELY(!stage)) {
+				LOGE("unknown stage or too many stages:%s", name.c_str());
+				SAFE_DELETE(pipeline);
+				RET(pipeline);
+			}
+			pipeline->addStage(stage);
+		}
+		if (UNLIKELY(pipeline->mSegments[pipeline->segments() - 1].first == pipeline->size())) {
+			LOGE("empty segment:%s", s.c_str());
+			SAFE_DELETE(pipeline);
+			RET(pipeline);
+		}
+	}
+	if (UNLIKELY(!pipeline->size())) {
+		LOGE("no stage:%s", s.c_str());
+		SAFE_DELETE(pipeline);
+	} else {
+		pipeline->initPackets();
+	}
+
+	RET(pipeline);
+}
+
+/*private*/
+void IPPipeline::addStage(IPStage *stage) {
+	stage_stats_t stats;
+	memset(&stats, 0, sizeof(stats));
+	stats.segment = mNumSegments - 1;
+	mStages.push_back(stage);
+	mBuffers.push_back(cv::Mat());
+	mElapsed.push_back(0);
+	mStats.push_back(stats);
+	mSegments[mNumSegments - 1].last = size();
+}
+
+/*private*/
+void IPPipeline::addSegment() {
+	segment_t &segment = mSegments[mNumSegments];
+	segment.pipeline = this;
+	segment.index = mNumSegments;
+	segment.first = segment.last = size();
+	mNumSegments++;
+}
+
+/**
+ * each segment holds one frame and each queue between segments holds mQueueDepth frames
+ */
+/*private*/
+void IPPipeline::initPackets() {
+	const int num = mNumSegments + mQueueDepth * (mNumSegments - 1);
+	mPackets.resize(num);
+	mQueues[0].init(num);
+	for (int i = 1; i < mNumSegments; i++) {
+		mQueues[i].init(mQueueDepth);
+	}
+	for (int i = 0; i < num; i++) {
+		mPackets[i].dropped = false;
+		mPackets[i].skipped = false;
+	}
+}
+
+/**
+ * start threads of the segments, call this before #process
+ * @param listener receiver of the result, should be valid until #stop
+ */
+int IPPipeline::start(IPPipelineListener *listener) {
+	ENTER();
+
+	int result = 0;
+	if (!mIsRunning) {
+		mListener = listener;
+		mQueues[0].clear();
+		for (int i = 1; i < mNumSegments; i++) {
+			mQueues[i].clear();
+		}
+		// all packets are free at first
+		for (int i = 0; i < (int)mPackets.size(); i++) {
+			mQueues[0].push(i);
+		}
+		mIsRunning = true;
+		for (int i = 1; i < mNumSegments; i++) {
+			result = pthread_create(&mSegments[i].thread, NULL, segment_thread_func, (void *)&mSegments[i]);
+			if (UNLIKELY(result)) {
+				LOGE("pthread_create failed:%d", result);
+				// terminate already started threads
+				for (int j = i; j < mNumSegments; j++) {
+					mSegments[j].thread = 0;
+				}
+				stop();
+				break;
+			}
+		}
+	}
+
+	RETURN(result, int);
+}
+
+/**
+ * terminate threads of the segments, frames that are in the pipeline are discarded.
+ * listener is never called after this returns
+ */
+void IPPipeline::stop() {
+	ENTER();
+
+	if (mIsRunning) {
+		mIsRunning = false;
+		for (int i = 0; i < mNumSegments; i++) {
+			mQueues[i].wakeAll();
+		}
+		for (int i = 1; i < mNumSegments; i++) {
+			if (mSegments[i].thread
+				&& (pthread_join(mSegments[i].thread, NULL) != EXIT_SUCCESS)) {
+				LOGW("terminate segment thread: pthread_join failed");
+			}
+			mSegments[i].thread = 0;
+		}
+		mListener = NULL;
+	}
+
+	EXIT();
+}
+
+/**
+ * whether or not #process can take new frame now,
+ * false if all frames are in the pipeline or input queue of second segment is full
+ */
+const bool IPPipeline::canAccept() const {
+	return mIsRunning && !mQueues[0].empty()
+		&& ((mNumSegments < 2) || (mQueues[1].size() < mQueues[1].capacity()));
+}
+
+/**
+ * pass the frame to the pipeline, this returns after first segment processed it,
+ * result is passed to the listener on this thread or the thread of last segment.
+ * the frame is not referred after this returns.
+ * return -1 if the pipeline is not running or can not accept the frame(see #canAccept)
+ * @param ctx metadata of the frame, results and result are replaced with those of the pipeline
+ * @param frame the frame(or region of interest of it) from frame queue
+ */
+int IPPipeline::process(JNIEnv *env, stage_context_t &ctx, const cv::Mat &frame) {
+	ENTER();
+
+	intptr_t ix;
+	if (UNLIKELY(!canAccept() || !mQueues[0].pop(ix))) {
+		RETURN(-1, int);
+	}
+	stage_packet_t &packet = mPackets[ix];
+	packet.ctx = ctx;
+	packet.ctx.result.release();
+	memset(packet.ctx.results, 0, sizeof(packet.ctx.results));
+	packet.ctx.detect_type = TYPE_NON;
+	packet.dropped = false;
+	// stages are not needed for unchanged frame, its results are filled in #forward
+	packet.skipped = ctx.unchanged;
+	// packet has been taken from mQueues[0], so it should always go through #forward
+	// that returns it even if preparing the result failed
+	try {
+		// result image is built only when it is needed
+		switch (ctx.unchanged ? RESULT_FRAME_TYPE_NON : ctx.result_frame_type) {
+		case RESULT_FRAME_TYPE_NON:
+			// only numbers are passed to Java
+			break;
+		case RESULT_FRAME_TYPE_SRC:
+			if ((mNumSegments < 2) && frame.isContinuous()
+				&& (frame.cols == ctx.width) && (frame.rows == ctx.height)) {
+				// listener is called on this thread before the frame is recycled,
+				// so we can pass the frame itself without copying
+				packet.ctx.result = frame;
+				break;
+			}
+			// fall through, the frame is recycled before later segment finishes
+			// and only the region of interest is passed as the frame
+		default:
+		{
+			// each packet has its own result image so that segments never write same image
+			cv::Mat &r = packet.result;
+			const int type = ctx.result_format == RESULT_FORMAT_GRAY ? CV_8UC1 : CV_8UC4;
+			// result is always full frame size and only the region of interest is updated
+			if (UNLIKELY((r.cols != ctx.width) || (r.rows != ctx.height) || (r.type() != type))) {
+				r.allocator = ctx.allocator;
+				r.create(ctx.height, ctx.width, type);
+				r.setTo(cv::Scalar::all(0));
+				packet.prev_roi = ctx.roi;
+			} else if (UNLIKELY(ctx.roi != packet.prev_roi)) {
+				// keep the image and only clear what previous region wrote outside of new region
+				clear_uncovered(r, packet.prev_roi, ctx.roi);
+				packet.prev_roi = ctx.roi;
+			}
+			packet.ctx.result = r;
+			if ((ctx.result_frame_type == RESULT_FRAME_TYPE_SRC)
+				|| (ctx.result_frame_type == RESULT_FRAME_TYPE_SRC_LINE)) {
+
+				// result starts from copy of the frame, stages may draw overlay on it
+				cv::Mat out = r(ctx.roi);
+				ip_parallel_for_tiles(frame.rows, frame.cols * frame.elemSize(),
+					WriteImageBody(frame, out));
+			}
+			break;
+		}
+		}
+	} catch (const cv::Exception &e) {
+		LOGE("failed to prepare result:%s", e.msg.c_str());
+		// result image and its region may be half updated, so it is built again for next frame
+		packet.ctx.result.release();
+		packet.result.release();
+		packet.dropped = true;
+	} catch (...) {
+		LOGE("failed to prepare result:unknown exception");
+		packet.ctx.result.release();
+		packet.result.release();
+		packet.dropped = true;
+	}
+	runSegment(0, packet, frame);
+	forward(env, 0, ix);
+
+	RETURN(0, int);
+}
+
+/**
+ * run stages of the segment,
+ * output is kept in the packet when next segment processes it on other thread
+ */
+/*private*/
+void IPPipeline::runSegment(const int &index, stage_packet_t &packet, const cv::Mat &input) {
+	ENTER();
+
+	const segment_t &segment = mSegments[index];
+	stage_context_t &ctx = packet.ctx;
+	cv::Mat src = input;
+	int last = segment.first;
+	for (int i = segment.first; !packet.dropped && !packet.skipped && (i < segment.last); i++) {
+		IPStage *stage = mStages[i];
+		cv::Mat dst;
+		const int type = stage->outputType(src.type());
+		try {
+			if (type >= 0) {
+				cv::Mat &buf = mBuffers[i];
+				if (UNLIKELY((buf.cols != ctx.width) || (buf.rows != ctx.height) || (buf.type() != type))) {
+					buf.allocator = ctx.allocator;
+					buf.create(ctx.height, ctx.width, type);
+				}
+				// share full frame size buffer so that changing region never allocates
+				dst = IPFrame::continuousView(buf, src.cols, src.rows, type);
+			}
+			const nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
+			int r = 0;
+			if (stage->isTileParallel()) {
+				// per-pixel stage, split into horizontal tiles and process them on WorkStealingPool
+				if (UNLIKELY(ip_parallel_for_tiles(src.rows, src.cols * src.elemSize(),
+					StageTileBody(stage, ctx, src, dst)))) {
+
+					LOGE("stage %s failed", stage->name());
+					r = -1;
+				}
+			} else {
+				r = stage->process(ctx, src, dst);
+			}
+			mElapsed[i] = systemTime(SYSTEM_TIME_MONOTONIC) - start;
+			last = i + 1;
+			if (r == STAGE_SKIP_REST) {
+				// rest of stages are not needed for this frame
+				packet.skipped = true;
+				break;
+			} else if (r) {
+				// the stage stopped the pipeline for this frame
+				packet.dropped = true;
+				break;
+			}
+		} catch (const cv::Exception &e) {
+			LOGE("stage %s failed:%s", stage->name(), e.msg.c_str());
+			packet.dropped = true;
+			break;
+		} catch (...) {
+			// e.g. std::bad_alloc, this must not escape the thread of the segment
+			LOGE("stage %s failed:unknown exception", stage->name());
+			packet.dropped = true;
+			break;
+		}
+		// stage that does not output anything passes its input through
+		if (!dst.empty()) {
+			src = dst;
+		}
+	}
+	if (!packet.dropped && !packet.skipped && (index < mNumSegments - 1)) {
+		// stage buffers of this segment are overwritten by next frame while next segment
+		// processes this frame, so keep the output in the packet unless it is already there
+		try {
+			if (is_view_of(packet.handoff[0], src) || is_view_of(packet.handoff[1], src)) {
+				packet.data = src;
+			} else {
+				cv::Mat &buf = packet.handoff[is_view_of(packet.handoff[0], packet.data) ? 1 : 0];
+				if (UNLIKELY((buf.cols != ctx.width) || (buf.rows != ctx.height) || (buf.type() != src.type()))) {
+					buf.allocator = ctx.allocator;
+					buf.create(ctx.height, ctx.width, src.type());
+				}
+				packet.data = IPFrame::continuousView(buf, src.cols, src.rows, src.type());
+				src.copyTo(packet.data);
+			}
+		} catch (...) {
+			LOGE("segment %d failed to keep its output", index);
+			packet.data.release();
+			packet.dropped = true;
+		}
+	}
+	// publish stats once for each frame
+	mStatsLock.lock();
+	{
+		for (int i = segment.first; i < last; i++) {
+			stage_stats_t &stats = mStats[i];
+			stats.count++;
+			stats.total_ns += mElapsed[i];
+			if (mElapsed[i] > stats.max_ns) {
+				stats.max_ns = mElapsed[i];
+			}
+			mStages[i]->getDetectStats(stats.detect_count, stats.fallback_count);
+		}
+	}
+	mStatsLock.unlock();
+
+	EXIT();
+}
+
+/**
+ * pass the packet to next segment, or to the listener if this is last segment
+ */
+/*private*/
+void IPPipeline::forward(JNIEnv *env, const int &index, const intptr_t &ix) {
+	ENTER();
+
+	if (index < mNumSegments - 1) {
+		IPSpscRing &queue = mQueues[index + 1];
+		const int n = queue.size() + 1;
+		// first segment never waits here because #canAccept checked first queue,
+		// later segments wait while next segment is slower than them
+		for ( ; !queue.push(ix) ; ) {
+			if (UNLIKELY(!mIsRunning)) {
+				// packets are returned to free queue on #start
+				EXIT();
+			}
+			const int seq = queue.popSeq();
+			if (queue.size() >= queue.capacity()) {
+				queue.waitPop(seq, MAX_WAIT_NS);
+			}
+		}
+		mStatsLock.lock();
+		{
+			stage_stats_t &stats = mStats[mSegments[index + 1].first];
+			stats.queue_total += n;
+			if (n > stats.queue_max) {
+				stats.queue_max = n;
+			}
+		}
+		mStatsLock.unlock();
+	} else {
+		stage_packet_t &packet = mPackets[ix];
+		if (LIKELY(!packet.dropped && mIsRunning && mListener)) {
+			stage_context_t &ctx = packet.ctx;
+			if (ctx.unchanged) {
+				memcpy(ctx.results, mLastResults, sizeof(mLastResults));
+				ctx.detect_type = mLastDetectType;
+			} else {
+				memcpy(mLastResults, ctx.results, sizeof(mLastResults));
+				mLastDetectType = ctx.detect_type;
+			}
+			mListener->onPipelineResult(env, ctx);
+		}
+		// result may refer the frame(RESULT_FRAME_TYPE_SRC)
+		packet.ctx.result.release();
+		packet.data.release();
+		mQueues[0].push(ix);
+		if (mIsRunning && mListener) {
+			mListener->onPipelineReady();
+		}
+	}
+
+	EXIT();
+}
+
+/** static member thread function */
+/*private*/
+void *IPPipeline::segment_thread_func(void *vptr_args) {
+	ENTER();
+
+	segment_t *segment = reinterpret_cast<segment_t *>(vptr_args);
+	if (LIKELY(segment && segment->pipeline)) {
+		// last segment calls listener that may call Java method
+		JavaVM *vm = getVM();
+		if (LIKELY(vm)) {
+			JNIEnv *env;
+			vm->AttachCurrentThread(&env, NULL);
+			CHECK(env);
+			segment->pipeline->do_segment(env, segment->index);
+			vm->DetachCurrentThread();
+		} else {
+			// without Java(e.g. host build)
+			segment->pipeline->do_segment(NULL, segment->index);
+		}
+	}
+
+	PRE_EXIT();
+	pthread_exit(NULL);
+}
+
+/*private*/
+void IPPipeline::do_segment(JNIEnv *env, const int &index) {
+	ENTER();
+
+	IPSpscRing &queue = mQueues[index];
+	intptr_t ix;
+	for ( ; mIsRunning ; ) {
+		const int seq = queue.pushSeq();
+		if (!queue.pop(ix)) {
+			// wait until previous segment pushes next frame
+			queue.waitPush(seq, MAX_WAIT_NS);
+			continue;
+		}
+		stage_packet_t &packet = mPackets[ix];
+		runSegment(index, packet, packet.data);
+		forward(env, index, ix);
+	}
+
+	EXIT();
+}
+
+/**
+ * release buffers of all stages and frames, call this only while the pipeline is stopped
+ */
+void IPPipeline::reset() {
+	ENTER();
+
+	for (int i = 0; i < size(); i++) {
+		mStages[i]->reset();
+		mBuffers[i].release();
+	}
+	for (std::vector<stage_packet_t>::iterator iter = mPackets.begin(); iter != mPackets.end(); iter++) {
+		stage_packet_t &packet = *iter;
+		packet.ctx.result.release();
+		packet.result.release();
+		packet.data.release();
+		packet.handoff[0].release();
+		packet.handoff[1].release();
+		packet.prev_roi = cv::Rect();
+	}
+	memset(mLastResults, 0, sizeof(mLastResults));
+	mLastDetectType = TYPE_NON;
+
+	EXIT();
+}
+
+/**
+ * copy processing stats of each stage
+ * return number of stages
+ */
+int IPPipeline::getStats(stage_stats_t *stats, const int &max_num) const {
+	ENTER();
+
+	Mutex::Autolock lock(mStatsLock);
+	const int n = size();
+	for (int i = 0; (i < n) && (i < max_num); i++) {
+		stats[i] = mStats[i];
+		const int segment = (int)mStats[i].segment;
+		if ((segment > 0) && (mSegments[segment].first == i)) {
+			stats[i].queue_capacity = mQueues[segment].capacity();
+			stats[i].queue_size = mQueues[segment].size();
+		}
+	}
+
+	RETURN(n, int);
+}
+
+/**
+ * set parameter of the stages of the name(see IPStage#setParameter),
+ * call #validateParameter first so that all the stages accept it
+ * return number of the stages that the parameter was set, -1 if one of them rejected it
+ */
+int IPPipeline::setParameter(const std::string &stage, const std::string &key,
+	const float *values, const int &num) {
+
+	ENTER();
+
+	int result = 0;
+	for (int i = 0; i < size(); i++) {
+		if (stage == mStages[i]->name()) {
+			if (mStages[i]->setParameter(key, values, num)) {
+				RETURN(-1, int);
+			}
+			result++;
+		}
+	}
+
+	RETURN(result, int);
+}
+
+/**
+ * copy latest result of the first stage of the name(see IPStage#getResult)
+ * return number of the values of the result, -1 if there is no such stage or result
+ */
+int IPPipeline::getResult(const std::string &stage, const std::string &key,
+	float *values, const int &max_num, int64_t &seq) const {
+
+	ENTER();
+
+	for (int i = 0; i < size(); i++) {
+		if (stage == mStages[i]->name()) {
+			RETURN(mStages[i]->getResult(key, values, max_num, seq), int);
+		}
+	}
+
+	RETURN(-1, int);
+}
@@ -0,0 +1,191 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+
+#ifndef FLIGHTDEMO_IPPIPELINE_H
+#define FLIGHTDEMO_IPPIPELINE_H
+
+#include <pthread.h>
+#include <vector>
+#include <string>
+#include <jni.h>
+
+#include "Mutex.h"
+#include "Timers.h"
+#include "IPSpscRing.h"
+#include "IPStage.h"
+
+// max number of stages in one pipeline
+#define PIPELINE_MAX_STAGES 16
+// max number of segments(threads) in one pipeline, first segment runs on the caller thread
+#define PIPELINE_MAX_SEGMENTS 4
+// default/max number of frames that can wait between segments
+#define DEFAULT_STAGE_QUEUE_DEPTH 2
+#define MAX_STAGE_QUEUE_DEPTH 8
+// pipeline that is used when the pipeline is not specified,
+// gray scale for later stages and gray scale image for callback in single pass
+#define DEFAULT_PIPELINE "gray_rgba"
+
+typedef struct stage_stats {
+	// number of frames that the stage processed
+	int64_t count;
+	// total processing time of the stage[ns]
+	int64_t total_ns;
+	// max processing time of the stage[ns]
+	int64_t max_ns;
+	// index of the segment(thread) that runs the stage, 0 is the worker thread of the scheduler
+	int64_t segment;
+	// capacity, current/max number of frames in input queue of the segment,
+	// these are zero for the stages of first segment and the stages that are not first in the segment
+	int64_t queue_capacity;
+	int64_t queue_size;
+	int64_t queue_max;
+	// sum of number of frames in input queue when each frame was queued,
+	// queue_total / count is the average occupancy
+	int64_t queue_total;
+	// number of full detections of tracking stage and the ones because tracking was lost,
+	// other full detections were scheduled by detect interval
+	int64_t detect_count;
+	int64_t fallback_count;
+} stage_stats_t;
+
+// index of stage stats in the array passed to Java, this is repeated for each stage
+#define STAGE_STATS_IX_COUNT 0
+#define STAGE_STATS_IX_TOTAL_TIME 1
+#define STAGE_STATS_IX_MAX_TIME 2
+#define STAGE_STATS_IX_SEGMENT 3
+#define STAGE_STATS_IX_QUEUE_CAPACITY 4
+#define STAGE_STATS_IX_QUEUE_SIZE 5
+#define STAGE_STATS_IX_QUEUE_MAX 6
+#define STAGE_STATS_IX_QUEUE_TOTAL 7
+#define STAGE_STATS_IX_DETECT_COUNT 8
+#define STAGE_STATS_IX_FALLBACK_COUNT 9
+#define STAGE_STATS_NUM 10
+
+using namespace android;
+
+/**
+ * receiver of the frames that passed through all stages
+ */
+class IPPipelineListener {
+public:
+	virtual ~IPPipelineListener() {};
+	/**
+	 * called for each frame in the order of the frames,
+	 * on the caller thread of IPPipeline#process or the thread of last segment
+	 * @param env JNIEnv of current thread, NULL if JavaVM is not available
+	 */
+	virtual void onPipelineResult(JNIEnv *env, stage_context_t &ctx) = 0;
+	/** called when the pipeline becomes able to accept new frame(#canAccept) */
+	virtual void onPipelineReady() {};
+};
+
+/**
+ * chain of IPStage, output of each stage is passed to next stage as its input.
+ * stages are grouped into segments, first segment runs on the caller thread of #process
+ * and each of the rest runs on its own thread, segments are connected with bounded queues
+ * so that next frame can be processed by earlier stages while later stages process
+ * current frame. frames(with their metadata and result) pass through the queues
+ * in the order that they were passed to #process.
+ * intermediate buffers are kept for each stage and reused while the frame size is same,
+ * region of interest is served as a view of the full frame size buffer so that
+ * changing it never allocates.
+ * #process, #start, #stop and #reset should be called from one thread at a time,
+ * #canAccept, #getStats, #setParameter and #getResult can be called from any thread.
+ */
+class IPPipeline {
+private:
+	// one frame that is passed through the segments
+	typedef struct stage_packet {
+		stage_context_t ctx;
+		// backing buffer of ctx.result, full frame size
+		cv::Mat result;
+		// output of the segment that is passed to next segment, view of one of handoff
+		cv::Mat data;
+		// buffers to keep output of the segment until next segment processes it
+		cv::Mat handoff[2];
+		cv::Rect prev_roi;
+		// true if one of the stage failed, rest of stages skip the frame
+		bool dropped;
+		// true if one of the stage returned STAGE_SKIP_REST,
+		// rest of stages skip the frame but its result is passed to the listener
+		bool skipped;
+	} stage_packet_t;
+
+	typedef struct segment {
+		IPPipeline *pipeline;
+		int index;
+		// range of the stages, [first, last)
+		int first, last;
+		pthread_t thread;
+	} segment_t;
+
+	const std::string mSpec;
+	const int mQueueDepth;
+	volatile bool mIsRunning;
+	IPPipelineListener *mListener;
+	std::vector<IPStage *> mStages;
+	// full frame size backing buffers of each stage
+	std::vector<cv::Mat> mBuffers;
+	// processing time of each stage for current frame, accessed only from the thread of the stage
+	std::vector<nsecs_t> mElapsed;
+	segment_t mSegments[PIPELINE_MAX_SEGMENTS];
+	int mNumSegments;
+	// mQueues[0] holds free packets, mQueues[i] is input queue of segment i
+	IPSpscRing mQueues[PIPELINE_MAX_SEGMENTS];
+	std::vector<stage_packet_t> mPackets;
+	mutable Mutex mStatsLock;
+	std::vector<stage_stats_t> mStats;
+	// results of last processed frame that are passed again for unchanged frames,
+	// accessed only from the thread of last segment
+	float mLastResults[RESULT_NUM];
+	int mLastDetectType;
+	IPPipeline(const char *spec, const int &queue_depth);
+	void addStage(IPStage *stage);
+	void addSegment();
+	void initPackets();
+	void runSegment(const int &index, stage_packet_t &packet, const cv::Mat &input);
+	void forward(JNIEnv *env, const int &index, const intptr_t &ix);
+	static void *segment_thread_func(void *vptr_args);
+	void do_segment(JNIEnv *env, const int &index);
+public:
+	virtual ~IPPipeline();
+	static IPPipeline *create(const char *spec, const int &queue_depth = DEFAULT_STAGE_QUEUE_DEPTH);
+	static IPStage *createStage(const std::string &name);
+	static int validateParameter(const std::string &stage, const std::string &key,
+		const float *values, const int &num);
+	int start(IPPipelineListener *listener);
+	void stop();
+	const bool canAccept() const;
+	int process(JNIEnv *env, stage_context_t &ctx, const cv::Mat &frame);
+	void reset();
+	int getStats(stage_stats_t *stats, const int &max_num) const;
+	int setParameter(const std::string &stage, const std::string &key, const float *values, const int &num);
+	int getResult(const std::string &stage, const std::string &key,
+		float *values, const int &max_num, int64_t &seq) const;
+	inline const int size() const { return (int)mStages.size(); };
+	inline const int segments() const { return mNumSegments; };
+	inline const char *spec() const { return mSpec.c_str(); };
+};
+
+#endif //FLIGHTDEMO_IPPIPELINE_H
@@ -0,0 +1,150 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+
+#include <stdlib.h>
+#include <math.h>
+#include <algorithm>
+
+#include "IPScanline.h"
+
+// number of refinement of fit_line_robust
+#define FIT_ITERATIONS 3
+
+/*public*/
+float scan_line_center(const uint8_t *p, const int &stride, const int &n,
+	const int &min_contrast, const int &max_width, int &strength) {
+
+	strength = 0;
+	if (n < 3) {
+		return -1;
+	}
+	// central difference, strongest rising and falling edges
+	int max_rise = 0, max_fall = 0;
+	int rise = -1, fall = -1;
+	const uint8_t *q = p + stride;
+	for (int i = 1; i < n - 1; i++, q += stride) {
+		const int g = (int)q[stride] - (int)q[-stride];
+		if (g > max_rise) {
+			max_rise = g;
+			rise = i;
+		} else if (-g > max_fall) {
+			max_fall = -g;
+			fall = i;
+		}
+	}
+	const bool has_rise = max_rise >= min_contrast;
+	const bool has_fall = max_fall >= min_contrast;
+	if (has_rise && has_fall && (abs(rise - fall) <= max_width)) {
+		strength = std::min(max_rise, max_fall);
+		return (rise + fall) * 0.5f;
+	} else if (has_rise && (max_rise >= max_fall)) {
+		strength = max_rise;
+		return (float)rise;
+	} else if (has_fall) {
+		strength = max_fall;
+		return (float)fall;
+	}
+	return -1;
+}
+
+/**
+ * orthogonal least squares of the points whose residual is not greater than max_error,
+ * all points are used if max_error is negative
+ */
+static int fit_line_lsq(const std::vector<cv::Point2f> &points,
+	const std::vector<float> &residuals, const float &max_error,
+	cv::Point2f &center, cv::Point2f &dir) {
+
+	const int n = (int)points.size();
+	double sx = 0, sy = 0;
+	int m = 0;
+	for (int i = 0; i < n; i++) {
+		if ((max_error < 0) || (residuals[i] <= max_error)) {
+			sx += points[i].x;
+			sy += points[i].y;
+			m++;
+		}
+	}
+	if (m < 2) {
+		return 0;
+	}
+	const double cx = sx / m, cy = sy / m;
+	double sxx = 0, sxy = 0, syy = 0;
+	for (int i = 0; i < n; i++) {
+		if ((max_error < 0) || (residuals[i] <= max_error)) {
+			const double dx = points[i].x - cx, dy = points[i].y - cy;
+			sxx += dx * dx;
+			sxy += dx * dy;
+			syy += dy * dy;
+		}
+	}
+	// principal axis of the covariance
+	const double theta = 0.5 * atan2(2.0 * sxy, sxx - syy);
+	center = cv::Point2f((float)cx, (float)cy);
+	dir = cv::Point2f((float)cos(theta), (float)sin(theta));
+	return m;
+}
+
+/** distance of each point from the line */
+static void line_residuals(const std::vector<cv::Point2f> &points,
+	const cv::Point2f &center, const cv::Point2f &dir, std::vector<float> &residuals) {
+
+	const int n = (int)points.size();
+	residuals.resize(n);
+	for (int i = 0; i < n; i++) {
+		const cv::Point2f d = points[i] - center;
+		residuals[i] = fabsf(d.x * dir.y - d.y * dir.x);
+	}
+}
+
+/*public*/
+int fit_line_robust(const std::vector<cv::Point2f> &points,
+	cv::Point2f &center, cv::Point2f &dir,
+	const float &max_error, std::vector<float> &work) {
+
+	int result = fit_line_lsq(points, work, -1, center, dir);
+	for (int i = 0; (result >= 2) && (i < FIT_ITERATIONS); i++) {
+		line_residuals(points, center, dir, work);
+		// first round drops gross outliers only, they pull the line too far at first
+		float threshold = max_error;
+		if (!i) {
+			// median of the residuals, second half of work is used as scratch
+			const size_t n = points.size();
+			work.resize(n * 2);
+			std::copy(work.begin(), work.begin() + n, work.begin() + n);
+			std::nth_element(work.begin() + n, work.begin() + n + n / 2, work.end());
+			threshold = std::max(max_error, 3.0f * work[n + n / 2]);
+		}
+		result = fit_line_lsq(points, work, threshold, center, dir);
+	}
+	if (result >= 2) {
+		// count inliers of the final line
+		line_residuals(points, center, dir, work);
+		result = 0;
+		for (size_t i = 0; i < points.size(); i++) {
+			if (work[i] <= max_error) result++;
+		}
+	}
+	return result;
+}
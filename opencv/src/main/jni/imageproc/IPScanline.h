@@ -0,0 +1,62 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+
+#ifndef FLIGHTDEMO_IPSCANLINE_H
+#define FLIGHTDEMO_IPSCANLINE_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "opencv2/core.hpp"
+
+/**
+ * search a line(e.g. tape on the floor) that crosses a scanline of gray scale image,
+ * the line is a pair of rising and falling edges or a single edge if the pair is not found.
+ * this only reads the scanline, so detectors can sample a narrow window instead of the whole image.
+ * @param p first pixel of the scanline
+ * @param stride distance between pixels[bytes], 1 for row and step of the image for column
+ * @param n number of pixels
+ * @param min_contrast minimum difference of the pixels across the edge
+ * @param max_width maximum width of the line[px], edges further apart are not paired
+ * @param strength contrast of weaker edge of the pair or of the single edge
+ * @return center of the line as index of the pixel, -1 if no edge found
+ */
+float scan_line_center(const uint8_t *p, const int &stride, const int &n,
+	const int &min_contrast, const int &max_width, int &strength);
+
+/**
+ * fit a line to the points by orthogonal least squares,
+ * points further than max_error from the line are excluded and the line is fitted again.
+ * @param points sampled points, this is not changed
+ * @param center point on the line(centroid of inliers)
+ * @param dir unit vector along the line
+ * @param max_error maximum distance of inliers from the line[px]
+ * @param work buffer of residuals that is reused between calls
+ * @return number of inliers, 0 if the line can't be fitted(less than 2 points)
+ */
+int fit_line_robust(const std::vector<cv::Point2f> &points,
+	cv::Point2f &center, cv::Point2f &dir,
+	const float &max_error, std::vector<float> &work);
+
+#endif //FLIGHTDEMO_IPSCANLINE_H
@@ -0,0 +1,418 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+
+#if 1	// set 0 to enable debug output, otherwise set 1
+	#ifndef LOG_NDEBUG
+		#define	LOG_NDEBUG		// disable LOGV/LOGD/MARK
+	#endif
+	#undef USE_LOGALL			// enable specific LOGx only
+#else
+//	#define USE_LOGALL
+	#define USE_LOGD
+	#undef LOG_NDEBUG
+	#undef NDEBUG
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <limits.h>
+#include <time.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <algorithm>
+
+#include "utilbase.h"
+#include "common_utils.h"
+
+#include "IPScheduler.h"
+
+// max waiting time of worker thread when no client has frame[ns],
+// frame sources always signal, so this is just for safety
+#define MAX_WAIT_NS 100000000LL
+
+/** get process-wide instance */
+/*public static*/
+IPScheduler &IPScheduler::getInstance() {
+	static IPScheduler instance;
+	return instance;
+}
+
+IPScheduler::IPScheduler()
+: mSignalSeq(0),
+  mIdleWorkers(0),
+  mNumThreads(0),
+  mRequestThreads(0),
+  mIsRunning(false),
+  mIsStopping(false) {
+
+	ENTER();
+
+	memset(&mRemovedStats, 0, sizeof(mRemovedStats));
+
+	EXIT();
+}
+
+IPScheduler::~IPScheduler() {
+	ENTER();
+
+	stopThreads();
+
+	EXIT();
+}
+
+/**
+ * set number of worker threads, zero or negative means number of cpu cores.
+ * this is applied when worker threads start next time(i.e. when no client is added)
+ */
+/*public*/
+void IPScheduler::setNumThreads(const int &num_threads) {
+	ENTER();
+
+	Mutex::Autolock lock(mLock);
+	mRequestThreads = num_threads;
+
+	EXIT();
+}
+
+/**
+ * add client, worker threads are started if this is the first client
+ * @param priority larger value is served first
+ * @param budget_fps max number of frames per second that are processed for this client,
+ *                   zero or negative means unlimited
+ */
+/*public*/
+int IPScheduler::add(IPSchedulerClient *client, const int &priority, const float &budget_fps) {
+	ENTER();
+
+	int result = -1;
+	Mutex::Autolock lock(mLock);
+	for ( ; mIsStopping ; ) {
+		// previous worker threads are being terminated by #remove of the last client
+		mSync.wait(mLock);
+	}
+	if (LIKELY(client && !find(client))) {
+		scheduler_client_t c;
+		memset(&c, 0, sizeof(c));
+		c.client = client;
+		c.priority = priority;
+		c.interval_ns = budget_fps > 0 ? (nsecs_t)(1000000000.0 / budget_fps) : 0;
+		mClients.push_back(c);
+		if (!mIsRunning) {
+			startThreads();
+		}
+		result = 0;
+	}
+
+	RETURN(result, int);
+}
+
+/**
+ * remove client, this waits until worker thread finishes processing of the client.
+ * worker threads are terminated if this is the last client.
+ * never call this on worker thread.
+ */
+/*public*/
+void IPScheduler::remove(IPSchedulerClient *client) {
+	ENTER();
+
+	mLock.lock();
+	{
+		for (scheduler_client_t *c = find(client); c && c->busy; c = find(client)) {
+			mSync.wait(mLock);
+		}
+		for (std::vector<scheduler_client_t>::iterator itr = mClients.begin(); itr != mClients.end(); itr++) {
+			if ((*itr).client == client) {
+				mRemovedStats.processed += (*itr).stats.processed;
+				mRemovedStats.busy_ns += (*itr).stats.busy_ns;
+				mClients.erase(itr);
+				break;
+			}
+		}
+	}
+	const bool last = mClients.empty();
+	mLock.unlock();
+	if (last) {
+		stopThreads();
+	}
+
+	EXIT();
+}
+
+/**
+ * change priority and frame budget of the client, this can be called anytime
+ */
+/*public*/
+int IPScheduler::setPriority(IPSchedulerClient *client, const int &priority, const float &budget_fps) {
+	ENTER();
+
+	int result = -1;
+	Mutex::Autolock lock(mLock);
+	scheduler_client_t *c = find(client);
+	if (LIKELY(c)) {
+		c->priority = priority;
+		c->interval_ns = budget_fps > 0 ? (nsecs_t)(1000000000.0 / budget_fps) : 0;
+		c->next_time_ns = 0;
+		wakeWorkers(INT_MAX);
+		result = 0;
+	}
+
+	RETURN(result, int);
+}
+
+static inline void futex_wait(volatile int *addr, const int &value, const nsecs_t &timeout_ns) {
+	struct timespec ts;
+	ts.tv_sec = (time_t)(timeout_ns / 1000000000LL);
+	ts.tv_nsec = (long)(timeout_ns % 1000000000LL);
+	syscall(__NR_futex, addr, FUTEX_WAIT_PRIVATE, value, &ts, NULL, 0);
+}
+
+static inline void futex_wake(volatile int *addr, const int &num) {
+	syscall(__NR_futex, addr, FUTEX_WAKE_PRIVATE, num, NULL, NULL, 0);
+}
+
+/**
+ * notify that client(s) may have new frame, call this after frame was queued.
+ * this is called for every frame, so this takes no lock and
+ * enters kernel only when worker thread is waiting
+ */
+/*public*/
+void IPScheduler::signal() {
+	wakeWorkers(1);
+}
+
+/**
+ * advance mSignalSeq and wake up to num idle worker threads, this can be called with or without mLock.
+ * worker thread increments mIdleWorkers before it checks mSignalSeq,
+ * both are full barriers, so either worker thread sees new sequence number or we see it waiting.
+ */
+/*private*/
+void IPScheduler::wakeWorkers(const int &num) {
+	__sync_fetch_and_add(&mSignalSeq, 1);
+	if (__sync_fetch_and_add(&mIdleWorkers, 0) > 0) {
+		futex_wake(&mSignalSeq, num);
+	}
+}
+
+/**
+ * get stats of the client and aggregate stats of all clients since worker threads started
+ * @param client can be NULL if you need only aggregate stats
+ */
+/*public*/
+int IPScheduler::getStats(IPSchedulerClient *client, scheduler_stats_t &client_stats,
+	scheduler_stats_t &total_stats, int &num_threads, int &num_clients) const {
+
+	ENTER();
+
+	int result = -1;
+	Mutex::Autolock lock(mLock);
+	memset(&client_stats, 0, sizeof(client_stats));
+	total_stats = mRemovedStats;
+	for (std::vector<scheduler_client_t>::const_iterator itr = mClients.begin(); itr != mClients.end(); itr++) {
+		total_stats.processed += (*itr).stats.processed;
+		total_stats.busy_ns += (*itr).stats.busy_ns;
+		if ((*itr).client == client) {
+			client_stats = (*itr).stats;
+			result = 0;
+		}
+	}
+	num_threads = mNumThreads;
+	num_clients = (int)mClients.size();
+
+	RETURN(client ? result : 0, int);
+}
+
+/** call this with mLock held */
+/*private*/
+IPScheduler::scheduler_client_t *IPScheduler::find(IPSchedulerClient *client) {
+	for (std::vector<scheduler_client_t>::iterator itr = mClients.begin(); itr != mClients.end(); itr++) {
+		if ((*itr).client == client) {
+			return &(*itr);
+		}
+	}
+	return NULL;
+}
+
+/**
+ * select client to process next, call this with mLock held.
+ * return NULL if no client can be served now,
+ * in that case wait_ns is set to the time until the client becomes within its frame budget.
+ */
+/*private*/
+IPScheduler::scheduler_client_t *IPScheduler::next(const nsecs_t &now, nsecs_t &wait_ns) {
+	scheduler_client_t *result = NULL;
+	wait_ns = MAX_WAIT_NS;
+	for (std::vector<scheduler_client_t>::iterator itr = mClients.begin(); itr != mClients.end(); itr++) {
+		scheduler_client_t &c = *itr;
+		if (c.busy || !c.client->hasFrame()) continue;
+		if (c.next_time_ns > now) {
+			// over frame budget
+			wait_ns = std::min(wait_ns, c.next_time_ns - now);
+			continue;
+		}
+		if (!result || (c.priority > result->priority)
+			|| ((c.priority == result->priority) && (c.last_served_ns < result->last_served_ns))) {
+			result = &c;
+		}
+	}
+	return result;
+}
+
+/** call this with mLock held */
+/*private*/
+void IPScheduler::startThreads() {
+	ENTER();
+
+	int num = mRequestThreads > 0 ? mRequestThreads : (int)sysconf(_SC_NPROCESSORS_ONLN);
+	num = std::min(std::max(num, 1), SCHEDULER_MAX_THREADS);
+	// stats are since worker threads started
+	memset(&mRemovedStats, 0, sizeof(mRemovedStats));
+	mIsRunning = true;
+	mNumThreads = 0;
+	for (int i = 0; i < num; i++) {
+		if (UNLIKELY(pthread_create(&mThreads[mNumThreads], NULL, worker_thread_func, (void *)this))) {
+			LOGE("pthread_create failed");
+			break;
+		}
+		mNumThreads++;
+	}
+	LOGI("started %d worker threads", mNumThreads);
+
+	EXIT();
+}
+
+/*private*/
+void IPScheduler::stopThreads() {
+	ENTER();
+
+	pthread_t threads[SCHEDULER_MAX_THREADS];
+	int num;
+	mLock.lock();
+	{
+		// client may be added again before we get the lock,
+		// or other thread may be already terminating worker threads
+		if (!mClients.empty() || !mIsRunning) {
+			mLock.unlock();
+			EXIT();
+		}
+		mIsRunning = false;
+		mIsStopping = true;
+		num = mNumThreads;
+		memcpy(threads, mThreads, sizeof(pthread_t) * num);
+		mNumThreads = 0;
+		wakeWorkers(INT_MAX);
+	}
+	mLock.unlock();
+	for (int i = 0; i < num; i++) {
+		if (pthread_join(threads[i], NULL) != EXIT_SUCCESS) {
+			LOGW("terminate worker thread: pthread_join failed");
+		}
+	}
+	mLock.lock();
+	{
+		mIsStopping = false;
+		// wake up #add that is waiting for termination
+		mSync.broadcast();
+	}
+	mLock.unlock();
+
+	EXIT();
+}
+
+/** static member thread function */
+/*private*/
+void *IPScheduler::worker_thread_func(void *vptr_args) {
+	ENTER();
+
+	IPScheduler *scheduler = reinterpret_cast<IPScheduler *>(vptr_args);
+	if (LIKELY(scheduler)) {
+		// attach to JavaVM only once for each worker thread
+		JavaVM *vm = getVM();
+		if (LIKELY(vm)) {
+			JNIEnv *env;
+			vm->AttachCurrentThread(&env, NULL);
+			CHECK(env);
+			scheduler->do_work(env);
+			vm->DetachCurrentThread();
+		} else {
+			// without Java(e.g. host build)
+			scheduler->do_work(NULL);
+		}
+	}
+
+	PRE_EXIT();
+	pthread_exit(NULL);
+}
+
+/*private*/
+void IPScheduler::do_work(JNIEnv *env) {
+	ENTER();
+
+	mLock.lock();
+	for ( ; mIsRunning ; ) {
+		// read sequence number before checking clients, #signal after this wakes us up
+		const int seq = __sync_fetch_and_add(&mSignalSeq, 0);
+		nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC);
+		nsecs_t wait_ns;
+		scheduler_client_t *c = next(now, wait_ns);
+		if (!c) {
+			__sync_fetch_and_add(&mIdleWorkers, 1);
+			mLock.unlock();
+			{
+				// returns immediately if #signal was called after we read seq
+				futex_wait(&mSignalSeq, seq, wait_ns);
+			}
+			mLock.lock();
+			__sync_fetch_and_sub(&mIdleWorkers, 1);
+			continue;
+		}
+		IPSchedulerClient *client = c->client;
+		c->busy = true;
+		c->last_served_ns = now;
+		if (c->interval_ns) {
+			// keep average rate within budget, allow jitter of half interval
+			// but do not accumulate credit while idle
+			c->next_time_ns = std::max(c->next_time_ns, now - c->interval_ns / 2) + c->interval_ns;
+		}
+		mLock.unlock();
+		{
+			client->processFrame(env);
+		}
+		mLock.lock();
+		// vector may be re-allocated while unlocked
+		c = find(client);
+		if (LIKELY(c)) {
+			const nsecs_t t = systemTime(SYSTEM_TIME_MONOTONIC);
+			c->busy = false;
+			c->stats.processed++;
+			c->stats.busy_ns += t - now;
+		}
+		// the client may be waiting in #remove,
+		// other frames of this client are processed by this thread in next loop
+		mSync.broadcast();
+	}
+	mLock.unlock();
+
+	EXIT();
+}
@@ -0,0 +1,137 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+
+#ifndef FLIGHTDEMO_IPSCHEDULER_H
+#define FLIGHTDEMO_IPSCHEDULER_H
+
+#include <pthread.h>
+#include <vector>
+#include <jni.h>
+
+#include "Mutex.h"
+#include "Condition.h"
+#include "Timers.h"
+
+// upper limit of number of worker threads that are shared by all ImageProcessor instances
+#define SCHEDULER_MAX_THREADS 8
+// default priority of the client, larger value is served first
+#define SCHEDULER_DEFAULT_PRIORITY 0
+
+typedef struct scheduler_stats {
+	// number of frames that were processed
+	int64_t processed;
+	// total time that worker threads spent in processing[ns]
+	int64_t busy_ns;
+} scheduler_stats_t;
+
+// index of scheduler stats in the array passed to Java,
+// first 2 are per client(camera), rest are aggregate of all clients
+#define SCHEDULER_STATS_IX_PROCESSED 0
+#define SCHEDULER_STATS_IX_BUSY_TIME 1
+#define SCHEDULER_STATS_IX_TOTAL_PROCESSED 2
+#define SCHEDULER_STATS_IX_TOTAL_BUSY_TIME 3
+#define SCHEDULER_STATS_IX_THREADS 4
+#define SCHEDULER_STATS_IX_CLIENTS 5
+#define SCHEDULER_STATS_NUM 6
+
+using namespace android;
+
+/**
+ * interface of the client that is processed by IPScheduler(e.g. ImageProcessor for each camera)
+ */
+class IPSchedulerClient {
+public:
+	virtual ~IPSchedulerClient() {};
+	/** whether or not the client has frame to process now, called with lock of the scheduler */
+	virtual bool hasFrame() = 0;
+	/** process one frame, never called simultaneously for same client */
+	virtual void processFrame(JNIEnv *env) = 0;
+};
+
+/**
+ * process-wide scheduler that processes frames of multiple clients on
+ * bounded number of shared worker threads instead of one thread per client.
+ * the client with highest priority that has frame and is within its frame budget is served first,
+ * clients with same priority are served round-robin.
+ * each client is processed by at most one worker thread at a time so that
+ * processing of the client does not need to be thread safe.
+ * worker threads are started when first client is added and terminated when last one is removed.
+ */
+class IPScheduler {
+private:
+	typedef struct scheduler_client {
+		IPSchedulerClient *client;
+		int priority;
+		// min interval between frames from budget[ns], zero means unlimited
+		nsecs_t interval_ns;
+		// the client is not served until this time because of its frame budget
+		nsecs_t next_time_ns;
+		// last time the client was served, for round-robin
+		nsecs_t last_served_ns;
+		// being processed by worker thread
+		bool busy;
+		scheduler_stats_t stats;
+	} scheduler_client_t;
+
+	mutable Mutex mLock;
+	// signalled when client becomes idle or worker threads terminated, for #remove and #add
+	Condition mSync;
+	// incremented on every #signal, idle worker threads wait on this as futex word
+	// so that #signal never takes mLock
+	volatile int mSignalSeq;
+	// number of worker threads that are waiting on mSignalSeq
+	volatile int mIdleWorkers;
+	std::vector<scheduler_client_t> mClients;
+	pthread_t mThreads[SCHEDULER_MAX_THREADS];
+	int mNumThreads;
+	int mRequestThreads;
+	volatile bool mIsRunning;
+	// worker threads are being joined without mLock, #add waits until they terminated
+	// so that they never see mIsRunning of next generation
+	bool mIsStopping;
+	// stats of clients that were already removed
+	scheduler_stats_t mRemovedStats;
+
+	IPScheduler();
+	~IPScheduler();
+	static void *worker_thread_func(void *vptr_args);
+	void do_work(JNIEnv *env);
+	scheduler_client_t *find(IPSchedulerClient *client);
+	scheduler_client_t *next(const nsecs_t &now, nsecs_t &wait_ns);
+	void startThreads();
+	void stopThreads();
+	void wakeWorkers(const int &num);
+public:
+	static IPScheduler &getInstance();
+	void setNumThreads(const int &num_threads);
+	int add(IPSchedulerClient *client,
+		const int &priority = SCHEDULER_DEFAULT_PRIORITY, const float &budget_fps = 0.0f);
+	void remove(IPSchedulerClient *client);
+	int setPriority(IPSchedulerClient *client, const int &priority, const float &budget_fps);
+	void signal();
+	int getStats(IPSchedulerClient *client, scheduler_stats_t &client_stats,
+		scheduler_stats_t &total_stats, int &num_threads, int &num_clients) const;
+};
+
+#endif //FLIGHTDEMO_IPSCHEDULER_H
@@ -0,0 +1,190 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+#ifndef FLIGHTDEMO_IPSPSCRING_H
+#define FLIGHTDEMO_IPSPSCRING_H
+
+#include <stdint.h>
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#include "utilbase.h"
+#include "Timers.h"
+
+// max number of values in the ring, should be power of 2
+#define SPSC_RING_MAX_CAPACITY 128
+#define SPSC_RING_CACHE_LINE 64
+
+/**
+ * fixed capacity lock-free ring of integer values(index/pointer)
+ * between single producer thread and single consumer thread.
+ * #push should be called only from producer thread,
+ * #pop can be called from consumer thread and also from producer thread
+ * to evict the oldest value, because #pop advances tail with compare-and-swap.
+ * waiting is done with futex only when ring is empty/full,
+ * so #push/#pop never enter the kernel while nobody is waiting.
+ * This class does not allocate any memory and does not depend on OpenCV.
+ */
+class IPSpscRing {
+private:
+	// padding to keep producer side and consumer side on different cache lines
+	// without relying on extended alignment of operator new
+	uint8_t mPad0[SPSC_RING_CACHE_LINE];
+	// written by producer only
+	volatile uint32_t mHead;
+	// sequence number incremented on every push, used as futex word
+	volatile int mPushSeq;
+	volatile int mPopWaiters;
+	uint8_t mPad1[SPSC_RING_CACHE_LINE];
+	// advanced by consumer(and producer when it evicts)
+	volatile uint32_t mTail;
+	// sequence number incremented on every pop, used as futex word
+	volatile int mPopSeq;
+	volatile int mPushWaiters;
+	uint8_t mPad2[SPSC_RING_CACHE_LINE];
+	int mCapacity;
+	volatile intptr_t mValues[SPSC_RING_MAX_CAPACITY];
+
+	static inline void futex_wait(volatile int *addr, const int &value, const nsecs_t &timeout_ns) {
+		if (timeout_ns >= 0) {
+			struct timespec ts;
+			ts.tv_sec = (time_t)(timeout_ns / 1000000000LL);
+			ts.tv_nsec = (long)(timeout_ns % 1000000000LL);
+			syscall(__NR_futex, addr, FUTEX_WAIT_PRIVATE, value, &ts, NULL, 0);
+		} else {
+			syscall(__NR_futex, addr, FUTEX_WAIT_PRIVATE, value, NULL, NULL, 0);
+		}
+	}
+	static inline void futex_wake(volatile int *addr) {
+		syscall(__NR_futex, addr, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+	}
+public:
+	IPSpscRing() : mHead(0), mPushSeq(0), mPopWaiters(0),
+		mTail(0), mPopSeq(0), mPushWaiters(0), mCapacity(SPSC_RING_MAX_CAPACITY) {};
+
+	/**
+	 * set capacity and clear the ring,
+	 * this is not thread safe, call this while nobody accesses the ring
+	 * @param capacity [1, SPSC_RING_MAX_CAPACITY]
+	 */
+	inline void init(const int &capacity) {
+		mCapacity = capacity < 1 ? 1
+			: (capacity > SPSC_RING_MAX_CAPACITY ? SPSC_RING_MAX_CAPACITY : capacity);
+		clear();
+	};
+	/** this is not thread safe, call this while nobody accesses the ring */
+	inline void clear() {
+		mHead = mTail = 0;
+		__sync_synchronize();
+	};
+
+	inline const int capacity() const { return mCapacity; };
+	inline const int size() const {
+		const uint32_t tail = mTail;
+		__sync_synchronize();
+		return (int)(mHead - tail);
+	};
+	inline const bool empty() const { return size() <= 0; };
+
+	/**
+	 * append value, call this only from producer thread
+	 * @return false if the ring is full
+	 */
+	inline bool push(const intptr_t &value) {
+		const uint32_t head = mHead;
+		if (UNLIKELY((int)(head - mTail) >= mCapacity)) {
+			return false;
+		}
+		mValues[head & (SPSC_RING_MAX_CAPACITY - 1)] = value;
+		// publish the value before advancing head
+		__sync_synchronize();
+		mHead = head + 1;
+		__sync_fetch_and_add(&mPushSeq, 1);	// this is also full barrier
+		if (UNLIKELY(mPushWaiters)) {
+			futex_wake(&mPushSeq);
+		}
+		return true;
+	};
+
+	/**
+	 * remove the oldest value, safe to call from both of producer and consumer
+	 * @return false if the ring is empty
+	 */
+	inline bool pop(intptr_t &value) {
+		for ( ; ; ) {
+			const uint32_t tail = mTail;
+			__sync_synchronize();
+			if (tail == mHead) {
+				return false;
+			}
+			const intptr_t v = mValues[tail & (SPSC_RING_MAX_CAPACITY - 1)];
+			// the value is valid only when we win the race to advance tail
+			if (__sync_bool_compare_and_swap(&mTail, tail, tail + 1)) {
+				value = v;
+				break;
+			}
+		}
+		__sync_fetch_and_add(&mPopSeq, 1);	// this is also full barrier
+		if (UNLIKELY(mPopWaiters)) {
+			futex_wake(&mPopSeq);
+		}
+		return true;
+	};
+
+	inline const int pushSeq() const { return mPushSeq; };
+	inline const int popSeq() const { return mPopSeq; };
+	/**
+	 * block until something is pushed after #pushSeq returned seq
+	 * @param timeout_ns negative value means infinite
+	 */
+	inline void waitPush(const int &seq, const nsecs_t &timeout_ns = -1) {
+		__sync_fetch_and_add(&mPushWaiters, 1);
+		if (mPushSeq == seq) {
+			futex_wait(&mPushSeq, seq, timeout_ns);
+		}
+		__sync_fetch_and_sub(&mPushWaiters, 1);
+	};
+	/**
+	 * block until something is popped after #popSeq returned seq
+	 * @param timeout_ns negative value means infinite
+	 */
+	inline void waitPop(const int &seq, const nsecs_t &timeout_ns = -1) {
+		__sync_fetch_and_add(&mPopWaiters, 1);
+		if (mPopSeq == seq) {
+			futex_wait(&mPopSeq, seq, timeout_ns);
+		}
+		__sync_fetch_and_sub(&mPopWaiters, 1);
+	};
+	/** wake up all threads waiting on this ring(e.g. when terminating) */
+	inline void wakeAll() {
+		__sync_fetch_and_add(&mPushSeq, 1);
+		__sync_fetch_and_add(&mPopSeq, 1);
+		futex_wake(&mPushSeq);
+		futex_wake(&mPopSeq);
+	};
+};
+
+#endif //FLIGHTDEMO_IPSPSCRING_H
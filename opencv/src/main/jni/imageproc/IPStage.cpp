@@ -0,0 +1,74 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+
+#if 1	// set 0 to enable debug output, otherwise set 1
+	#ifndef LOG_NDEBUG
+		#define	LOG_NDEBUG		// disable LOGV/LOGD/MARK
+	#endif
+	#undef USE_LOGALL			// enable specific LOGx only
+#else
+//	#define USE_LOGALL
+	#define USE_LOGD
+	#undef LOG_NDEBUG
+	#undef NDEBUG
+#endif
+
+#include "utilbase.h"
+
+#include "IPColorKernels.h"
+#include "IPStage.h"
+
+IPStage::IPStage(const char *name)
+: mName(name ? name : "") {
+
+	ENTER();
+
+	EXIT();
+}
+
+IPStage::~IPStage() {
+	ENTER();
+
+	EXIT();
+}
+
+/**
+ * write rows of 1 channel(gray scale) or 4 channels(RGBA) image into
+ * same rows of dst that is RGBA or gray scale, converting its format if they are different
+ */
+/*public static*/
+void IPStage::writeImage(const cv::Mat &src, cv::Mat &dst, const cv::Range &rows) {
+	const int cols = src.cols;
+	if (src.type() == dst.type()) {
+		src.rowRange(rows).copyTo(dst.rowRange(rows));
+	} else if (src.channels() == 1) {
+		for (int y = rows.start; y < rows.end; y++) {
+			gray_to_rgba(src.ptr<uint8_t>(y), dst.ptr<uint8_t>(y), cols);
+		}
+	} else {
+		for (int y = rows.start; y < rows.end; y++) {
+			rgba_to_gray_rgba(src.ptr<uint8_t>(y), dst.ptr<uint8_t>(y), NULL, cols);
+		}
+	}
+}
@@ -0,0 +1,155 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+
+#ifndef FLIGHTDEMO_IPSTAGE_H
+#define FLIGHTDEMO_IPSTAGE_H
+
+#include <string>
+
+#include "IPBase.h"
+#include "IPFrame.h"
+
+/**
+ * context of the frame that is passed through all stages of IPPipeline
+ */
+typedef struct stage_context {
+	// metadata of the frame
+	frame_info_t info;
+	// size of the full frame
+	int width, height;
+	// region of the full frame that the frame contains, same as roi_xxx of info
+	cv::Rect roi;
+	// time when the frame was dequeued from frame queue[ns]
+	nsecs_t dequeued_time_ns;
+	// RESULT_FRAME_TYPE_XXX
+	int result_frame_type;
+	// RESULT_FORMAT_XXX, type of result
+	int result_format;
+	// values passed to Java, stages attach their results here, cleared for each frame
+	float results[RESULT_NUM];
+	// DetectType of results that is passed to Java with them, TYPE_NON if nothing detected
+	int detect_type;
+	// image passed to Java, this is full frame size(RGBA or gray scale, see result_format)
+	// and only the region of interest is updated.
+	// this is empty for RESULT_FRAME_TYPE_NON and can be the frame itself for RESULT_FRAME_TYPE_SRC,
+	// so stages should check #writes_result/#draws_overlay before writing into this
+	cv::Mat result;
+	// allocator that stages should use for their buffers
+	cv::MatAllocator *allocator;
+	// true if the frame is same as last processed frame, stages are skipped
+	// and last results are passed again without result image
+	bool unchanged;
+} stage_context_t;
+
+/** whether or not stages should write processed image into ctx.result(RESULT_FRAME_TYPE_DST/DST_LINE) */
+static inline bool writes_result(const stage_context_t &ctx) {
+	return ((ctx.result_frame_type == RESULT_FRAME_TYPE_DST)
+		|| (ctx.result_frame_type == RESULT_FRAME_TYPE_DST_LINE)) && !ctx.result.empty();
+}
+
+/** whether or not stages should draw overlay into ctx.result(RESULT_FRAME_TYPE_XXX_LINE) */
+static inline bool draws_overlay(const stage_context_t &ctx) {
+	return ((ctx.result_frame_type == RESULT_FRAME_TYPE_SRC_LINE)
+		|| (ctx.result_frame_type == RESULT_FRAME_TYPE_DST_LINE)) && !ctx.result.empty();
+}
+
+// return value of IPStage#process to skip rest of stages, e.g. no motion in the frame
+#define STAGE_SKIP_REST 1
+
+/**
+ * processing stage of IPPipeline, this takes cv::Mat in and produces cv::Mat out.
+ * stages are called only from one worker thread at a time,
+ * so they can keep buffers between frames without lock.
+ * parameters and results that are specific to the stage are set/read by their key
+ * through #setParameter/#getResult, these are called from other threads(e.g. Java)
+ * and the stage guards them by itself.
+ */
+class IPStage : virtual public IPBase {
+private:
+	const std::string mName;
+protected:
+	IPStage(const char *name);
+public:
+	virtual ~IPStage();
+	/**
+	 * type of the image that this stage outputs for the input type(e.g. CV_8UC1),
+	 * IPPipeline prepares dst of this type and same size as src from its reusable buffer,
+	 * return -1 if this stage prepares dst by itself(e.g. different size or pass through src)
+	 */
+	virtual int outputType(const int &src_type) const { return -1; };
+	/**
+	 * process one frame
+	 * @param ctx context of the frame, stages can attach their results to it
+	 * @param src output of previous stage or the frame itself for the first stage
+	 * @param dst output of this stage that is passed to next stage
+	 * return 0 if next stage should continue, STAGE_SKIP_REST if rest of stages are not needed
+	 * for this frame(results are still passed to Java), otherwise the frame is dropped
+	 */
+	virtual int process(stage_context_t &ctx, const cv::Mat &src, cv::Mat &dst) = 0;
+	/**
+	 * whether or not this stage is per-pixel processing that can be split into horizontal tiles,
+	 * if true, IPPipeline calls #processTile for the tiles on WorkStealingPool instead of #process
+	 */
+	virtual bool isTileParallel() const { return false; };
+	/**
+	 * process rows of src into same rows of dst, this is called simultaneously for disjoint rows.
+	 * dst is prepared by IPPipeline(see #outputType) or empty that means src is passed through
+	 */
+	virtual void processTile(stage_context_t &ctx,
+		const cv::Mat &src, cv::Mat &dst, const cv::Range &rows) {};
+	/** release buffers, called when the pipeline is released or the frame size changed */
+	virtual void reset() {};
+	/**
+	 * number of full detections and the ones that tracking was lost(see IPTrackingStage),
+	 * zero for the stages that do not detect anything
+	 */
+	virtual void getDetectStats(int64_t &detect_count, int64_t &fallback_count) const {
+		detect_count = fallback_count = 0;
+	};
+	/**
+	 * set parameter of this stage, this can be called from any thread while processing
+	 * and the stage applies it from next frame
+	 * @param key name of the parameter, e.g. "detect_interval"
+	 * @param values values of the parameter
+	 * @param num number of the values
+	 * return 0 on success, -1 if the stage does not have the parameter or values are invalid
+	 */
+	virtual int setParameter(const std::string &key, const float *values, const int &num) { return -1; };
+	/**
+	 * copy latest result of this stage that does not fit in stage_context_t#results(e.g. dense flow),
+	 * this can be called from any thread
+	 * @param key name of the result, e.g. "flow"
+	 * @param values only first max_num values are copied if the result is larger
+	 * @param seq sequence number of the frame of the result
+	 * return number of the values of the result, 0 if there is no result yet,
+	 * -1 if the stage does not have the result
+	 */
+	virtual int getResult(const std::string &key, float *values, const int &max_num, int64_t &seq) const {
+		return -1;
+	};
+	inline const char *name() const { return mName.c_str(); };
+	static void writeImage(const cv::Mat &src, cv::Mat &dst, const cv::Range &rows);
+};
+
+#endif //FLIGHTDEMO_IPSTAGE_H
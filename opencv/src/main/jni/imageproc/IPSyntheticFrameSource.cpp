@@ -0,0 +1,284 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+#if 1	// set 0 to enable debug output, otherwise set 1
+	#ifndef LOG_NDEBUG
+		#define	LOG_NDEBUG		// disable LOGV/LOGD/MARK
+	#endif
+	#undef USE_LOGALL			// enable specific LOGx only
+#else
+//	#define USE_LOGALL
+	#define USE_LOGD
+	#undef LOG_NDEBUG
+	#undef NDEBUG
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "utilbase.h"
+
+#include "IPSyntheticFrameSource.h"
+
+// max number of frames that are loaded from raw RGBA file
+#define MAX_LOAD_FRAMES 300
+// interval to retry when frame queue is full[us]
+#define RETRY_INTERVAL_US 500
+
+IPSyntheticFrameSource::IPSyntheticFrameSource(IPFrame &frame, const char *path, const float &fps,
+	const bool &luma_only)
+: IPFrameSource(frame, luma_only),
+  mPath(path ? path : ""),
+  mFps(fps),
+  mRecordedFormat(PIXEL_FORMAT_RGBA),
+  mIsRunning(false) {
+
+	ENTER();
+
+	EXIT();
+}
+
+IPSyntheticFrameSource::~IPSyntheticFrameSource() {
+	ENTER();
+
+	release();
+
+	EXIT();
+}
+
+int IPSyntheticFrameSource::init(const int &width, const int &height) {
+	ENTER();
+
+	int result = -1;
+	if (!mIsRunning) {
+		IPFrameSource::init(width, height);
+		loadFrames();
+		mIsRunning = true;
+		result = pthread_create(&source_thread, NULL, source_thread_func, (void *)this);
+		if (UNLIKELY(result)) {
+			LOGE("pthread_create failed:%d", result);
+			mIsRunning = false;
+		}
+	}
+
+	RETURN(result, int);
+}
+
+void IPSyntheticFrameSource::release() {
+	ENTER();
+
+	if (mIsRunning) {
+		mIsRunning = false;
+		if (pthread_join(source_thread, NULL) != EXIT_SUCCESS) {
+			LOGW("terminate source thread: pthread_join failed");
+		}
+	}
+	mImages.clear();
+	mRecorded.clear();
+	IPFrameSource::release();
+
+	EXIT();
+}
+
+static bool has_ext(const std::string &path, const char *ext) {
+	const size_t len = strlen(ext);
+	return (path.size() > len) && !path.compare(path.size() - len, len, ext);
+}
+
+/**
+ * load frames from file, return number of loaded frames
+ */
+/*private*/
+int IPSyntheticFrameSource::loadFrames() {
+	ENTER();
+
+	mImages.clear();
+	mRecorded.clear();
+	if (mPath.empty()) {
+		RETURN(0, int);
+	}
+	if (has_ext(mPath, ".yuyv")) {
+		RETURN(loadRecorded(PIXEL_FORMAT_YUYV), int);
+	} else if (has_ext(mPath, ".nv21")) {
+		RETURN(loadRecorded(PIXEL_FORMAT_NV21), int);
+	} else if (has_ext(mPath, ".mjpeg") || has_ext(mPath, ".mjpg")) {
+		RETURN(loadRecorded(PIXEL_FORMAT_MJPEG), int);
+	}
+	if (has_ext(mPath, ".rgba")) {
+
+		// raw RGBA frames with processing size
+		FILE *fp = fopen(mPath.c_str(), "rb");
+		if (LIKELY(fp)) {
+			for (int i = 0; i < MAX_LOAD_FRAMES; i++) {
+				cv::Mat image(mHeight, mWidth, CV_8UC4);
+				if (fread(image.data, image.total() * image.elemSize(), 1, fp) != 1) break;
+				mImages.push_back(image);
+			}
+			fclose(fp);
+		} else {
+			LOGW("failed to open %s", mPath.c_str());
+		}
+	} else {
+		cv::Mat bgr = cv::imread(mPath, cv::IMREAD_COLOR);
+		if (LIKELY(!bgr.empty())) {
+			cv::Mat image;
+			cv::resize(bgr, bgr, cv::Size(mWidth, mHeight), 0, 0, cv::INTER_AREA);
+			cv::cvtColor(bgr, image, cv::COLOR_BGR2RGBA);
+			mImages.push_back(image);
+		} else {
+			LOGW("failed to load %s", mPath.c_str());
+		}
+	}
+
+	RETURN((int)mImages.size(), int);
+}
+
+/**
+ * load recorded raw frames, return number of loaded frames
+ * @param format PIXEL_FORMAT_YUYV or PIXEL_FORMAT_NV21 with processing size,
+ *               or PIXEL_FORMAT_MJPEG(concatenated JPEG images)
+ */
+/*private*/
+int IPSyntheticFrameSource::loadRecorded(const int &format) {
+	ENTER();
+
+	mRecordedFormat = format;
+	FILE *fp = fopen(mPath.c_str(), "rb");
+	if (UNLIKELY(!fp)) {
+		LOGW("failed to open %s", mPath.c_str());
+		RETURN(0, int);
+	}
+	if (format == PIXEL_FORMAT_MJPEG) {
+		std::vector<uint8_t> data;
+		uint8_t buf[4096];
+		for (size_t n; (n = fread(buf, 1, sizeof(buf), fp)) > 0; ) {
+			data.insert(data.end(), buf, buf + n);
+		}
+		// split at SOI(FFD8)...EOI(FFD9) markers,
+		// 0xFF in entropy-coded data is always followed by 0x00 or RSTn
+		size_t start = 0;
+		for (size_t i = 0; (i + 1 < data.size()) && (mRecorded.size() < MAX_LOAD_FRAMES); i++) {
+			if (data[i] != 0xff) continue;
+			if (data[i + 1] == 0xd8) {
+				start = i;
+			} else if (data[i + 1] == 0xd9) {
+				mRecorded.push_back(std::vector<uint8_t>(data.begin() + start, data.begin() + i + 2));
+			}
+		}
+	} else {
+		const size_t bytes = format == PIXEL_FORMAT_YUYV
+			? (size_t)mWidth * mHeight * 2 : (size_t)mWidth * mHeight * 3 / 2;
+		for (int i = 0; i < MAX_LOAD_FRAMES; i++) {
+			std::vector<uint8_t> frame(bytes);
+			if (fread(&frame[0], bytes, 1, fp) != 1) break;
+			mRecorded.push_back(frame);
+		}
+	}
+	fclose(fp);
+
+	RETURN((int)mRecorded.size(), int);
+}
+
+/**
+ * generate synthetic pattern, gradient background with rotating bar
+ */
+/*private*/
+void IPSyntheticFrameSource::generate(cv::Mat &frame, const int &seq) {
+	const int w = frame.cols, h = frame.rows;
+	for (int y = 0; y < h; y++) {
+		uint8_t *row = frame.ptr<uint8_t>(y);
+		const uint8_t v = (uint8_t)((y * 128) / h + 64);
+		for (int x = 0; x < w; x++) {
+			row[0] = row[1] = row[2] = v;
+			row[3] = 255;
+			row += 4;
+		}
+	}
+	const double angle = (seq % 360) * CV_PI / 180.0;
+	const cv::Point2d center(w / 2.0, h / 2.0);
+	const cv::Point2d d(cos(angle) * w, sin(angle) * w);
+	cv::line(frame, center - d, center + d, cv::Scalar(255, 255, 255, 255), 8);
+}
+
+/** static member thread function */
+/*private*/
+void *IPSyntheticFrameSource::source_thread_func(void *vptr_args) {
+	ENTER();
+
+	IPSyntheticFrameSource *source = reinterpret_cast<IPSyntheticFrameSource *>(vptr_args);
+	if (LIKELY(source)) {
+		source->do_generate();
+	}
+
+	PRE_EXIT();
+	pthread_exit(NULL);
+}
+
+/*private*/
+void IPSyntheticFrameSource::do_generate() {
+	ENTER();
+
+	const nsecs_t interval_ns = mFps > 0 ? (nsecs_t)(1000000000.0 / mFps) : 0;
+	nsecs_t next_time = systemTime(SYSTEM_TIME_MONOTONIC);
+	const int num_images = (int)mImages.size();
+	const int num_recorded = (int)mRecorded.size();
+	int seq = 0;
+	for ( ; mIsRunning ; ) {
+		if (interval_ns) {
+			const nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC);
+			if (now < next_time) {
+				usleep((useconds_t)ns2us(next_time - now));
+			}
+			next_time += interval_ns;
+		} else if (queuedFrames() >= queueSize()) {
+			// full speed, just wait until worker thread takes queued frame
+			usleep(RETRY_INTERVAL_US);
+			continue;
+		}
+		const nsecs_t capture_time_ns = systemTime(SYSTEM_TIME_MONOTONIC);
+		if (num_recorded) {
+			// same path as raw buffer from camera
+			const std::vector<uint8_t> &data = mRecorded[seq++ % num_recorded];
+			ingestBuffer(&data[0], data.size(), mWidth, mHeight, 0, mRecordedFormat,
+				capture_time_ns, 0);
+			continue;
+		}
+		int roi_x = 0, roi_y = 0, roi_width = mWidth, roi_height = mHeight;
+		cv::Mat frame;
+		if (num_images) {
+			// copy only region of interest
+			getReadRoi(roi_x, roi_y, roi_width, roi_height);
+			frame = obtainFromPool(roi_width, roi_height);
+			mImages[seq % num_images](cv::Rect(roi_x, roi_y, roi_width, roi_height)).copyTo(frame);
+		} else {
+			// synthetic pattern is always generated as full frame
+			frame = obtainFromPool(mWidth, mHeight);
+			generate(frame, seq);
+		}
+		seq++;
+		addFrame(frame, capture_time_ns, 0, roi_x, roi_y);
+	}
+
+	EXIT();
+}
@@ -0,0 +1,67 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+#ifndef FLIGHTDEMO_IPSYNTHETICFRAMESOURCE_H
+#define FLIGHTDEMO_IPSYNTHETICFRAMESOURCE_H
+
+#include <pthread.h>
+#include <string>
+#include <vector>
+
+#include "IPFrameSource.h"
+
+/**
+ * frame source that generates frames on its own thread without OpenGL|ES and Java.
+ * frames are read from file(raw RGBA frames with ".rgba" extension
+ * or any image file that OpenCV can decode) and repeated,
+ * or synthetic pattern is generated if no file is specified.
+ * recorded raw frames of camera with processing size(".yuyv", ".nv21")
+ * and concatenated JPEG frames(".mjpeg", ".mjpg") are replayed through
+ * same conversion as FRAME_SOURCE_MEMORY.
+ * This is mainly for benchmarking/load testing on host(e.g. Linux) build.
+ */
+class IPSyntheticFrameSource : public IPFrameSource {
+private:
+	const std::string mPath;
+	// frame rate, generate frames as fast as worker thread can process if this is zero or negative
+	const float mFps;
+	std::vector<cv::Mat> mImages;
+	// recorded raw frames and their PIXEL_FORMAT_XXX
+	std::vector<std::vector<uint8_t> > mRecorded;
+	int mRecordedFormat;
+	volatile bool mIsRunning;
+	pthread_t source_thread;
+	static void *source_thread_func(void *vptr_args);
+	void do_generate();
+	int loadFrames();
+	int loadRecorded(const int &format);
+	void generate(cv::Mat &frame, const int &seq);
+public:
+	IPSyntheticFrameSource(IPFrame &frame, const char *path = NULL, const float &fps = 0.0f,
+		const bool &luma_only = false);
+	virtual ~IPSyntheticFrameSource();
+	virtual int init(const int &width, const int &height);
+	virtual void release();
+};
+
+#endif //FLIGHTDEMO_IPSYNTHETICFRAMESOURCE_H
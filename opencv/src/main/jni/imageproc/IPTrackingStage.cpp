@@ -0,0 +1,168 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+
+
+#if 1	// set 0 to enable debug output, otherwise set 1
+	#ifndef LOG_NDEBUG
+		#define	LOG_NDEBUG		// disable LOGV/LOGD/MARK
+	#endif
+	#undef USE_LOGALL			// enable specific LOGx only
+#else
+//	#define USE_LOGALL
+	#define USE_LOGD
+	#undef LOG_NDEBUG
+	#undef NDEBUG
+#endif
+
+#include "utilbase.h"
+
+#include "IPTrackingStage.h"
+
+IPTrackingStage::IPTrackingStage(const char *name,
+	const float &min_confidence, const int &lost_frames, const int &full_search_ix)
+:	IPStage(name),
+	mMinConfidence(min_confidence),
+	mLostFrames(lost_frames),
+	mFullSearchIx(full_search_ix),
+	mTracking(false),
+	mMissed(0),
+	mSinceDetect(0),
+	mDetectInterval(DEFAULT_DETECT_INTERVAL),
+	mDetectCount(0),
+	mFallbackCount(0) {
+
+	ENTER();
+
+	EXIT();
+}
+
+IPTrackingStage::~IPTrackingStage() {
+	ENTER();
+
+	EXIT();
+}
+
+/*public*/
+void IPTrackingStage::reset() {
+	ENTER();
+
+	mTracking = false;
+	mMissed = 0;
+	mPrevRoi = cv::Rect();
+	mGray.release();
+
+	EXIT();
+}
+
+/**
+ * check the parameter without the instance(see IPPipeline::validateParameter)
+ * return 0 if valid, -1 if unknown key or invalid values
+ */
+/*public static*/
+int IPTrackingStage::validateParameter(const std::string &key, const float *values, const int &num) {
+	if ((key == "detect_interval") && (num == 1)
+		&& (values[0] >= 0) && (values[0] <= MAX_DETECT_INTERVAL)) {
+
+		return 0;
+	}
+	return -1;
+}
+
+/*public*/
+int IPTrackingStage::setParameter(const std::string &key, const float *values, const int &num) {
+	ENTER();
+
+	if (UNLIKELY(validateParameter(key, values, num))) {
+		RETURN(-1, int);
+	}
+	mDetectInterval = (int)values[0];
+
+	RETURN(0, int);
+}
+
+/*public*/
+void IPTrackingStage::getDetectStats(int64_t &detect_count, int64_t &fallback_count) const {
+	detect_count = mDetectCount;
+	fallback_count = mFallbackCount;
+}
+
+/*public*/
+int IPTrackingStage::process(stage_context_t &ctx, const cv::Mat &src, cv::Mat &dst) {
+	ENTER();
+
+	dst = src;
+	const cv::Mat *gray = &src;
+	if (src.channels() != 1) {
+		cv::cvtColor(src, mGray, cv::COLOR_RGBA2GRAY);
+		gray = &mGray;
+	}
+	if (UNLIKELY(ctx.roi != mPrevRoi)) {
+		if (mTracking && !onRoiChanged(mPrevRoi, ctx.roi)) {
+			mTracking = false;
+		}
+		mPrevRoi = ctx.roi;
+	}
+
+	float confidence = 0;
+	bool full_search = false;
+	const int detect_interval = mDetectInterval;
+	if (mTracking) {
+		mSinceDetect++;
+		if ((detect_interval > 0) && (mSinceDetect >= detect_interval)) {
+			// scheduled full detection, e.g. to find other object that became better
+			full_search = true;
+			mDetectCount++;
+			mSinceDetect = 0;
+			confidence = detect(*gray);
+		}
+		if (confidence < mMinConfidence) {
+			confidence = track(*gray);
+			if ((confidence < mMinConfidence) && (++mMissed >= mLostFrames)) {
+				mTracking = false;
+			}
+		}
+	}
+	if (!mTracking && !full_search) {
+		// nothing to track, fall back to full detection(at most once for each frame)
+		full_search = true;
+		mDetectCount++;
+		mFallbackCount++;
+		mSinceDetect = 0;
+		confidence = detect(*gray);
+	}
+	if (confidence >= mMinConfidence) {
+		accept();
+		mTracking = true;
+		mMissed = 0;
+	} else {
+		confidence = 0;
+	}
+	ctx.results[mFullSearchIx] = full_search ? 1.0f : 0.0f;
+	if (mTracking) {
+		// previous object is reported with confidence 0 until it is lost
+		report(ctx, confidence, full_search);
+	}
+
+	RETURN(0, int);
+}
@@ -0,0 +1,98 @@
+/*
+ * UVCCamera
+ * library and sample to access to UVC web camera on non-rooted Android device
+ *
+ * Copyright (c) 2014-2018 saki t_saki@serenegiant.com
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * All files in the folder are under this Apache License, Version 2.0.
+ * Files in the jni/libjpeg, jni/libusb, jin/libuvc, jni/rapidjson, opencv3
+ * folder may have a different license, see the respective files.
+*/
+
+
+#ifndef FLIGHTDEMO_IPTRACKINGSTAGE_H
+#define FLIGHTDEMO_IPTRACKINGSTAGE_H
+
+#include "IPStage.h"
+
+// default interval of full detection while tracking[frames],
+// 0 means full detection runs only when tracking is lost
+#define DEFAULT_DETECT_INTERVAL 0
+#define MAX_DETECT_INTERVAL 1000
+
+/**
+ * detector stage that runs full(whole frame) detection only once
+ * and tracks the detected object by cheap local search on following frames.
+ * full detection runs again when
+ * - tracking failed(confidence less than min_confidence) for lost_frames frames
+ * - detect_interval frames passed since last full detection(if it is not 0)
+ * number of full detections and the ones caused by lost tracking are counted for stage stats.
+ * RGBA input is converted to gray scale and the input is passed through to next stage.
+ * parameter:
+ *   "detect_interval" interval of full detection while tracking[frames](0-MAX_DETECT_INTERVAL)
+ */
+class IPTrackingStage : public IPStage {
+private:
+	const float mMinConfidence;
+	const int mLostFrames;
+	// index of ctx.results for whether or not whole frame was searched
+	const int mFullSearchIx;
+	bool mTracking;
+	int mMissed;
+	int mSinceDetect;
+	// interval of full detection[frames], 0 means only when tracking is lost, set from other thread
+	volatile int mDetectInterval;
+	cv::Rect mPrevRoi;
+	cv::Mat mGray;
+	// updated and read only on the thread of the pipeline
+	int64_t mDetectCount;
+	int64_t mFallbackCount;
+protected:
+	IPTrackingStage(const char *name, const float &min_confidence, const int &lost_frames,
+		const int &full_search_ix);
+	/**
+	 * search whole frame and keep the candidate until #accept
+	 * @return confidence of the candidate(0-1)
+	 */
+	virtual float detect(const cv::Mat &gray) = 0;
+	/**
+	 * search only around tracked object and keep the candidate until #accept
+	 * @return confidence of the candidate(0-1)
+	 */
+	virtual float track(const cv::Mat &gray) = 0;
+	/** candidate of last #detect/#track becomes tracked object */
+	virtual void accept() = 0;
+	/**
+	 * attach tracked object to ctx, called for each frame while tracking
+	 * @param confidence 0 if the object was not found in this frame
+	 * @param full_search whether or not whole frame was searched in this frame
+	 */
+	virtual void report(stage_context_t &ctx, const float &confidence, const bool &full_search) = 0;
+	/**
+	 * region of interest changed, tracked object can be moved to new coordinates here
+	 * @return false if the object can't be tracked anymore
+	 */
+	virtual bool onRoiChanged(const cv::Rect &prev, const cv::Rect &roi) { return false; };
+	inline const bool isTracking() const { return mTracking; };
+public:
+	virtual ~IPTrackingStage();
+	virtual int process(stage_context_t &ctx, const cv::Mat &src, cv::Mat &dst);
+	virtual void reset();
+	virtual int setParameter(const std::string &key, const float *values, const int &num);
+	static int validateParameter(const std::string &key, const float *values, const int &num);
+	virtual void getDetectStats(int64_t &detect_count, int64_t &fallback_count) const;
+};
+
+#endif //FLIGHTDEMO_IPTRACKINGSTAGE_H
@@ -41,8 +41,25 @@
 #include "common_utils.h"
 #include "JNIHelp.h"
 #include "Errors.h"
+#include "WorkStealingPool.h"
 
 #include "ImageProcessor.h"
+#include "IPMemFrameSource.h"
+#include "IPMjpegFrameSource.h"
+#include "IPSyntheticFrameSource.h"
+
+#ifndef USE_GL_FRAME_SOURCE
+	#if defined(__ANDROID__)
+		#define USE_GL_FRAME_SOURCE 1
+	#else
+		// host build, OpenGL|ES may not be available
+		#define USE_GL_FRAME_SOURCE 0
+	#endif
+#endif
+
+#if USE_GL_FRAME_SOURCE
+#include "IPGLFrameSource.h"
+#endif
 
 struct fields_t {
     jmethodID callFromNative;
@@ -52,18 +69,38 @@ static fields_t fields;
 
 using namespace android;
 
+/**
+ * Constructor
+ * you can pass NULL as env when you use this without Java(e.g. on host build),
+ * in that case result is not passed to Java.
+ */
 ImageProcessor::ImageProcessor(JNIEnv* env, jobject weak_thiz_obj, jclass clazz)
-:	mWeakThiz(env->NewGlobalRef(weak_thiz_obj)),
-	mClazz((jclass)env->NewGlobalRef(clazz)),
+:	mWeakThiz(env ? env->NewGlobalRef(weak_thiz_obj) : NULL),
+	mClazz(env ? (jclass)env->NewGlobalRef(clazz) : NULL),
 	mIsRunning(false),
-	mResultFrameType(RESULT_FRAME_TYPE_DST_LINE)
+	mResultFrameType(RESULT_FRAME_TYPE_DST_LINE),
+	mResultFormat(RESULT_FORMAT_RGBA),
+	mUnchangedThreshold(DEFAULT_UNCHANGED_THRESHOLD),
+	mFrameSource(NULL),
+	mSyntheticFps(0.0f),
+	mArenaFlags(0),
+	mLumaOnly(true),
+	mPriority(SCHEDULER_DEFAULT_PRIORITY),
+	mBudgetFps(0.0f),
+	mPipeline(NULL),
+	mPendingPipeline(NULL),
+	mProcessed(0)
 {
 	ENTER();
 
+	frame_hash_reset(mLastHash);
+
 	EXIT();
 }
 
 ImageProcessor::~ImageProcessor() {
+	SAFE_DELETE(mPendingPipeline);
+	SAFE_DELETE(mPipeline);
 }
 
 void ImageProcessor::release(JNIEnv *env) {
@@ -87,19 +124,72 @@ void ImageProcessor::release(JNIEnv *env) {
 /**
  * request start image processing
  * This is called on gl context and you can execute OpenGL|ES functions
+ * @param width
+ * @param height
+ * @param source_type one of FRAME_SOURCE_XXX
+ * @param pbo_num number of PBOs for FRAME_SOURCE_GL
+ * @param use_lease use zero-copy readback for FRAME_SOURCE_GL
+ * @param queue_size max number of frames in frame queue
+ * @param pool_size max number of frames in frame pool
+ * @param queue_policy what to do when frame queue is full, one of QUEUE_POLICY_XXX
+ * @param block_timeout_ms max waiting time of frame source for QUEUE_POLICY_BLOCK[ms]
  */
-int ImageProcessor::start(const int &width, const int &height) {
+int ImageProcessor::start(const int &width, const int &height,
+	const int &source_type, const int &pbo_num, const bool &use_lease,
+	const int &queue_size, const int &pool_size,
+	const int &queue_policy, const int &block_timeout_ms) {
+
 	ENTER();
 	int result = -1;
 
 	if (!isRunning()) {
+		IPFrameSource *source = createFrameSource(source_type, pbo_num, use_lease);
+		if (UNLIKELY(!source)) {
+			LOGE("unsupported frame source:%d", source_type);
+			RETURN(-1, int);
+		}
 		mMutex.lock();
 		{
-			initFrame(width, height);
+			// this should be called before IPFrameSource#init
+			// because GL frame source in lease mode depends on frame queue size
+			initFrame(width, height, source, queue_size, pool_size, queue_policy, block_timeout_ms,
+				mArenaFlags);
+			if (mPendingPipeline) {
+				SAFE_DELETE(mPipeline);
+				mPipeline = mPendingPipeline;
+				mPendingPipeline = NULL;
+			} else if (!mPipeline) {
+				mPipeline = IPPipeline::create(DEFAULT_PIPELINE);
+				if (mPipeline) {
+					applyStageParameters(mPipeline);
+				}
+			}
+			mProcessed = 0;
+			frame_hash_reset(mLastHash);
 			mIsRunning = true;
-			result = pthread_create(&processor_thread, NULL, processor_thread_func, (void *)this);
+			// later segments of the pipeline run on their own threads
+			result = mPipeline ? mPipeline->start(this) : -1;
+			if (LIKELY(!result)) {
+				// frames are processed on worker threads shared by all instances
+				result = IPScheduler::getInstance().add(this, mPriority, mBudgetFps);
+				if (UNLIKELY(result)) {
+					mPipeline->stop();
+				}
+			}
+			if (UNLIKELY(result)) {
+				mIsRunning = false;
+			}
 		}
 		mMutex.unlock();
+		if (LIKELY(!result)) {
+			Mutex::Autolock lock(mSourceMutex);
+			mFrameSource = source;
+			source->init(width, height);
+		} else {
+			LOGE("failed to start pipeline or add to scheduler:%d", result);
+			releaseFrame();
+			SAFE_DELETE(source);
+		}
 	} else {
 		LOGW("already running");
 	}
@@ -107,6 +197,34 @@ int ImageProcessor::start(const int &width, const int &height) {
 	RETURN(result, int);
 }
 
+/*private*/
+IPFrameSource *ImageProcessor::createFrameSource(const int &source_type,
+	const int &pbo_num, const bool &use_lease) {
+
+	ENTER();
+
+	IPFrameSource *result = NULL;
+	switch (source_type) {
+#if USE_GL_FRAME_SOURCE
+	case FRAME_SOURCE_GL:
+		result = new IPGLFrameSource(*this, pbo_num, use_lease);
+		break;
+#endif
+	case FRAME_SOURCE_MEMORY:
+		result = new IPMemFrameSource(*this, mLumaOnly);
+		break;
+	case FRAME_SOURCE_MJPEG:
+		result = new IPMjpegFrameSource(*this, mLumaOnly);
+		break;
+	case FRAME_SOURCE_SYNTHETIC:
+		result = new IPSyntheticFrameSource(*this,
+			mSyntheticPath.empty() ? NULL : mSyntheticPath.c_str(), mSyntheticFps, mLumaOnly);
+		break;
+	}
+
+	RET(result);
+}
+
 /**
  * request stop image processing
  * This is called on gl context and you can execute OpenGL|ES functions
@@ -117,23 +235,136 @@ int ImageProcessor::stop() {
 	bool b = isRunning();
 	if (LIKELY(b)) {
 		mIsRunning = false;
-		releaseFrame();
-		mMutex.lock();
-		{
-			MARK("signal to processor thread");
-			mSync.broadcast();
+		abortFrame();
+		MARK("wait for worker thread finishes processing of this instance");
+		IPScheduler::getInstance().remove(this);
+		// buffers for processing were allocated from the arena that is released in #clearFrames
+		if (mPipeline) {
+			mPipeline->stop();
+			mPipeline->reset();
 		}
-		mMutex.unlock();
-		MARK("wait for processing thread finishes");
-		if (pthread_join(processor_thread, NULL) != EXIT_SUCCESS) {
-			LOGW("terminate processor thread: pthread_join failed");
+		// worker thread may access to leased PBO until it finishes,
+		// so release frame source after removing from scheduler
+		mSourceMutex.lock();
+		{
+			if (mFrameSource) {
+				mFrameSource->release();
+			}
+			releaseFrame();
+			SAFE_DELETE(mFrameSource);
 		}
+		mSourceMutex.unlock();
 	}
 	clearFrames();
 
 	RETURN(0, int);
 }
 
+/**
+ * get image from frame buffer of OpenGL|ES, call this on drawing thread of Java
+ * return 1 if the frame was dropped, negative value if current frame source is not FRAME_SOURCE_GL
+ * @param timestamp_ns timestamp of the frame(SurfaceTexture#getTimestamp)
+ * @param readback false if caller skipped rendering current frame because of #isBusy
+ */
+int ImageProcessor::handleFrame(const int &width, const int &height, const int &tex_name,
+	const int64_t &timestamp_ns, const bool &readback) {
+
+	ENTER();
+
+	int result = -1;
+#if USE_GL_FRAME_SOURCE
+	// XXX we don't need to lock mSourceMutex here because
+	//     this, #start and #stop are all called on GL thread
+	IPGLFrameSource *source = dynamic_cast<IPGLFrameSource *>(mFrameSource);
+	if (LIKELY(source)) {
+		result = source->handleFrame(width, height, tex_name, timestamp_ns, readback);
+	}
+#endif
+
+	RETURN(result, int);
+}
+
+/**
+ * whether or not worker thread is busy and frame source does not need new frame now,
+ * caller can skip rendering/preparing current frame. for FRAME_SOURCE_GL call this on GL thread
+ */
+const bool ImageProcessor::isBusy() const {
+	ENTER();
+
+	bool result = false;
+	Mutex::Autolock lock(mSourceMutex);
+	if (LIKELY(mFrameSource)) {
+		result = mFrameSource->isBusy();
+	}
+
+	RET(result);
+}
+
+/**
+ * pass raw image to frame queue without OpenGL|ES(e.g. frame callback of UVC camera)
+ * return 1 if the frame was dropped, negative value if current frame source is not FRAME_SOURCE_MEMORY|FRAME_SOURCE_MJPEG
+ * @param timestamp_ns timestamp of the image from caller[ns]
+ * @param format one of PIXEL_FORMAT_XXX
+ */
+int ImageProcessor::handleBuffer(const uint8_t *data, const size_t &size,
+	const int &width, const int &height, const int &stride, const int64_t &timestamp_ns,
+	const int &format) {
+
+	ENTER();
+
+	int result = -1;
+	Mutex::Autolock lock(mSourceMutex);
+	IPMemFrameSource *source = dynamic_cast<IPMemFrameSource *>(mFrameSource);
+	if (LIKELY(source)) {
+		result = source->handleBuffer(data, size, width, height, stride, timestamp_ns, format);
+	}
+
+	RETURN(result, int);
+}
+
+/**
+ * set file and frame rate for FRAME_SOURCE_SYNTHETIC, this should be called before #start
+ * @param path raw RGBA frames(*.rgba) or image file, NULL or empty to generate synthetic pattern
+ * @param fps frame rate, zero or negative means as fast as possible
+ */
+void ImageProcessor::setSyntheticSource(const char *path, const float &fps) {
+	ENTER();
+
+	Mutex::Autolock lock(mSourceMutex);
+	mSyntheticPath = path ? path : "";
+	mSyntheticFps = fps;
+
+	EXIT();
+}
+
+/**
+ * set flags for the arena that serves frames and buffers of worker thread,
+ * this should be called before #start
+ * @param flags ARENA_FLAG_XXX
+ */
+void ImageProcessor::setArenaFlags(const int &flags) {
+	ENTER();
+
+	Mutex::Autolock lock(mSourceMutex);
+	mArenaFlags = flags;
+
+	EXIT();
+}
+
+/**
+ * whether or not YUV/JPEG image is queued as luminance only without color conversion,
+ * this should be called before #start. default is true because worker thread
+ * only needs luminance now, set false if your processing needs color.
+ */
+void ImageProcessor::setLumaOnly(const bool &luma_only) {
+	ENTER();
+
+	Mutex::Autolock lock(mSourceMutex);
+	mLumaOnly = luma_only;
+
+	EXIT();
+}
+
 void ImageProcessor::setResultFrameType(const int &result_frame_type) {
 	ENTER();
 
@@ -146,103 +377,394 @@ void ImageProcessor::setResultFrameType(const int &result_frame_type) {
 	EXIT();
 };
 
+/**
+ * set pixel format of result image passed to Java, applied from next frame
+ * @param result_format RESULT_FORMAT_RGBA or RESULT_FORMAT_GRAY(1/4 bytes of RGBA)
+ */
+void ImageProcessor::setResultFormat(const int &result_format) {
+	ENTER();
+
+	Mutex::Autolock lock(mMutex);
+
+	mResultFormat = result_format % RESULT_FORMAT_MAX;
+
+	EXIT();
+};
+
+/**
+ * set threshold to skip the frames that are same as last processed frame, applied from next frame.
+ * stages are skipped for those frames and last results are passed to Java again without result image
+ * @param threshold max difference of mean luminance of the blocks of the frame(see #frame_hash_diff)
+ * 	that is regarded as changed, frames with smaller difference are unchanged. 0 disables this
+ */
+int ImageProcessor::setUnchangedThreshold(const int &threshold) {
+	ENTER();
 
-/** static member thread function */
+	if ((threshold < 0) || (threshold > MAX_UNCHANGED_THRESHOLD)) {
+		RETURN(-1, int);
+	}
+	Mutex::Autolock lock(mMutex);
+
+	mUnchangedThreshold = threshold;
+
+	RETURN(0, int);
+}
+
+/**
+ * set parameter of the stages of the name in the pipeline(see IPStage#setParameter),
+ * this can be called anytime and the stages apply it from next frame.
+ * the parameter is checked by IPPipeline::validateParameter regardless of current pipeline
+ * and kept to apply it to the pipeline that is set later(#setPipeline) as well,
+ * so this can be called for the stage that is not in current pipeline
+ * @param stage name of the stage, e.g. "dense_flow"
+ * @param key name of the parameter, e.g. "flow"
+ * return 0 if success, -1 if unknown stage, unknown key or invalid values
+ */
+int ImageProcessor::setStageParameter(const char *stage, const char *key,
+	const float *values, const int &num) {
+
+	ENTER();
+
+	if (UNLIKELY(!stage || !key || IPPipeline::validateParameter(stage, key, values, num))) {
+		RETURN(-1, int);
+	}
+	int result = 0;
+	Mutex::Autolock lock(mMutex);
+	// mPipeline is swapped/deleted by worker thread only while holding mMutex.
+	// valid parameter is applied to both pipelines, this fails only when the stage
+	// could not apply it(e.g. failed to start thread) and the parameter is kept anyway
+	if (mPipeline && (mPipeline->setParameter(stage, key, values, num) < 0)) {
+		result = -1;
+	}
+	if (mPendingPipeline && (mPendingPipeline->setParameter(stage, key, values, num) < 0)) {
+		result = -1;
+	}
+	std::vector<stage_param_t>::iterator iter = mStageParams.begin();
+	for ( ; iter != mStageParams.end(); iter++) {
+		if ((iter->stage == stage) && (iter->key == key)) {
+			break;
+		}
+	}
+	if (iter == mStageParams.end()) {
+		iter = mStageParams.insert(mStageParams.end(), stage_param_t());
+		iter->stage = stage;
+		iter->key = key;
+	}
+	iter->values.assign(values, values + num);
+
+	RETURN(result, int);
+}
+
+/**
+ * copy latest result of the stage of the name in current pipeline(see IPStage#getResult),
+ * this can be called from any thread
+ * @param stage name of the stage, e.g. "dense_flow"
+ * @param key name of the result, e.g. "flow"
+ * @param values only first max_num values are copied if the result is larger
+ * @param seq sequence number of the frame of the result
+ * return number of the values of the result, 0 if no result yet,
+ * 	-1 if current pipeline does not have the stage or the result
+ */
+int ImageProcessor::getStageResult(const char *stage, const char *key,
+	float *values, const int &max_num, int64_t &seq) const {
+
+	ENTER();
+
+	int result = -1;
+	if (LIKELY(stage && key)) {
+		Mutex::Autolock lock(mMutex);
+		if (mPipeline) {
+			result = mPipeline->getResult(stage, key, values, max_num, seq);
+		}
+	}
+
+	RETURN(result, int);
+}
+
+/**
+ * apply kept parameters of the stages to new pipeline, call this while holding mMutex
+ */
 /*private*/
-void *ImageProcessor::processor_thread_func(void *vptr_args) {
+void ImageProcessor::applyStageParameters(IPPipeline *pipeline) {
 	ENTER();
 
-	ImageProcessor *processor = reinterpret_cast<ImageProcessor *>(vptr_args);
-	if (LIKELY(processor)) {
-		// attach to JavaVM so that ImageProcessor can call method(s) on Java class
-		JavaVM *vm = getVM();
-		CHECK(vm);
-		JNIEnv *env;
-		vm->AttachCurrentThread(&env, NULL);
-		CHECK(env);
-		processor->do_process(env);
-		LOGD("image processing loop finished, detach from JavaVM");
-		vm->DetachCurrentThread();
-		LOGD("detach finished");
+	for (std::vector<stage_param_t>::const_iterator iter = mStageParams.begin();
+		iter != mStageParams.end(); iter++) {
+
+		const stage_param_t &param = *iter;
+		if (UNLIKELY(pipeline->setParameter(param.stage, param.key,
+			param.values.empty() ? NULL : &param.values[0], (int)param.values.size()) < 0)) {
+
+			LOGW("stage %s rejected parameter %s", param.stage.c_str(), param.key.c_str());
+		}
+	}
+
+	EXIT();
+}
+
+
+/**
+ * set priority and frame budget of this instance on the scheduler that is shared by all instances,
+ * this can be called anytime
+ * @param priority larger value is served first
+ * @param budget_fps max number of frames per second that are processed, zero means unlimited
+ */
+void ImageProcessor::setPriority(const int &priority, const float &budget_fps) {
+	ENTER();
+
+	mMutex.lock();
+	{
+		mPriority = priority;
+		mBudgetFps = budget_fps;
+	}
+	mMutex.unlock();
+	if (isRunning()) {
+		IPScheduler::getInstance().setPriority(this, priority, budget_fps);
+	}
+
+	EXIT();
+}
+
+/**
+ * set processing stages as comma separated stage names(e.g. "gray,rgba"),
+ * '|' instead of ',' runs following stages on their own thread(e.g. "gray|rgba").
+ * this can be called anytime and new pipeline is applied from next frame while running
+ * return 0 if success, -1 if the spec contains unknown stage
+ * @param spec NULL or empty string means DEFAULT_PIPELINE
+ * @param queue_depth max number of frames that can wait between threads of the pipeline
+ */
+int ImageProcessor::setPipeline(const char *spec, const int &queue_depth) {
+	ENTER();
+
+	IPPipeline *pipeline = IPPipeline::create(spec, queue_depth);
+	if (UNLIKELY(!pipeline)) {
+		RETURN(-1, int);
+	}
+	IPPipeline *prev;
+	mMutex.lock();
+	{
+		applyStageParameters(pipeline);
+		// worker thread swaps this at frame boundary(or #start)
+		prev = mPendingPipeline;
+		mPendingPipeline = pipeline;
 	}
+	mMutex.unlock();
+	// pending pipeline never has buffers, so we can delete it here
+	SAFE_DELETE(prev);
 
-	PRE_EXIT();
-	pthread_exit(NULL);
+	RETURN(0, int);
+}
+
+/**
+ * get processing stats of each stage of current pipeline
+ * return number of stages
+ */
+int ImageProcessor::getStageStats(stage_stats_t *stats, const int &max_num) {
+	ENTER();
+
+	int result = 0;
+	Mutex::Autolock lock(mMutex);
+	// mPipeline is swapped/deleted by worker thread only while holding mMutex
+	if (mPipeline) {
+		result = mPipeline->getStats(stats, max_num);
+	}
+
+	RETURN(result, int);
 }
 
-/** actual member thread function */
+/**
+ * swap pipeline if new one was set, call this only from worker thread
+ */
 /*private*/
-void ImageProcessor::do_process(JNIEnv *env) {
+IPPipeline *ImageProcessor::updatePipeline() {
+	ENTER();
+
+	IPPipeline *prev = NULL;
+	mMutex.lock();
+	{
+		if (UNLIKELY(mPendingPipeline)) {
+			prev = mPipeline;
+			mPipeline = mPendingPipeline;
+			mPendingPipeline = NULL;
+		}
+	}
+	mMutex.unlock();
+	if (UNLIKELY(prev)) {
+		// frames in previous pipeline are discarded and its buffers are returned to the arena
+		prev->stop();
+		prev->reset();
+		SAFE_DELETE(prev);
+		if (UNLIKELY(mPipeline->start(this))) {
+			LOGE("failed to start pipeline:%s", mPipeline->spec());
+		}
+		// new pipeline allocates its buffers, so count allocations again after warm up
+		setSteadyState(false);
+		mProcessed = 0;
+		// new pipeline has no results to reuse
+		frame_hash_reset(mLastHash);
+	}
+
+	RET(mPipeline);
+}
+
+/**
+ * get stats of this instance and aggregate stats of all instances on the scheduler
+ */
+int ImageProcessor::getSchedulerStats(scheduler_stats_t &stats, scheduler_stats_t &total_stats,
+	int &num_threads, int &num_clients) {
+
 	ENTER();
 
-	cv::Mat src, result;
-	long last_queued_time_ms;
+	const int result = IPScheduler::getInstance().getStats(this, stats, total_stats,
+		num_threads, num_clients);
+
+	RETURN(result, int);
+}
 
-	for ( ; mIsRunning ; ) {
-		// wait for image
-		cv::Mat frame = getFrame(last_queued_time_ms);
-		if (UNLIKELY(!mIsRunning)) break;
-		if (LIKELY(!frame.empty())) {
-			try {
+/** wake up worker thread of the scheduler */
+/*protected*/
+void ImageProcessor::onFrameQueued() {
+	IPScheduler::getInstance().signal();
+}
+
+/** called from the scheduler with its lock held, this should be lightweight */
+bool ImageProcessor::hasFrame() {
+	// frames wait in frame queue(and follow its queue policy) while the pipeline is full
+	return mIsRunning && (queuedFrames() > 0)
+		&& (!mPipeline || mPendingPipeline || mPipeline->canAccept());
+}
+
+/**
+ * process one queued frame, called on worker thread of the scheduler.
+ * this is never called simultaneously for same instance
+ */
+void ImageProcessor::processFrame(JNIEnv *env) {
+	ENTER();
+
+	frame_info_t info;
+	cv::Mat frame = getFrame(info, false);
+	const nsecs_t dequeued_time_ns = systemTime(SYSTEM_TIME_MONOTONIC);
+	if (UNLIKELY(frame.empty())) {
+		EXIT();
+	}
+	IPPipeline *pipeline = updatePipeline();
+	try {
 //--------------------------------------------------------------------------------
 // local copy
 // if you want to pass some parameters while image processing,
 // you should do access control like here.
-				int result_frame_type;
-				mMutex.lock();
-				{
-					result_frame_type = mResultFrameType;
-				}
-				mMutex.unlock();
+		int result_frame_type, result_format, unchanged_threshold;
+		mMutex.lock();
+		{
+			result_frame_type = mResultFrameType;
+			result_format = mResultFormat;
+			unchanged_threshold = mUnchangedThreshold;
+		}
+		mMutex.unlock();
 //--------------------------------------------------------------------------------
-// do something you want
-// for a sample, convert to gray scale and return it as rgba here now.
-				switch (result_frame_type) {
-				default:
-					// convert to gray scale(RGBA->Y)
-					cv::cvtColor(frame, src, cv::COLOR_RGBA2GRAY, 1);
-					// convert gray scale to rgba(for callback)
-					cv::cvtColor(src, result, cv::COLOR_GRAY2RGBA);
-					break;
-				}
-				if (UNLIKELY(!mIsRunning)) break;
+// pass the frame through the stages of the pipeline,
+// frame may be region of interest of the full frame.
+// result is passed to #onPipelineResult on this thread or the thread of last segment
+		stage_context_t ctx;
+		ctx.info = info;
+		ctx.width = width();
+		ctx.height = height();
+		ctx.roi = cv::Rect(info.roi_x, info.roi_y, frame.cols, frame.rows);
+		ctx.dequeued_time_ns = dequeued_time_ns;
+		ctx.result_frame_type = result_frame_type;
+		ctx.result_format = result_format;
+		ctx.allocator = frameAllocator();
+		ctx.detect_type = TYPE_NON;
+		ctx.unchanged = frame_hash_unchanged(mLastHash, frame, ctx.roi, unchanged_threshold);
+		if (ctx.unchanged) {
+			countUnchanged();
+		}
+		if (UNLIKELY(!pipeline || pipeline->process(env, ctx, frame))) {
+			LOGW("pipeline is not available, frame dropped");
+		}
+	} catch (cv::Exception e) {
+		LOGE("processFrame failed:%s", e.msg.c_str());
+		// frame may wrap leased PBO, so we always need to return it
+		recycle(frame);
+		EXIT();
+	} catch (...) {
+		LOGE("processFrame unknown exception:");
+		recycle(frame);
+		EXIT();
+	}
+	recycle(frame);
+	countProcessed();
+	if (UNLIKELY(++mProcessed == STEADY_STATE_FRAMES)) {
+		// all buffers should have been allocated until here
+		setSteadyState(true);
+	}
+
+	EXIT();
+}
+
+/**
+ * called for each frame that passed through the pipeline, in the order of the frames
+ */
+/*protected*/
+void ImageProcessor::onPipelineResult(JNIEnv *env, stage_context_t &ctx) {
+	ENTER();
+
+	if (LIKELY(mIsRunning)) {
 //--------------------------------------------------------------------------------
 // call method on Java class
-				callJavaCallback(env, result, last_queued_time_ms);
+		callJavaCallback(env, ctx.detect_type, ctx.result, ctx.results, ctx.info, ctx.dequeued_time_ns);
 //--------------------------------------------------------------------------------
-			} catch (cv::Exception e) {
-				LOGE("do_process failed:%s", e.msg.c_str());
-				continue;
-			} catch (...) {
-				LOGE("do_process unknown exception:");
-				break;
-			}
-			recycle(frame);
-		}
 	}
 
 	EXIT();
 }
 
-#define RESULT_NUM 20
+/** frame in the pipeline finished, wake up worker thread of the scheduler */
+/*protected*/
+void ImageProcessor::onPipelineReady() {
+	IPScheduler::getInstance().signal();
+}
 
 /*private*/
-int ImageProcessor::callJavaCallback(JNIEnv *env, cv::Mat &result, const long &last_queued_time_ms) {
-	ENTER();
+int ImageProcessor::callJavaCallback(JNIEnv *env, const int &type, cv::Mat &result, float *detected,
+	const frame_info_t &info, const nsecs_t &dequeued_time_ns) {
 
-	float detected[RESULT_NUM];
+	ENTER();
 
-	if (LIKELY(mIsRunning && fields.callFromNative && mClazz && mWeakThiz)) {
+	detected[RESULT_IX_READBACK_LATENCY] = (info.queued_time_ns - info.capture_time_ns) / 1000000.0f;
+	jlong frame_info[FRAME_INFO_NUM];
+	frame_info[FRAME_INFO_IX_SEQ] = info.seq;
+	frame_info[FRAME_INFO_IX_CAPTURE_TIME] = info.capture_time_ns;
+	frame_info[FRAME_INFO_IX_QUEUED_TIME] = info.queued_time_ns;
+	frame_info[FRAME_INFO_IX_SOURCE_TIMESTAMP] = info.source_timestamp_ns;
+	frame_info[FRAME_INFO_IX_DROPPED] = info.dropped;
+	frame_info[FRAME_INFO_IX_DEQUEUED_TIME] = dequeued_time_ns;
+	frame_info[FRAME_INFO_IX_RESULT_TIME] = systemTime(SYSTEM_TIME_MONOTONIC);
+	frame_info[FRAME_INFO_IX_ROI_X] = info.roi_x;
+	frame_info[FRAME_INFO_IX_ROI_Y] = info.roi_y;
+	frame_info[FRAME_INFO_IX_ROI_WIDTH] = info.roi_width;
+	frame_info[FRAME_INFO_IX_ROI_HEIGHT] = info.roi_height;
+	// -1 when no result image(RESULT_FRAME_TYPE_NON)
+	frame_info[FRAME_INFO_IX_RESULT_FORMAT] = result.empty() ? -1
+		: (result.channels() == 1 ? RESULT_FORMAT_GRAY : RESULT_FORMAT_RGBA);
+
+	if (LIKELY(env && mIsRunning && fields.callFromNative && mClazz && mWeakThiz)) {
 		jfloatArray detected_array = env->NewFloatArray(RESULT_NUM);
 		env->SetFloatArrayRegion(detected_array, 0, RESULT_NUM, detected);
-		// result image
-		jobject buf_frame = env->NewDirectByteBuffer(result.data, result.total() * result.elemSize());
+		jlongArray info_array = env->NewLongArray(FRAME_INFO_NUM);
+		env->SetLongArrayRegion(info_array, 0, FRAME_INFO_NUM, frame_info);
+		// result image, null when there is no result image
+		jobject buf_frame = result.empty() ? NULL
+			: env->NewDirectByteBuffer(result.data, result.total() * result.elemSize());
 		// call method on Java class
-		env->CallStaticVoidMethod(mClazz, fields.callFromNative, mWeakThiz, 0, buf_frame, detected_array);
+		env->CallStaticVoidMethod(mClazz, fields.callFromNative, mWeakThiz, type, buf_frame, detected_array, info_array);
 		env->ExceptionClear();
 		if (LIKELY(detected_array)) {
 			env->DeleteLocalRef(detected_array);
 		}
+		if (LIKELY(info_array)) {
+			env->DeleteLocalRef(info_array);
+		}
 		if (buf_frame) {
 			env->DeleteLocalRef(buf_frame);
 		}
@@ -258,7 +780,7 @@ static void nativeClassInit(JNIEnv* env, jclass clazz) {
 	ENTER();
 
 	fields.callFromNative = env->GetStaticMethodID(clazz, "callFromNative",
-         "(Ljava/lang/ref/WeakReference;ILjava/nio/ByteBuffer;[F)V");
+         "(Ljava/lang/ref/WeakReference;ILjava/nio/ByteBuffer;[F[J)V");
 	if (UNLIKELY(!fields.callFromNative)) {
 		LOGW("can't find com.serenegiant.ImageProcessor#callFromNative");
 	}
@@ -311,14 +833,17 @@ static void nativeRelease(JNIEnv *env, jobject thiz,
 }
 
 static jint nativeStart(JNIEnv *env, jobject thiz,
-	ID_TYPE id_native, jint width, jint height) {
+	ID_TYPE id_native, jint width, jint height,
+	jint source_type, jint pbo_num, jboolean use_lease,
+	jint queue_size, jint pool_size, jint queue_policy, jint block_timeout_ms) {
 
 	ENTER();
 
 	jint result = -1;
 	ImageProcessor *processor = reinterpret_cast<ImageProcessor *>(id_native);
 	if (LIKELY(processor)) {
-		result = processor->start(width, height);
+		result = processor->start(width, height, source_type, pbo_num, use_lease,
+			queue_size, pool_size, queue_policy, block_timeout_ms);
 	}
 
 	RETURN(result, jint);
@@ -339,19 +864,264 @@ static jint nativeStop(JNIEnv *env, jobject thiz,
 }
 
 static int nativeHandleFrame(JNIEnv *env, jobject thiz,
-	ID_TYPE id_native, jint width, jint height, jint tex_name) {
+	ID_TYPE id_native, jint width, jint height, jint tex_name, jlong timestamp_ns,
+	jboolean readback) {
 
 	ENTER();
 
 	jint result = -1;
 	ImageProcessor *processor = reinterpret_cast<ImageProcessor *>(id_native);
 	if (LIKELY(processor)) {
-		result = processor->handleFrame(width, height, tex_name);
+		result = processor->handleFrame(width, height, tex_name, timestamp_ns, readback);
 	}
 
 	RETURN(result, jint);
 }
 
+static jboolean nativeIsBusy(JNIEnv *env, jobject thiz,
+	ID_TYPE id_native) {
+
+	ENTER();
+
+	jboolean result = JNI_FALSE;
+	ImageProcessor *processor = reinterpret_cast<ImageProcessor *>(id_native);
+	if (LIKELY(processor)) {
+		result = processor->isBusy();
+	}
+
+	RETURN(result, jboolean);
+}
+
+static jint nativeHandleBuffer(JNIEnv *env, jobject thiz,
+	ID_TYPE id_native, jobject buf, jint width, jint height, jint stride, jlong timestamp_ns,
+	jint format) {
+
+	ENTER();
+
+	jint result = -1;
+	ImageProcessor *processor = reinterpret_cast<ImageProcessor *>(id_native);
+	if (LIKELY(processor && buf)) {
+		const uint8_t *data = (const uint8_t *)env->GetDirectBufferAddress(buf);
+		const jlong size = env->GetDirectBufferCapacity(buf);
+		if (LIKELY(data && (size > 0))) {
+			result = processor->handleBuffer(data, (size_t)size, width, height, stride, timestamp_ns,
+				format);
+		} else {
+			LOGW("buffer should be a direct ByteBuffer");
+		}
+	}
+
+	RETURN(result, jint);
+}
+
+static jint nativeSetSyntheticSource(JNIEnv *env, jobject thiz,
+	ID_TYPE id_native, jstring path_str, jfloat fps) {
+
+	ENTER();
+
+	jint result = -1;
+	ImageProcessor *processor = reinterpret_cast<ImageProcessor *>(id_native);
+	if (LIKELY(processor)) {
+		const char *path = path_str ? env->GetStringUTFChars(path_str, NULL) : NULL;
+		processor->setSyntheticSource(path, fps);
+		if (path) {
+			env->ReleaseStringUTFChars(path_str, path);
+		}
+		result = 0;
+	}
+
+	RETURN(result, jint);
+}
+
+static jint nativeGetFrameStats(JNIEnv *env, jobject thiz,
+	ID_TYPE id_native, jlongArray stats_array) {
+
+	ENTER();
+
+	jint result = -1;
+	ImageProcessor *processor = reinterpret_cast<ImageProcessor *>(id_native);
+	if (LIKELY(processor && stats_array
+		&& (env->GetArrayLength(stats_array) >= FRAME_STATS_NUM))) {
+
+		frame_stats_t stats;
+		processor->getFrameStats(stats);
+		jlong values[FRAME_STATS_NUM];
+		values[FRAME_STATS_IX_READBACK] = stats.readback;
+		values[FRAME_STATS_IX_ENQUEUED] = stats.enqueued;
+		values[FRAME_STATS_IX_DROPPED] = stats.dropped;
+		values[FRAME_STATS_IX_PROCESSED] = stats.processed;
+		values[FRAME_STATS_IX_STEADY_ALLOCATIONS] = stats.steady_allocations;
+		values[FRAME_STATS_IX_BACKPRESSURE] = stats.backpressure;
+		values[FRAME_STATS_IX_UNCHANGED] = stats.unchanged;
+		env->SetLongArrayRegion(stats_array, 0, FRAME_STATS_NUM, values);
+		result = 0;
+	}
+
+	RETURN(result, jint);
+}
+
+static jint nativeSetArenaFlags(JNIEnv *env, jobject thiz,
+	ID_TYPE id_native, jint flags) {
+
+	ENTER();
+
+	jint result = -1;
+	ImageProcessor *processor = reinterpret_cast<ImageProcessor *>(id_native);
+	if (LIKELY(processor)) {
+		processor->setArenaFlags(flags);
+		result = 0;
+	}
+
+	RETURN(result, jint);
+}
+
+static jint nativeSetLumaOnly(JNIEnv *env, jobject thiz,
+	ID_TYPE id_native, jboolean luma_only) {
+
+	ENTER();
+
+	jint result = -1;
+	ImageProcessor *processor = reinterpret_cast<ImageProcessor *>(id_native);
+	if (LIKELY(processor)) {
+		processor->setLumaOnly(luma_only);
+		result = 0;
+	}
+
+	RETURN(result, jint);
+}
+
+static jint nativeSetReadbackRoi(JNIEnv *env, jobject thiz,
+	ID_TYPE id_native, jint x, jint y, jint width, jint height) {
+
+	ENTER();
+
+	jint result = -1;
+	ImageProcessor *processor = reinterpret_cast<ImageProcessor *>(id_native);
+	if (LIKELY(processor)) {
+		processor->setReadRoi(x, y, width, height);
+		result = 0;
+	}
+
+	RETURN(result, jint);
+}
+
+static jint nativeSetPriority(JNIEnv *env, jobject thiz,
+	ID_TYPE id_native, jint priority, jfloat budget_fps) {
+
+	ENTER();
+
+	jint result = -1;
+	ImageProcessor *processor = reinterpret_cast<ImageProcessor *>(id_native);
+	if (LIKELY(processor)) {
+		processor->setPriority(priority, budget_fps);
+		result = 0;
+	}
+
+	RETURN(result, jint);
+}
+
+static jint nativeGetSchedulerStats(JNIEnv *env, jobject thiz,
+	ID_TYPE id_native, jlongArray stats_array) {
+
+	ENTER();
+
+	jint result = -1;
+	ImageProcessor *processor = reinterpret_cast<ImageProcessor *>(id_native);
+	if (LIKELY(processor && stats_array
+		&& (env->GetArrayLength(stats_array) >= SCHEDULER_STATS_NUM))) {
+
+		scheduler_stats_t stats, total_stats;
+		int num_threads, num_clients;
+		// this instance may not be running, aggregate stats are still valid
+		processor->getSchedulerStats(stats, total_stats, num_threads, num_clients);
+		jlong values[SCHEDULER_STATS_NUM];
+		values[SCHEDULER_STATS_IX_PROCESSED] = stats.processed;
+		values[SCHEDULER_STATS_IX_BUSY_TIME] = stats.busy_ns;
+		values[SCHEDULER_STATS_IX_TOTAL_PROCESSED] = total_stats.processed;
+		values[SCHEDULER_STATS_IX_TOTAL_BUSY_TIME] = total_stats.busy_ns;
+		values[SCHEDULER_STATS_IX_THREADS] = num_threads;
+		values[SCHEDULER_STATS_IX_CLIENTS] = num_clients;
+		env->SetLongArrayRegion(stats_array, 0, SCHEDULER_STATS_NUM, values);
+		result = 0;
+	}
+
+	RETURN(result, jint);
+}
+
+static jint nativeSetPipeline(JNIEnv *env, jobject thiz,
+	ID_TYPE id_native, jstring spec_str, jint queue_depth) {
+
+	ENTER();
+
+	jint result = -1;
+	ImageProcessor *processor = reinterpret_cast<ImageProcessor *>(id_native);
+	if (LIKELY(processor)) {
+		const char *spec = spec_str ? env->GetStringUTFChars(spec_str, NULL) : NULL;
+		result = processor->setPipeline(spec, queue_depth);
+		if (spec) {
+			env->ReleaseStringUTFChars(spec_str, spec);
+		}
+	}
+
+	RETURN(result, jint);
+}
+
+/**
+ * copy stats of each stage into stats_array(STAGE_STATS_NUM values for each stage)
+ * return number of stages of current pipeline, stats of stages that do not fit are not copied
+ */
+static jint nativeGetStageStats(JNIEnv *env, jobject thiz,
+	ID_TYPE id_native, jlongArray stats_array) {
+
+	ENTER();
+
+	jint result = -1;
+	ImageProcessor *processor = reinterpret_cast<ImageProcessor *>(id_native);
+	if (LIKELY(processor && stats_array)) {
+		stage_stats_t stats[PIPELINE_MAX_STAGES];
+		result = processor->getStageStats(stats, PIPELINE_MAX_STAGES);
+		const int n = std::min(result, (int)(env->GetArrayLength(stats_array) / STAGE_STATS_NUM));
+		jlong values[PIPELINE_MAX_STAGES * STAGE_STATS_NUM];
+		for (int i = 0; i < n; i++) {
+			values[i * STAGE_STATS_NUM + STAGE_STATS_IX_COUNT] = stats[i].count;
+			values[i * STAGE_STATS_NUM + STAGE_STATS_IX_TOTAL_TIME] = stats[i].total_ns;
+			values[i * STAGE_STATS_NUM + STAGE_STATS_IX_MAX_TIME] = stats[i].max_ns;
+			values[i * STAGE_STATS_NUM + STAGE_STATS_IX_SEGMENT] = stats[i].segment;
+			values[i * STAGE_STATS_NUM + STAGE_STATS_IX_QUEUE_CAPACITY] = stats[i].queue_capacity;
+			values[i * STAGE_STATS_NUM + STAGE_STATS_IX_QUEUE_SIZE] = stats[i].queue_size;
+			values[i * STAGE_STATS_NUM + STAGE_STATS_IX_QUEUE_MAX] = stats[i].queue_max;
+			values[i * STAGE_STATS_NUM + STAGE_STATS_IX_QUEUE_TOTAL] = stats[i].queue_total;
+			values[i * STAGE_STATS_NUM + STAGE_STATS_IX_DETECT_COUNT] = stats[i].detect_count;
+			values[i * STAGE_STATS_NUM + STAGE_STATS_IX_FALLBACK_COUNT] = stats[i].fallback_count;
+		}
+		if (n > 0) {
+			env->SetLongArrayRegion(stats_array, 0, n * STAGE_STATS_NUM, values);
+		}
+	}
+
+	RETURN(result, jint);
+}
+
+static jint nativeSetSchedulerThreads(JNIEnv *env, jclass clazz,
+	jint num_threads) {
+
+	ENTER();
+
+	IPScheduler::getInstance().setNumThreads(num_threads);
+
+	RETURN(0, jint);
+}
+
+static jint nativeSetTileThreads(JNIEnv *env, jclass clazz,
+	jint num_threads) {
+
+	ENTER();
+
+	WorkStealingPool::getInstance().setNumThreads(num_threads);
+
+	RETURN(0, jint);
+}
+
 static jint nativeSetResultFrameType(JNIEnv *env, jobject thiz,
 	ID_TYPE id_native, jint result_frame_type) {
 
@@ -367,6 +1137,108 @@ static jint nativeSetResultFrameType(JNIEnv *env, jobject thiz,
 	RETURN(result, jint);
 }
 
+static jint nativeSetResultFormat(JNIEnv *env, jobject thiz,
+	ID_TYPE id_native, jint result_format) {
+
+	ENTER();
+
+	jint result = -1;
+	ImageProcessor *processor = reinterpret_cast<ImageProcessor *>(id_native);
+	if (LIKELY(processor)) {
+		processor->setResultFormat(result_format);
+		result = 0;
+	}
+
+	RETURN(result, jint);
+}
+
+static jint nativeSetUnchangedThreshold(JNIEnv *env, jobject thiz,
+	ID_TYPE id_native, jint threshold) {
+
+	ENTER();
+
+	jint result = -1;
+	ImageProcessor *processor = reinterpret_cast<ImageProcessor *>(id_native);
+	if (LIKELY(processor)) {
+		result = processor->setUnchangedThreshold(threshold);
+	}
+
+	RETURN(result, jint);
+}
+
+/**
+ * set parameter of the stages of the name(see ImageProcessor#setStageParameter)
+ * return 0 if success, -1 if unknown stage, unknown key or invalid values
+ */
+static jint nativeSetStageParameter(JNIEnv *env, jobject thiz,
+	ID_TYPE id_native, jstring stage_str, jstring key_str, jfloatArray values_array) {
+
+	ENTER();
+
+	jint result = -1;
+	ImageProcessor *processor = reinterpret_cast<ImageProcessor *>(id_native);
+	if (LIKELY(processor && stage_str && key_str && values_array)) {
+		const char *stage = env->GetStringUTFChars(stage_str, NULL);
+		const char *key = env->GetStringUTFChars(key_str, NULL);
+		const int num = env->GetArrayLength(values_array);
+		jfloat *values = env->GetFloatArrayElements(values_array, NULL);
+		if (LIKELY(stage && key && values)) {
+			result = processor->setStageParameter(stage, key, values, num);
+		}
+		if (values) {
+			env->ReleaseFloatArrayElements(values_array, values, JNI_ABORT);
+		}
+		if (key) {
+			env->ReleaseStringUTFChars(key_str, key);
+		}
+		if (stage) {
+			env->ReleaseStringUTFChars(stage_str, stage);
+		}
+	}
+
+	RETURN(result, jint);
+}
+
+/**
+ * copy latest result of the stage of the name into values_array
+ * and sequence number of its frame into seq_array[0]
+ * return number of the values of the result(values that do not fit are not copied),
+ * 0 if no result yet, -1 if current pipeline does not have the stage or the result
+ */
+static jint nativeGetStageResult(JNIEnv *env, jobject thiz,
+	ID_TYPE id_native, jstring stage_str, jstring key_str, jfloatArray values_array, jlongArray seq_array) {
+
+	ENTER();
+
+	jint result = -1;
+	ImageProcessor *processor = reinterpret_cast<ImageProcessor *>(id_native);
+	if (LIKELY(processor && stage_str && key_str && values_array)) {
+		const char *stage = env->GetStringUTFChars(stage_str, NULL);
+		const char *key = env->GetStringUTFChars(key_str, NULL);
+		const int len = env->GetArrayLength(values_array);
+		jfloat *values = env->GetFloatArrayElements(values_array, NULL);
+		if (LIKELY(stage && key && values)) {
+			int64_t seq = -1;
+			result = processor->getStageResult(stage, key, values, len, seq);
+			if (seq_array && (env->GetArrayLength(seq_array) > 0)) {
+				const jlong s = seq;
+				env->SetLongArrayRegion(seq_array, 0, 1, &s);
+			}
+		}
+		if (values) {
+			env->ReleaseFloatArrayElements(values_array, values, 0);
+		}
+		if (key) {
+			env->ReleaseStringUTFChars(key_str, key);
+		}
+		if (stage) {
+			env->ReleaseStringUTFChars(stage_str, stage);
+		}
+	}
+
+	RETURN(result, jint);
+}
+
 static jint nativeGetResultFrameType(JNIEnv *env, jobject thiz,
 	ID_TYPE id_native) {
 
@@ -386,11 +1258,28 @@ static JNINativeMethod methods[] = {
 	{ "nativeClassInit",			"()V",   (void*)nativeClassInit },
 	{ "nativeCreate",				"(Ljava/lang/ref/WeakReference;)J", (void *) nativeCreate },
 	{ "nativeRelease",				"(J)V", (void *) nativeRelease },
-	{ "nativeStart",				"(JII)I", (void *) nativeStart },
+	{ "nativeStart",				"(JIIIIZIIII)I", (void *) nativeStart },
 	{ "nativeStop",					"(J)I", (void *) nativeStop },
-	{ "nativeHandleFrame",			"(JIII)I", (void *) nativeHandleFrame },
+	{ "nativeHandleFrame",			"(JIIIJZ)I", (void *) nativeHandleFrame },
+	{ "nativeIsBusy",				"(J)Z", (void *) nativeIsBusy },
+	{ "nativeHandleBuffer",			"(JLjava/nio/ByteBuffer;IIIJI)I", (void *) nativeHandleBuffer },
+	{ "nativeSetSyntheticSource",	"(JLjava/lang/String;F)I", (void *) nativeSetSyntheticSource },
+	{ "nativeGetFrameStats",		"(J[J)I", (void *) nativeGetFrameStats },
+	{ "nativeSetArenaFlags",		"(JI)I", (void *) nativeSetArenaFlags },
+	{ "nativeSetLumaOnly",			"(JZ)I", (void *) nativeSetLumaOnly },
+	{ "nativeSetReadbackRoi",		"(JIIII)I", (void *) nativeSetReadbackRoi },
+	{ "nativeSetPriority",			"(JIF)I", (void *) nativeSetPriority },
+	{ "nativeGetSchedulerStats",	"(J[J)I", (void *) nativeGetSchedulerStats },
+	{ "nativeSetSchedulerThreads",	"(I)I", (void *) nativeSetSchedulerThreads },
+	{ "nativeSetTileThreads",		"(I)I", (void *) nativeSetTileThreads },
+	{ "nativeSetPipeline",			"(JLjava/lang/String;I)I", (void *) nativeSetPipeline },
+	{ "nativeGetStageStats",		"(J[J)I", (void *) nativeGetStageStats },
 	{ "nativeSetResultFrameType",	"(JI)I", (void *) nativeSetResultFrameType },
 	{ "nativeGetResultFrameType",	"(J)I", (void *) nativeGetResultFrameType },
+	{ "nativeSetResultFormat",		"(JI)I", (void *) nativeSetResultFormat },
+	{ "nativeSetUnchangedThreshold",	"(JI)I", (void *) nativeSetUnchangedThreshold },
+	{ "nativeSetStageParameter",	"(JLjava/lang/String;Ljava/lang/String;[F)I", (void *) nativeSetStageParameter },
+	{ "nativeGetStageResult",		"(JLjava/lang/String;Ljava/lang/String;[F[J)I", (void *) nativeGetStageResult },
 };
 
 
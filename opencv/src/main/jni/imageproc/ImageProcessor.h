@@ -26,33 +26,102 @@
 #endif //FLIGHTDEMO_IMAGEPROCESSOR_H
 
 #include "Mutex.h"
-#include "Condition.h"
 #include "IPBase.h"
 #include "IPFrame.h"
+#include "IPFrameSource.h"
+#include "IPScheduler.h"
+#include "IPPipeline.h"
+#include "IPFrameHash.h"
 
 using namespace android;
 
-class ImageProcessor : virtual public IPFrame {
+/**
+ * frames of each instance(camera) are processed on worker threads of IPScheduler
+ * that are shared by all instances
+ */
+class ImageProcessor : virtual public IPFrame, public IPSchedulerClient, public IPPipelineListener {
 private:
 	jobject mWeakThiz;
 	jclass mClazz;
 	volatile bool mIsRunning;
 	int mResultFrameType;
+	// RESULT_FORMAT_XXX
+	int mResultFormat;
+	// threshold of frame difference to skip unchanged frame, 0 disables
+	int mUnchangedThreshold;
+	// parameters of the stages that are applied to new pipeline too, guarded by mMutex
+	typedef struct stage_param {
+		std::string stage;
+		std::string key;
+		std::vector<float> values;
+	} stage_param_t;
+	std::vector<stage_param_t> mStageParams;
 
 	mutable Mutex mMutex;
-	Condition mSync;
-	pthread_t processor_thread;
-	static void *processor_thread_func(void *vptr_args);
-	void do_process(JNIEnv *env);
-	int callJavaCallback(JNIEnv *env, cv::Mat &result, const long &last_queued_time_ms);
+	// guard to access mFrameSource from outside of worker thread
+	mutable Mutex mSourceMutex;
+	IPFrameSource *mFrameSource;
+	// file and frame rate for FRAME_SOURCE_SYNTHETIC
+	std::string mSyntheticPath;
+	float mSyntheticFps;
+	// ARENA_FLAG_XXX, applied on #start
+	int mArenaFlags;
+	// queue only luminance of YUV/JPEG image, applied on #start
+	bool mLumaOnly;
+	// priority and frame budget on IPScheduler
+	int mPriority;
+	float mBudgetFps;
+	// processing stages, mPipeline is accessed only in #processFrame while running,
+	// new pipeline is set to mPendingPipeline and swapped at frame boundary
+	IPPipeline *mPipeline;
+	IPPipeline *mPendingPipeline;
+	int mProcessed;
+	// hash of last processed frame and number of unchanged frames since then,
+	// accessed only from worker thread
+	frame_hash_state_t mLastHash;
+	IPFrameSource *createFrameSource(const int &source_type,
+		const int &pbo_num, const bool &use_lease);
+	IPPipeline *updatePipeline();
+	void applyStageParameters(IPPipeline *pipeline);
+	int callJavaCallback(JNIEnv *env, const int &type, cv::Mat &result, float *detected,
+		const frame_info_t &info, const nsecs_t &dequeued_time_ns);
 protected:
+	virtual void onFrameQueued();
+	virtual void onPipelineResult(JNIEnv *env, stage_context_t &ctx);
+	virtual void onPipelineReady();
 public:
 	ImageProcessor(JNIEnv* env, jobject weak_thiz_obj, jclass clazz);
 	virtual ~ImageProcessor();
 	void release(JNIEnv *env);
-	int start(const int &width, const int &height);
+	int start(const int &width, const int &height,
+		const int &source_type = FRAME_SOURCE_GL,
+		const int &pbo_num = DEFAULT_PBO_NUM, const bool &use_lease = false,
+		const int &queue_size = DEFAULT_QUEUED_FRAMES, const int &pool_size = DEFAULT_POOL_SIZE,
+		const int &queue_policy = QUEUE_POLICY_DROP_OLDEST,
+		const int &block_timeout_ms = DEFAULT_BLOCK_TIMEOUT_MS);
 	int stop();
+	int handleFrame(const int &width, const int &height, const int &tex_name,
+		const int64_t &timestamp_ns = 0, const bool &readback = true);
+	const bool isBusy() const;
+	int handleBuffer(const uint8_t *data, const size_t &size,
+		const int &width, const int &height, const int &stride = 0,
+		const int64_t &timestamp_ns = 0, const int &format = PIXEL_FORMAT_RGBA);
+	void setSyntheticSource(const char *path, const float &fps);
+	void setArenaFlags(const int &flags);
+	void setLumaOnly(const bool &luma_only);
+	void setPriority(const int &priority, const float &budget_fps);
+	int setPipeline(const char *spec, const int &queue_depth = DEFAULT_STAGE_QUEUE_DEPTH);
+	int getStageStats(stage_stats_t *stats, const int &max_num);
+	int getSchedulerStats(scheduler_stats_t &stats, scheduler_stats_t &total_stats,
+		int &num_threads, int &num_clients);
+	virtual bool hasFrame();
+	virtual void processFrame(JNIEnv *env);
 	inline const bool isRunning() const { return mIsRunning; };
 	void setResultFrameType(const int &result_frame_type);
 	inline const int getResultFrameType() const { return mResultFrameType; };
+	void setResultFormat(const int &result_format);
+	inline const int getResultFormat() const { return mResultFormat; };
+	int setUnchangedThreshold(const int &threshold);
+	int setStageParameter(const char *stage, const char *key, const float *values, const int &num);
+	int getStageResult(const char *stage, const char *key, float *values, const int &max_num, int64_t &seq) const;
 };
\ No newline at end of file